@@ -18,6 +18,8 @@
 #include "qgsalgorithmaggregate.h"
 #include "qgsprocessingparameteraggregate.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsoutofcoreoperators.h"
+#include "qgsmaplayerstore.h"
 
 ///@cond PRIVATE
 
@@ -140,6 +142,9 @@ QVariantMap QgsAggregateAlgorithm::processAlgorithm( const QVariantMap &paramete
   QgsExpressionContext expressionContext = createExpressionContext( parameters, context, mSource.get() );
   mGroupByExpression.prepare( &expressionContext );
 
+  if ( context.memoryBudget() > 0 )
+    return processAlgorithmWithMemoryBudget( parameters, context, feedback, expressionContext );
+
   // Group features in memory layers
   const long long count = mSource->featureCount();
   double progressStep = count > 0 ? 50.0 / count : 1;
@@ -218,65 +223,113 @@ QVariantMap QgsAggregateAlgorithm::processAlgorithm( const QVariantMap &paramete
   current = 0;
   for ( const QVariantList &key : keys )
   {
-    const Group &group = groups[ key ];
+    const QgsFeature outFeat = aggregateGroup( key, groups[ key ], parameters, context );
+    if ( !sink->addFeature( outFeat, QgsFeatureSink::FastInsert ) )
+      throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
+
+    current++;
+    feedback->setProgress( 50 + current * progressStep );
+    if ( feedback->isCanceled() )
+      break;
+  }
+
+  QVariantMap results;
+  results.insert( QStringLiteral( "OUTPUT" ), destId );
+  return results;
+}
 
-    QgsExpressionContext exprContext = createExpressionContext( parameters, context );
-    exprContext.appendScope( QgsExpressionContextUtils::layerScope( group.layer ) );
-    exprContext.setFeature( group.firstFeature );
+QVariantMap QgsAggregateAlgorithm::processAlgorithmWithMemoryBudget( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback, QgsExpressionContext &expressionContext )
+{
+  // Group features, spilling them to disk if they exceed the memory budget
+  const long long count = mSource->featureCount();
+  const double progressStep = count > 0 ? 50.0 / count : 1;
+  long long current = 0;
 
-    QgsGeometry geometry = mGeometryExpression.evaluate( &exprContext ).value< QgsGeometry >();
-    if ( mGeometryExpression.hasEvalError() )
+  // the grouper and the sorter restoring the order of the groups share the memory budget
+  QgsSpillingFeatureGrouper grouper( context, mSource->fields(), count, 2 );
+  QgsFeature feature;
+  QgsFeatureIterator it = mSource->getFeatures( QgsFeatureRequest() );
+  while ( it.nextFeature( feature ) )
+  {
+    expressionContext.setFeature( feature );
+    const QVariant groupByValue = mGroupByExpression.evaluate( &expressionContext );
+    if ( mGroupByExpression.hasEvalError() )
     {
-      throw QgsProcessingException( QObject::tr( "Evaluation error in geometry expression \"%1\": %2" ).arg( mGeometryExpression.expression(),
-                                    mGeometryExpression.evalErrorString() ) );
+      throw QgsProcessingException( QObject::tr( "Evaluation error in group by expression \"%1\": %2" ).arg( mGroupByExpression.expression(),
+                                    mGroupByExpression.evalErrorString() ) );
     }
 
-    if ( !geometry.isNull() && !geometry.isEmpty() )
-    {
-      geometry = QgsGeometry::unaryUnion( geometry.asGeometryCollection() );
-      if ( geometry.isEmpty() )
-      {
-        QStringList keyString;
-        for ( const QVariant &v : key )
-          keyString << v.toString();
+    const QVariantList key = groupByValue.type() == QVariant::List ? groupByValue.toList() : ( QVariantList() << groupByValue );
+    grouper.add( key, feature );
 
-        throw QgsProcessingException( QObject::tr( "Impossible to combine geometries for %1 = %2" ).arg( mGroupBy, keyString.join( ',' ) ) );
-      }
-    }
+    current++;
+    feedback->setProgress( current * progressStep );
+    if ( feedback->isCanceled() )
+      break;
+  }
+
+  QString destId;
+  std::unique_ptr< QgsFeatureSink > sink( parameterAsSink( parameters, QStringLiteral( "OUTPUT" ), context, destId, mFields, QgsWkbTypes::multiType( mSource->wkbType() ), mSource->sourceCrs() ) );
+  if ( !sink )
+    throw QgsProcessingException( invalidSinkError( parameters, QStringLiteral( "OUTPUT" ) ) );
 
-    QgsAttributes attributes;
-    attributes.reserve( mExpressions.size() );
-    int currentAttributeIndex = 0;
-    for ( auto it = mExpressions.begin(); it != mExpressions.end(); ++it )
+  // groups read back from disk come one partition at a time, so the output features are sorted back
+  // into the order of the first feature of their group
+  const bool restoreOrder = grouper.hasSpilled();
+  QgsExternalFeatureSorter sorter( context, mFields, 2 );
+
+  // Calculate aggregates on a memory layer per group, deleted once used
+  const int partitionCount = grouper.partitionCount();
+  int partition = 0;
+  std::vector< QgsSpillingFeatureGrouper::Group > groups;
+  while ( !feedback->isCanceled() && grouper.nextGroups( groups ) )
+  {
+    for ( std::size_t i = 0; i < groups.size(); ++i )
     {
-      exprContext.setFeature( mAttributesRequireLastFeature.contains( currentAttributeIndex ) ? group.lastFeature : group.firstFeature );
-      if ( it->isValid() )
+      const QgsSpillingFeatureGrouper::Group &spilledGroup = groups[i];
+
+      QString id = QStringLiteral( "memory:" );
+      std::unique_ptr< QgsFeatureSink > groupSink( QgsProcessingUtils::createFeatureSink( id,
+          context,
+          mSource->fields(),
+          mSource->wkbType(),
+          mSource->sourceCrs() ) );
+      QgsFeatureList features = spilledGroup.features;
+      if ( !groupSink->addFeatures( features, QgsFeatureSink::FastInsert ) )
+        throw QgsProcessingException( writeFeatureError( groupSink.get(), parameters, QString() ) );
+      groupSink.reset();
+
+      Group group;
+      group.layer = QgsProcessingUtils::mapLayerFromString( id, context );
+      group.firstFeature = spilledGroup.features.constFirst();
+      group.lastFeature = spilledGroup.features.constLast();
+      const QgsFeature outFeat = aggregateGroup( spilledGroup.key, group, parameters, context );
+      context.temporaryLayerStore()->removeMapLayer( group.layer );
+
+      if ( restoreOrder )
       {
-        const QVariant value = it->evaluate( &exprContext );
-        if ( it->hasEvalError() )
-        {
-          throw QgsProcessingException( QObject::tr( "Evaluation error in expression \"%1\": %2" ).arg( it->expression(), it->evalErrorString() ) );
-        }
-        attributes.append( value );
+        sorter.add( spilledGroup.sequences.constFirst(), outFeat );
       }
-      else
+      else if ( !sink->addFeature( outFeat, QgsFeatureSink::FastInsert ) )
       {
-        attributes.append( QVariant() );
+        throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
       }
-      currentAttributeIndex++;
+
+      feedback->setProgress( 50 + 50.0 * ( partition + static_cast< double >( i + 1 ) / groups.size() ) / partitionCount );
+      if ( feedback->isCanceled() )
+        break;
     }
+    partition++;
+  }
 
-    // Write output feature
+  if ( restoreOrder && !feedback->isCanceled() )
+  {
     QgsFeature outFeat;
-    outFeat.setGeometry( geometry );
-    outFeat.setAttributes( attributes );
-    if ( !sink->addFeature( outFeat, QgsFeatureSink::FastInsert ) )
-      throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
-
-    current++;
-    feedback->setProgress( 50 + current * progressStep );
-    if ( feedback->isCanceled() )
-      break;
+    while ( sorter.next( outFeat ) )
+    {
+      if ( !sink->addFeature( outFeat, QgsFeatureSink::FastInsert ) )
+        throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
+    }
   }
 
   QVariantMap results;
@@ -284,6 +337,60 @@ QVariantMap QgsAggregateAlgorithm::processAlgorithm( const QVariantMap &paramete
   return results;
 }
 
+QgsFeature QgsAggregateAlgorithm::aggregateGroup( const QVariantList &key, const Group &group, const QVariantMap &parameters, QgsProcessingContext &context )
+{
+  QgsExpressionContext exprContext = createExpressionContext( parameters, context );
+  exprContext.appendScope( QgsExpressionContextUtils::layerScope( group.layer ) );
+  exprContext.setFeature( group.firstFeature );
+
+  QgsGeometry geometry = mGeometryExpression.evaluate( &exprContext ).value< QgsGeometry >();
+  if ( mGeometryExpression.hasEvalError() )
+  {
+    throw QgsProcessingException( QObject::tr( "Evaluation error in geometry expression \"%1\": %2" ).arg( mGeometryExpression.expression(),
+                                  mGeometryExpression.evalErrorString() ) );
+  }
+
+  if ( !geometry.isNull() && !geometry.isEmpty() )
+  {
+    geometry = QgsGeometry::unaryUnion( geometry.asGeometryCollection() );
+    if ( geometry.isEmpty() )
+    {
+      QStringList keyString;
+      for ( const QVariant &v : key )
+        keyString << v.toString();
+
+      throw QgsProcessingException( QObject::tr( "Impossible to combine geometries for %1 = %2" ).arg( mGroupBy, keyString.join( ',' ) ) );
+    }
+  }
+
+  QgsAttributes attributes;
+  attributes.reserve( mExpressions.size() );
+  int currentAttributeIndex = 0;
+  for ( auto it = mExpressions.begin(); it != mExpressions.end(); ++it )
+  {
+    exprContext.setFeature( mAttributesRequireLastFeature.contains( currentAttributeIndex ) ? group.lastFeature : group.firstFeature );
+    if ( it->isValid() )
+    {
+      const QVariant value = it->evaluate( &exprContext );
+      if ( it->hasEvalError() )
+      {
+        throw QgsProcessingException( QObject::tr( "Evaluation error in expression \"%1\": %2" ).arg( it->expression(), it->evalErrorString() ) );
+      }
+      attributes.append( value );
+    }
+    else
+    {
+      attributes.append( QVariant() );
+    }
+    currentAttributeIndex++;
+  }
+
+  QgsFeature outFeat;
+  outFeat.setGeometry( geometry );
+  outFeat.setAttributes( attributes );
+  return outFeat;
+}
+
 bool QgsAggregateAlgorithm::supportInPlaceEdit( const QgsMapLayer *layer ) const
 {
   Q_UNUSED( layer )
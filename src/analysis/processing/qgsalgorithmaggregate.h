@@ -55,6 +55,16 @@ class QgsAggregateAlgorithm : public QgsProcessingAlgorithm
 
     QgsExpression createExpression( const QString &expressionString, QgsProcessingContext &context ) const;
 
+    struct Group;
+
+    /**
+     * Groups the features with a QgsSpillingFeatureGrouper, for the memory budget of the context.
+     */
+    QVariantMap processAlgorithmWithMemoryBudget( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback, QgsExpressionContext &expressionContext );
+
+    //! Returns the output feature of a \a group of features with the specified \a key
+    QgsFeature aggregateGroup( const QVariantList &key, const Group &group, const QVariantMap &parameters, QgsProcessingContext &context );
+
     std::unique_ptr< QgsProcessingFeatureSource > mSource;
     QString mGroupBy;
 
@@ -20,6 +20,11 @@
 
 ///@cond PRIVATE
 
+QgsProcessingAlgorithm::Flags QgsBoundaryAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagThreadSafeFeatureProcessing | QgsProcessingAlgorithm::FlagSupportsCheckpoints;
+}
+
 QString QgsBoundaryAlgorithm::name() const
 {
   return QStringLiteral( "boundary" );
@@ -30,6 +30,11 @@ QString QgsCentroidAlgorithm::displayName() const
   return QObject::tr( "Centroids" );
 }
 
+QgsProcessingAlgorithm::Flags QgsCentroidAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagSupportsCheckpoints;
+}
+
 QStringList QgsCentroidAlgorithm::tags() const
 {
   return QObject::tr( "centroid,center,average,point,middle" ).split( ',' );
@@ -39,6 +39,7 @@ class QgsCentroidAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString svgIconPath() const override { return QgsApplication::iconPath( QStringLiteral( "/algorithms/mAlgorithmCentroids.svg" ) ); }
     QString name() const override;
     QString displayName() const override;
+    QgsProcessingAlgorithm::Flags flags() const override;
     QStringList tags() const override;
     QString group() const override;
     QString groupId() const override;
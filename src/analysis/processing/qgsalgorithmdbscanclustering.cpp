@@ -17,6 +17,14 @@
 
 #include "qgsalgorithmdbscanclustering.h"
 #include "qgsspatialindexkdbush.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
 #include <unordered_set>
 
 ///@cond PRIVATE
@@ -167,7 +175,10 @@ QVariantMap QgsDbscanClusteringAlgorithm::processAlgorithm( const QVariantMap &p
   idToCluster.reserve( index.size() );
   const long featureCount = source->featureCount();
   QgsFeatureIterator features = source->getFeatures( QgsFeatureRequest().setNoAttributes() );
-  stdbscan( minSize, eps1, eps2, borderPointsAreNoise, featureCount, features, index, idToCluster, idToDateTime, feedback );
+  if ( context.maximumThreads() > 1 )
+    stdbscanParallel( minSize, eps1, eps2, borderPointsAreNoise, context.maximumThreads(), features, index, idToCluster, idToDateTime, feedback );
+  else
+    stdbscan( minSize, eps1, eps2, borderPointsAreNoise, featureCount, features, index, idToCluster, idToDateTime, feedback );
 
   // cluster size
   std::unordered_map< int, int> clusterSize;
@@ -339,6 +350,214 @@ void QgsDbscanClusteringAlgorithm::stdbscan( const std::size_t minSize,
   }
 }
 
+void QgsDbscanClusteringAlgorithm::stdbscanParallel( const std::size_t minSize,
+    const double eps1,
+    const double eps2,
+    const bool borderPointsAreNoise,
+    const int threads,
+    QgsFeatureIterator features,
+    QgsSpatialIndexKDBush &index,
+    std::unordered_map< QgsFeatureId, int> &idToCluster,
+    std::unordered_map< QgsFeatureId, QDateTime> &idToDateTime,
+    QgsProcessingFeedback *feedback )
+{
+  // points which can be clustered, numbered in the order stdbscan() visits them
+  const bool useDateTime = !idToDateTime.empty();
+  std::vector< QgsSpatialIndexKDBushData > points;
+  std::vector< qint64 > msecs;
+  std::unordered_map< QgsFeatureId, int > idToPosition;
+  points.reserve( index.size() );
+  idToPosition.reserve( index.size() );
+  QgsFeature feat;
+  while ( features.nextFeature( feat ) )
+  {
+    if ( feedback->isCanceled() )
+      return;
+
+    if ( !feat.hasGeometry() )
+      continue;
+
+    if ( QgsWkbTypes::flatType( feat.geometry().wkbType() ) != Qgis::WkbType::Point )
+    {
+      // not a point geometry
+      feedback->reportError( QObject::tr( "Feature %1 is a %2 feature, not a point." ).arg( feat.id() ).arg( QgsWkbTypes::displayString( feat.geometry().wkbType() ) ) );
+      continue;
+    }
+
+    if ( useDateTime )
+    {
+      const auto dateTime = idToDateTime.find( feat.id() );
+      if ( dateTime == idToDateTime.end() || !dateTime->second.isValid() )
+      {
+        // missing datetime value
+        feedback->reportError( QObject::tr( "Feature %1 is missing a valid datetime value." ).arg( feat.id() ) );
+        continue;
+      }
+      msecs.push_back( dateTime->second.toMSecsSinceEpoch() );
+    }
+
+    const QgsPointXY point( *qgsgeometry_cast< const QgsPoint * >( feat.geometry().constGet() ) );
+    idToPosition[ feat.id() ] = static_cast< int >( points.size() );
+    points.emplace_back( feat.id(), point.x(), point.y() );
+  }
+  if ( points.empty() )
+    return;
+
+  // neighbors are the points within eps1, and within eps2 in time for ST-DBSCAN, including the point itself
+  const auto forEachNeighbor = [&]( int position, const std::function< void( int ) > &visitor )
+  {
+    index.within( points[ position ].point(), eps1, [&]( const QgsSpatialIndexKDBushData & data )
+    {
+      const auto neighbor = idToPosition.find( data.id );
+      if ( neighbor == idToPosition.end() )
+        return;
+      if ( useDateTime && std::abs( msecs[ neighbor->second ] - msecs[ position ] ) > eps2 )
+        return;
+      visitor( neighbor->second );
+    } );
+  };
+
+  // partition the points in grid cells of eps1 so that each thread queries the index in a compact area
+  QgsRectangle extent;
+  extent.setMinimal();
+  for ( const QgsSpatialIndexKDBushData &point : points )
+  {
+    extent.include( point.point() );
+  }
+  constexpr double MAX_CELLS_PER_SIDE = 65536;
+  const double cellSize = std::max( { eps1, extent.width() / MAX_CELLS_PER_SIDE, extent.height() / MAX_CELLS_PER_SIDE, std::numeric_limits< double >::min() } );
+  std::vector< std::pair< qint64, int > > cells( points.size() );
+  for ( std::size_t position = 0; position < points.size(); ++position )
+  {
+    const qint64 column = static_cast< qint64 >( std::min( MAX_CELLS_PER_SIDE, std::floor( ( points[ position ].coords.first - extent.xMinimum() ) / cellSize ) ) );
+    const qint64 row = static_cast< qint64 >( std::min( MAX_CELLS_PER_SIDE, std::floor( ( points[ position ].coords.second - extent.yMinimum() ) / cellSize ) ) );
+    cells[ position ] = std::make_pair( row * ( static_cast< qint64 >( MAX_CELLS_PER_SIDE ) + 1 ) + column, static_cast< int >( position ) );
+  }
+  std::sort( cells.begin(), cells.end() );
+
+  // runs task on consecutive cells, a few partitions per thread balancing dense and sparse areas
+  QThreadPool pool;
+  pool.setMaxThreadCount( threads );
+  const std::size_t partitionCount = std::min( points.size(), static_cast< std::size_t >( threads ) * 8 );
+  const auto runPartitions = [&]( const std::function< void( int ) > &task, double progressStart, double progressEnd )
+  {
+    QList< QFuture< void > > futures;
+    for ( std::size_t partition = 0; partition < partitionCount; ++partition )
+    {
+      const std::size_t begin = partition * cells.size() / partitionCount;
+      const std::size_t end = ( partition + 1 ) * cells.size() / partitionCount;
+      futures << QtConcurrent::run( &pool, [&cells, &task, feedback, begin, end]
+      {
+        for ( std::size_t i = begin; i < end && !feedback->isCanceled(); ++i )
+        {
+          task( cells[ i ].second );
+        }
+      } );
+    }
+    for ( int i = 0; i < futures.size(); ++i )
+    {
+      futures[ i ].waitForFinished();
+      feedback->setProgress( progressStart + ( progressEnd - progressStart ) * ( i + 1 ) / futures.size() );
+    }
+  };
+
+  // core points have at least minSize neighbors
+  std::vector< char > isCore( points.size(), 0 );
+  runPartitions( [&]( int position )
+  {
+    std::size_t neighbors = 0;
+    forEachNeighbor( position, [&neighbors]( int ) { neighbors++; } );
+    isCore[ position ] = neighbors >= minSize;
+  }, 0, 30 );
+  if ( feedback->isCanceled() )
+    return;
+
+  // neighboring core points are in the same cluster. The root of a cluster is linked to the root with the smaller
+  // position, so that it ends up being the first core point of the cluster, where stdbscan() starts the cluster
+  std::unique_ptr< std::atomic< int >[] > parents( new std::atomic< int >[ points.size()] );
+  for ( std::size_t position = 0; position < points.size(); ++position )
+    parents[ position ].store( static_cast< int >( position ), std::memory_order_relaxed );
+  const auto findRoot = [&parents]( int position )
+  {
+    int parent = parents[ position ].load();
+    while ( parent != position )
+    {
+      position = parent;
+      parent = parents[ position ].load();
+    }
+    return position;
+  };
+  const auto unite = [&parents, &findRoot]( int a, int b )
+  {
+    while ( true )
+    {
+      a = findRoot( a );
+      b = findRoot( b );
+      if ( a == b )
+        return;
+      if ( a > b )
+        std::swap( a, b );
+
+      // fails if another thread linked b in the meantime
+      int expected = b;
+      if ( parents[ b ].compare_exchange_strong( expected, a ) )
+        return;
+    }
+  };
+  runPartitions( [&]( int position )
+  {
+    if ( !isCore[ position ] )
+      return;
+    forEachNeighbor( position, [&]( int neighbor )
+    {
+      if ( neighbor > position && isCore[ neighbor ] )
+        unite( position, neighbor );
+    } );
+  }, 30, 60 );
+  if ( feedback->isCanceled() )
+    return;
+
+  // clusters are numbered in the order stdbscan() starts them
+  std::vector< int > rootToCluster( points.size(), 0 );
+  int clusterCount = 0;
+  for ( std::size_t position = 0; position < points.size(); ++position )
+  {
+    if ( isCore[ position ] && findRoot( static_cast< int >( position ) ) == static_cast< int >( position ) )
+      rootToCluster[ position ] = ++clusterCount;
+  }
+
+  // border points join the first started cluster with a neighbor core point
+  std::vector< int > pointToCluster( points.size(), 0 );
+  runPartitions( [&]( int position )
+  {
+    if ( isCore[ position ] )
+    {
+      pointToCluster[ position ] = rootToCluster[ findRoot( position ) ];
+    }
+    else if ( !borderPointsAreNoise )
+    {
+      int cluster = 0;
+      forEachNeighbor( position, [&]( int neighbor )
+      {
+        if ( !isCore[ neighbor ] )
+          return;
+        const int neighborCluster = rootToCluster[ findRoot( neighbor ) ];
+        if ( cluster == 0 || neighborCluster < cluster )
+          cluster = neighborCluster;
+      } );
+      pointToCluster[ position ] = cluster;
+    }
+  }, 60, 90 );
+  if ( feedback->isCanceled() )
+    return;
+
+  for ( std::size_t position = 0; position < points.size(); ++position )
+  {
+    if ( pointToCluster[ position ] > 0 )
+      idToCluster[ points[ position ].id ] = pointToCluster[ position ];
+  }
+}
+
 ///@endcond
 
 
@@ -66,6 +66,23 @@ class ANALYSIS_EXPORT QgsDbscanClusteringAlgorithm : public QgsProcessingAlgorit
                           std::unordered_map< QgsFeatureId, QDateTime> &idToDateTime,
                           QgsProcessingFeedback *feedback );
 
+    /**
+     * Parallel version of stdbscan(), using up to \a threads threads.
+     *
+     * Core points are found in parallel, and connected core points are merged in clusters with a
+     * concurrent union-find. Clusters and border points get the same assignments as stdbscan().
+     */
+    static void stdbscanParallel( std::size_t minSize,
+                                  const double eps1,
+                                  const double eps2,
+                                  bool borderPointsAreNoise,
+                                  int threads,
+                                  QgsFeatureIterator features,
+                                  QgsSpatialIndexKDBush &index,
+                                  std::unordered_map< QgsFeatureId, int> &idToCluster,
+                                  std::unordered_map< QgsFeatureId, QDateTime> &idToDateTime,
+                                  QgsProcessingFeedback *feedback );
+
 };
 
 ///@endcond PRIVATE
@@ -16,6 +16,13 @@
  ***************************************************************************/
 
 #include "qgsalgorithmdissolve.h"
+#include "qgsoutofcoreoperators.h"
+#include "qgsprocessingfeedback.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
 
 ///@cond PRIVATE
 
@@ -24,7 +31,8 @@
 //
 
 QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback,
-    const std::function<QgsGeometry( const QVector< QgsGeometry >& )> &collector, int maxQueueLength, QgsProcessingFeatureSource::Flags sourceFlags, bool separateDisjoint )
+    const std::function<QgsGeometry( const QVector< QgsGeometry >& )> &collector, int maxQueueLength, QgsProcessingFeatureSource::Flags sourceFlags, bool separateDisjoint,
+    const std::function<QVector<QgsGeometry>( const QVector<QVector<QgsGeometry>>& )> &groupsCollector )
 {
   std::unique_ptr< QgsProcessingFeatureSource > source( parameterAsSource( parameters, QStringLiteral( "INPUT" ), context ) );
   if ( !source )
@@ -70,7 +78,7 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
       if ( f.hasGeometry() && !f.geometry().isNull() )
       {
         geomQueue.append( f.geometry() );
-        if ( maxQueueLength > 0 && geomQueue.length() > maxQueueLength )
+        if ( !groupsCollector && maxQueueLength > 0 && geomQueue.length() > maxQueueLength )
         {
           // queue too long, combine it
           const QgsGeometry tempOutputGeometry = collector( geomQueue );
@@ -83,15 +91,15 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
       current++;
     }
 
+    const QgsGeometry combinedGeometry = groupsCollector ? groupsCollector( QVector< QVector< QgsGeometry > >() << geomQueue ).value( 0 ) : collector( geomQueue );
     if ( !separateDisjoint )
     {
-      outputFeature.setGeometry( collector( geomQueue ) );
+      outputFeature.setGeometry( combinedGeometry );
       if ( !sink->addFeature( outputFeature, QgsFeatureSink::FastInsert ) )
         throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
     }
     else
     {
-      const QgsGeometry combinedGeometry = collector( geomQueue );
       for ( auto it = combinedGeometry.const_parts_begin(); it != combinedGeometry.const_parts_end(); ++it )
       {
         QgsGeometry partGeom( ( ( *it )->clone() ) );
@@ -113,80 +121,182 @@ QVariantMap QgsCollectorAlgorithm::processCollection( const QVariantMap &paramet
         fieldIndexes << index;
     }
 
-    QHash< QVariant, QgsAttributes > attributeHash;
-    QHash< QVariant, QVector< QgsGeometry > > geometryHash;
-
-    while ( it.nextFeature( f ) )
+    auto addGroupFeature = [&]( QgsFeature & outputFeature, QgsGeometry geom )
     {
-      if ( feedback->isCanceled() )
+      if ( !geom.isMultipart() )
       {
-        break;
+        geom.convertToMultiType();
       }
-
-      QVariantList indexAttributes;
-      indexAttributes.reserve( fieldIndexes.size() );
-      for ( const int index : std::as_const( fieldIndexes ) )
+      if ( !separateDisjoint )
       {
-        indexAttributes << f.attribute( index );
-      }
-
-      if ( !attributeHash.contains( indexAttributes ) )
-      {
-        // keep attributes of first feature
-        attributeHash.insert( indexAttributes, f.attributes() );
+        outputFeature.setGeometry( geom );
+        if ( !sink->addFeature( outputFeature, QgsFeatureSink::FastInsert ) )
+          throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
       }
-
-      if ( f.hasGeometry() && !f.geometry().isNull() )
+      else
       {
-        geometryHash[ indexAttributes ].append( f.geometry() );
+        for ( auto it = geom.const_parts_begin(); it != geom.const_parts_end(); ++it )
+        {
+          QgsGeometry partGeom( ( ( *it )->clone() ) );
+          partGeom.convertToMultiType();
+          outputFeature.setGeometry( partGeom );
+          if ( !sink->addFeature( outputFeature, QgsFeatureSink::FastInsert ) )
+            throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
+        }
       }
-    }
+    };
 
-    const int numberFeatures = attributeHash.count();
-    QHash< QVariant, QgsAttributes >::const_iterator attrIt = attributeHash.constBegin();
-    for ( ; attrIt != attributeHash.constEnd(); ++attrIt )
+    if ( context.memoryBudget() > 0 )
     {
-      if ( feedback->isCanceled() )
+      // group the features, spilling them to disk if they exceed the memory budget, then collect the
+      // groups one batch at a time
+      QgsSpillingFeatureGrouper grouper( context, source->fields(), count );
+      while ( it.nextFeature( f ) )
       {
-        break;
+        if ( feedback->isCanceled() )
+        {
+          break;
+        }
+
+        QVariantList indexAttributes;
+        indexAttributes.reserve( fieldIndexes.size() );
+        for ( const int index : std::as_const( fieldIndexes ) )
+        {
+          indexAttributes << f.attribute( index );
+        }
+
+        grouper.add( indexAttributes, f );
+
+        feedback->setProgress( current * step / 2 );
+        current++;
       }
 
-      QgsFeature outputFeature;
-      outputFeature.setAttributes( attrIt.value() );
-      auto geometryHashIt = geometryHash.find( attrIt.key() );
-      if ( geometryHashIt != geometryHash.end() )
+      const int partitionCount = grouper.partitionCount();
+      int partition = 0;
+      std::vector< QgsSpillingFeatureGrouper::Group > groups;
+      while ( !feedback->isCanceled() && grouper.nextGroups( groups ) )
       {
-        QgsGeometry geom = collector( geometryHashIt.value() );
-        if ( !geom.isMultipart() )
+        QVector< QVector< QgsGeometry > > groupGeometries( static_cast< int >( groups.size() ) );
+        for ( std::size_t i = 0; i < groups.size(); ++i )
         {
-          geom.convertToMultiType();
+          for ( const QgsFeature &feature : groups[i].features )
+          {
+            if ( feature.hasGeometry() && !feature.geometry().isNull() )
+              groupGeometries[ static_cast< int >( i ) ].append( feature.geometry() );
+          }
         }
-        if ( !separateDisjoint )
+
+        // groups with geometries of the batch are collected at once, so that the groups collector can process them together
+        QVector< QgsGeometry > collectedGeometries;
+        if ( groupsCollector )
         {
-          outputFeature.setGeometry( geom );
-          if ( !sink->addFeature( outputFeature, QgsFeatureSink::FastInsert ) )
-            throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
+          QVector< QVector< QgsGeometry > > nonEmptyGroups;
+          for ( const QVector< QgsGeometry > &geometries : std::as_const( groupGeometries ) )
+          {
+            if ( !geometries.isEmpty() )
+              nonEmptyGroups << geometries;
+          }
+          collectedGeometries = groupsCollector( nonEmptyGroups );
         }
-        else
+
+        int collectedIndex = 0;
+        for ( std::size_t i = 0; i < groups.size(); ++i )
         {
-          for ( auto it = geom.const_parts_begin(); it != geom.const_parts_end(); ++it )
+          if ( feedback->isCanceled() )
+          {
+            break;
+          }
+
+          QgsFeature outputFeature;
+          outputFeature.setAttributes( groups[i].features.constFirst().attributes() );
+          const QVector< QgsGeometry > &geometries = groupGeometries.at( static_cast< int >( i ) );
+          if ( !geometries.isEmpty() )
+          {
+            addGroupFeature( outputFeature, groupsCollector ? collectedGeometries.value( collectedIndex++ ) : collector( geometries ) );
+          }
+          else
           {
-            QgsGeometry partGeom( ( ( *it )->clone() ) );
-            partGeom.convertToMultiType();
-            outputFeature.setGeometry( partGeom );
             if ( !sink->addFeature( outputFeature, QgsFeatureSink::FastInsert ) )
               throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
           }
         }
+
+        partition++;
+        feedback->setProgress( 50 + 50.0 * partition / partitionCount );
       }
-      else
+    }
+    else
+    {
+      QHash< QVariant, QgsAttributes > attributeHash;
+      QHash< QVariant, QVector< QgsGeometry > > geometryHash;
+
+      while ( it.nextFeature( f ) )
       {
-        if ( !sink->addFeature( outputFeature, QgsFeatureSink::FastInsert ) )
-          throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
+        if ( feedback->isCanceled() )
+        {
+          break;
+        }
+
+        QVariantList indexAttributes;
+        indexAttributes.reserve( fieldIndexes.size() );
+        for ( const int index : std::as_const( fieldIndexes ) )
+        {
+          indexAttributes << f.attribute( index );
+        }
+
+        if ( !attributeHash.contains( indexAttributes ) )
+        {
+          // keep attributes of first feature
+          attributeHash.insert( indexAttributes, f.attributes() );
+        }
+
+        if ( f.hasGeometry() && !f.geometry().isNull() )
+        {
+          geometryHash[ indexAttributes ].append( f.geometry() );
+        }
       }
 
-      feedback->setProgress( current * 100.0 / numberFeatures );
-      current++;
+      // geometries of all groups are collected at once, so that the groups collector can process them together
+      QHash< QVariant, QgsGeometry > collectedGeometries;
+      if ( groupsCollector && !feedback->isCanceled() )
+      {
+        QVariantList keys;
+        QVector< QVector< QgsGeometry > > groups;
+        for ( auto groupIt = geometryHash.constBegin(); groupIt != geometryHash.constEnd(); ++groupIt )
+        {
+          keys << groupIt.key();
+          groups << groupIt.value();
+        }
+        const QVector< QgsGeometry > geometries = groupsCollector( groups );
+        for ( int i = 0; i < keys.size(); ++i )
+          collectedGeometries.insert( keys.at( i ), geometries.value( i ) );
+      }
+
+      const int numberFeatures = attributeHash.count();
+      QHash< QVariant, QgsAttributes >::const_iterator attrIt = attributeHash.constBegin();
+      for ( ; attrIt != attributeHash.constEnd(); ++attrIt )
+      {
+        if ( feedback->isCanceled() )
+        {
+          break;
+        }
+
+        QgsFeature outputFeature;
+        outputFeature.setAttributes( attrIt.value() );
+        auto geometryHashIt = geometryHash.find( attrIt.key() );
+        if ( geometryHashIt != geometryHash.end() )
+        {
+          addGroupFeature( outputFeature, groupsCollector ? collectedGeometries.value( attrIt.key() ) : collector( geometryHashIt.value() ) );
+        }
+        else
+        {
+          if ( !sink->addFeature( outputFeature, QgsFeatureSink::FastInsert ) )
+            throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
+        }
+
+        feedback->setProgress( current * 100.0 / numberFeatures );
+        current++;
+      }
     }
   }
 
@@ -256,41 +366,298 @@ QgsDissolveAlgorithm *QgsDissolveAlgorithm::createInstance() const
   return new QgsDissolveAlgorithm();
 }
 
+//! Unions the \a parts of a dissolved feature
+static QgsGeometry dissolveParts( const QVector< QgsGeometry > &parts, QgsProcessingFeedback *feedback )
+{
+  QgsGeometry result( QgsGeometry::unaryUnion( parts ) );
+  if ( QgsWkbTypes::geometryType( result.wkbType() ) == Qgis::GeometryType::Line )
+    result = result.mergeLines();
+  // Geos may fail in some cases, let's try a slower but safer approach
+  // See: https://github.com/qgis/QGIS/issues/28411 - Dissolve tool failing to produce outputs
+  if ( ! result.lastError().isEmpty() && parts.count() >  2 )
+  {
+    if ( feedback->isCanceled() )
+      return result;
+
+    feedback->pushDebugInfo( QObject::tr( "GEOS exception: taking the slower route ..." ) );
+    result = QgsGeometry();
+    for ( const auto &p : parts )
+    {
+      result = QgsGeometry::unaryUnion( QVector< QgsGeometry >() << result << p );
+      if ( QgsWkbTypes::geometryType( result.wkbType() ) == Qgis::GeometryType::Line )
+        result = result.mergeLines();
+      if ( feedback->isCanceled() )
+        return result;
+    }
+  }
+  if ( ! result.lastError().isEmpty() )
+  {
+    feedback->reportError( result.lastError(), true );
+    if ( result.isEmpty() )
+      throw QgsProcessingException( QObject::tr( "The algorithm returned no output." ) );
+  }
+  return result;
+}
+
 QVariantMap QgsDissolveAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
   const bool separateDisjoint = parameterAsBool( parameters, QStringLiteral( "SEPARATE_DISJOINT" ), context );
 
-  return processCollection( parameters, context, feedback, [ & ]( const QVector< QgsGeometry > &parts )->QgsGeometry
+  std::function< QVector< QgsGeometry >( const QVector< QVector< QgsGeometry > > & ) > groupsCollector;
+  const int threads = context.maximumThreads();
+  if ( threads > 1 )
   {
-    QgsGeometry result( QgsGeometry::unaryUnion( parts ) );
-    if ( QgsWkbTypes::geometryType( result.wkbType() ) == Qgis::GeometryType::Line )
-      result = result.mergeLines();
-    // Geos may fail in some cases, let's try a slower but safer approach
-    // See: https://github.com/qgis/QGIS/issues/28411 - Dissolve tool failing to produce outputs
-    if ( ! result.lastError().isEmpty() && parts.count() >  2 )
+    groupsCollector = [ & ]( const QVector< QVector< QgsGeometry > > &groups )
     {
-      if ( feedback->isCanceled() )
-        return result;
+      return cascadedUnion( groups, threads, feedback, dissolveParts );
+    };
+  }
 
-      feedback->pushDebugInfo( QObject::tr( "GEOS exception: taking the slower route ..." ) );
-      result = QgsGeometry();
-      for ( const auto &p : parts )
+  return processCollection( parameters, context, feedback, [ & ]( const QVector< QgsGeometry > &parts )->QgsGeometry
+  {
+    return dissolveParts( parts, feedback );
+  }, 10000, QgsProcessingFeatureSource::Flags(), separateDisjoint, groupsCollector );
+}
+
+//! Result of a union run by a thread of the cascaded union
+struct QgsCascadedUnionResult
+{
+  QgsGeometry geometry;
+  std::vector< QgsProcessingBufferedFeedback::Message > messages;
+  bool failed = false;
+  QString error;
+};
+
+//! Number of geometries unioned at once at the leaves of the cascaded union tree
+constexpr int CASCADED_UNION_LEAF_SIZE = 32;
+
+/**
+ * Returns the distance along a Hilbert curve of the cell with column \a x and row \a y,
+ * in a grid of 65536 by 65536 cells.
+ */
+static quint64 hilbertDistance( quint32 x, quint32 y )
+{
+  constexpr quint32 GRID_SIZE = 1 << 16;
+  quint64 distance = 0;
+  for ( quint32 s = GRID_SIZE / 2; s > 0; s /= 2 )
+  {
+    const quint32 rx = ( x & s ) > 0 ? 1 : 0;
+    const quint32 ry = ( y & s ) > 0 ? 1 : 0;
+    distance += static_cast< quint64 >( s ) * s * ( ( 3 * rx ) ^ ry );
+
+    // rotate the quadrant so that the curve is continuous
+    if ( ry == 0 )
+    {
+      if ( rx == 1 )
       {
-        result = QgsGeometry::unaryUnion( QVector< QgsGeometry >() << result << p );
-        if ( QgsWkbTypes::geometryType( result.wkbType() ) == Qgis::GeometryType::Line )
-          result = result.mergeLines();
-        if ( feedback->isCanceled() )
-          return result;
+        x = GRID_SIZE - 1 - x;
+        y = GRID_SIZE - 1 - y;
       }
+      std::swap( x, y );
     }
-    if ( ! result.lastError().isEmpty() )
+  }
+  return distance;
+}
+
+//! Returns \a geometries sorted along a Hilbert curve of the centers of their bounding boxes, so that nearby geometries follow each other
+static QVector< QgsGeometry > sortAlongHilbertCurve( const QVector< QgsGeometry > &geometries )
+{
+  QgsRectangle extent;
+  std::vector< QgsPointXY > centers;
+  centers.reserve( geometries.size() );
+  for ( const QgsGeometry &geometry : geometries )
+  {
+    const QgsRectangle bounds = geometry.boundingBox();
+    extent.combineExtentWith( bounds );
+    centers.emplace_back( bounds.center() );
+  }
+
+  const double cellWidth = extent.width() > 0 ? extent.width() / 65535 : 1;
+  const double cellHeight = extent.height() > 0 ? extent.height() / 65535 : 1;
+  std::vector< std::pair< quint64, int > > distances;
+  distances.reserve( geometries.size() );
+  for ( int i = 0; i < geometries.size(); ++i )
+  {
+    const quint32 x = static_cast< quint32 >( std::clamp( ( centers[ i ].x() - extent.xMinimum() ) / cellWidth, 0.0, 65535.0 ) );
+    const quint32 y = static_cast< quint32 >( std::clamp( ( centers[ i ].y() - extent.yMinimum() ) / cellHeight, 0.0, 65535.0 ) );
+    distances.emplace_back( hilbertDistance( x, y ), i );
+  }
+  std::sort( distances.begin(), distances.end() );
+
+  QVector< QgsGeometry > sorted;
+  sorted.reserve( geometries.size() );
+  for ( const std::pair< quint64, int > &distance : distances )
+    sorted << geometries.at( distance.second );
+  return sorted;
+}
+
+/**
+ * Unions the geometries from \a begin to \a end with a tree of unions: blocks of CASCADED_UNION_LEAF_SIZE
+ * geometries are unioned, then unions of the same level are unioned in pairs.
+ *
+ * The tree is built depth first, so only the unions waiting for their sibling are held, one per level of the tree.
+ */
+static QgsGeometry unionTree( const QVector< QgsGeometry > &geometries, int begin, int end, QgsProcessingFeedback *feedback,
+                              const std::function< QgsGeometry( const QVector< QgsGeometry > &, QgsProcessingFeedback * ) > &unionParts )
+{
+  std::vector< std::pair< int, QgsGeometry > > pending;
+  for ( int leafBegin = begin; leafBegin < end; leafBegin += CASCADED_UNION_LEAF_SIZE )
+  {
+    if ( feedback->isCanceled() )
+      return QgsGeometry();
+
+    QgsGeometry node = unionParts( geometries.mid( leafBegin, std::min( CASCADED_UNION_LEAF_SIZE, end - leafBegin ) ), feedback );
+    int level = 0;
+    while ( !pending.empty() && pending.back().first == level )
     {
-      feedback->reportError( result.lastError(), true );
-      if ( result.isEmpty() )
-        throw QgsProcessingException( QObject::tr( "The algorithm returned no output." ) );
+      node = unionParts( QVector< QgsGeometry >() << pending.back().second << node, feedback );
+      pending.pop_back();
+      ++level;
     }
+    pending.emplace_back( level, node );
+  }
+
+  if ( pending.empty() )
+    return QgsGeometry();
+
+  // unions left at the end of an incomplete tree
+  QgsGeometry result = pending.back().second;
+  pending.pop_back();
+  while ( !pending.empty() )
+  {
+    result = unionParts( QVector< QgsGeometry >() << pending.back().second << result, feedback );
+    pending.pop_back();
+  }
+  return result;
+}
+
+QVector< QgsGeometry > QgsDissolveAlgorithm::cascadedUnion( const QVector< QVector< QgsGeometry > > &groups, int threads, QgsProcessingFeedback *feedback,
+    const std::function< QgsGeometry( const QVector< QgsGeometry > &, QgsProcessingFeedback * ) > &unionParts )
+{
+  QThreadPool pool;
+  pool.setMaxThreadCount( threads );
+
+  const auto runUnion = [feedback]( const std::function< QgsGeometry( QgsProcessingFeedback * ) > &task ) -> QgsCascadedUnionResult
+  {
+    QgsCascadedUnionResult result;
+    QgsProcessingBufferedFeedback unionFeedback( feedback );
+    try
+    {
+      result.geometry = task( &unionFeedback );
+    }
+    catch ( QgsProcessingException &e )
+    {
+      result.failed = true;
+      result.error = e.what();
+    }
+    result.messages = unionFeedback.takeMessages();
     return result;
-  }, 10000, QgsProcessingFeatureSource::Flags(), separateDisjoint );
+  };
+
+  // all unions must be done before returning, even if one of them failed
+  const auto takeResults = [feedback]( std::vector< QFuture< QgsCascadedUnionResult > > &futures ) -> QVector< QgsGeometry >
+  {
+    QVector< QgsGeometry > geometries;
+    QString error;
+    for ( QFuture< QgsCascadedUnionResult > &future : futures )
+    {
+      QgsCascadedUnionResult result = future.result();
+      QgsProcessingBufferedFeedback::reportMessages( result.messages, feedback );
+      if ( result.failed && error.isEmpty() )
+        error = result.error;
+      geometries << result.geometry;
+    }
+    if ( !error.isEmpty() )
+      throw QgsProcessingException( error );
+    return geometries;
+  };
+
+  // groups are sorted in parallel
+  std::vector< QFuture< QVector< QgsGeometry > > > pendingSorts;
+  for ( const QVector< QgsGeometry > &group : groups )
+  {
+    pendingSorts.push_back( QtConcurrent::run( &pool, sortAlongHilbertCurve, group ) );
+  }
+  QVector< QVector< QgsGeometry > > sortedGroups;
+  for ( QFuture< QVector< QgsGeometry > > &pendingSort : pendingSorts )
+  {
+    sortedGroups << pendingSort.result();
+  }
+
+  // each group is split in runs of nearby geometries, at most one per thread, and the runs of all groups are unioned in parallel
+  std::vector< QFuture< QgsCascadedUnionResult > > pendingRuns;
+  QVector< int > runCounts;
+  for ( const QVector< QgsGeometry > &group : std::as_const( sortedGroups ) )
+  {
+    const int count = group.size();
+    const int runSize = std::max( CASCADED_UNION_LEAF_SIZE, ( count + threads - 1 ) / threads );
+    int runCount = 0;
+    for ( int runBegin = 0; runBegin < count; runBegin += runSize )
+    {
+      const int runEnd = std::min( count, runBegin + runSize );
+      pendingRuns.push_back( QtConcurrent::run( &pool, runUnion, [&group, runBegin, runEnd, &unionParts]( QgsProcessingFeedback * unionFeedback )
+      {
+        return unionTree( group, runBegin, runEnd, unionFeedback, unionParts );
+      } ) );
+      ++runCount;
+    }
+    runCounts << runCount;
+  }
+  const QVector< QgsGeometry > runGeometries = takeResults( pendingRuns );
+
+  QVector< QVector< QgsGeometry > > partialUnions;
+  int run = 0;
+  for ( const int runCount : std::as_const( runCounts ) )
+  {
+    partialUnions << runGeometries.mid( run, runCount );
+    run += runCount;
+  }
+
+  // the unions of the runs of a group are unioned in pairs of neighbors, level by level, until one is left
+  bool merged = false;
+  while ( !merged && !feedback->isCanceled() )
+  {
+    merged = true;
+    std::vector< QFuture< QgsCascadedUnionResult > > pendingPairs;
+    QVector< int > pairCounts;
+    for ( const QVector< QgsGeometry > &partial : std::as_const( partialUnions ) )
+    {
+      int pairCount = 0;
+      for ( int i = 0; i + 1 < partial.size(); i += 2 )
+      {
+        const QVector< QgsGeometry > pair = QVector< QgsGeometry >() << partial.at( i ) << partial.at( i + 1 );
+        pendingPairs.push_back( QtConcurrent::run( &pool, runUnion, [pair, &unionParts]( QgsProcessingFeedback * unionFeedback )
+        {
+          return unionParts( pair, unionFeedback );
+        } ) );
+        ++pairCount;
+      }
+      pairCounts << pairCount;
+      merged = merged && pairCount == 0;
+    }
+    if ( merged )
+      break;
+
+    const QVector< QgsGeometry > pairGeometries = takeResults( pendingPairs );
+    int pair = 0;
+    for ( int group = 0; group < partialUnions.size(); ++group )
+    {
+      QVector< QgsGeometry > &partial = partialUnions[ group ];
+      QVector< QgsGeometry > nextLevel = pairGeometries.mid( pair, pairCounts.at( group ) );
+      if ( partial.size() % 2 == 1 )
+        nextLevel << partial.constLast();
+      partial = nextLevel;
+      pair += pairCounts.at( group );
+    }
+  }
+
+  QVector< QgsGeometry > results;
+  results.reserve( groups.size() );
+  for ( const QVector< QgsGeometry > &partial : std::as_const( partialUnions ) )
+  {
+    results << partial.value( 0 );
+  }
+  return results;
 }
 
 //
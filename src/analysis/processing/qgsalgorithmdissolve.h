@@ -33,9 +33,16 @@ class QgsCollectorAlgorithm : public QgsProcessingAlgorithm
 {
   protected:
 
+    /**
+     * Collects the geometries of the features of each group with \a collector.
+     *
+     * If \a groupsCollector is set, it is called once with the geometries of all groups instead, and
+     * returns the collected geometry of each group in the same order.
+     */
     QVariantMap processCollection( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback,
                                    const std::function<QgsGeometry( const QVector<QgsGeometry>& )> &collector, int maxQueueLength = 0, QgsProcessingFeatureSource::Flags sourceFlags = QgsProcessingFeatureSource::Flags(),
-                                   bool separateDisjoint = false );
+                                   bool separateDisjoint = false,
+                                   const std::function<QVector<QgsGeometry>( const QVector<QVector<QgsGeometry>>& )> &groupsCollector = nullptr );
 };
 
 /**
@@ -63,6 +70,19 @@ class QgsDissolveAlgorithm : public QgsCollectorAlgorithm
     QVariantMap processAlgorithm( const QVariantMap &parameters,
                                   QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
 
+  private:
+
+    /**
+     * Unions the geometries of each of the \a groups with \a unionParts, using up to \a threads threads.
+     *
+     * The geometries of a group are sorted along a Hilbert curve, then unioned by a tree of unions
+     * of nearby geometries. Groups are split in runs of geometries unioned in parallel, along with the
+     * runs of the other groups, and the unions of the runs are unioned in pairs in parallel. Only the
+     * unions of a run waiting for their sibling in the tree are held in memory.
+     */
+    static QVector< QgsGeometry > cascadedUnion( const QVector< QVector< QgsGeometry > > &groups, int threads, QgsProcessingFeedback *feedback,
+        const std::function< QgsGeometry( const QVector< QgsGeometry > &, QgsProcessingFeedback * ) > &unionParts );
+
 };
 
 /**
@@ -19,6 +19,11 @@
 
 ///@cond PRIVATE
 
+QgsProcessingAlgorithm::Flags QgsDropMZValuesAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagThreadSafeFeatureProcessing | QgsProcessingAlgorithm::FlagSupportsCheckpoints;
+}
+
 QString QgsDropMZValuesAlgorithm::name() const
 {
   return QStringLiteral( "dropmzvalues" );
@@ -24,6 +24,11 @@
 
 ///@cond PRIVATE
 
+QgsProcessingAlgorithm::Flags QgsExplodeAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagThreadSafeFeatureProcessing | QgsProcessingAlgorithm::FlagSupportsCheckpoints;
+}
+
 QString QgsExplodeAlgorithm::name() const
 {
   return QStringLiteral( "explodelines" );
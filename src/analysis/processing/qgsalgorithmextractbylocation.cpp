@@ -17,6 +17,7 @@
 
 #include "qgsalgorithmextractbylocation.h"
 #include "qgsgeometryengine.h"
+#include "qgsspatialjoinengine.h"
 #include "qgsvectorlayer.h"
 #include "qgsvectorlayerfeatureiterator.h"
 
@@ -92,8 +93,14 @@ void QgsLocationBasedAlgorithm::process( const QgsProcessingContext &context, Qg
        !selectedPredicates.contains( Disjoint ) )
     return;
 
-  if ( mTargetFeatureCount > 0 && mIntersectFeatureCount > 0 &&
-       mTargetFeatureCount < mIntersectFeatureCount )
+  if ( context.maximumThreads() > 1 )
+  {
+    processWithSpatialJoin( context, targetSource, intersectSource,
+                            selectedPredicates, handleFeatureFunction,
+                            onlyRequireTargetIds, feedback, skipTargetFeatureIds );
+  }
+  else if ( mTargetFeatureCount > 0 && mIntersectFeatureCount > 0 &&
+            mTargetFeatureCount < mIntersectFeatureCount )
   {
     // joining FEWER features to a layer with MORE features. So we iterate over the FEW features and find matches from the MANY
     processByIteratingOverTargetSource( context, targetSource, intersectSource,
@@ -221,6 +228,105 @@ void QgsLocationBasedAlgorithm::processByIteratingOverTargetSource( const QgsPro
   }
 }
 
+//! Returns the spatial join predicate for a location based \a predicate
+static QgsSpatialJoinEngine::Predicate toSpatialJoinPredicate( int predicate )
+{
+  switch ( predicate )
+  {
+    case 1:
+      return QgsSpatialJoinEngine::Contains;
+    case 2:
+      return QgsSpatialJoinEngine::Disjoint;
+    case 3:
+      return QgsSpatialJoinEngine::IsEqual;
+    case 4:
+      return QgsSpatialJoinEngine::Touches;
+    case 5:
+      return QgsSpatialJoinEngine::Overlaps;
+    case 6:
+      return QgsSpatialJoinEngine::Within;
+    case 7:
+      return QgsSpatialJoinEngine::Crosses;
+  }
+  return QgsSpatialJoinEngine::Intersects;
+}
+
+void QgsLocationBasedAlgorithm::processWithSpatialJoin( const QgsProcessingContext &context, QgsFeatureSource *targetSource,
+    QgsFeatureSource *intersectSource,
+    const QList< int > &selectedPredicates,
+    const std::function < void( const QgsFeature & ) > &handleFeatureFunction,
+    bool onlyRequireTargetIds,
+    QgsProcessingFeedback *feedback,
+    const QgsFeatureIds &skipTargetFeatureIds )
+{
+  // the features of the smaller source are loaded in memory with their prepared geometries, and
+  // the features of the other source are tested against them in parallel. Target features without
+  // geometry are disjoint from everything but aren't loaded, so disjoints are found by probing targets
+  const bool testDisjoint = selectedPredicates.contains( Disjoint );
+  const bool buildFromTarget = !testDisjoint && mTargetFeatureCount > 0 && mIntersectFeatureCount > 0 && mTargetFeatureCount < mIntersectFeatureCount;
+
+  // predicates are tested as "build feature <predicate> probe feature"
+  QList< QgsSpatialJoinEngine::Predicate > predicates;
+  predicates.reserve( selectedPredicates.count() );
+  for ( const int predicate : selectedPredicates )
+  {
+    predicates << ( buildFromTarget ? toSpatialJoinPredicate( predicate ) : QgsSpatialJoinEngine::reversePredicate( toSpatialJoinPredicate( predicate ) ) );
+  }
+  QgsSpatialJoinEngine join( predicates );
+
+  QgsFeatureRequest targetRequest;
+  if ( onlyRequireTargetIds )
+    targetRequest.setNoAttributes();
+  const QgsFeatureRequest intersectRequest = QgsFeatureRequest().setNoAttributes().setDestinationCrs( mTargetCrs, context.transformContext() );
+
+  if ( buildFromTarget )
+  {
+    QgsFeatureIterator targetIt = targetSource->getFeatures( targetRequest );
+    if ( !join.loadBuildFeatures( targetIt, feedback ) )
+      return;
+
+    std::vector< bool > matched( static_cast< std::size_t >( join.buildFeatureCount() ), false );
+    QgsFeatureIterator intersectIt = intersectSource->getFeatures( intersectRequest );
+    join.probe( intersectIt, context.maximumThreads(), mIntersectFeatureCount, feedback, nullptr, [&]( const QgsFeature &, const QgsSpatialJoinEngine::Matches & matches )
+    {
+      for ( const int position : matches.matches )
+        matched[ static_cast< std::size_t >( position ) ] = true;
+    } );
+    if ( feedback->isCanceled() )
+      return;
+
+    for ( int position = 0; position < join.buildFeatureCount(); ++position )
+    {
+      const QgsFeature &f = join.buildFeature( position );
+      // don't check features in skipTargetFeatureIds
+      if ( skipTargetFeatureIds.contains( f.id() ) )
+        continue;
+
+      if ( matched[ static_cast< std::size_t >( position ) ] )
+        handleFeatureFunction( f );
+    }
+  }
+  else
+  {
+    QgsFeatureIterator intersectIt = intersectSource->getFeatures( intersectRequest );
+    if ( !join.loadBuildFeatures( intersectIt, feedback ) )
+      return;
+
+    // a single match is enough to handle a target feature
+    join.setFirstMatchOnly( true );
+    QgsFeatureIterator targetIt = targetSource->getFeatures( targetRequest );
+    join.probe( targetIt, context.maximumThreads(), mTargetFeatureCount, feedback, nullptr, [&]( const QgsFeature & f, const QgsSpatialJoinEngine::Matches & matches )
+    {
+      // don't check features in skipTargetFeatureIds
+      if ( skipTargetFeatureIds.contains( f.id() ) )
+        return;
+
+      if ( !matches.matches.isEmpty() || ( testDisjoint && matches.intersecting.isEmpty() ) )
+        handleFeatureFunction( f );
+    } );
+  }
+}
+
 void QgsLocationBasedAlgorithm::processByIteratingOverIntersectSource( const QgsProcessingContext &context, QgsFeatureSource *targetSource,
     QgsFeatureSource *intersectSource,
     const QList< int > &selectedPredicates,
@@ -22,6 +22,11 @@
 
 ///@cond PRIVATE
 
+QgsProcessingAlgorithm::Flags QgsForceRHRAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagThreadSafeFeatureProcessing | QgsProcessingAlgorithm::FlagSupportsCheckpoints;
+}
+
 QString QgsForceRHRAlgorithm::name() const
 {
   return QStringLiteral( "forcerhr" );
@@ -17,6 +17,7 @@
 
 #include "qgsalgorithmjoinbyattribute.h"
 #include "qgsprocessingoutputs.h"
+#include "qgsoutofcoreoperators.h"
 
 ///@cond PRIVATE
 
@@ -175,7 +176,14 @@ QVariantMap QgsJoinByAttributeAlgorithm::processAlgorithm( const QVariantMap &pa
   if ( parameters.value( QStringLiteral( "NON_MATCHING" ) ).isValid() && !sinkNonMatching1 )
     throw QgsProcessingException( invalidSinkError( parameters, QStringLiteral( "NON_MATCHING" ) ) );
 
-  // cache attributes of input2
+  // cache attributes of input2. With a memory budget, they are grouped by join value first, and
+  // spilled to disk if they exceed the budget. The budget is shared by the groupers of both inputs
+  // and the two sorters restoring the input order
+  const bool useMemoryBudget = context.memoryBudget() > 0;
+  std::unique_ptr< QgsSpillingFeatureGrouper > input2Grouper;
+  if ( useMemoryBudget )
+    input2Grouper = std::make_unique< QgsSpillingFeatureGrouper >( context, QgsFields(), input2->featureCount(), 4 );
+
   QMultiHash< QVariant, QgsAttributes > input2AttributeCache;
   QgsFeatureIterator features = input2->getFeatures( QgsFeatureRequest().setFlags( QgsFeatureRequest::NoGeometry ).setSubsetOfAttributes( fields2Fetch ), QgsProcessingFeatureSource::FlagSkipGeometryValidityChecks );
   double step = input2->featureCount() > 0 ? 50.0 / input2->featureCount() : 1;
@@ -191,7 +199,7 @@ QVariantMap QgsJoinByAttributeAlgorithm::processAlgorithm( const QVariantMap &pa
 
     feedback->setProgress( i * step );
 
-    if ( joinMethod == 1 && input2AttributeCache.contains( feat.attribute( joinField2Index ) ) )
+    if ( joinMethod == 1 && !useMemoryBudget && input2AttributeCache.contains( feat.attribute( joinField2Index ) ) )
       continue;
 
     // only keep selected attributes
@@ -203,41 +211,76 @@ QVariantMap QgsJoinByAttributeAlgorithm::processAlgorithm( const QVariantMap &pa
       attributes << feat.attribute( j );
     }
 
-    input2AttributeCache.insert( feat.attribute( joinField2Index ), attributes );
+    if ( useMemoryBudget )
+    {
+      QgsFeature cachedFeature;
+      cachedFeature.setAttributes( attributes );
+      input2Grouper->add( QVariantList() << feat.attribute( joinField2Index ), cachedFeature );
+    }
+    else
+    {
+      input2AttributeCache.insert( feat.attribute( joinField2Index ), attributes );
+    }
   }
 
-  // Create output vector layer with additional attribute
-  step = input->featureCount() > 0 ? 50.0 / input->featureCount() : 1;
-  features = input->getFeatures( QgsFeatureRequest(), QgsProcessingFeatureSource::FlagSkipGeometryValidityChecks );
-  i = 0;
-  long long joinedCount = 0;
-  long long unjoinedCount = 0;
-  while ( features.nextFeature( feat ) )
+  // fills the attribute cache from groups of input2 features, in the order the features were read
+  auto cacheGroups = [joinMethod]( const std::vector< QgsSpillingFeatureGrouper::Group > &groups, QMultiHash< QVariant, QgsAttributes > &cache )
   {
-    i++;
-    if ( feedback->isCanceled() )
+    for ( const QgsSpillingFeatureGrouper::Group &group : groups )
     {
-      break;
+      const int cachedCount = joinMethod == 1 ? 1 : group.features.size();
+      for ( int j = 0; j < cachedCount; ++j )
+        cache.insert( group.key.constFirst(), group.features.at( j ).attributes() );
     }
+  };
 
-    feedback->setProgress( 50 + i * step );
+  std::vector< QgsSpillingFeatureGrouper::Group > input2Groups;
+  if ( useMemoryBudget && !input2Grouper->hasSpilled() )
+  {
+    input2Grouper->nextGroups( input2Groups );
+    cacheGroups( input2Groups, input2AttributeCache );
+    input2Groups.clear();
+  }
+
+  // when input2 was spilled to disk, input features are joined one partition at a time, and the
+  // outputs are sorted back into the input order
+  const bool joinPartitions = useMemoryBudget && input2Grouper->hasSpilled();
+  std::unique_ptr< QgsExternalFeatureSorter > sorter;
+  std::unique_ptr< QgsExternalFeatureSorter > sorterNonMatching1;
+  if ( joinPartitions )
+  {
+    sorter = std::make_unique< QgsExternalFeatureSorter >( context, outFields, 4 );
+    sorterNonMatching1 = std::make_unique< QgsExternalFeatureSorter >( context, input->fields(), 4 );
+  }
+
+  long long joinedCount = 0;
+  long long unjoinedCount = 0;
 
-    if ( input2AttributeCache.count( feat.attribute( joinField1Index ) ) > 0 )
+  auto joinFeature = [&]( QgsFeature & feat, const QMultiHash< QVariant, QgsAttributes > &cache, qint64 sequence )
+  {
+    auto addFeature = [&parameters, sequence]( QgsFeatureSink * featureSink, QgsExternalFeatureSorter * featureSorter, const QgsFeature & feature, const QString & parameterName )
+    {
+      if ( featureSorter )
+        featureSorter->add( sequence, feature );
+      else if ( !featureSink->addFeature( feature, QgsFeatureSink::FastInsert ) )
+        throw QgsProcessingException( writeFeatureError( featureSink, parameters, parameterName ) );
+    };
+
+    if ( cache.count( feat.attribute( joinField1Index ) ) > 0 )
     {
       joinedCount++;
       if ( sink )
       {
         const QgsAttributes attrs = feat.attributes();
 
-        QList< QgsAttributes > attributes = input2AttributeCache.values( feat.attribute( joinField1Index ) );
+        QList< QgsAttributes > attributes = cache.values( feat.attribute( joinField1Index ) );
         QList< QgsAttributes >::iterator attrsIt = attributes.begin();
         for ( ; attrsIt != attributes.end(); ++attrsIt )
         {
           QgsAttributes newAttrs = attrs;
           newAttrs.append( *attrsIt );
           feat.setAttributes( newAttrs );
-          if ( !sink->addFeature( feat, QgsFeatureSink::FastInsert ) )
-            throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
+          addFeature( sink.get(), sorter.get(), feat, QStringLiteral( "OUTPUT" ) );
         }
       }
     }
@@ -246,16 +289,84 @@ QVariantMap QgsJoinByAttributeAlgorithm::processAlgorithm( const QVariantMap &pa
       // no matching for input feature
       if ( sink && !discardNonMatching )
       {
-        if ( !sink->addFeature( feat, QgsFeatureSink::FastInsert ) )
-          throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
+        addFeature( sink.get(), sorter.get(), feat, QStringLiteral( "OUTPUT" ) );
       }
       if ( sinkNonMatching1 )
       {
-        if ( !sinkNonMatching1->addFeature( feat, QgsFeatureSink::FastInsert ) )
-          throw QgsProcessingException( writeFeatureError( sinkNonMatching1.get(), parameters, QStringLiteral( "NON_MATCHING" ) ) );
+        addFeature( sinkNonMatching1.get(), sorterNonMatching1.get(), feat, QStringLiteral( "NON_MATCHING" ) );
       }
       unjoinedCount++;
     }
+  };
+
+  // Create output vector layer with additional attribute
+  step = input->featureCount() > 0 ? 50.0 / input->featureCount() : 1;
+  features = input->getFeatures( QgsFeatureRequest(), QgsProcessingFeatureSource::FlagSkipGeometryValidityChecks );
+  i = 0;
+  if ( !joinPartitions )
+  {
+    while ( features.nextFeature( feat ) )
+    {
+      i++;
+      if ( feedback->isCanceled() )
+      {
+        break;
+      }
+
+      feedback->setProgress( 50 + i * step );
+
+      joinFeature( feat, input2AttributeCache, i );
+    }
+  }
+  else
+  {
+    // partition the input features like the input2 ones, so that matching features are in partitions with the same index
+    QgsSpillingFeatureGrouper input1Grouper( context, input->fields(), input->featureCount(), 4 );
+    input1Grouper.spill( input2Grouper->partitionCount() );
+    while ( features.nextFeature( feat ) )
+    {
+      i++;
+      if ( feedback->isCanceled() )
+      {
+        break;
+      }
+
+      feedback->setProgress( 50 + i * step / 2 );
+
+      input1Grouper.add( QVariantList() << feat.attribute( joinField1Index ), feat );
+    }
+
+    const int partitionCount = input2Grouper->partitionCount();
+    int partition = 0;
+    std::vector< QgsSpillingFeatureGrouper::Group > input1Groups;
+    while ( !feedback->isCanceled() && input2Grouper->nextGroups( input2Groups ) && input1Grouper.nextGroups( input1Groups ) )
+    {
+      QMultiHash< QVariant, QgsAttributes > partitionCache;
+      cacheGroups( input2Groups, partitionCache );
+
+      for ( const QgsSpillingFeatureGrouper::Group &group : input1Groups )
+      {
+        for ( int j = 0; j < group.features.size(); ++j )
+        {
+          QgsFeature inputFeature = group.features.at( j );
+          joinFeature( inputFeature, partitionCache, group.sequences.at( j ) );
+        }
+      }
+
+      partition++;
+      feedback->setProgress( 75 + 15.0 * partition / partitionCount );
+    }
+
+    while ( sink && !feedback->isCanceled() && sorter->next( feat ) )
+    {
+      if ( !sink->addFeature( feat, QgsFeatureSink::FastInsert ) )
+        throw QgsProcessingException( writeFeatureError( sink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
+    }
+    while ( sinkNonMatching1 && !feedback->isCanceled() && sorterNonMatching1->next( feat ) )
+    {
+      if ( !sinkNonMatching1->addFeature( feat, QgsFeatureSink::FastInsert ) )
+        throw QgsProcessingException( writeFeatureError( sinkNonMatching1.get(), parameters, QStringLiteral( "NON_MATCHING" ) ) );
+    }
   }
 
   feedback->pushInfo( QObject::tr( "%n feature(s) from input layer were successfully matched", nullptr, joinedCount ) );
@@ -22,6 +22,7 @@
 #include "qgsapplication.h"
 #include "qgsfeature.h"
 #include "qgsfeaturesource.h"
+#include "qgsspatialjoinengine.h"
 
 ///@cond PRIVATE
 
@@ -180,32 +181,39 @@ QVariantMap QgsJoinByLocationAlgorithm::processAlgorithm( const QVariantMap &par
   if ( parameters.value( QStringLiteral( "NON_MATCHING" ) ).isValid() && !mUnjoinedFeatures )
     throw QgsProcessingException( invalidSinkError( parameters, QStringLiteral( "NON_MATCHING" ) ) );
 
-  switch ( mJoinMethod )
+  if ( context.maximumThreads() > 1 )
   {
-    case OneToMany:
-    case JoinToFirst:
+    processAlgorithmWithSpatialJoin( context, feedback );
+  }
+  else
+  {
+    switch ( mJoinMethod )
     {
-      if ( mBaseSource->featureCount() > 0 && mJoinSource->featureCount() > 0 && mBaseSource->featureCount() < mJoinSource->featureCount() )
-      {
-        // joining FEWER features to a layer with MORE features. So we iterate over the FEW features and find matches from the MANY
-        processAlgorithmByIteratingOverInputSource( context, feedback );
-      }
-      else
+      case OneToMany:
+      case JoinToFirst:
       {
-        // default -- iterate over the join source and match back to the base source. We do this on the assumption that the most common
-        // use case is joining a points layer to a polygon layer (taking polygon attributes and adding them to the points), so by iterating
-        // over the polygons we can take advantage of prepared geometries for the spatial relationship test.
+        if ( mBaseSource->featureCount() > 0 && mJoinSource->featureCount() > 0 && mBaseSource->featureCount() < mJoinSource->featureCount() )
+        {
+          // joining FEWER features to a layer with MORE features. So we iterate over the FEW features and find matches from the MANY
+          processAlgorithmByIteratingOverInputSource( context, feedback );
+        }
+        else
+        {
+          // default -- iterate over the join source and match back to the base source. We do this on the assumption that the most common
+          // use case is joining a points layer to a polygon layer (taking polygon attributes and adding them to the points), so by iterating
+          // over the polygons we can take advantage of prepared geometries for the spatial relationship test.
 
-        // TODO - consider using more heuristics to determine whether it's always best to iterate over the join
-        // source.
-        processAlgorithmByIteratingOverJoinedSource( context, feedback );
+          // TODO - consider using more heuristics to determine whether it's always best to iterate over the join
+          // source.
+          processAlgorithmByIteratingOverJoinedSource( context, feedback );
+        }
+        break;
       }
-      break;
-    }
 
-    case JoinToLargestOverlap:
-      processAlgorithmByIteratingOverInputSource( context, feedback );
-      break;
+      case JoinToLargestOverlap:
+        processAlgorithmByIteratingOverInputSource( context, feedback );
+        break;
+    }
   }
 
   QVariantMap outputs;
@@ -332,6 +340,11 @@ void QgsJoinByLocationAlgorithm::processAlgorithmByIteratingOverJoinedSource( Qg
     feedback->setProgress( i * step );
   }
 
+  processUnjoinedFeatures( feedback );
+}
+
+void QgsJoinByLocationAlgorithm::processUnjoinedFeatures( QgsProcessingFeedback *feedback )
+{
   if ( !mDiscardNonMatching || mUnjoinedFeatures )
   {
     QgsFeatureIds unjoinedIds = mBaseSource->allFeatureIds();
@@ -392,6 +405,187 @@ void QgsJoinByLocationAlgorithm::processAlgorithmByIteratingOverInputSource( Qgs
   }
 }
 
+void QgsJoinByLocationAlgorithm::processAlgorithmWithSpatialJoin( QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  // the features of the smaller source are loaded in memory with their prepared geometries, and the features of
+  // the other source are tested against them in parallel. Largest overlaps are computed for each base feature, so
+  // the base features are always tested against the join features in that case
+  const bool buildFromBase = mJoinMethod != JoinToLargestOverlap && mBaseSource->featureCount() > 0 && mJoinSource->featureCount() > 0
+                             && mBaseSource->featureCount() < mJoinSource->featureCount();
+
+  // predicates are tested as "build feature <predicate> probe feature", and mPredicates as "base feature <predicate> join feature"
+  QList< QgsSpatialJoinEngine::Predicate > predicates;
+  predicates.reserve( mPredicates.count() );
+  for ( const int predicate : std::as_const( mPredicates ) )
+  {
+    QgsSpatialJoinEngine::Predicate joinPredicate = QgsSpatialJoinEngine::Intersects;
+    switch ( predicate )
+    {
+      case 0:
+        joinPredicate = QgsSpatialJoinEngine::Intersects;
+        break;
+      case 1:
+        joinPredicate = QgsSpatialJoinEngine::Contains;
+        break;
+      case 2:
+        joinPredicate = QgsSpatialJoinEngine::IsEqual;
+        break;
+      case 3:
+        joinPredicate = QgsSpatialJoinEngine::Touches;
+        break;
+      case 4:
+        joinPredicate = QgsSpatialJoinEngine::Overlaps;
+        break;
+      case 5:
+        joinPredicate = QgsSpatialJoinEngine::Within;
+        break;
+      case 6:
+        joinPredicate = QgsSpatialJoinEngine::Crosses;
+        break;
+    }
+    predicates << ( buildFromBase ? joinPredicate : QgsSpatialJoinEngine::reversePredicate( joinPredicate ) );
+  }
+  QgsSpatialJoinEngine join( predicates );
+
+  const QgsFeatureRequest joinRequest = QgsFeatureRequest().setDestinationCrs( mBaseSource->sourceCrs(), context.transformContext() ).setSubsetOfAttributes( mJoinedFieldIndices );
+  const auto addJoinedFeature = [this]( const QgsFeature & baseFeature, const QgsFeature & joinFeature )
+  {
+    if ( !mJoinedFeatures )
+      return;
+
+    QgsAttributes joinAttributes = baseFeature.attributes();
+    joinAttributes.reserve( joinAttributes.size() + mJoinedFieldIndices.size() );
+    for ( int ix : std::as_const( mJoinedFieldIndices ) )
+    {
+      joinAttributes.append( joinFeature.attribute( ix ) );
+    }
+
+    QgsFeature outputFeature( baseFeature );
+    outputFeature.setAttributes( joinAttributes );
+    if ( !mJoinedFeatures->addFeature( outputFeature, QgsFeatureSink::FastInsert ) )
+      throw QgsProcessingException( writeFeatureError( mJoinedFeatures.get(), QVariantMap(), QStringLiteral( "OUTPUT" ) ) );
+  };
+
+  if ( buildFromBase )
+  {
+    QgsFeatureIterator baseIt = mBaseSource->getFeatures();
+    if ( !join.loadBuildFeatures( baseIt, feedback ) )
+      return;
+
+    QgsFeatureIterator joinIt = mJoinSource->getFeatures( joinRequest );
+    join.probe( joinIt, context.maximumThreads(), mJoinSource->featureCount(), feedback, nullptr, [&]( const QgsFeature & joinFeature, const QgsSpatialJoinEngine::Matches & matches )
+    {
+      for ( const int position : matches.matches )
+      {
+        const QgsFeature &baseFeature = join.buildFeature( position );
+        if ( mJoinMethod == JoinToFirst && mAddedIds.contains( baseFeature.id() ) )
+        {
+          //  already added this feature, and user has opted to only output first match
+          continue;
+        }
+
+        addJoinedFeature( baseFeature, joinFeature );
+        mAddedIds.insert( baseFeature.id() );
+        mJoinedCount++;
+      }
+    } );
+    if ( feedback->isCanceled() )
+      return;
+
+    processUnjoinedFeatures( feedback );
+  }
+  else
+  {
+    QgsFeatureIterator joinIt = mJoinSource->getFeatures( joinRequest );
+    if ( !join.loadBuildFeatures( joinIt, feedback ) )
+      return;
+
+    join.setFirstMatchOnly( mJoinMethod == JoinToFirst );
+
+    // keeps the matching join feature with the largest overlap
+    const auto keepLargestOverlap = [&join]( const QgsFeature & baseFeature, QgsSpatialJoinEngine::Matches & matches )
+    {
+      if ( matches.matches.size() < 2 )
+        return;
+
+      std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( baseFeature.geometry().constGet() ) );
+      engine->prepareGeometry();
+      double largestOverlap = std::numeric_limits< double >::lowest();
+      int bestMatch = matches.matches.constFirst();
+      for ( const int position : std::as_const( matches.matches ) )
+      {
+        // calculate area of overlap
+        std::unique_ptr< QgsAbstractGeometry > intersection( engine->intersection( join.buildFeature( position ).geometry().constGet() ) );
+        double overlap = 0;
+        switch ( intersection ? QgsWkbTypes::geometryType( intersection->wkbType() ) : Qgis::GeometryType::Null )
+        {
+          case Qgis::GeometryType::Line:
+            overlap = intersection->length();
+            break;
+
+          case Qgis::GeometryType::Polygon:
+            overlap = intersection->area();
+            break;
+
+          case Qgis::GeometryType::Unknown:
+          case Qgis::GeometryType::Point:
+          case Qgis::GeometryType::Null:
+            break;
+        }
+
+        if ( overlap > largestOverlap )
+        {
+          largestOverlap = overlap;
+          bestMatch = position;
+        }
+      }
+      matches.matches = QVector< int >() << bestMatch;
+    };
+
+    QgsFeatureIterator baseIt = mBaseSource->getFeatures();
+    join.probe( baseIt, context.maximumThreads(), mBaseSource->featureCount(), feedback,
+                mJoinMethod == JoinToLargestOverlap ? keepLargestOverlap : std::function< void( const QgsFeature &, QgsSpatialJoinEngine::Matches & ) >(),
+                [&]( const QgsFeature & baseFeature, const QgsSpatialJoinEngine::Matches & matches )
+    {
+      if ( matches.matches.isEmpty() )
+      {
+        addUnjoinedFeature( baseFeature );
+        return;
+      }
+
+      for ( const int position : matches.matches )
+      {
+        addJoinedFeature( baseFeature, join.buildFeature( position ) );
+      }
+      mJoinedCount++;
+    } );
+  }
+}
+
+void QgsJoinByLocationAlgorithm::addUnjoinedFeature( const QgsFeature &baseFeature )
+{
+  if ( mJoinedFeatures && !mDiscardNonMatching )
+  {
+    QgsAttributes emptyAttributes;
+    emptyAttributes.reserve( mJoinedFieldIndices.count() );
+    for ( int i = 0; i < mJoinedFieldIndices.count(); ++i )
+      emptyAttributes << QVariant();
+
+    QgsAttributes attributes = baseFeature.attributes();
+    attributes.append( emptyAttributes );
+    QgsFeature outputFeature( baseFeature );
+    outputFeature.setAttributes( attributes );
+    if ( !mJoinedFeatures->addFeature( outputFeature, QgsFeatureSink::FastInsert ) )
+      throw QgsProcessingException( writeFeatureError( mJoinedFeatures.get(), QVariantMap(), QStringLiteral( "OUTPUT" ) ) );
+  }
+
+  if ( mUnjoinedFeatures )
+  {
+    if ( !mUnjoinedFeatures->addFeature( baseFeature, QgsFeatureSink::FastInsert ) )
+      throw QgsProcessingException( writeFeatureError( mUnjoinedFeatures.get(), QVariantMap(), QStringLiteral( "NON_MATCHING" ) ) );
+  }
+}
+
 void QgsJoinByLocationAlgorithm::sortPredicates( QList<int> &predicates )
 {
   // Sort predicate list so that faster predicates are earlier in the list
@@ -58,6 +58,9 @@ class QgsJoinByLocationAlgorithm : public QgsProcessingAlgorithm
 
     void processAlgorithmByIteratingOverJoinedSource( QgsProcessingContext &context, QgsProcessingFeedback *feedback );
     void processAlgorithmByIteratingOverInputSource( QgsProcessingContext &context, QgsProcessingFeedback *feedback );
+    void processAlgorithmWithSpatialJoin( QgsProcessingContext &context, QgsProcessingFeedback *feedback );
+    void processUnjoinedFeatures( QgsProcessingFeedback *feedback );
+    void addUnjoinedFeature( const QgsFeature &baseFeature );
 
     enum JoinMethod
     {
@@ -16,12 +16,71 @@
  ***************************************************************************/
 
 #include "qgsalgorithmkmeansclustering.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
 #include <unordered_map>
 
 ///@cond PRIVATE
 
 const int KMEANS_MAX_ITERATIONS = 1000;
 
+// points are processed in chunks of a fixed size, so that results don't depend on the number of threads
+const std::size_t KMEANS_CHUNK_SIZE = 65536;
+
+// mini-batch clustering stops once no center moves further than this fraction of the diagonal of the points extent
+const double KMEANS_MINI_BATCH_TOLERANCE = 1e-4;
+
+//! Calls \a function( begin, end, chunk ) for the chunks of \a count items, using up to \a threads threads
+static void forEachChunk( std::size_t count, int threads, const std::function< void( std::size_t, std::size_t, std::size_t ) > &function )
+{
+  const std::size_t chunkCount = ( count + KMEANS_CHUNK_SIZE - 1 ) / KMEANS_CHUNK_SIZE;
+  if ( threads <= 1 || chunkCount <= 1 )
+  {
+    for ( std::size_t chunk = 0; chunk < chunkCount; ++chunk )
+      function( chunk * KMEANS_CHUNK_SIZE, std::min( count, ( chunk + 1 ) * KMEANS_CHUNK_SIZE ), chunk );
+    return;
+  }
+
+  QThreadPool pool;
+  pool.setMaxThreadCount( threads );
+  QList< QFuture< void > > futures;
+  for ( std::size_t chunk = 0; chunk < chunkCount; ++chunk )
+  {
+    futures << QtConcurrent::run( &pool, [&function, count, chunk]
+    {
+      function( chunk * KMEANS_CHUNK_SIZE, std::min( count, ( chunk + 1 ) * KMEANS_CHUNK_SIZE ), chunk );
+    } );
+  }
+  for ( QFuture< void > &future : futures )
+    future.waitForFinished();
+}
+
+//! Returns the index of the center nearest to ( \a x, \a y ), the first one in case of ties
+static int nearestCenter( double x, double y, const std::vector< double > &centerX, const std::vector< double > &centerY, std::vector< double > &distances )
+{
+  // squared distances to all the centers first, in a loop compilers can vectorize
+  const std::size_t k = centerX.size();
+  const double *cx = centerX.data();
+  const double *cy = centerY.data();
+  double *d = distances.data();
+  for ( std::size_t cluster = 0; cluster < k; cluster++ )
+  {
+    d[cluster] = ( x - cx[cluster] ) * ( x - cx[cluster] ) + ( y - cy[cluster] ) * ( y - cy[cluster] );
+  }
+
+  int nearest = 0;
+  for ( std::size_t cluster = 1; cluster < k; cluster++ )
+  {
+    if ( d[cluster] < d[nearest] )
+      nearest = static_cast< int >( cluster );
+  }
+  return nearest;
+}
+
 QString QgsKMeansClusteringAlgorithm::name() const
 {
   return QStringLiteral( "kmeansclustering" );
@@ -63,13 +122,29 @@ void QgsKMeansClusteringAlgorithm::initAlgorithm( const QVariantMap & )
   sizeFieldNameParam->setFlags( sizeFieldNameParam->flags() | QgsProcessingParameterDefinition::FlagAdvanced );
   addParameter( sizeFieldNameParam.release() );
 
+  auto initParam = std::make_unique<QgsProcessingParameterEnum>( QStringLiteral( "INIT" ), QObject::tr( "Initialization method" ),
+                   QStringList() << QObject::tr( "Farthest points" ) << QObject::tr( "K-means++" ), false, 0 );
+  initParam->setFlags( initParam->flags() | QgsProcessingParameterDefinition::FlagAdvanced );
+  addParameter( initParam.release() );
+  auto miniBatchParam = std::make_unique<QgsProcessingParameterNumber>( QStringLiteral( "MINI_BATCH_SIZE" ),
+                        QObject::tr( "Mini-batch size (0 to use all points at each iteration)" ), QgsProcessingParameterNumber::Integer, 0, false, 0 );
+  miniBatchParam->setFlags( miniBatchParam->flags() | QgsProcessingParameterDefinition::FlagAdvanced );
+  addParameter( miniBatchParam.release() );
+  auto randomSeedParam = std::make_unique<QgsProcessingParameterNumber>( QStringLiteral( "SEED" ), QObject::tr( "Random seed" ),
+                         QgsProcessingParameterNumber::Integer, QVariant(), true, 1 );
+  randomSeedParam->setFlags( randomSeedParam->flags() | QgsProcessingParameterDefinition::FlagAdvanced );
+  addParameter( randomSeedParam.release() );
+
   addParameter( new QgsProcessingParameterFeatureSink( QStringLiteral( "OUTPUT" ), QObject::tr( "Clusters" ), QgsProcessing::TypeVectorAnyGeometry ) );
 }
 
 QString QgsKMeansClusteringAlgorithm::shortHelpString() const
 {
   return QObject::tr( "Calculates the 2D distance based k-means cluster number for each input feature.\n\n"
-                      "If input geometries are lines or polygons, the clustering is based on the centroid of the feature." );
+                      "If input geometries are lines or polygons, the clustering is based on the centroid of the feature.\n\n"
+                      "The initial cluster centers are either the points farthest from each other, or picked randomly with the k-means++ method. "
+                      "With a mini-batch size, the cluster centers are computed from random batches of points, which is much faster for large inputs but less accurate. "
+                      "A random seed makes the k-means++ and mini-batch results reproducible." );
 }
 
 QgsKMeansClusteringAlgorithm *QgsKMeansClusteringAlgorithm::createInstance() const
@@ -84,6 +159,10 @@ QVariantMap QgsKMeansClusteringAlgorithm::processAlgorithm( const QVariantMap &p
     throw QgsProcessingException( invalidSourceError( parameters, QStringLiteral( "INPUT" ) ) );
 
   int k = parameterAsInt( parameters, QStringLiteral( "CLUSTERS" ), context );
+  const int initialization = parameterAsEnum( parameters, QStringLiteral( "INIT" ), context );
+  const std::size_t miniBatchSize = static_cast< std::size_t >( parameterAsInt( parameters, QStringLiteral( "MINI_BATCH_SIZE" ), context ) );
+  const bool useRandomSeed = parameters.value( QStringLiteral( "SEED" ) ).isValid();
+  const int randomSeed = parameterAsInt( parameters, QStringLiteral( "SEED" ), context );
 
   QgsFields outputFields = source->fields();
   QgsFields newFields;
@@ -153,8 +232,19 @@ QVariantMap QgsKMeansClusteringAlgorithm::processAlgorithm( const QVariantMap &p
     // cluster centers
     std::vector< QgsPointXY > centers( k );
 
-    initClusters( clusterFeatures, centers, k, feedback );
-    calculateKMeans( clusterFeatures, centers, k, feedback );
+    std::random_device randomDevice;
+    std::mt19937 generator( useRandomSeed ? static_cast< std::mt19937::result_type >( randomSeed ) : randomDevice() );
+    const int threads = context.maximumThreads();
+
+    if ( initialization == 1 )
+      initClustersPlusPlus( clusterFeatures, centers, k, generator, threads );
+    else
+      initClusters( clusterFeatures, centers, k, feedback );
+
+    if ( miniBatchSize > 0 && miniBatchSize < clusterFeatures.size() )
+      calculateMiniBatchKMeans( clusterFeatures, centers, k, miniBatchSize, generator, feedback, threads );
+    else
+      calculateKMeans( clusterFeatures, centers, k, feedback, threads );
   }
 
   // cluster size
@@ -300,9 +390,70 @@ void QgsKMeansClusteringAlgorithm::initClusters( std::vector<Feature> &points, s
   }
 }
 
+void QgsKMeansClusteringAlgorithm::initClustersPlusPlus( const std::vector<Feature> &points, std::vector<QgsPointXY> &centers, const int k, std::mt19937 &generator, const int threads )
+{
+  const std::size_t n = points.size();
+  if ( n == 0 )
+    return;
+
+  centers[0] = points[ std::uniform_int_distribution< std::size_t >( 0, n - 1 )( generator ) ].point;
+
+  // squared distance from each point to its nearest center, and its sum for each chunk of points
+  std::vector< double > distances( n );
+  std::vector< double > chunkSums( ( n + KMEANS_CHUNK_SIZE - 1 ) / KMEANS_CHUNK_SIZE );
+  for ( int i = 1; i < k; i++ )
+  {
+    const QgsPointXY &center = centers[i - 1];
+    forEachChunk( n, threads, [&]( std::size_t begin, std::size_t end, std::size_t chunk )
+    {
+      double sum = 0;
+      for ( std::size_t j = begin; j < end; j++ )
+      {
+        const double distance = points[j].point.sqrDist( center );
+        if ( i == 1 || distance < distances[j] )
+          distances[j] = distance;
+        sum += distances[j];
+      }
+      chunkSums[chunk] = sum;
+    } );
+
+    double total = 0;
+    for ( const double sum : std::as_const( chunkSums ) )
+      total += sum;
+
+    if ( total <= 0 )
+    {
+      // all points are duplicates of the centers, the extra clusters stay empty
+      centers[i] = centers[i - 1];
+      continue;
+    }
+
+    // pick a point with a probability proportional to its distance, walking chunks first
+    double remaining = std::uniform_real_distribution< double >( 0, total )( generator );
+    std::size_t chunk = 0;
+    while ( chunk + 1 < chunkSums.size() && remaining >= chunkSums[chunk] )
+    {
+      remaining -= chunkSums[chunk];
+      chunk++;
+    }
+    const std::size_t end = std::min( n, ( chunk + 1 ) * KMEANS_CHUNK_SIZE );
+    std::size_t candidateCenter = chunk * KMEANS_CHUNK_SIZE;
+    for ( std::size_t j = candidateCenter; j < end; j++ )
+    {
+      if ( distances[j] <= 0 )
+        continue;
+      candidateCenter = j;
+      if ( remaining < distances[j] )
+        break;
+      remaining -= distances[j];
+    }
+    centers[i] = points[candidateCenter].point;
+  }
+}
+
 // ported from https://github.com/postgis/postgis/blob/svn-trunk/liblwgeom/lwkmeans.c
 
-void QgsKMeansClusteringAlgorithm::calculateKMeans( std::vector<QgsKMeansClusteringAlgorithm::Feature> &objs, std::vector<QgsPointXY> &centers, int k, QgsProcessingFeedback *feedback )
+void QgsKMeansClusteringAlgorithm::calculateKMeans( std::vector<QgsKMeansClusteringAlgorithm::Feature> &objs, std::vector<QgsPointXY> &centers, int k, QgsProcessingFeedback *feedback, int threads )
 {
   int converged = false;
   bool changed = false;
@@ -316,8 +467,8 @@ void QgsKMeansClusteringAlgorithm::calculateKMeans( std::vector<QgsKMeansCluster
     if ( feedback && feedback->isCanceled() )
       break;
 
-    findNearest( objs, centers, k, changed );
-    updateMeans( objs, centers, weights, k );
+    findNearest( objs, centers, k, changed, threads );
+    updateMeans( objs, centers, weights, k, threads );
     converged = !changed;
   }
 
@@ -327,57 +478,158 @@ void QgsKMeansClusteringAlgorithm::calculateKMeans( std::vector<QgsKMeansCluster
     feedback->pushInfo( QObject::tr( "Clustering converged after %n iteration(s)", nullptr, i ) );
 }
 
-// ported from https://github.com/postgis/postgis/blob/svn-trunk/liblwgeom/lwkmeans.c
-
-void QgsKMeansClusteringAlgorithm::findNearest( std::vector<QgsKMeansClusteringAlgorithm::Feature> &points, const std::vector<QgsPointXY> &centers, const int k, bool &changed )
+void QgsKMeansClusteringAlgorithm::calculateMiniBatchKMeans( std::vector<Feature> &points, std::vector<QgsPointXY> &centers, const int k, const std::size_t batchSize,
+    std::mt19937 &generator, QgsProcessingFeedback *feedback, const int threads )
 {
-  changed = false;
+  // Sculley, "Web-scale k-means clustering", 2010
   const std::size_t n = points.size();
-  for ( std::size_t i = 0; i < n; i++ )
+  if ( n == 0 )
+    return;
+
+  QgsRectangle extent;
+  extent.setMinimal();
+  for ( const Feature &point : points )
+    extent.include( point.point );
+  const double tolerance = KMEANS_MINI_BATCH_TOLERANCE * std::sqrt( extent.width() * extent.width() + extent.height() * extent.height() );
+
+  std::vector< double > centerX( k );
+  std::vector< double > centerY( k );
+  for ( int cluster = 0; cluster < k; cluster++ )
   {
-    Feature &point = points[i];
+    centerX[cluster] = centers[cluster].x();
+    centerY[cluster] = centers[cluster].y();
+  }
 
-    // Initialize with distance to first cluster
-    double currentDistance = point.point.sqrDist( centers[0] );
-    int currentCluster = 0;
+  // number of points a center was moved towards, which sets how far the next point moves it
+  std::vector< uint > counts( k, 0 );
+  std::vector< std::size_t > batch( batchSize );
+  std::vector< int > batchClusters( batchSize );
+  std::uniform_int_distribution< std::size_t > pickPoint( 0, n - 1 );
+
+  bool converged = false;
+  uint i = 0;
+  for ( i = 0; i < KMEANS_MAX_ITERATIONS && !converged; i++ )
+  {
+    if ( feedback && feedback->isCanceled() )
+      break;
 
-    // Check all other cluster centers and find the nearest
-    for ( int cluster = 1; cluster < k; cluster++ )
+    for ( std::size_t &position : batch )
+      position = pickPoint( generator );
+
+    forEachChunk( batchSize, threads, [&]( std::size_t begin, std::size_t end, std::size_t )
     {
-      const double distance = point.point.sqrDist( centers[cluster] );
-      if ( distance < currentDistance )
+      std::vector< double > distances( k );
+      for ( std::size_t j = begin; j < end; j++ )
       {
-        currentDistance = distance;
-        currentCluster = cluster;
+        const QgsPointXY &point = points[ batch[j] ].point;
+        batchClusters[j] = nearestCenter( point.x(), point.y(), centerX, centerY, distances );
       }
+    } );
+
+    const std::vector< double > previousX = centerX;
+    const std::vector< double > previousY = centerY;
+    for ( std::size_t j = 0; j < batchSize; j++ )
+    {
+      const int cluster = batchClusters[j];
+      const QgsPointXY &point = points[ batch[j] ].point;
+      const double rate = 1.0 / ++counts[cluster];
+      centerX[cluster] += rate * ( point.x() - centerX[cluster] );
+      centerY[cluster] += rate * ( point.y() - centerY[cluster] );
     }
 
-    // Store the nearest cluster this object is in
-    if ( point.cluster != currentCluster )
+    converged = true;
+    for ( int cluster = 0; cluster < k && converged; cluster++ )
     {
-      changed = true;
-      point.cluster = currentCluster;
+      const double dx = centerX[cluster] - previousX[cluster];
+      const double dy = centerY[cluster] - previousY[cluster];
+      converged = dx * dx + dy * dy <= tolerance * tolerance;
     }
   }
+
+  if ( !converged && feedback )
+    feedback->reportError( QObject::tr( "Clustering did not converge after %n iteration(s)", nullptr, i ) );
+  else if ( feedback )
+    feedback->pushInfo( QObject::tr( "Clustering converged after %n iteration(s)", nullptr, i ) );
+
+  for ( int cluster = 0; cluster < k; cluster++ )
+    centers[cluster] = QgsPointXY( centerX[cluster], centerY[cluster] );
+
+  bool changed = false;
+  findNearest( points, centers, k, changed, threads );
 }
 
 // ported from https://github.com/postgis/postgis/blob/svn-trunk/liblwgeom/lwkmeans.c
 
-void QgsKMeansClusteringAlgorithm::updateMeans( const std::vector<Feature> &points, std::vector<QgsPointXY> &centers, std::vector<uint> &weights, const int k )
+void QgsKMeansClusteringAlgorithm::findNearest( std::vector<QgsKMeansClusteringAlgorithm::Feature> &points, const std::vector<QgsPointXY> &centers, const int k, bool &changed, const int threads )
 {
-  const uint n = points.size();
+  std::vector< double > centerX( k );
+  std::vector< double > centerY( k );
+  for ( int cluster = 0; cluster < k; cluster++ )
+  {
+    centerX[cluster] = centers[cluster].x();
+    centerY[cluster] = centers[cluster].y();
+  }
+
+  const std::size_t n = points.size();
+  std::vector< char > chunkChanged( ( n + KMEANS_CHUNK_SIZE - 1 ) / KMEANS_CHUNK_SIZE, false );
+  forEachChunk( n, threads, [&]( std::size_t begin, std::size_t end, std::size_t chunk )
+  {
+    std::vector< double > distances( k );
+    for ( std::size_t i = begin; i < end; i++ )
+    {
+      Feature &point = points[i];
+
+      // Find the nearest cluster center
+      const int currentCluster = nearestCenter( point.point.x(), point.point.y(), centerX, centerY, distances );
+
+      // Store the nearest cluster this object is in
+      if ( point.cluster != currentCluster )
+      {
+        chunkChanged[chunk] = true;
+        point.cluster = currentCluster;
+      }
+    }
+  } );
+
+  changed = std::find( chunkChanged.begin(), chunkChanged.end(), true ) != chunkChanged.end();
+}
+
+// ported from https://github.com/postgis/postgis/blob/svn-trunk/liblwgeom/lwkmeans.c
+
+void QgsKMeansClusteringAlgorithm::updateMeans( const std::vector<Feature> &points, std::vector<QgsPointXY> &centers, std::vector<uint> &weights, const int k, const int threads )
+{
+  // sums of the coordinates of each chunk of points, added in chunk order
+  const std::size_t n = points.size();
+  const std::size_t chunkCount = ( n + KMEANS_CHUNK_SIZE - 1 ) / KMEANS_CHUNK_SIZE;
+  std::vector< double > sumX( chunkCount * k, 0.0 );
+  std::vector< double > sumY( chunkCount * k, 0.0 );
+  std::vector< uint > chunkWeights( chunkCount * k, 0 );
+  forEachChunk( n, threads, [&]( std::size_t begin, std::size_t end, std::size_t chunk )
+  {
+    const std::size_t offset = chunk * k;
+    for ( std::size_t i = begin; i < end; i++ )
+    {
+      const std::size_t cluster = offset + points[i].cluster;
+      sumX[cluster] += points[i].point.x();
+      sumY[cluster] += points[i].point.y();
+      chunkWeights[cluster] += 1;
+    }
+  } );
+
   std::fill( weights.begin(), weights.end(), 0 );
   for ( int i = 0; i < k; i++ )
   {
     centers[i].setX( 0.0 );
     centers[i].setY( 0.0 );
   }
-  for ( uint i = 0; i < n; i++ )
+  for ( std::size_t chunk = 0; chunk < chunkCount; chunk++ )
   {
-    const int cluster = points[i].cluster;
-    centers[cluster] += QgsVector( points[i].point.x(),
-                                   points[i].point.y() );
-    weights[cluster] += 1;
+    for ( int i = 0; i < k; i++ )
+    {
+      const std::size_t cluster = chunk * k + i;
+      centers[i] += QgsVector( sumX[cluster], sumY[cluster] );
+      weights[i] += chunkWeights[cluster];
+    }
   }
   for ( int i = 0; i < k; i++ )
   {
@@ -24,6 +24,8 @@
 #include "qgis_analysis.h"
 #include "qgsprocessingalgorithm.h"
 
+#include <random>
+
 ///@cond PRIVATE
 
 
@@ -63,9 +65,24 @@ class ANALYSIS_EXPORT QgsKMeansClusteringAlgorithm : public QgsProcessingAlgorit
     };
 
     static void initClusters( std::vector< Feature > &points, std::vector< QgsPointXY > &centers, int k, QgsProcessingFeedback *feedback );
-    static void calculateKMeans( std::vector< Feature > &points, std::vector< QgsPointXY > &centers, int k, QgsProcessingFeedback *feedback );
-    static void findNearest( std::vector< Feature > &points, const std::vector< QgsPointXY > &centers, int k, bool &changed );
-    static void updateMeans( const std::vector< Feature > &points, std::vector< QgsPointXY > &centers, std::vector< uint > &weights, int k );
+
+    /**
+     * Initializes the \a k \a centers with k-means++: each center is a point picked with a probability
+     * proportional to its squared distance to the nearest center already picked.
+     */
+    static void initClustersPlusPlus( const std::vector< Feature > &points, std::vector< QgsPointXY > &centers, int k, std::mt19937 &generator, int threads = 1 );
+
+    static void calculateKMeans( std::vector< Feature > &points, std::vector< QgsPointXY > &centers, int k, QgsProcessingFeedback *feedback, int threads = 1 );
+
+    /**
+     * Moves the \a centers towards random batches of \a batchSize points until they are stable, then assigns
+     * all the points to their nearest center.
+     */
+    static void calculateMiniBatchKMeans( std::vector< Feature > &points, std::vector< QgsPointXY > &centers, int k, std::size_t batchSize,
+                                          std::mt19937 &generator, QgsProcessingFeedback *feedback, int threads = 1 );
+
+    static void findNearest( std::vector< Feature > &points, const std::vector< QgsPointXY > &centers, int k, bool &changed, int threads = 1 );
+    static void updateMeans( const std::vector< Feature > &points, std::vector< QgsPointXY > &centers, std::vector< uint > &weights, int k, int threads = 1 );
 
     friend class TestQgsProcessingAlgsPt1;
 };
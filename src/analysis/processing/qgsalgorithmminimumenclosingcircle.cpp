@@ -20,6 +20,11 @@
 
 ///@cond PRIVATE
 
+QgsProcessingAlgorithm::Flags QgsMinimumEnclosingCircleAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagThreadSafeFeatureProcessing | QgsProcessingAlgorithm::FlagSupportsCheckpoints;
+}
+
 QString QgsMinimumEnclosingCircleAlgorithm::name() const
 {
   return QStringLiteral( "minimumenclosingcircle" );
@@ -34,6 +34,7 @@ class QgsMinimumEnclosingCircleAlgorithm : public QgsProcessingFeatureBasedAlgor
   public:
 
     QgsMinimumEnclosingCircleAlgorithm() = default;
+    QgsProcessingAlgorithm::Flags flags() const override;
     void initParameters( const QVariantMap &configuration = QVariantMap() ) override;
     QString name() const override;
     QString displayName() const override;
@@ -23,6 +23,11 @@
 
 ///@cond PRIVATE
 
+QgsProcessingAlgorithm::Flags QgsPolygonsToLinesAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagThreadSafeFeatureProcessing | QgsProcessingAlgorithm::FlagSupportsCheckpoints;
+}
+
 QString QgsPolygonsToLinesAlgorithm::name() const
 {
   return QStringLiteral( "polygonstolines" );
@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgsalgorithmremoveduplicatesbyattribute.h"
+#include "qgsoutofcoreoperators.h"
 
 ///@cond PRIVATE
 
@@ -116,6 +117,14 @@ QVariantMap QgsRemoveDuplicatesByAttributeAlgorithm::processAlgorithm( const QVa
 
   QSet< QVariantList > matched;
 
+  // with a memory budget, the features are grouped by key and spilled to disk if they exceed the budget,
+  // then the first feature of each group is kept. The grouper and the two sorters restoring the input order
+  // share the budget
+  const bool useMemoryBudget = context.memoryBudget() > 0;
+  std::unique_ptr< QgsSpillingFeatureGrouper > grouper;
+  if ( useMemoryBudget )
+    grouper = std::make_unique< QgsSpillingFeatureGrouper >( context, source->fields(), count, 3 );
+
   QgsFeatureIterator it = source->getFeatures( QgsFeatureRequest(), QgsProcessingFeatureSource::FlagSkipGeometryValidityChecks );
   QgsFeature f;
 
@@ -138,7 +147,11 @@ QVariantMap QgsRemoveDuplicatesByAttributeAlgorithm::processAlgorithm( const QVa
     for ( const int attr : attributes )
       dupeKey[i++] = f.attribute( attr );
 
-    if ( matched.contains( dupeKey ) )
+    if ( useMemoryBudget )
+    {
+      grouper->add( dupeKey, f );
+    }
+    else if ( matched.contains( dupeKey ) )
     {
       // duplicate
       discardedCount++;
@@ -157,10 +170,52 @@ QVariantMap QgsRemoveDuplicatesByAttributeAlgorithm::processAlgorithm( const QVa
         throw QgsProcessingException( writeFeatureError( noDupeSink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
     }
 
-    feedback->setProgress( current * step );
+    feedback->setProgress( ( useMemoryBudget ? 0.5 : 1.0 ) * current * step );
     current++;
   }
 
+  if ( useMemoryBudget && !feedback->isCanceled() )
+  {
+    // both outputs are sorted back into the input order
+    QgsExternalFeatureSorter noDupeSorter( context, source->fields(), 3 );
+    QgsExternalFeatureSorter dupeSorter( context, source->fields(), 3 );
+
+    const int partitionCount = grouper->partitionCount();
+    int partition = 0;
+    std::vector< QgsSpillingFeatureGrouper::Group > groups;
+    while ( grouper->nextGroups( groups ) )
+    {
+      for ( const QgsSpillingFeatureGrouper::Group &group : groups )
+      {
+        keptCount++;
+        noDupeSorter.add( group.sequences.constFirst(), group.features.constFirst() );
+
+        discardedCount += group.features.size() - 1;
+        if ( dupesSink )
+        {
+          for ( int i = 1; i < group.features.size(); ++i )
+            dupeSorter.add( group.sequences.at( i ), group.features.at( i ) );
+        }
+      }
+      partition++;
+      feedback->setProgress( 50 + 25.0 * partition / partitionCount );
+      if ( feedback->isCanceled() )
+        break;
+    }
+
+    while ( !feedback->isCanceled() && noDupeSorter.next( f ) )
+    {
+      if ( !noDupeSink->addFeature( f, QgsFeatureSink::FastInsert ) )
+        throw QgsProcessingException( writeFeatureError( noDupeSink.get(), parameters, QStringLiteral( "OUTPUT" ) ) );
+    }
+    feedback->setProgress( 90 );
+    while ( dupesSink && !feedback->isCanceled() && dupeSorter.next( f ) )
+    {
+      if ( !dupesSink->addFeature( f, QgsFeatureSink::FastInsert ) )
+        throw QgsProcessingException( writeFeatureError( dupesSink.get(), parameters, QStringLiteral( "DUPLICATES" ) ) );
+    }
+  }
+
   QVariantMap outputs;
   outputs.insert( QStringLiteral( "RETAINED_COUNT" ), keptCount );
   outputs.insert( QStringLiteral( "DUPLICATE_COUNT" ), discardedCount );
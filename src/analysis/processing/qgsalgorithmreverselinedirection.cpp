@@ -21,6 +21,11 @@
 
 ///@cond PRIVATE
 
+QgsProcessingAlgorithm::Flags QgsReverseLineDirectionAlgorithm::flags() const
+{
+  return QgsProcessingFeatureBasedAlgorithm::flags() | QgsProcessingAlgorithm::FlagThreadSafeFeatureProcessing | QgsProcessingAlgorithm::FlagSupportsCheckpoints;
+}
+
 QString QgsReverseLineDirectionAlgorithm ::name() const
 {
   return QStringLiteral( "reverselinedirection" );
@@ -0,0 +1,542 @@
+/***************************************************************************
+                         qgsoutofcoreoperators.cpp
+                         -------------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsoutofcoreoperators.h"
+#include "qgsabstractgeometry.h"
+#include "qgsexception.h"
+#include "qgsgeometry.h"
+#include "qgsprocessingcontext.h"
+#include "qgsprocessingutils.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QFile>
+#include <QDir>
+#include <QTemporaryFile>
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+///@cond PRIVATE
+
+//! Types of the key values written to spill files
+enum class QgsSpillKeyValueType : quint8
+{
+  Variant, //!< Value of a built-in type, written with the QVariant stream operator
+  List, //!< List of values, each of them written like a key value
+  Map, //!< Map of values, each of them written like a key value
+  Geometry, //!< Geometry, written as WKB
+  String, //!< Value of another type, written as its string representation
+};
+
+/**
+ * Writes a key \a value to a \a stream.
+ *
+ * Keys can hold values without QDataStream operators, such as geometries returned by a group by expression,
+ * which can't be streamed as a QVariant: geometries are written as WKB, and values of other custom types as
+ * their string representation.
+ */
+static void writeKeyValue( QDataStream &stream, const QVariant &value )
+{
+  if ( value.userType() == QMetaType::QVariantList )
+  {
+    const QVariantList list = value.toList();
+    stream << static_cast< quint8 >( QgsSpillKeyValueType::List ) << static_cast< qint32 >( list.size() );
+    for ( const QVariant &item : list )
+      writeKeyValue( stream, item );
+  }
+  else if ( value.userType() == QMetaType::QVariantMap )
+  {
+    const QVariantMap map = value.toMap();
+    stream << static_cast< quint8 >( QgsSpillKeyValueType::Map ) << static_cast< qint32 >( map.size() );
+    for ( auto it = map.constBegin(); it != map.constEnd(); ++it )
+    {
+      stream << it.key();
+      writeKeyValue( stream, it.value() );
+    }
+  }
+  else if ( value.userType() == qMetaTypeId< QgsGeometry >() )
+  {
+    stream << static_cast< quint8 >( QgsSpillKeyValueType::Geometry ) << value.value< QgsGeometry >().asWkb();
+  }
+  else if ( value.userType() < QMetaType::User )
+  {
+    stream << static_cast< quint8 >( QgsSpillKeyValueType::Variant ) << value;
+  }
+  else
+  {
+    stream << static_cast< quint8 >( QgsSpillKeyValueType::String ) << value.toString();
+  }
+}
+
+//! Reads a key value written by writeKeyValue() from a \a stream
+static QVariant readKeyValue( QDataStream &stream )
+{
+  quint8 type = 0;
+  stream >> type;
+  switch ( static_cast< QgsSpillKeyValueType >( type ) )
+  {
+    case QgsSpillKeyValueType::Variant:
+    {
+      QVariant value;
+      stream >> value;
+      return value;
+    }
+
+    case QgsSpillKeyValueType::List:
+    {
+      qint32 size = 0;
+      stream >> size;
+      QVariantList list;
+      for ( qint32 i = 0; i < size && stream.status() == QDataStream::Ok; ++i )
+        list << readKeyValue( stream );
+      return list;
+    }
+
+    case QgsSpillKeyValueType::Map:
+    {
+      qint32 size = 0;
+      stream >> size;
+      QVariantMap map;
+      for ( qint32 i = 0; i < size && stream.status() == QDataStream::Ok; ++i )
+      {
+        QString key;
+        stream >> key;
+        map.insert( key, readKeyValue( stream ) );
+      }
+      return map;
+    }
+
+    case QgsSpillKeyValueType::Geometry:
+    {
+      QByteArray wkb;
+      stream >> wkb;
+      QgsGeometry geometry;
+      geometry.fromWkb( wkb );
+      return QVariant::fromValue( geometry );
+    }
+
+    case QgsSpillKeyValueType::String:
+    {
+      QString value;
+      stream >> value;
+      return value;
+    }
+  }
+
+  stream.setStatus( QDataStream::ReadCorruptData );
+  return QVariant();
+}
+
+/**
+ * Temporary file of (key, sequence, feature) records, written once and then read once.
+ * The file is removed when the object is deleted.
+ *
+ * Keys are written with writeKeyValue(), and the file uses a fixed QDataStream version.
+ *
+ * Records are buffered in memory and appended to the file in chunks, the file is only open while a
+ * chunk is appended or while it's read. Operators can hold many spill files without running out of
+ * file descriptors.
+ */
+class QgsSpillFile
+{
+  public:
+
+    explicit QgsSpillFile( const QString &folder )
+    {
+      // the temporary file only reserves a unique name, it really closes the file once deleted
+      QTemporaryFile file( QDir( folder ).filePath( QStringLiteral( "spill_XXXXXX.bin" ) ) );
+      file.setAutoRemove( false );
+      if ( !file.open() )
+        throw QgsProcessingException( QObject::tr( "Could not create temporary file in %1: %2" ).arg( folder, file.errorString() ) );
+      mFile.setFileName( file.fileName() );
+
+      mBuffer.open( QIODevice::WriteOnly );
+      mBufferStream.setDevice( &mBuffer );
+      mBufferStream.setVersion( QDataStream::Qt_5_12 );
+      mStream.setVersion( QDataStream::Qt_5_12 );
+    }
+
+    ~QgsSpillFile()
+    {
+      mFile.close();
+      QFile::remove( mFile.fileName() );
+    }
+
+    QgsSpillFile( const QgsSpillFile &other ) = delete;
+    QgsSpillFile &operator=( const QgsSpillFile &other ) = delete;
+
+    void write( const QVariantList &key, qint64 sequence, const QgsFeature &feature )
+    {
+      mBufferStream << static_cast< qint32 >( key.size() );
+      for ( const QVariant &value : key )
+        writeKeyValue( mBufferStream, value );
+      mBufferStream << sequence << feature;
+      if ( mBufferStream.status() != QDataStream::Ok )
+        throw QgsProcessingException( QObject::tr( "Could not write to temporary file %1" ).arg( mFile.fileName() ) );
+
+      if ( mBuffer.size() >= WRITE_BUFFER_SIZE )
+        flush();
+    }
+
+    //! Appends the buffered records to the file
+    void flush()
+    {
+      if ( mBuffer.size() == 0 )
+        return;
+
+      if ( !mFile.open( QIODevice::WriteOnly | QIODevice::Append ) || mFile.write( mBuffer.buffer() ) != mBuffer.size() )
+        throw QgsProcessingException( QObject::tr( "Could not write to temporary file %1: %2" ).arg( mFile.fileName(), mFile.errorString() ) );
+      mFile.close();
+
+      mBuffer.buffer().clear();
+      mBuffer.seek( 0 );
+    }
+
+    void startReading()
+    {
+      flush();
+      if ( !mFile.open( QIODevice::ReadOnly ) )
+        throw QgsProcessingException( QObject::tr( "Could not read temporary file %1: %2" ).arg( mFile.fileName(), mFile.errorString() ) );
+      mStream.setDevice( &mFile );
+    }
+
+    bool read( QVariantList &key, qint64 &sequence, QgsFeature &feature, const QgsFields &fields )
+    {
+      if ( mStream.atEnd() )
+      {
+        // the file is left closed once read
+        mFile.close();
+        return false;
+      }
+
+      qint32 keySize = 0;
+      mStream >> keySize;
+      key.clear();
+      for ( qint32 i = 0; i < keySize && mStream.status() == QDataStream::Ok; ++i )
+        key << readKeyValue( mStream );
+      mStream >> sequence >> feature;
+      if ( mStream.status() != QDataStream::Ok )
+        throw QgsProcessingException( QObject::tr( "Could not read temporary file %1" ).arg( mFile.fileName() ) );
+      feature.setFields( fields, false );
+      return true;
+    }
+
+  private:
+
+    //! Size of the records buffered before they are appended to the file
+    static constexpr qint64 WRITE_BUFFER_SIZE = 16 * 1024;
+
+    QFile mFile;
+    QDataStream mStream;
+    QBuffer mBuffer;
+    QDataStream mBufferStream;
+};
+
+//! Returns the approximate memory used by a \a value
+static qint64 variantSize( const QVariant &value )
+{
+  switch ( value.type() )
+  {
+    case QVariant::String:
+      return static_cast< qint64 >( sizeof( QVariant ) ) + 2 * value.toString().size();
+    case QVariant::ByteArray:
+      return static_cast< qint64 >( sizeof( QVariant ) ) + value.toByteArray().size();
+    default:
+      return sizeof( QVariant );
+  }
+}
+
+//! Returns the approximate memory used by a \a feature held in a container, along with its \a key
+static qint64 featureSize( const QVariantList &key, const QgsFeature &feature )
+{
+  // fixed overhead of the feature data and the container nodes
+  qint64 size = 128;
+  for ( const QVariant &value : key )
+    size += variantSize( value );
+  const QgsAttributes attributes = feature.attributes();
+  for ( const QVariant &value : attributes )
+    size += variantSize( value );
+  // geometry objects take roughly twice their WKB size
+  if ( feature.hasGeometry() )
+    size += 2 * feature.geometry().constGet()->wkbSize();
+  return size;
+}
+
+/**
+ * Returns the part of the memory budget of the \a context for one of the \a operatorCount operators
+ * an algorithm holds at once, or 0 if there is no limit.
+ */
+static qint64 memoryBudgetShare( const QgsProcessingContext &context, int operatorCount )
+{
+  if ( context.memoryBudget() <= 0 )
+    return 0;
+
+  return std::max< qint64 >( 1, context.memoryBudget() / std::max( 1, operatorCount ) );
+}
+
+//
+// QgsExternalFeatureSorter
+//
+
+//! Maximum number of runs merged at once, each of them having its file open while being merged
+constexpr std::size_t MAXIMUM_MERGED_RUNS = 64;
+
+QgsExternalFeatureSorter::QgsExternalFeatureSorter( const QgsProcessingContext &context, const QgsFields &fields, int operatorCount )
+  : mTemporaryFolder( QgsProcessingUtils::tempFolder( &context ) )
+  , mMemoryBudget( memoryBudgetShare( context, operatorCount ) )
+  , mFields( fields )
+{
+}
+
+QgsExternalFeatureSorter::~QgsExternalFeatureSorter() = default;
+
+void QgsExternalFeatureSorter::add( qint64 key, const QgsFeature &feature )
+{
+  Q_ASSERT( !mReading );
+
+  mBuffer.emplace_back( Entry{ key, feature } );
+  mBufferSize += featureSize( QVariantList(), feature );
+  if ( mMemoryBudget > 0 && mBufferSize > mMemoryBudget )
+    writeRun();
+}
+
+void QgsExternalFeatureSorter::writeRun()
+{
+  std::stable_sort( mBuffer.begin(), mBuffer.end(), []( const Entry & a, const Entry & b ) { return a.key < b.key; } );
+
+  std::unique_ptr< QgsSpillFile > run = std::make_unique< QgsSpillFile >( mTemporaryFolder );
+  for ( const Entry &entry : mBuffer )
+    run->write( QVariantList(), entry.key, entry.feature );
+  run->flush();
+  mRuns.emplace_back( std::move( run ) );
+
+  mBuffer.clear();
+  mBuffer.shrink_to_fit();
+  mBufferSize = 0;
+}
+
+void QgsExternalFeatureSorter::mergeFirstRuns( std::size_t count )
+{
+  std::unique_ptr< QgsSpillFile > merged = std::make_unique< QgsSpillFile >( mTemporaryFolder );
+
+  std::vector< Entry > heads( count );
+  std::priority_queue< std::pair< qint64, std::size_t >, std::vector< std::pair< qint64, std::size_t > >, std::greater<> > queue;
+  QVariantList key;
+  for ( std::size_t i = 0; i < count; ++i )
+  {
+    mRuns[i]->startReading();
+    if ( mRuns[i]->read( key, heads[i].key, heads[i].feature, mFields ) )
+      queue.push( { heads[i].key, i } );
+  }
+
+  // ties are broken by run, the merged run keeps the order of equal keys
+  while ( !queue.empty() )
+  {
+    const std::size_t run = queue.top().second;
+    queue.pop();
+    merged->write( QVariantList(), heads[run].key, heads[run].feature );
+    if ( mRuns[run]->read( key, heads[run].key, heads[run].feature, mFields ) )
+      queue.push( { heads[run].key, run } );
+  }
+  merged->flush();
+
+  mRuns.erase( mRuns.begin(), mRuns.begin() + static_cast< std::ptrdiff_t >( count ) );
+  mRuns.insert( mRuns.begin(), std::move( merged ) );
+}
+
+bool QgsExternalFeatureSorter::next( QgsFeature &feature )
+{
+  if ( !mReading )
+  {
+    mReading = true;
+    if ( mRuns.empty() )
+    {
+      std::stable_sort( mBuffer.begin(), mBuffer.end(), []( const Entry & a, const Entry & b ) { return a.key < b.key; } );
+    }
+    else
+    {
+      // the features left in memory form the last run, so that equal keys keep their order
+      if ( !mBuffer.empty() )
+        writeRun();
+
+      // the first runs are merged into one until they can all be merged at once
+      while ( mRuns.size() > MAXIMUM_MERGED_RUNS )
+        mergeFirstRuns( MAXIMUM_MERGED_RUNS );
+
+      mHeads.resize( mRuns.size() );
+      for ( std::size_t i = 0; i < mRuns.size(); ++i )
+      {
+        QVariantList key;
+        mRuns[i]->startReading();
+        if ( mRuns[i]->read( key, mHeads[i].key, mHeads[i].feature, mFields ) )
+          mMergeQueue.push( { mHeads[i].key, i } );
+      }
+    }
+  }
+
+  if ( mRuns.empty() )
+  {
+    if ( mBufferPosition >= mBuffer.size() )
+      return false;
+    feature = std::move( mBuffer[ mBufferPosition++ ].feature );
+    return true;
+  }
+
+  if ( mMergeQueue.empty() )
+    return false;
+
+  // ties are broken by run, so equal keys keep their order
+  const std::size_t run = mMergeQueue.top().second;
+  mMergeQueue.pop();
+  feature = std::move( mHeads[run].feature );
+
+  QVariantList key;
+  if ( mRuns[run]->read( key, mHeads[run].key, mHeads[run].feature, mFields ) )
+    mMergeQueue.push( { mHeads[run].key, run } );
+  else
+    mRuns[run].reset();
+  return true;
+}
+
+//
+// QgsSpillingFeatureGrouper
+//
+
+/**
+ * Maximum number of partitions a grouper spills to. Partition files are only open while their buffered
+ * records are appended, but each partition buffers some records in memory.
+ */
+constexpr int MAXIMUM_PARTITIONS = 256;
+
+QgsSpillingFeatureGrouper::QgsSpillingFeatureGrouper( const QgsProcessingContext &context, const QgsFields &fields, long long expectedFeatureCount, int operatorCount )
+  : mTemporaryFolder( QgsProcessingUtils::tempFolder( &context ) )
+  , mMemoryBudget( memoryBudgetShare( context, operatorCount ) )
+  , mFields( fields )
+  , mExpectedFeatureCount( expectedFeatureCount )
+{
+}
+
+QgsSpillingFeatureGrouper::~QgsSpillingFeatureGrouper() = default;
+
+void QgsSpillingFeatureGrouper::add( const QVariantList &key, const QgsFeature &feature )
+{
+  Q_ASSERT( !mReading );
+
+  const qint64 sequence = mSequence++;
+  if ( !mPartitions.empty() )
+  {
+    mPartitions[ qHash( key ) % mPartitions.size() ]->write( key, sequence, feature );
+    return;
+  }
+
+  auto it = mGroupIndex.constFind( key );
+  if ( it == mGroupIndex.constEnd() )
+  {
+    it = mGroupIndex.insert( key, mGroups.size() );
+    Group group;
+    group.key = key;
+    mGroups.emplace_back( std::move( group ) );
+  }
+  Group &group = mGroups[ it.value() ];
+  group.features << feature;
+  group.sequences << sequence;
+
+  mSize += featureSize( key, feature );
+  if ( mMemoryBudget > 0 && mSize > mMemoryBudget )
+  {
+    // size the partitions so that each one fits in the budget, with some margin for skewed keys
+    int partitionCount = 64;
+    if ( mExpectedFeatureCount > mSequence )
+    {
+      const double expectedSize = static_cast< double >( mSize ) / mSequence * mExpectedFeatureCount;
+      partitionCount = static_cast< int >( std::ceil( 2 * expectedSize / mMemoryBudget ) );
+    }
+    spill( std::clamp( partitionCount, 16, MAXIMUM_PARTITIONS ) );
+  }
+}
+
+void QgsSpillingFeatureGrouper::spill( int partitionCount )
+{
+  Q_ASSERT( mPartitions.empty() && !mReading );
+
+  mPartitions.reserve( partitionCount );
+  for ( int i = 0; i < partitionCount; ++i )
+    mPartitions.emplace_back( std::make_unique< QgsSpillFile >( mTemporaryFolder ) );
+
+  for ( const Group &group : std::as_const( mGroups ) )
+  {
+    QgsSpillFile *partition = mPartitions[ qHash( group.key ) % mPartitions.size() ].get();
+    for ( int i = 0; i < group.features.size(); ++i )
+      partition->write( group.key, group.sequences.at( i ), group.features.at( i ) );
+  }
+
+  mGroups.clear();
+  mGroups.shrink_to_fit();
+  mGroupIndex.clear();
+  mSize = 0;
+}
+
+bool QgsSpillingFeatureGrouper::nextGroups( std::vector< Group > &groups )
+{
+  groups.clear();
+
+  if ( mPartitions.empty() )
+  {
+    if ( mReading )
+      return false;
+
+    mReading = true;
+    groups = std::move( mGroups );
+    mGroups.clear();
+    mGroupIndex.clear();
+    return true;
+  }
+
+  mReading = true;
+  if ( mNextPartition >= mPartitions.size() )
+    return false;
+
+  std::unique_ptr< QgsSpillFile > partition = std::move( mPartitions[ mNextPartition++ ] );
+  partition->startReading();
+
+  // the features of a partition are in increasing sequence within each group, since the features held
+  // in memory were written before any feature added afterwards
+  QHash< QVariantList, std::size_t > index;
+  QVariantList key;
+  qint64 sequence = 0;
+  QgsFeature feature;
+  while ( partition->read( key, sequence, feature, mFields ) )
+  {
+    auto it = index.constFind( key );
+    if ( it == index.constEnd() )
+    {
+      it = index.insert( key, groups.size() );
+      Group group;
+      group.key = key;
+      groups.emplace_back( std::move( group ) );
+    }
+    Group &group = groups[ it.value() ];
+    group.features << feature;
+    group.sequences << sequence;
+  }
+
+  std::sort( groups.begin(), groups.end(), []( const Group & a, const Group & b ) { return a.sequences.constFirst() < b.sequences.constFirst(); } );
+  return true;
+}
+
+///@endcond PRIVATE
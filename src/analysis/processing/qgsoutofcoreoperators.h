@@ -0,0 +1,189 @@
+/***************************************************************************
+                         qgsoutofcoreoperators.h
+                         -----------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSOUTOFCOREOPERATORS_H
+#define QGSOUTOFCOREOPERATORS_H
+
+#define SIP_NO_FILE
+
+#include "qgsfeature.h"
+#include "qgsfields.h"
+
+#include <QHash>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+///@cond PRIVATE
+
+class QgsProcessingContext;
+class QgsSpillFile;
+
+/**
+ * Sorts features by an integer key, such as their position in the input of an algorithm.
+ *
+ * Features are kept in memory until they exceed the memory budget of the processing context. They
+ * are then sorted and written to a temporary file as a run, and the runs are merged when the features
+ * are read back, in several passes if there are too many runs to merge them at once. Features with
+ * equal keys are read in the order they were added.
+ */
+class QgsExternalFeatureSorter
+{
+  public:
+
+    /**
+     * Constructor for QgsExternalFeatureSorter, using the memory budget and temporary folder of \a context.
+     *
+     * Features read back from temporary files get the specified \a fields. The memory budget is split evenly
+     * between the \a operatorCount sorters and groupers the algorithm holds at once.
+     */
+    explicit QgsExternalFeatureSorter( const QgsProcessingContext &context, const QgsFields &fields = QgsFields(), int operatorCount = 1 );
+    ~QgsExternalFeatureSorter();
+
+    QgsExternalFeatureSorter( const QgsExternalFeatureSorter &other ) = delete;
+    QgsExternalFeatureSorter &operator=( const QgsExternalFeatureSorter &other ) = delete;
+
+    /**
+     * Adds a \a feature with its sort \a key. Features can't be added once reading started.
+     *
+     * Throws a QgsProcessingException if a temporary file can't be written.
+     */
+    void add( qint64 key, const QgsFeature &feature );
+
+    //! Returns TRUE if features were written to temporary files
+    bool hasSpilled() const { return !mRuns.empty(); }
+
+    /**
+     * Reads the next \a feature, in key order. Returns FALSE once all features were read.
+     */
+    bool next( QgsFeature &feature );
+
+  private:
+
+    struct Entry
+    {
+      qint64 key = 0;
+      QgsFeature feature;
+    };
+
+    void writeRun();
+
+    //! Merges the first \a count runs into one run, which replaces them
+    void mergeFirstRuns( std::size_t count );
+
+    QString mTemporaryFolder;
+    qint64 mMemoryBudget = 0;
+    QgsFields mFields;
+
+    std::vector< Entry > mBuffer;
+    qint64 mBufferSize = 0;
+    std::size_t mBufferPosition = 0;
+    bool mReading = false;
+
+    std::vector< std::unique_ptr< QgsSpillFile > > mRuns;
+    //! First feature of each run not read yet, during the merge
+    std::vector< Entry > mHeads;
+    //! Keys of the heads and their runs, smallest first
+    std::priority_queue< std::pair< qint64, std::size_t >, std::vector< std::pair< qint64, std::size_t > >, std::greater<> > mMergeQueue;
+};
+
+/**
+ * Groups features by key, like a QHash of feature lists.
+ *
+ * Groups are kept in memory until they exceed the memory budget of the processing context. The
+ * features, and the ones added afterwards, are then written to temporary files partitioned by the
+ * hash of their key, so that all the features of a group are in the same partition. Groups are then
+ * read back one partition at a time.
+ *
+ * Keys read back from temporary files keep their values, except values of custom types other than
+ * geometries, which are read back as their string representation.
+ */
+class QgsSpillingFeatureGrouper
+{
+  public:
+
+    //! Features sharing a key
+    struct Group
+    {
+      QVariantList key;
+      //! Features of the group, in the order they were added
+      QgsFeatureList features;
+      //! Positions of the features of the group among all the features added
+      QVector< qint64 > sequences;
+    };
+
+    /**
+     * Constructor for QgsSpillingFeatureGrouper, using the memory budget and temporary folder of \a context.
+     *
+     * Features read back from temporary files get the specified \a fields. The \a expectedFeatureCount, if known,
+     * is used to choose the number of partitions so that each of them fits in the memory budget. The memory budget
+     * is split evenly between the \a operatorCount sorters and groupers the algorithm holds at once.
+     */
+    explicit QgsSpillingFeatureGrouper( const QgsProcessingContext &context, const QgsFields &fields = QgsFields(), long long expectedFeatureCount = -1, int operatorCount = 1 );
+    ~QgsSpillingFeatureGrouper();
+
+    QgsSpillingFeatureGrouper( const QgsSpillingFeatureGrouper &other ) = delete;
+    QgsSpillingFeatureGrouper &operator=( const QgsSpillingFeatureGrouper &other ) = delete;
+
+    /**
+     * Adds a \a feature to the group with the specified \a key. Features can't be added once reading started.
+     *
+     * Throws a QgsProcessingException if a temporary file can't be written.
+     */
+    void add( const QVariantList &key, const QgsFeature &feature );
+
+    //! Returns TRUE if features were written to temporary files
+    bool hasSpilled() const { return !mPartitions.empty(); }
+
+    //! Returns the number of batches of groups returned by nextGroups()
+    int partitionCount() const { return mPartitions.empty() ? 1 : static_cast< int >( mPartitions.size() ); }
+
+    /**
+     * Writes the features to \a partitionCount temporary files, even if they fit in the memory budget.
+     *
+     * Two groupers spilled to the same number of partitions return the groups with the same keys in the same batches.
+     */
+    void spill( int partitionCount );
+
+    /**
+     * Takes the next batch of \a groups: all of them if nothing was written to temporary files, or
+     * the groups of the next partition otherwise. The groups of a batch are in the order of their
+     * first feature. Returns FALSE once all groups were read.
+     */
+    bool nextGroups( std::vector< Group > &groups );
+
+  private:
+
+    QString mTemporaryFolder;
+    qint64 mMemoryBudget = 0;
+    QgsFields mFields;
+    long long mExpectedFeatureCount = -1;
+
+    qint64 mSequence = 0;
+    qint64 mSize = 0;
+    QHash< QVariantList, std::size_t > mGroupIndex;
+    std::vector< Group > mGroups;
+
+    std::vector< std::unique_ptr< QgsSpillFile > > mPartitions;
+    std::size_t mNextPartition = 0;
+    bool mReading = false;
+};
+
+///@endcond PRIVATE
+
+#endif // QGSOUTOFCOREOPERATORS_H
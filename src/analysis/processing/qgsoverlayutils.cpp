@@ -22,6 +22,16 @@
 #include "qgsprocessingcontext.h"
 #include "qgsspatialindex.h"
 
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
 ///@cond PRIVATE
 
 bool QgsOverlayUtils::sanitizeIntersectionResult( QgsGeometry &geom, Qgis::GeometryType geometryType, SanitizeFlags flags )
@@ -99,8 +109,421 @@ static QString writeFeatureError()
   return QObject::tr( "Could not write feature" );
 }
 
+//! Number of features A read at once per thread by the partitioned overlay
+static constexpr int PARTITIONED_FEATURES_PER_THREAD = 1000;
+
+//! Number of partitions of the features A read at once per thread, so that partitions of uneven cost keep threads busy
+static constexpr int PARTITIONS_PER_THREAD = 4;
+
+//! Maximum number of features B read in memory by the partitioned overlay, larger sources are overlaid serially
+static constexpr long long PARTITIONED_MAXIMUM_FEATURES_B = 200000;
+
+//! Result of reading the features B in memory for the partitioned overlay
+enum class OverlayFeaturesLoading
+{
+  Loaded, //!< All features B were read
+  Canceled, //!< Canceled by the feedback
+  TooManyFeatures, //!< More than PARTITIONED_MAXIMUM_FEATURES_B features, the serial overlay must be used
+};
+
+/**
+ * Returns TRUE if the features of \a sourceB can be read in memory for the partitioned overlay.
+ */
+static bool canOverlayPartitioned( const QgsFeatureSource &sourceB )
+{
+  const long long featureCount = sourceB.featureCount();
+  return featureCount >= 0 && featureCount <= PARTITIONED_MAXIMUM_FEATURES_B;
+}
+
+/**
+ * Features B overlapping a partition of the features A. A partition has its own spatial index
+ * and prepared geometries, so that partitions are overlaid by different threads without sharing them.
+ */
+class QgsOverlayPartition
+{
+  public:
+
+    QgsOverlayPartition( const std::vector< QgsFeature > &featuresB, const std::vector< QgsRectangle > &boundsB, const QList< QgsFeatureId > &candidates )
+      : mFeaturesB( featuresB )
+    {
+      for ( const QgsFeatureId position : candidates )
+        mIndex.addFeature( position, boundsB[ static_cast< std::size_t >( position ) ] );
+    }
+
+    //! Returns the positions of the features B with a bounding box intersecting \a rectangle, in the order they were read
+    QList< QgsFeatureId > intersects( const QgsRectangle &rectangle ) const
+    {
+      QList< QgsFeatureId > positions = mIndex.intersects( rectangle );
+      std::sort( positions.begin(), positions.end() );
+      return positions;
+    }
+
+    //! Returns the feature B at \a position
+    const QgsFeature &feature( QgsFeatureId position ) const
+    {
+      return mFeaturesB[ static_cast< std::size_t >( position ) ];
+    }
+
+    //! Returns the geometry engine of the feature B at \a position, prepared the first time a feature A is tested against it
+    QgsGeometryEngine *engine( QgsFeatureId position )
+    {
+      std::unique_ptr< QgsGeometryEngine > &engine = mEngines[ position ];
+      if ( !engine )
+      {
+        engine.reset( QgsGeometry::createGeometryEngine( feature( position ).geometry().constGet() ) );
+        engine->prepareGeometry();
+      }
+      return engine.get();
+    }
+
+  private:
+
+    const std::vector< QgsFeature > &mFeaturesB;
+    QgsSpatialIndex mIndex;
+    std::unordered_map< QgsFeatureId, std::unique_ptr< QgsGeometryEngine > > mEngines;
+};
+
+/**
+ * Splits the features with the specified bounding box \a centers into about \a partitionCount partitions of
+ * nearby features with the same number of features, with a sort-tile-recursive tiling: features are sorted
+ * by x into vertical slices, and the features of each slice are sorted by y into partitions.
+ */
+static std::vector< std::vector< std::size_t > > sortTileRecursive( const std::vector< QgsPointXY > &centers, int partitionCount )
+{
+  const std::size_t count = centers.size();
+  const std::size_t partitionSize = std::max< std::size_t >( 1, ( count + partitionCount - 1 ) / partitionCount );
+  const std::size_t leafCount = ( count + partitionSize - 1 ) / partitionSize;
+  const std::size_t sliceSize = partitionSize * static_cast< std::size_t >( std::ceil( std::sqrt( static_cast< double >( leafCount ) ) ) );
+
+  std::vector< std::size_t > order( count );
+  std::iota( order.begin(), order.end(), 0 );
+  std::stable_sort( order.begin(), order.end(), [&centers]( std::size_t a, std::size_t b ) { return centers[ a ].x() < centers[ b ].x(); } );
+
+  std::vector< std::vector< std::size_t > > partitions;
+  for ( std::size_t sliceStart = 0; sliceStart < count; sliceStart += sliceSize )
+  {
+    const std::size_t sliceEnd = std::min( count, sliceStart + sliceSize );
+    std::stable_sort( order.begin() + sliceStart, order.begin() + sliceEnd, [&centers]( std::size_t a, std::size_t b ) { return centers[ a ].y() < centers[ b ].y(); } );
+    for ( std::size_t start = sliceStart; start < sliceEnd; start += partitionSize )
+    {
+      partitions.emplace_back( order.begin() + start, order.begin() + std::min( sliceEnd, start + partitionSize ) );
+    }
+  }
+  return partitions;
+}
+
+/**
+ * Reads the features B to overlay in memory, with their bounding boxes and a spatial index of their
+ * positions. Reading stops when the source has more than PARTITIONED_MAXIMUM_FEATURES_B features, as its
+ * feature count may be inexact.
+ */
+static OverlayFeaturesLoading loadOverlayFeatures( const QgsFeatureSource &sourceB, const QgsFeatureRequest &request, std::vector< QgsFeature > &featuresB, std::vector< QgsRectangle > &boundsB, QgsSpatialIndex &indexB, QgsProcessingFeedback *feedback )
+{
+  feedback->setProgressText( QObject::tr( "Creating spatial index" ) );
+  const double step = sourceB.featureCount() > 0 ? 100.0 / static_cast< double >( sourceB.featureCount() ) : 1;
+
+  QgsFeature featB;
+  QgsFeatureIterator fitB = sourceB.getFeatures( request );
+  while ( fitB.nextFeature( featB ) )
+  {
+    if ( feedback->isCanceled() )
+      return OverlayFeaturesLoading::Canceled;
+
+    if ( !featB.hasGeometry() )
+      continue;
+
+    if ( static_cast< long long >( featuresB.size() ) >= PARTITIONED_MAXIMUM_FEATURES_B )
+      return OverlayFeaturesLoading::TooManyFeatures;
+
+    // bounding boxes are computed once here, as geometries B are then read from several threads
+    const QgsRectangle bounds = featB.geometry().boundingBox();
+    indexB.addFeature( static_cast< QgsFeatureId >( featuresB.size() ), bounds );
+    boundsB.push_back( bounds );
+    featuresB.push_back( featB );
+
+    feedback->setProgress( static_cast< double >( featuresB.size() ) * step );
+  }
+  return OverlayFeaturesLoading::Loaded;
+}
+
+/**
+ * Calls \a overlayFeature for each feature of \a fitA, with the partition holding the features B overlapping it,
+ * and writes the resulting features to the sink.
+ *
+ * Features A are read in chunks, each chunk being split into partitions of nearby features with sortTileRecursive().
+ * Partitions are overlaid in parallel, using the maximum number of threads of the context. The extent of a
+ * partition covers the bounding boxes of all its features A, so a feature A crossing the border between partitions
+ * is overlaid once, with all the features B it overlaps. Features resulting from a chunk are written in the order
+ * of the features A, so the output doesn't depend on the partitions or on the number of threads.
+ */
+static void overlayPartitioned( QgsFeatureIterator &fitA, const std::vector< QgsFeature > &featuresB, const std::vector< QgsRectangle > &boundsB, const QgsSpatialIndex &indexB,
+                                QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, long &count, long totalCount,
+                                const std::function< void( const QgsFeature &featA, QgsOverlayPartition &partition, QgsFeatureList &output ) > &overlayFeature )
+{
+  const int threads = context.maximumThreads();
+  const std::size_t chunkSize = static_cast< std::size_t >( threads ) * PARTITIONED_FEATURES_PER_THREAD;
+
+  QThreadPool pool;
+  pool.setMaxThreadCount( threads );
+
+  QgsFeature featA;
+  bool atEnd = false;
+  while ( !atEnd && !feedback->isCanceled() )
+  {
+    std::vector< QgsFeature > chunk;
+    std::vector< QgsRectangle > boundsA;
+    std::vector< QgsPointXY > centers;
+    chunk.reserve( chunkSize );
+    while ( chunk.size() < chunkSize && fitA.nextFeature( featA ) )
+    {
+      const QgsRectangle bounds = featA.hasGeometry() ? featA.geometry().boundingBox() : QgsRectangle();
+      boundsA.push_back( bounds );
+      centers.push_back( featA.hasGeometry() ? bounds.center() : QgsPointXY() );
+      chunk.push_back( featA );
+    }
+    atEnd = chunk.size() < chunkSize;
+    if ( chunk.empty() )
+      break;
+
+    std::vector< QgsFeatureList > outputs( chunk.size() );
+    std::vector< QFuture< QString > > pendingPartitions;
+    for ( const std::vector< std::size_t > &partition : sortTileRecursive( centers, threads * PARTITIONS_PER_THREAD ) )
+    {
+      // not using combineExtentWith(), which skips the bounding box of a point at the origin
+      double xMin = std::numeric_limits< double >::max();
+      double yMin = std::numeric_limits< double >::max();
+      double xMax = std::numeric_limits< double >::lowest();
+      double yMax = std::numeric_limits< double >::lowest();
+      bool hasBounds = false;
+      for ( const std::size_t i : partition )
+      {
+        if ( !chunk[ i ].hasGeometry() )
+          continue;
+
+        xMin = std::min( xMin, boundsA[ i ].xMinimum() );
+        yMin = std::min( yMin, boundsA[ i ].yMinimum() );
+        xMax = std::max( xMax, boundsA[ i ].xMaximum() );
+        yMax = std::max( yMax, boundsA[ i ].yMaximum() );
+        hasBounds = true;
+      }
+      const QList< QgsFeatureId > candidates = hasBounds ? indexB.intersects( QgsRectangle( xMin, yMin, xMax, yMax, false ) ) : QList< QgsFeatureId >();
+
+      pendingPartitions.push_back( QtConcurrent::run( &pool, [&, partition, candidates]() -> QString
+      {
+        QgsOverlayPartition overlayPartition( featuresB, boundsB, candidates );
+        try
+        {
+          for ( const std::size_t i : partition )
+          {
+            if ( feedback->isCanceled() )
+              break;
+
+            overlayFeature( chunk[ i ], overlayPartition, outputs[ i ] );
+          }
+        }
+        catch ( QgsProcessingException &e )
+        {
+          return e.what();
+        }
+        return QString();
+      } ) );
+    }
+
+    // all partitions must be done before the chunk goes out of scope, even if one of them failed
+    QString error;
+    for ( QFuture< QString > &pendingPartition : pendingPartitions )
+    {
+      const QString partitionError = pendingPartition.result();
+      if ( error.isEmpty() )
+        error = partitionError;
+    }
+    if ( !error.isEmpty() )
+      throw QgsProcessingException( error );
+
+    if ( feedback->isCanceled() )
+      break;
+
+    for ( QgsFeatureList &output : outputs )
+    {
+      if ( !sink.addFeatures( output, QgsFeatureSink::FastInsert ) )
+        throw QgsProcessingException( writeFeatureError() );
+    }
+
+    count += static_cast< long >( chunk.size() );
+    feedback->setProgress( count / static_cast< double >( totalCount ) * 100. );
+  }
+}
+
+/**
+ * Partitioned version of QgsOverlayUtils::difference(). Returns FALSE if the features B could not
+ * be read in memory, in which case nothing was written to the sink.
+ */
+static bool differencePartitioned( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, long &count, long totalCount, QgsOverlayUtils::DifferenceOutput outputAttrs, const QgsGeometryParameters &parameters, QgsOverlayUtils::SanitizeFlags flags )
+{
+  const Qgis::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
+  QgsFeatureRequest requestB;
+  requestB.setNoAttributes();
+  if ( outputAttrs != QgsOverlayUtils::OutputBA )
+    requestB.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
+
+  std::vector< QgsFeature > featuresB;
+  std::vector< QgsRectangle > boundsB;
+  QgsSpatialIndex indexB;
+  switch ( loadOverlayFeatures( sourceB, requestB, featuresB, boundsB, indexB, feedback ) )
+  {
+    case OverlayFeaturesLoading::Loaded:
+      break;
+    case OverlayFeaturesLoading::Canceled:
+      return true;
+    case OverlayFeaturesLoading::TooManyFeatures:
+      return false;
+  }
+
+  const int fieldsCountA = sourceA.fields().count();
+  const int fieldsCountB = sourceB.fields().count();
+
+  if ( totalCount == 0 )
+    totalCount = 1;  // avoid division by zero
+
+  feedback->setProgressText( QObject::tr( "Calculating difference" ) );
+
+  QgsFeatureRequest requestA;
+  requestA.setInvalidGeometryCheck( context.invalidGeometryCheck() );
+  if ( outputAttrs == QgsOverlayUtils::OutputBA )
+    requestA.setDestinationCrs( sourceB.sourceCrs(), context.transformContext() );
+  QgsFeatureIterator fitA = sourceA.getFeatures( requestA );
+  overlayPartitioned( fitA, featuresB, boundsB, indexB, sink, context, feedback, count, totalCount, [&]( const QgsFeature & featA, QgsOverlayPartition & partition, QgsFeatureList & output )
+  {
+    if ( !featA.hasGeometry() )
+    {
+      output << featA;
+      return;
+    }
+
+    QgsGeometry geom( featA.geometry() );
+    QVector<QgsGeometry> geometriesB;
+    const QList< QgsFeatureId > positions = partition.intersects( geom.boundingBox() );
+    for ( const QgsFeatureId position : positions )
+    {
+      if ( partition.engine( position )->intersects( geom.constGet() ) )
+        geometriesB << partition.feature( position ).geometry();
+    }
+
+    if ( !geometriesB.isEmpty() )
+    {
+      const QgsGeometry geomB = QgsGeometry::unaryUnion( geometriesB, parameters );
+      if ( !geomB.lastError().isEmpty() )
+      {
+        throw QgsProcessingException( QStringLiteral( "%1\n\n%2" ).arg( QObject::tr( "GEOS geoprocessing error: unary union failed." ), geomB.lastError() ) );
+      }
+      geom = geom.difference( geomB, parameters );
+    }
+
+    if ( !geom.isNull() && !sanitizeDifferenceResult( geom, geometryType, flags ) )
+      return;
+
+    QgsAttributes attrs;
+    const QgsAttributes attrsA( featA.attributes() );
+    switch ( outputAttrs )
+    {
+      case QgsOverlayUtils::OutputA:
+        attrs = attrsA;
+        break;
+      case QgsOverlayUtils::OutputAB:
+        attrs.resize( fieldsCountA + fieldsCountB );
+        for ( int i = 0; i < fieldsCountA; ++i )
+          attrs[i] = attrsA[i];
+        break;
+      case QgsOverlayUtils::OutputBA:
+        attrs.resize( fieldsCountA + fieldsCountB );
+        for ( int i = 0; i < fieldsCountA; ++i )
+          attrs[i + fieldsCountB] = attrsA[i];
+        break;
+    }
+
+    QgsFeature outFeat;
+    outFeat.setGeometry( geom );
+    outFeat.setAttributes( attrs );
+    output << outFeat;
+  } );
+  return true;
+}
+
+/**
+ * Partitioned version of QgsOverlayUtils::intersection(). Returns FALSE if the features B could not
+ * be read in memory, in which case nothing was written to the sink.
+ */
+static bool intersectionPartitioned( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, long &count, long totalCount, const QList<int> &fieldIndicesA, const QList<int> &fieldIndicesB, const QgsGeometryParameters &parameters )
+{
+  const Qgis::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
+  const int attrCount = fieldIndicesA.count() + fieldIndicesB.count();
+
+  QgsFeatureRequest requestB;
+  requestB.setSubsetOfAttributes( fieldIndicesB );
+  requestB.setDestinationCrs( sourceA.sourceCrs(), context.transformContext() );
+
+  std::vector< QgsFeature > featuresB;
+  std::vector< QgsRectangle > boundsB;
+  QgsSpatialIndex indexB;
+  switch ( loadOverlayFeatures( sourceB, requestB, featuresB, boundsB, indexB, feedback ) )
+  {
+    case OverlayFeaturesLoading::Loaded:
+      break;
+    case OverlayFeaturesLoading::Canceled:
+      return true;
+    case OverlayFeaturesLoading::TooManyFeatures:
+      return false;
+  }
+
+  if ( totalCount == 0 )
+    totalCount = 1;  // avoid division by zero
+
+  feedback->setProgressText( QObject::tr( "Calculating intersection" ) );
+
+  QgsFeatureIterator fitA = sourceA.getFeatures( QgsFeatureRequest().setSubsetOfAttributes( fieldIndicesA ) );
+  overlayPartitioned( fitA, featuresB, boundsB, indexB, sink, context, feedback, count, totalCount, [&]( const QgsFeature & featA, QgsOverlayPartition & partition, QgsFeatureList & output )
+  {
+    if ( !featA.hasGeometry() )
+      return;
+
+    const QgsGeometry geom( featA.geometry() );
+    QgsAttributes outAttributes( attrCount );
+    const QgsAttributes attrsA( featA.attributes() );
+    for ( int i = 0; i < fieldIndicesA.count(); ++i )
+      outAttributes[i] = attrsA[fieldIndicesA[i]];
+
+    const QList< QgsFeatureId > positions = partition.intersects( geom.boundingBox() );
+    for ( const QgsFeatureId position : positions )
+    {
+      if ( !partition.engine( position )->intersects( geom.constGet() ) )
+        continue;
+
+      const QgsFeature &featB = partition.feature( position );
+      QgsGeometry intGeom = geom.intersection( featB.geometry(), parameters );
+      if ( !QgsOverlayUtils::sanitizeIntersectionResult( intGeom, geometryType ) )
+        continue;
+
+      const QgsAttributes attrsB( featB.attributes() );
+      for ( int i = 0; i < fieldIndicesB.count(); ++i )
+        outAttributes[fieldIndicesA.count() + i] = attrsB[fieldIndicesB[i]];
+
+      QgsFeature outFeat;
+      outFeat.setGeometry( intGeom );
+      outFeat.setAttributes( outAttributes );
+      output << outFeat;
+    }
+  } );
+  return true;
+}
+
 void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, long &count, long totalCount, QgsOverlayUtils::DifferenceOutput outputAttrs, const QgsGeometryParameters &parameters, SanitizeFlags flags )
 {
+  if ( context.maximumThreads() > 1 && canOverlayPartitioned( sourceB )
+       && differencePartitioned( sourceA, sourceB, sink, context, feedback, count, totalCount, outputAttrs, parameters, flags ) )
+  {
+    return;
+  }
+
   const Qgis::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
   QgsFeatureRequest requestB;
   requestB.setNoAttributes();
@@ -233,6 +656,12 @@ void QgsOverlayUtils::difference( const QgsFeatureSource &sourceA, const QgsFeat
 
 void QgsOverlayUtils::intersection( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, long &count, long totalCount, const QList<int> &fieldIndicesA, const QList<int> &fieldIndicesB, const QgsGeometryParameters &parameters )
 {
+  if ( context.maximumThreads() > 1 && canOverlayPartitioned( sourceB )
+       && intersectionPartitioned( sourceA, sourceB, sink, context, feedback, count, totalCount, fieldIndicesA, fieldIndicesB, parameters ) )
+  {
+    return;
+  }
+
   const Qgis::GeometryType geometryType = QgsWkbTypes::geometryType( QgsWkbTypes::multiType( sourceA.wkbType() ) );
   const int attrCount = fieldIndicesA.count() + fieldIndicesB.count();
 
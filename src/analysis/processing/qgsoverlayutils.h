@@ -59,9 +59,23 @@ namespace QgsOverlayUtils
   Q_DECLARE_FLAGS( SanitizeFlags, SanitizeFlag )
 
 
+  /**
+   * Writes to the sink the features of \a sourceA minus the features of \a sourceB overlapping them.
+   *
+   * With a context allowing more than one thread, and if \a sourceB has a known and moderate number of features,
+   * the features of \a sourceB are loaded in memory and the features of \a sourceA are overlaid by spatial
+   * partitions in parallel.
+   */
   void difference( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, long &count, long totalCount, DifferenceOutput outputAttrs, const QgsGeometryParameters &parameters = QgsGeometryParameters(),
                    SanitizeFlags flags = SanitizeFlags() );
 
+  /**
+   * Writes to the sink the intersections of the features of \a sourceA with the features of \a sourceB.
+   *
+   * With a context allowing more than one thread, and if \a sourceB has a known and moderate number of features,
+   * the features of \a sourceB are loaded in memory and the features of \a sourceA are overlaid by spatial
+   * partitions in parallel.
+   */
   void intersection( const QgsFeatureSource &sourceA, const QgsFeatureSource &sourceB, QgsFeatureSink &sink, QgsProcessingContext &context, QgsProcessingFeedback *feedback, long &count, long totalCount, const QList<int> &fieldIndicesA, const QList<int> &fieldIndicesB, const QgsGeometryParameters &parameters = QgsGeometryParameters() );
 
   //! Makes sure that what came out from intersection of two geometries is good to be used in the output
@@ -0,0 +1,351 @@
+/***************************************************************************
+                         qgsspatialjoinengine.cpp
+                         ------------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsspatialjoinengine.h"
+#include "qgsfeatureiterator.h"
+#include "qgsgeometryengine.h"
+#include "qgsprocessingfeedback.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+
+///@cond PRIVATE
+
+QgsSpatialJoinEngine::Predicate QgsSpatialJoinEngine::reversePredicate( Predicate predicate )
+{
+  switch ( predicate )
+  {
+    case Contains:
+      return Within;
+    case Within:
+      return Contains;
+    case Intersects:
+    case Disjoint:
+    case IsEqual:
+    case Touches:
+    case Overlaps:
+    case Crosses:
+      break;
+  }
+  return predicate;
+}
+
+QgsSpatialJoinEngine::QgsSpatialJoinEngine( const QList<Predicate> &predicates )
+  : mPredicates( predicates )
+  , mTestDisjoint( predicates.contains( Disjoint ) )
+{
+}
+
+bool QgsSpatialJoinEngine::loadBuildFeatures( QgsFeatureIterator &iterator, QgsFeedback *feedback )
+{
+  QgsFeature feature;
+  while ( iterator.nextFeature( feature ) )
+  {
+    if ( feedback->isCanceled() )
+      return false;
+
+    if ( !feature.hasGeometry() )
+      continue;
+
+    // bounding boxes are computed once here, as build geometries are then read from several threads
+    mBuildBounds.emplace_back( feature.geometry().boundingBox() );
+    mBuildFeatures.emplace_back( feature );
+  }
+
+  buildGrid();
+  return true;
+}
+
+void QgsSpatialJoinEngine::buildGrid()
+{
+  const std::size_t count = mBuildBounds.size();
+  if ( count == 0 )
+    return;
+
+  // not using combineExtentWith(), which skips the bounding box of a point at the origin
+  double xMin = std::numeric_limits< double >::max();
+  double yMin = std::numeric_limits< double >::max();
+  double xMax = std::numeric_limits< double >::lowest();
+  double yMax = std::numeric_limits< double >::lowest();
+  for ( const QgsRectangle &bounds : std::as_const( mBuildBounds ) )
+  {
+    xMin = std::min( xMin, bounds.xMinimum() );
+    yMin = std::min( yMin, bounds.yMinimum() );
+    xMax = std::max( xMax, bounds.xMaximum() );
+    yMax = std::max( yMax, bounds.yMaximum() );
+  }
+  mExtent = QgsRectangle( xMin, yMin, xMax, yMax, false );
+
+  // about one feature per cell, with fewer cells when large features would be repeated in too many cells
+  double cellCount = static_cast< double >( count );
+  std::size_t entryCount = 0;
+  while ( true )
+  {
+    const double aspectRatio = mExtent.width() > 0 && mExtent.height() > 0 ? mExtent.width() / mExtent.height() : 1;
+    mColumns = mExtent.width() > 0 ? std::max( 1, static_cast< int >( std::ceil( std::sqrt( cellCount * aspectRatio ) ) ) ) : 1;
+    mRows = mExtent.height() > 0 ? std::max( 1, static_cast< int >( std::ceil( cellCount / mColumns ) ) ) : 1;
+    mCellWidth = mExtent.width() > 0 ? mExtent.width() / mColumns : 1;
+    mCellHeight = mExtent.height() > 0 ? mExtent.height() / mRows : 1;
+
+    entryCount = 0;
+    for ( const QgsRectangle &bounds : std::as_const( mBuildBounds ) )
+    {
+      int firstColumn, lastColumn, firstRow, lastRow;
+      cellRange( bounds, firstColumn, lastColumn, firstRow, lastRow );
+      entryCount += static_cast< std::size_t >( lastColumn - firstColumn + 1 ) * static_cast< std::size_t >( lastRow - firstRow + 1 );
+    }
+
+    if ( entryCount <= 4 * count || ( mColumns == 1 && mRows == 1 ) )
+      break;
+    cellCount /= 4;
+  }
+
+  // counting sort of the features by cell, keeping the loading order within a cell
+  const std::size_t cells = static_cast< std::size_t >( mColumns ) * static_cast< std::size_t >( mRows );
+  mCellOffsets.assign( cells + 1, 0 );
+  const auto forEachCell = [this]( const QgsRectangle & bounds, const std::function< void( std::size_t cell ) > &function )
+  {
+    int firstColumn, lastColumn, firstRow, lastRow;
+    cellRange( bounds, firstColumn, lastColumn, firstRow, lastRow );
+    for ( int row = firstRow; row <= lastRow; ++row )
+    {
+      for ( int column = firstColumn; column <= lastColumn; ++column )
+      {
+        function( static_cast< std::size_t >( row ) * mColumns + column );
+      }
+    }
+  };
+  for ( const QgsRectangle &bounds : std::as_const( mBuildBounds ) )
+  {
+    forEachCell( bounds, [this]( std::size_t cell ) { ++mCellOffsets[ cell + 1 ]; } );
+  }
+  for ( std::size_t cell = 1; cell <= cells; ++cell )
+  {
+    mCellOffsets[ cell ] += mCellOffsets[ cell - 1 ];
+  }
+
+  mCellPositions.resize( entryCount );
+  std::vector< std::size_t > next( mCellOffsets.begin(), mCellOffsets.end() - 1 );
+  for ( std::size_t position = 0; position < count; ++position )
+  {
+    forEachCell( mBuildBounds[ position ], [this, &next, position]( std::size_t cell ) { mCellPositions[ next[ cell ]++ ] = static_cast< int >( position ); } );
+  }
+}
+
+void QgsSpatialJoinEngine::cellRange( const QgsRectangle &rectangle, int &firstColumn, int &lastColumn, int &firstRow, int &lastRow ) const
+{
+  firstColumn = static_cast< int >( std::clamp( std::floor( ( rectangle.xMinimum() - mExtent.xMinimum() ) / mCellWidth ), 0.0, mColumns - 1.0 ) );
+  lastColumn = static_cast< int >( std::clamp( std::floor( ( rectangle.xMaximum() - mExtent.xMinimum() ) / mCellWidth ), 0.0, mColumns - 1.0 ) );
+  firstRow = static_cast< int >( std::clamp( std::floor( ( rectangle.yMinimum() - mExtent.yMinimum() ) / mCellHeight ), 0.0, mRows - 1.0 ) );
+  lastRow = static_cast< int >( std::clamp( std::floor( ( rectangle.yMaximum() - mExtent.yMinimum() ) / mCellHeight ), 0.0, mRows - 1.0 ) );
+}
+
+void QgsSpatialJoinEngine::candidates( const QgsRectangle &rectangle, std::vector<int> &positions ) const
+{
+  positions.clear();
+  if ( mBuildFeatures.empty() || !rectangle.intersects( mExtent ) )
+    return;
+
+  int firstColumn, lastColumn, firstRow, lastRow;
+  cellRange( rectangle, firstColumn, lastColumn, firstRow, lastRow );
+  for ( int row = firstRow; row <= lastRow; ++row )
+  {
+    for ( int column = firstColumn; column <= lastColumn; ++column )
+    {
+      const std::size_t cell = static_cast< std::size_t >( row ) * mColumns + column;
+      for ( std::size_t i = mCellOffsets[ cell ]; i < mCellOffsets[ cell + 1 ]; ++i )
+      {
+        if ( mBuildBounds[ static_cast< std::size_t >( mCellPositions[ i ] ) ].intersects( rectangle ) )
+          positions.push_back( mCellPositions[ i ] );
+      }
+    }
+  }
+
+  // features spanning several cells are found once per cell
+  if ( firstColumn != lastColumn || firstRow != lastRow )
+  {
+    std::sort( positions.begin(), positions.end() );
+    positions.erase( std::unique( positions.begin(), positions.end() ), positions.end() );
+  }
+}
+
+void QgsSpatialJoinEngine::probe( QgsFeatureIterator &iterator, int threads, long long probeFeatureCount, QgsProcessingFeedback *feedback,
+                                  const std::function<void ( const QgsFeature &, Matches & )> &refineMatches,
+                                  const std::function<void ( const QgsFeature &, const Matches & )> &handleMatches ) const
+{
+  // number of probe features tested at once by a thread
+  constexpr int BATCH_SIZE = 1000;
+
+  threads = std::max( 1, threads );
+
+  // each thread testing a batch uses its own prepared geometries, kept from batch to batch
+  using PreparedGeometries = std::unordered_map< int, std::unique_ptr< QgsGeometryEngine > >;
+  std::vector< std::unique_ptr< PreparedGeometries > > preparedGeometries;
+  QVector< PreparedGeometries * > freePreparedGeometries;
+  for ( int i = 0; i < threads; ++i )
+  {
+    preparedGeometries.emplace_back( std::make_unique< PreparedGeometries >() );
+    freePreparedGeometries << preparedGeometries.back().get();
+  }
+  QMutex freePreparedGeometriesMutex;
+
+  const auto testBatch = [&]( const QgsFeatureList & features ) -> std::vector< Matches >
+  {
+    PreparedGeometries *prepared = nullptr;
+    {
+      QMutexLocker locker( &freePreparedGeometriesMutex );
+      prepared = freePreparedGeometries.takeLast();
+    }
+
+    std::vector< Matches > batchMatches( static_cast< std::size_t >( features.size() ) );
+    std::vector< int > positions;
+    for ( int i = 0; i < features.size(); ++i )
+    {
+      if ( feedback->isCanceled() )
+        break;
+
+      const QgsFeature &feature = features.at( i );
+      if ( !feature.hasGeometry() )
+        continue;
+
+      Matches &matches = batchMatches[ static_cast< std::size_t >( i ) ];
+      const QgsGeometry geometry = feature.geometry();
+      const QgsAbstractGeometry *geom = geometry.constGet();
+      candidates( geometry.boundingBox(), positions );
+      for ( const int position : std::as_const( positions ) )
+      {
+        std::unique_ptr< QgsGeometryEngine > &engine = ( *prepared )[ position ];
+        if ( !engine )
+        {
+          engine.reset( QgsGeometry::createGeometryEngine( buildFeature( position ).geometry().constGet() ) );
+          engine->prepareGeometry();
+        }
+
+        bool isMatch = false;
+        bool intersects = false;
+        for ( const Predicate predicate : mPredicates )
+        {
+          switch ( predicate )
+          {
+            case Intersects:
+              isMatch = engine->intersects( geom );
+              break;
+            case Contains:
+              isMatch = engine->contains( geom );
+              break;
+            case Disjoint:
+              intersects = intersects || engine->intersects( geom );
+              break;
+            case IsEqual:
+              isMatch = engine->isEqual( geom );
+              break;
+            case Touches:
+              isMatch = engine->touches( geom );
+              break;
+            case Overlaps:
+              isMatch = engine->overlaps( geom );
+              break;
+            case Within:
+              isMatch = engine->within( geom );
+              break;
+            case Crosses:
+              isMatch = engine->crosses( geom );
+              break;
+          }
+          if ( isMatch )
+            break;
+        }
+
+        // all the other predicates imply that the geometries intersect
+        if ( isMatch )
+        {
+          matches.matches << position;
+          intersects = true;
+        }
+        if ( mTestDisjoint && intersects )
+          matches.intersecting << position;
+
+        if ( mFirstMatchOnly && !matches.matches.isEmpty() && ( !mTestDisjoint || !matches.intersecting.isEmpty() ) )
+          break;
+      }
+
+      if ( refineMatches )
+        refineMatches( feature, matches );
+    }
+
+    QMutexLocker locker( &freePreparedGeometriesMutex );
+    freePreparedGeometries << prepared;
+    return batchMatches;
+  };
+
+  // the pool is destroyed first, waiting for the batches still being tested with the prepared geometries
+  QThreadPool pool;
+  pool.setMaxThreadCount( threads );
+
+  // batches are tested in parallel and handled in order, waiting on the oldest one
+  const int maxPendingBatches = 2 * threads;
+  std::deque< std::pair< QgsFeatureList, QFuture< std::vector< Matches > > > > pendingBatches;
+  const double step = probeFeatureCount > 0 ? 100.0 / static_cast< double >( probeFeatureCount ) : 1;
+  long long current = 0;
+  bool atEnd = false;
+  QgsFeature f;
+  while ( !feedback->isCanceled() )
+  {
+    while ( !atEnd && static_cast< int >( pendingBatches.size() ) < maxPendingBatches )
+    {
+      QgsFeatureList features;
+      features.reserve( BATCH_SIZE );
+      while ( features.size() < BATCH_SIZE && iterator.nextFeature( f ) )
+      {
+        features << f;
+      }
+      atEnd = features.size() < BATCH_SIZE;
+      if ( features.isEmpty() )
+        break;
+
+      QFuture< std::vector< Matches > > future = QtConcurrent::run( &pool, testBatch, features );
+      pendingBatches.emplace_back( features, future );
+    }
+    if ( pendingBatches.empty() )
+      break;
+
+    const QgsFeatureList features = pendingBatches.front().first;
+    const std::vector< Matches > batchMatches = pendingBatches.front().second.result();
+    pendingBatches.pop_front();
+
+    if ( feedback->isCanceled() )
+      break;
+
+    for ( int i = 0; i < features.size(); ++i )
+    {
+      handleMatches( features.at( i ), batchMatches[ static_cast< std::size_t >( i ) ] );
+    }
+
+    current += features.size();
+    feedback->setProgress( static_cast< double >( current ) * step );
+  }
+}
+
+///@endcond PRIVATE
@@ -0,0 +1,143 @@
+/***************************************************************************
+                         qgsspatialjoinengine.h
+                         ----------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSPATIALJOINENGINE_H
+#define QGSSPATIALJOINENGINE_H
+
+#define SIP_NO_FILE
+
+#include "qgsfeature.h"
+#include "qgsrectangle.h"
+
+#include <QList>
+#include <QVector>
+#include <functional>
+#include <vector>
+
+///@cond PRIVATE
+
+class QgsFeatureIterator;
+class QgsFeedback;
+class QgsProcessingFeedback;
+
+/**
+ * Joins the features of a probe source to the features of a build source matching a spatial predicate.
+ *
+ * The build features are loaded in memory with a grid index of their bounding boxes. Their geometries
+ * are prepared the first time they are tested, and kept prepared for the rest of the join. The probe
+ * features are streamed, and tested in batches by several threads. The build source should be the
+ * smaller of the two sources.
+ *
+ * Prepared GEOS geometries can't be used by several threads at once, so each thread has its own
+ * prepared geometries: a build geometry is prepared at most once per thread.
+ */
+class QgsSpatialJoinEngine
+{
+  public:
+
+    //! Spatial predicates, tested as "build geometry <predicate> probe geometry"
+    enum Predicate
+    {
+      Intersects,
+      Contains,
+      Disjoint, //!< Doesn't give matches, the build features intersecting the probe feature are reported instead
+      IsEqual,
+      Touches,
+      Overlaps,
+      Within,
+      Crosses,
+    };
+
+    //! Build features matching a probe feature
+    struct Matches
+    {
+      //! Positions of the build features matching one of the predicates, in the order they were loaded
+      QVector< int > matches;
+      //! Positions of the build features intersecting the probe feature, only reported when testing the Disjoint predicate
+      QVector< int > intersecting;
+    };
+
+    //! Returns the predicate to test for "probe geometry <predicate> build geometry" instead
+    static Predicate reversePredicate( Predicate predicate );
+
+    /**
+     * Constructor for QgsSpatialJoinEngine, testing whether any of the \a predicates is TRUE.
+     *
+     * Predicates are tested in the order of the list.
+     */
+    explicit QgsSpatialJoinEngine( const QList< Predicate > &predicates );
+
+    /**
+     * Sets whether the tests of a probe feature stop at its first match, in the order the build features were loaded.
+     *
+     * When testing the Disjoint predicate, they stop once there is a match and an intersecting build feature.
+     */
+    void setFirstMatchOnly( bool firstMatchOnly ) { mFirstMatchOnly = firstMatchOnly; }
+
+    /**
+     * Loads the build features with a geometry from \a iterator. Returns FALSE if canceled.
+     */
+    bool loadBuildFeatures( QgsFeatureIterator &iterator, QgsFeedback *feedback );
+
+    //! Returns the number of build features loaded
+    int buildFeatureCount() const { return static_cast< int >( mBuildFeatures.size() ); }
+
+    //! Returns the build feature at \a position
+    const QgsFeature &buildFeature( int position ) const { return mBuildFeatures[ static_cast< std::size_t >( position ) ]; }
+
+    /**
+     * Tests the features of \a iterator against the build features, using up to \a threads threads.
+     *
+     * \a refineMatches is called by the threads testing a probe feature once its matches are found, and can
+     * update them. It may be empty. \a handleMatches is then called for each probe feature in the order of
+     * \a iterator, from the calling thread. Probe features without geometry have no matches.
+     *
+     * \a probeFeatureCount is used to report progress, if known.
+     */
+    void probe( QgsFeatureIterator &iterator, int threads, long long probeFeatureCount, QgsProcessingFeedback *feedback,
+                const std::function< void( const QgsFeature &feature, Matches &matches ) > &refineMatches,
+                const std::function< void( const QgsFeature &feature, const Matches &matches ) > &handleMatches ) const;
+
+  private:
+
+    //! Appends to \a positions the positions of the build features with a bounding box intersecting \a rectangle, in loading order
+    void candidates( const QgsRectangle &rectangle, std::vector< int > &positions ) const;
+
+    //! Returns the columns and rows of the cells of the grid overlapping \a rectangle
+    void cellRange( const QgsRectangle &rectangle, int &firstColumn, int &lastColumn, int &firstRow, int &lastRow ) const;
+
+    void buildGrid();
+
+    QList< Predicate > mPredicates;
+    bool mTestDisjoint = false;
+    bool mFirstMatchOnly = false;
+
+    std::vector< QgsFeature > mBuildFeatures;
+    std::vector< QgsRectangle > mBuildBounds;
+
+    // grid of the bounding boxes of the build features, the positions of the features of a cell are stored consecutively
+    QgsRectangle mExtent;
+    int mColumns = 0;
+    int mRows = 0;
+    double mCellWidth = 0;
+    double mCellHeight = 0;
+    std::vector< std::size_t > mCellOffsets;
+    std::vector< int > mCellPositions;
+};
+
+///@endcond PRIVATE
+
+#endif // QGSSPATIALJOINENGINE_H
@@ -17,6 +17,7 @@
 
 #include "qgsaspectfilter.h"
 #include <cmath>
+#include <vector>
 
 QgsAspectFilter::QgsAspectFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : QgsDerivativeFilter( inputFile, outputFile, outputFormat )
@@ -44,3 +45,15 @@ float QgsAspectFilter::processNineCellWindow(
   }
 }
 
+void QgsAspectFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *output, int count )
+{
+  std::vector< float > derX( count );
+  std::vector< float > derY( count );
+  calcFirstDerRow( rowAbove, row, rowBelow, derX.data(), derY.data(), count );
+
+  for ( int i = 0; i < count; ++i )
+  {
+    const bool nodata = derX[i] == mOutputNodataValue || derY[i] == mOutputNodataValue || ( derX[i] == 0.0 && derY[i] == 0.0 );
+    output[i] = nodata ? mOutputNodataValue : static_cast< float >( 180.0 + std::atan2( derX[i], derY[i] ) * 180.0 / M_PI );
+  }
+}
@@ -20,6 +20,7 @@
 
 #include "qgsderivativefilter.h"
 #include "qgis_analysis.h"
+#include "qgis_sip.h"
 
 /**
  * \ingroup analysis
@@ -36,6 +37,8 @@ class ANALYSIS_EXPORT QgsAspectFilter: public QgsDerivativeFilter
                                  float *x12, float *x22, float *x32,
                                  float *x13, float *x23, float *x33 ) override;
 
+    void processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *output, int count ) override SIP_SKIP;
+
 
 #ifdef HAVE_OPENCL
   private:
@@ -157,7 +157,53 @@ float QgsDerivativeFilter::calcFirstDerY( float *x11, float *x21, float *x31, fl
   return sum / ( weight * mCellSizeY ) * mZFactor;
 }
 
+///@cond PRIVATE
+
+/*
+ * Adds the term of a row (or column) of the window to a derivative, as in calcFirstDerX():
+ * the difference between the high and low cells when both are valid, else the difference
+ * with the middle cell on the valid side. lowMissing is the test used for the missing low cell.
+ */
+static inline void addDerivativeTerm( float high, float middle, float low, bool lowMissing, float nodata, int factor, double &sum, int &weight )
+{
+  const bool both = high != nodata && low != nodata;
+  const bool onlyLow = !both && high == nodata && low != nodata && middle != nodata;
+  const bool onlyHigh = !both && !onlyLow && lowMissing && high != nodata && middle != nodata;
+  const float difference = both ? high - low : ( onlyLow ? middle - low : high - middle );
+  sum = both || onlyLow || onlyHigh ? sum + factor * difference : sum;
+  weight += both ? 2 * factor : ( onlyLow || onlyHigh ? factor : 0 );
+}
 
+///@endcond
 
-
-
+void QgsDerivativeFilter::calcFirstDerRow( const float *rowAbove, const float *row, const float *rowBelow, float *derX, float *derY, int count ) const
+{
+  const float nodata = mInputNodataValue;
+  for ( int i = 0; i < count; ++i )
+  {
+    const float x11 = rowAbove[i];
+    const float x21 = rowAbove[i + 1];
+    const float x31 = rowAbove[i + 2];
+    const float x12 = row[i];
+    const float x22 = row[i + 1];
+    const float x32 = row[i + 2];
+    const float x13 = rowBelow[i];
+    const float x23 = rowBelow[i + 1];
+    const float x33 = rowBelow[i + 2];
+
+    double sumX = 0;
+    int weightX = 0;
+    addDerivativeTerm( x31, x21, x11, x11 == nodata, nodata, 1, sumX, weightX );
+    addDerivativeTerm( x32, x22, x12, x12 == nodata, nodata, 2, sumX, weightX );
+    addDerivativeTerm( x33, x23, x13, x13 == nodata, nodata, 1, sumX, weightX );
+    derX[i] = weightX == 0 ? mOutputNodataValue : static_cast< float >( sumX / ( weightX * mCellSizeX ) * mZFactor );
+
+    // calcFirstDerY() tests x31 instead of x13 for the missing cell of the first row, keep the same results
+    double sumY = 0;
+    int weightY = 0;
+    addDerivativeTerm( x11, x12, x13, x31 == nodata, nodata, 1, sumY, weightY );
+    addDerivativeTerm( x21, x22, x23, x23 == nodata, nodata, 2, sumY, weightY );
+    addDerivativeTerm( x31, x32, x33, x33 == nodata, nodata, 1, sumY, weightY );
+    derY[i] = weightY == 0 ? mOutputNodataValue : static_cast< float >( sumY / ( weightY * mCellSizeY ) * mZFactor );
+  }
+}
@@ -20,6 +20,7 @@
 
 #include "qgsninecellfilter.h"
 #include "qgis_analysis.h"
+#include "qgis_sip.h"
 
 /**
  * \ingroup analysis
@@ -41,6 +42,18 @@ class ANALYSIS_EXPORT QgsDerivativeFilter : public QgsNineCellFilter
     float calcFirstDerX( float *x11, float *x21, float *x31, float *x12, float *x22, float *x32, float *x13, float *x23, float *x33 ) const;
     //! Calculates the first order derivative in y-direction according to Horn (1981)
     float calcFirstDerY( float *x11, float *x21, float *x31, float *x12, float *x22, float *x32, float *x13, float *x23, float *x33 ) const;
+
+    /**
+     * Calculates the first order derivatives in x- and y-direction of \a count consecutive cells
+     * of a row, with the same results as calcFirstDerX() and calcFirstDerY().
+     *
+     * The input rows are the ones passed to processNineCellRow(). The cases of
+     * nodata cells are written as selects, which lets the compiler vectorize the loop.
+     *
+     * \note Not available in Python bindings
+     * \since QGIS 3.34
+     */
+    void calcFirstDerRow( const float *rowAbove, const float *row, const float *rowBelow, float *derX, float *derY, int count ) const SIP_SKIP;
 };
 
 #endif // QGSDERIVATIVEFILTER_H
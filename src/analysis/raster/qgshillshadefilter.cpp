@@ -17,6 +17,7 @@
 
 #include "qgshillshadefilter.h"
 #include <cmath>
+#include <vector>
 
 QgsHillshadeFilter::QgsHillshadeFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat, double lightAzimuth,
                                         double lightAngle )
@@ -70,6 +71,24 @@ void QgsHillshadeFilter::setLightAngle( float angle )
   mSinZenithRad = std::sin( angle * static_cast<float>( M_PI ) / 180.0f );
 }
 
+void QgsHillshadeFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *output, int count )
+{
+  std::vector< float > derX( count );
+  std::vector< float > derY( count );
+  calcFirstDerRow( rowAbove, row, rowBelow, derX.data(), derY.data(), count );
+
+  for ( int i = 0; i < count; ++i )
+  {
+    const float slope_rad = std::atan( std::sqrt( derX[i] * derX[i] + derY[i] * derY[i] ) );
+    //aspect undefined, take a neutral value
+    const float aspect_rad = derX[i] == 0 && derY[i] == 0 ? mAzimuthRad / 2.0f : static_cast< float >( M_PI + std::atan2( derX[i], derY[i] ) );
+    const float value = std::max( 0.0f, 255.0f * ( ( mCosZenithRad * std::cos( slope_rad ) ) +
+                                  ( mSinZenithRad * std::sin( slope_rad ) *
+                                    std::cos( mAzimuthRad - aspect_rad ) ) ) );
+    output[i] = derX[i] == mOutputNodataValue || derY[i] == mOutputNodataValue ? mOutputNodataValue : value;
+  }
+}
+
 #ifdef HAVE_OPENCL
 
 void QgsHillshadeFilter::addExtraRasterParams( std::vector<float> &params )
@@ -20,6 +20,7 @@
 
 #include "qgsderivativefilter.h"
 #include "qgis_analysis.h"
+#include "qgis_sip.h"
 
 /**
  * \ingroup analysis
@@ -36,6 +37,8 @@ class ANALYSIS_EXPORT QgsHillshadeFilter: public QgsDerivativeFilter
                                  float *x12, float *x22, float *x32,
                                  float *x13, float *x23, float *x33 ) override;
 
+    void processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *output, int count ) override SIP_SKIP;
+
     float lightAzimuth() const { return mLightAzimuth; }
     void setLightAzimuth( float azimuth );
     float lightAngle() const { return mLightAngle; }
@@ -31,7 +31,13 @@
 #include <QFile>
 #include <QDebug>
 #include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <deque>
 #include <iterator>
+#include <vector>
 
 
 
@@ -402,91 +408,102 @@ int QgsNineCellFilter::processRasterCPU( QgsFeedback *feedback )
     return 6;
   }
 
-  //keep only three scanlines in memory at a time, make room for initial and final nodata
-  const std::size_t bufferSize( sizeof( float ) * ( xSize + 2 ) );
-  float *scanLine1 = ( float * ) CPLMalloc( bufferSize );
-  float *scanLine2 = ( float * ) CPLMalloc( bufferSize );
-  float *scanLine3 = ( float * ) CPLMalloc( bufferSize );
-
-  float *resultLine = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+  // number of cells of the strips of rows computed by a thread
+  constexpr qgssize STRIP_CELLS = 1024 * 1024;
+  constexpr int MIN_STRIP_ROWS = 16;
 
-  //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
-  for ( int yIndex = 0; yIndex < ySize; ++yIndex )
+  // datasets cannot be shared between threads, each strip being computed reads from its own dataset
+  const int maxPendingStrips = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() ) + 1;
+  std::vector< gdal::dataset_unique_ptr > inputDatasets;
+  QVector< GDALDatasetH > freeInputDatasets;
+  for ( int i = 0; i < maxPendingStrips; ++i )
   {
-    if ( feedback && feedback->isCanceled() )
+    gdal::dataset_unique_ptr dataset( GDALOpen( mInputFile.toUtf8().constData(), GA_ReadOnly ) );
+    if ( !dataset )
     {
-      break;
+      return 1;
     }
+    freeInputDatasets << dataset.get();
+    inputDatasets.emplace_back( std::move( dataset ) );
+  }
+  QMutex freeInputDatasetsMutex;
 
-    if ( feedback )
+  const std::size_t lineSize = static_cast< std::size_t >( xSize ) + 2;
+  const int stripRows = std::max( MIN_STRIP_ROWS, static_cast< int >( STRIP_CELLS / lineSize ) );
+  const int stripCount = ( ySize + stripRows - 1 ) / stripRows;
+
+  const auto calculateStrip = [&]( int strip ) -> std::vector< float >
+  {
+    const int firstRow = strip * stripRows;
+    const int rows = std::min( stripRows, ySize - firstRow );
+
+    //the strip is read with the rows above and below it, make room for initial and final nodata on each line
+    //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
+    std::vector< float > lines( lineSize * static_cast< std::size_t >( rows + 2 ), mInputNodataValue );
+    const int firstReadRow = std::max( 0, firstRow - 1 );
+    const int lastReadRow = std::min( ySize - 1, firstRow + rows );
+    const int readRows = lastReadRow - firstReadRow + 1;
+    float *readStart = lines.data() + lineSize * static_cast< std::size_t >( firstReadRow - firstRow + 1 ) + 1;
+
+    GDALDatasetH dataset = nullptr;
     {
-      feedback->setProgress( 100.0 * static_cast< double >( yIndex ) / ySize );
+      QMutexLocker locker( &freeInputDatasetsMutex );
+      dataset = freeInputDatasets.takeLast();
     }
-
-    if ( yIndex == 0 )
+    if ( GDALRasterIO( GDALGetRasterBand( dataset, 1 ), GF_Read, 0, firstReadRow, xSize, readRows, readStart, xSize, readRows, GDT_Float32, 0, static_cast< int >( lineSize * sizeof( float ) ) ) != CE_None )
     {
-      //fill scanline 1 with (input) nodata for the values above the first row and feed scanline2 with the first row
-      for ( int a = 0; a < xSize + 2 ; ++a )
-      {
-        scanLine1[a] = mInputNodataValue;
-      }
-      // Read scanline2
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, 0, xSize, 1, &scanLine2[1], xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugError( QStringLiteral( "Raster IO Error" ) );
-      }
+      QgsDebugError( QStringLiteral( "Raster IO Error" ) );
     }
-    else
     {
-      //normally fetch only scanLine3 and release scanline 1 if we move forward one row
-      CPLFree( scanLine1 );
-      scanLine1 = scanLine2;
-      scanLine2 = scanLine3;
-      scanLine3 = ( float * ) CPLMalloc( bufferSize );
+      QMutexLocker locker( &freeInputDatasetsMutex );
+      freeInputDatasets << dataset;
     }
 
-    // Read scanline 3
-    if ( yIndex == ySize - 1 ) //fill the row below the bottom with nodata values
+    //a window of three lines slides down the strip
+    std::vector< float > result( static_cast< std::size_t >( xSize ) * rows );
+    for ( int row = 0; row < rows; ++row )
     {
-      for ( int a = 0; a < xSize + 2; ++a )
-      {
-        scanLine3[a] = mInputNodataValue;
-      }
+      float *line = lines.data() + lineSize * row;
+      processNineCellRow( line, line + lineSize, line + 2 * lineSize, result.data() + static_cast< std::size_t >( xSize ) * row, xSize );
     }
-    else
+    return result;
+  };
+
+  // strips are computed in parallel and written in order, waiting on the oldest one
+  std::deque< QFuture< std::vector< float > > > pendingStrips;
+  int nextStrip = 0;
+  for ( int strip = 0; strip < stripCount; ++strip )
+  {
+    while ( nextStrip < stripCount && static_cast< int >( pendingStrips.size() ) < maxPendingStrips && !( feedback && feedback->isCanceled() ) )
     {
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, yIndex + 1, xSize, 1, &scanLine3[1], xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugError( QStringLiteral( "Raster IO Error" ) );
-      }
+      pendingStrips.push_back( QtConcurrent::run( calculateStrip, nextStrip++ ) );
+    }
+    if ( pendingStrips.empty() )
+    {
+      break;
     }
-    // Set first and last extra columns to nodata
-    scanLine1[0] = scanLine1[xSize + 1] = mInputNodataValue;
-    scanLine2[0] = scanLine2[xSize + 1] = mInputNodataValue;
-    scanLine3[0] = scanLine3[xSize + 1] = mInputNodataValue;
-
 
+    std::vector< float > result = pendingStrips.front().result();
+    pendingStrips.pop_front();
 
-    // j is the x axis index, skip 0 and last cell that have been filled with nodata
-    for ( int xIndex = 0; xIndex < xSize ; ++xIndex )
+    const int firstRow = strip * stripRows;
+    const int rows = static_cast< int >( result.size() / static_cast< std::size_t >( xSize ) );
+    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, firstRow, xSize, rows, result.data(), xSize, rows, GDT_Float32, 0, 0 ) != CE_None )
     {
-      // cells(x, y) x11, x21, x31, x12, x22, x32, x13, x23, x33
-      resultLine[ xIndex ] = processNineCellWindow( &scanLine1[ xIndex ], &scanLine1[ xIndex + 1 ], &scanLine1[ xIndex + 2 ],
-                             &scanLine2[ xIndex ], &scanLine2[ xIndex + 1 ], &scanLine2[ xIndex + 2 ],
-                             &scanLine3[ xIndex ], &scanLine3[ xIndex + 1 ], &scanLine3[ xIndex + 2 ] );
-
+      QgsDebugError( QStringLiteral( "Raster IO Error" ) );
     }
 
-    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, yIndex, xSize, 1, resultLine, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
+    if ( feedback )
     {
-      QgsDebugError( QStringLiteral( "Raster IO Error" ) );
+      feedback->setProgress( 100.0 * static_cast< double >( firstRow + rows ) / ySize );
     }
   }
 
-  CPLFree( resultLine );
-  CPLFree( scanLine1 );
-  CPLFree( scanLine2 );
-  CPLFree( scanLine3 );
+  // strips still being computed use the input datasets
+  for ( QFuture< std::vector< float > > &future : pendingStrips )
+  {
+    future.waitForFinished();
+  }
 
   if ( feedback && feedback->isCanceled() )
   {
@@ -496,3 +513,14 @@ int QgsNineCellFilter::processRasterCPU( QgsFeedback *feedback )
   }
   return 0;
 }
+
+void QgsNineCellFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *output, int count )
+{
+  for ( int xIndex = 0; xIndex < count; ++xIndex )
+  {
+    // cells(x, y) x11, x21, x31, x12, x22, x32, x13, x23, x33
+    output[ xIndex ] = processNineCellWindow( &rowAbove[ xIndex ], &rowAbove[ xIndex + 1 ], &rowAbove[ xIndex + 2 ],
+                       &row[ xIndex ], &row[ xIndex + 1 ], &row[ xIndex + 2 ],
+                       &rowBelow[ xIndex ], &rowBelow[ xIndex + 1 ], &rowBelow[ xIndex + 2 ] );
+  }
+}
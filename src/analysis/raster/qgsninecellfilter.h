@@ -21,6 +21,7 @@
 #include <QString>
 #include "gdal.h"
 #include "qgis_analysis.h"
+#include "qgis_sip.h"
 #include "qgsogrutils.h"
 #include "qgsconfig.h"
 
@@ -83,6 +84,24 @@ class ANALYSIS_EXPORT QgsNineCellFilter
                                          float *x12, float *x22, float *x32,
                                          float *x13, float *x23, float *x33 ) = 0;
 
+    /**
+     * Calculates the output values of \a count consecutive cells of a row.
+     *
+     * \a rowAbove, \a row and \a rowBelow hold the input values of the row above the cells,
+     * of the cells row and of the row below the cells. They start with the cell on the left
+     * of the first cell and end with the cell on the right of the last cell, so each of them
+     * holds \a count + 2 values. Values outside of the raster are set to the input nodata value.
+     *
+     * The default implementation calls processNineCellWindow() for each cell. Subclasses
+     * can override it with loops over the whole row which the compiler is able to vectorize,
+     * they must return the same values as processNineCellWindow().
+     *
+     * \note Rows are processed concurrently from several threads, implementations must not modify the filter.
+     * \note Not available in Python bindings
+     * \since QGIS 3.34
+     */
+    virtual void processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *output, int count ) SIP_SKIP;
+
   private:
     //default constructor forbidden. We need input file, output file and format obligatory
     QgsNineCellFilter() = delete;
@@ -104,6 +123,8 @@ class ANALYSIS_EXPORT QgsNineCellFilter
 
     /**
      * \brief processRasterCPU executes the computation on the CPU
+     *
+     * The raster is split in strips of rows which are computed in parallel.
      * \param feedback instance of QgsFeedback, to allow for progress monitoring and cancellation
      * \return an opaque integer for error codes: 0 in case of success
      */
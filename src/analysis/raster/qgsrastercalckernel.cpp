@@ -0,0 +1,355 @@
+/***************************************************************************
+                         qgsrastercalckernel.cpp
+                         -----------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrastercalckernel.h"
+#include "qgsrasterblock.h"
+#include "qgsrasterblockkernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+///@cond PRIVATE
+
+// applies op to the values which are not no data, as QgsRasterMatrix::oneArgumentOperation()
+template <typename Op>
+static void unaryLoop( const double *values, qgssize count, double nodataValue, double *output, Op op )
+{
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    output[i] = values[i] == nodataValue ? nodataValue : op( values[i] );
+  }
+}
+
+// applies op to the pairs of values which are not no data, as QgsRasterMatrix::twoArgumentOperation()
+template <typename Op>
+static void binaryLoop( const double *left, const double *right, qgssize count, double nodataValue, double *output, Op op )
+{
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    output[i] = left[i] == nodataValue || right[i] == nodataValue ? nodataValue : op( left[i], right[i] );
+  }
+}
+
+///@endcond
+
+std::unique_ptr<QgsRasterCalcKernel> QgsRasterCalcKernel::compile( const QgsRasterCalcNode &node, double nodataValue )
+{
+  std::unique_ptr< QgsRasterCalcKernel > kernel( new QgsRasterCalcKernel() );
+  kernel->mNodataValue = nodataValue;
+  if ( !kernel->compileNode( node, 0 ) )
+    return nullptr;
+  return kernel;
+}
+
+bool QgsRasterCalcKernel::compileNode( const QgsRasterCalcNode &node, int depth )
+{
+  // the result of the node is pushed at position depth of the stack
+  mStackSize = std::max( mStackSize, depth + 1 );
+
+  switch ( node.mType )
+  {
+    case QgsRasterCalcNode::tNumber:
+    {
+      Instruction instruction { Instruction::Constant };
+      instruction.constant = node.mNumber;
+      mProgram.push_back( instruction );
+      return true;
+    }
+
+    case QgsRasterCalcNode::tRasterRef:
+    {
+      Instruction instruction { Instruction::Input };
+      instruction.input = mRasterReferences.indexOf( node.mRasterName );
+      if ( instruction.input < 0 )
+      {
+        instruction.input = mRasterReferences.size();
+        mRasterReferences << node.mRasterName;
+      }
+      mProgram.push_back( instruction );
+      return true;
+    }
+
+    case QgsRasterCalcNode::tOperator:
+    {
+      switch ( node.mOperator )
+      {
+        case QgsRasterCalcNode::opSQRT:
+        case QgsRasterCalcNode::opSIN:
+        case QgsRasterCalcNode::opCOS:
+        case QgsRasterCalcNode::opTAN:
+        case QgsRasterCalcNode::opASIN:
+        case QgsRasterCalcNode::opACOS:
+        case QgsRasterCalcNode::opATAN:
+        case QgsRasterCalcNode::opSIGN:
+        case QgsRasterCalcNode::opLOG:
+        case QgsRasterCalcNode::opLOG10:
+        case QgsRasterCalcNode::opABS:
+        {
+          if ( !node.mLeft || !compileNode( *node.mLeft, depth ) )
+            return false;
+          Instruction instruction { Instruction::Unary };
+          instruction.op = node.mOperator;
+          mProgram.push_back( instruction );
+          return true;
+        }
+
+        case QgsRasterCalcNode::opPLUS:
+        case QgsRasterCalcNode::opMINUS:
+        case QgsRasterCalcNode::opMUL:
+        case QgsRasterCalcNode::opDIV:
+        case QgsRasterCalcNode::opPOW:
+        case QgsRasterCalcNode::opEQ:
+        case QgsRasterCalcNode::opNE:
+        case QgsRasterCalcNode::opGT:
+        case QgsRasterCalcNode::opLT:
+        case QgsRasterCalcNode::opGE:
+        case QgsRasterCalcNode::opLE:
+        case QgsRasterCalcNode::opAND:
+        case QgsRasterCalcNode::opOR:
+        case QgsRasterCalcNode::opMAX:
+        case QgsRasterCalcNode::opMIN:
+        {
+          if ( !node.mLeft || !node.mRight || !compileNode( *node.mLeft, depth ) || !compileNode( *node.mRight, depth + 1 ) )
+            return false;
+          Instruction instruction { Instruction::Binary };
+          instruction.op = node.mOperator;
+          mProgram.push_back( instruction );
+          return true;
+        }
+
+        case QgsRasterCalcNode::opNONE:
+          return false;
+      }
+      return false;
+    }
+
+    case QgsRasterCalcNode::tFunction:
+    {
+      if ( node.mFunctionName != QLatin1String( "if" ) || node.mFunctionArgs.size() != 3 )
+        return false;
+      for ( int i = 0; i < 3; ++i )
+      {
+        if ( !node.mFunctionArgs.at( i ) || !compileNode( *node.mFunctionArgs.at( i ), depth + i ) )
+          return false;
+      }
+      mProgram.push_back( Instruction { Instruction::Condition } );
+      return true;
+    }
+
+    case QgsRasterCalcNode::tMatrix:
+      return false;
+  }
+  return false;
+}
+
+void QgsRasterCalcKernel::evaluate( const std::vector<const QgsRasterBlock *> &inputs, qgssize count, float *output ) const
+{
+  const qgssize spanSize = std::min( count, QgsRasterBlockKernels::SPAN_SIZE );
+  const std::size_t inputCount = static_cast< std::size_t >( mRasterReferences.size() );
+  std::vector< std::vector< double > > inputValues( inputCount, std::vector< double >( spanSize ) );
+  std::vector< quint8 > noData( spanSize );
+  std::vector< std::vector< double > > stackBuffers( static_cast< std::size_t >( mStackSize ), std::vector< double >( spanSize ) );
+  std::vector< const double * > stack;
+  stack.reserve( stackBuffers.size() );
+
+  for ( qgssize start = 0; start < count; start += spanSize )
+  {
+    const qgssize size = std::min( count - start, spanSize );
+
+    // input values are converted once per span, no data pixels are set to the no data value
+    for ( std::size_t i = 0; i < inputCount; ++i )
+    {
+      double *values = inputValues[i].data();
+      const QgsRasterBlock *block = i < inputs.size() ? inputs[i] : nullptr;
+      if ( !block || !block->readValues( start, size, values, noData.data() ) )
+      {
+        std::fill( values, values + size, mNodataValue );
+        continue;
+      }
+      for ( qgssize j = 0; j < size; ++j )
+      {
+        values[j] = noData[j] ? mNodataValue : values[j];
+      }
+    }
+
+    // each instruction writes its result to the buffer of its position in the stack
+    stack.clear();
+    for ( const Instruction &instruction : mProgram )
+    {
+      switch ( instruction.kind )
+      {
+        case Instruction::Input:
+          stack.push_back( inputValues[ static_cast< std::size_t >( instruction.input ) ].data() );
+          break;
+
+        case Instruction::Constant:
+        {
+          double *buffer = stackBuffers[stack.size()].data();
+          std::fill( buffer, buffer + size, instruction.constant );
+          stack.push_back( buffer );
+          break;
+        }
+
+        case Instruction::Unary:
+        {
+          double *buffer = stackBuffers[stack.size() - 1].data();
+          unary( instruction.op, stack.back(), size, buffer );
+          stack.back() = buffer;
+          break;
+        }
+
+        case Instruction::Binary:
+        {
+          const double *right = stack.back();
+          stack.pop_back();
+          double *buffer = stackBuffers[stack.size() - 1].data();
+          binary( instruction.op, stack.back(), right, size, buffer );
+          stack.back() = buffer;
+          break;
+        }
+
+        case Instruction::Condition:
+        {
+          const double *secondOption = stack.back();
+          stack.pop_back();
+          const double *firstOption = stack.back();
+          stack.pop_back();
+          const double *condition = stack.back();
+          double *buffer = stackBuffers[stack.size() - 1].data();
+          const double nodataValue = mNodataValue;
+          for ( qgssize j = 0; j < size; ++j )
+          {
+            buffer[j] = condition[j] == nodataValue ? nodataValue : ( condition[j] != 0 ? firstOption[j] : secondOption[j] );
+          }
+          stack.back() = buffer;
+          break;
+        }
+      }
+    }
+
+    const double *result = stack.back();
+    float *out = output + start;
+    for ( qgssize j = 0; j < size; ++j )
+    {
+      out[j] = static_cast< float >( result[j] );
+    }
+  }
+}
+
+void QgsRasterCalcKernel::unary( QgsRasterCalcNode::Operator op, const double *values, qgssize count, double *output ) const
+{
+  const double nodataValue = mNodataValue;
+  switch ( op )
+  {
+    case QgsRasterCalcNode::opSQRT:
+      unaryLoop( values, count, nodataValue, output, [nodataValue]( double v ) { return v < 0 ? nodataValue : std::sqrt( v ); } );
+      break;
+    case QgsRasterCalcNode::opSIN:
+      unaryLoop( values, count, nodataValue, output, []( double v ) { return std::sin( v ); } );
+      break;
+    case QgsRasterCalcNode::opCOS:
+      unaryLoop( values, count, nodataValue, output, []( double v ) { return std::cos( v ); } );
+      break;
+    case QgsRasterCalcNode::opTAN:
+      unaryLoop( values, count, nodataValue, output, []( double v ) { return std::tan( v ); } );
+      break;
+    case QgsRasterCalcNode::opASIN:
+      unaryLoop( values, count, nodataValue, output, []( double v ) { return std::asin( v ); } );
+      break;
+    case QgsRasterCalcNode::opACOS:
+      unaryLoop( values, count, nodataValue, output, []( double v ) { return std::acos( v ); } );
+      break;
+    case QgsRasterCalcNode::opATAN:
+      unaryLoop( values, count, nodataValue, output, []( double v ) { return std::atan( v ); } );
+      break;
+    case QgsRasterCalcNode::opSIGN:
+      unaryLoop( values, count, nodataValue, output, []( double v ) { return -v; } );
+      break;
+    case QgsRasterCalcNode::opLOG:
+      unaryLoop( values, count, nodataValue, output, [nodataValue]( double v ) { return v <= 0 ? nodataValue : std::log( v ); } );
+      break;
+    case QgsRasterCalcNode::opLOG10:
+      unaryLoop( values, count, nodataValue, output, [nodataValue]( double v ) { return v <= 0 ? nodataValue : std::log10( v ); } );
+      break;
+    case QgsRasterCalcNode::opABS:
+      unaryLoop( values, count, nodataValue, output, []( double v ) { return std::fabs( v ); } );
+      break;
+    default:
+      std::fill( output, output + count, nodataValue );
+      break;
+  }
+}
+
+void QgsRasterCalcKernel::binary( QgsRasterCalcNode::Operator op, const double *left, const double *right, qgssize count, double *output ) const
+{
+  const double nodataValue = mNodataValue;
+  switch ( op )
+  {
+    case QgsRasterCalcNode::opPLUS:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a + b; } );
+      break;
+    case QgsRasterCalcNode::opMINUS:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a - b; } );
+      break;
+    case QgsRasterCalcNode::opMUL:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a * b; } );
+      break;
+    case QgsRasterCalcNode::opDIV:
+      binaryLoop( left, right, count, nodataValue, output, [nodataValue]( double a, double b ) { return b == 0 ? nodataValue : a / b; } );
+      break;
+    case QgsRasterCalcNode::opPOW:
+      binaryLoop( left, right, count, nodataValue, output, [nodataValue]( double a, double b )
+      {
+        // same validity test as QgsRasterMatrix::testPowerValidity()
+        const bool valid = !( ( a == 0 && b < 0 ) || ( a < 0 && ( b - std::floor( b ) ) > 0 ) );
+        return valid ? std::pow( a, b ) : nodataValue;
+      } );
+      break;
+    case QgsRasterCalcNode::opEQ:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a == b ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opNE:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a == b ? 0.0 : 1.0; } );
+      break;
+    case QgsRasterCalcNode::opGT:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a > b ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opLT:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a < b ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opGE:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a >= b ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opLE:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a <= b ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opAND:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a != 0 && b != 0 ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opOR:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return a != 0 || b != 0 ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opMAX:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return std::max( a, b ); } );
+      break;
+    case QgsRasterCalcNode::opMIN:
+      binaryLoop( left, right, count, nodataValue, output, []( double a, double b ) { return std::min( a, b ); } );
+      break;
+    default:
+      std::fill( output, output + count, nodataValue );
+      break;
+  }
+}
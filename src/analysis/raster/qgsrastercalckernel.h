@@ -0,0 +1,109 @@
+/***************************************************************************
+                         qgsrastercalckernel.h
+                         ---------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSRASTERCALCKERNEL_H
+#define QGSRASTERCALCKERNEL_H
+
+#include "qgis_analysis.h"
+#include "qgis_sip.h"
+#include "qgis.h"
+#include "qgsrastercalcnode.h"
+
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+class QgsRasterBlock;
+
+#define SIP_NO_FILE
+
+/**
+ * \ingroup analysis
+ * \brief Raster calculator expression compiled to a program evaluated on whole blocks.
+ *
+ * The expression tree is flattened to a sequence of instructions, each of them
+ * applied to a span of pixels held in the CPU cache, instead of building an
+ * intermediate QgsRasterMatrix for every node. The loops of the instructions are
+ * simple enough for the compiler to vectorize them.
+ *
+ * Results are the same as the ones of QgsRasterCalcNode::calculate(): no data
+ * pixels are represented by the no data value and propagate through operators.
+ *
+ * Kernels are not modified by evaluate(), so a single kernel can evaluate blocks
+ * from several threads at the same time.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.34
+ */
+class ANALYSIS_EXPORT QgsRasterCalcKernel
+{
+  public:
+
+    /**
+     * Compiles the expression of \a node, using \a nodataValue for no data results.
+     *
+     * Returns NULLPTR if the expression contains nodes which cannot be compiled,
+     * like matrices.
+     */
+    static std::unique_ptr< QgsRasterCalcKernel > compile( const QgsRasterCalcNode &node, double nodataValue );
+
+    /**
+     * Returns the names of the rasters referenced by the expression, in the
+     * order of the blocks expected by evaluate().
+     */
+    QStringList rasterReferences() const { return mRasterReferences; }
+
+    /**
+     * Evaluates the expression on \a count pixels, with the blocks of the referenced
+     * rasters in \a inputs, and writes the results to \a output.
+     *
+     * Missing or invalid input blocks are considered as no data.
+     */
+    void evaluate( const std::vector< const QgsRasterBlock * > &inputs, qgssize count, float *output ) const;
+
+  private:
+
+    QgsRasterCalcKernel() = default;
+
+    struct Instruction
+    {
+      enum Kind
+      {
+        Input,
+        Constant,
+        Unary,
+        Binary,
+        Condition
+      };
+
+      Kind kind;
+      QgsRasterCalcNode::Operator op = QgsRasterCalcNode::opNONE;
+      int input = -1;
+      double constant = 0;
+    };
+
+    //! Appends the instructions of \a node, returns FALSE if it cannot be compiled
+    bool compileNode( const QgsRasterCalcNode &node, int depth );
+
+    void unary( QgsRasterCalcNode::Operator op, const double *values, qgssize count, double *output ) const;
+    void binary( QgsRasterCalcNode::Operator op, const double *left, const double *right, qgssize count, double *output ) const;
+
+    std::vector< Instruction > mProgram;
+    QStringList mRasterReferences;
+    int mStackSize = 0;
+    double mNodataValue = 0;
+};
+
+#endif // QGSRASTERCALCKERNEL_H
@@ -148,6 +148,10 @@ class ANALYSIS_EXPORT QgsRasterCalcNode
     QgsRasterCalcNode( const QgsRasterCalcNode &rh );
 #endif
 
+#ifndef SIP_RUN
+    friend class QgsRasterCalcKernel;
+#endif
+
     /**
      * Calculates result of raster calculation when tFunct type is used
      * \since QGIS 3.22
@@ -17,6 +17,7 @@
 
 #include "qgsgdalutils.h"
 #include "qgsrastercalculator.h"
+#include "qgsrastercalckernel.h"
 #include "qgsrasterdataprovider.h"
 #include "qgsrasterinterface.h"
 #include "qgsrasterlayer.h"
@@ -25,8 +26,15 @@
 #include "qgsfeedback.h"
 #include "qgsogrutils.h"
 #include "qgsproject.h"
+#include "qgsthreadingutils.h"
 
 #include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <deque>
 
 #include <cpl_string.h>
 #include <gdalwarper.h>
@@ -194,8 +202,24 @@ QgsRasterCalculator::Result QgsRasterCalculator::processCalculation( QgsFeedback
   GDALSetRasterNoDataValue( outputRasterBand, outputNodataValue );
 
 
-  // Take the fast route (process one line at a time) if we can
+  // Expressions without matrices are compiled to a kernel evaluated on strips of rows in parallel
+  std::unique_ptr< QgsRasterCalcKernel > kernel;
   if ( ! requiresMatrix )
+  {
+    kernel = QgsRasterCalcKernel::compile( *calcNode, outputNodataValue );
+  }
+
+  if ( kernel )
+  {
+    if ( !processStrips( *kernel, outputRasterBand, feedback ) )
+    {
+      //delete the dataset without closing (because it is faster)
+      gdal::fast_delete_and_close( outputDataset, outputDriver, mOutputFile );
+      return CalculationError;
+    }
+  }
+  // Take the fast route (process one line at a time) if we can
+  else if ( ! requiresMatrix )
   {
     // Map of raster names -> blocks
     std::map<QString, std::unique_ptr<QgsRasterBlock>> inputBlocks;
@@ -394,6 +418,132 @@ QgsRasterCalculator::Result QgsRasterCalculator::processCalculation( QgsFeedback
   return Success;
 }
 
+bool QgsRasterCalculator::processStrips( const QgsRasterCalcKernel &kernel, GDALRasterBandH outputRasterBand, QgsFeedback *feedback )
+{
+  // number of pixels of the strips of rows computed by a thread
+  constexpr qgssize STRIP_PIXELS = 512 * 512;
+
+  const QStringList references = kernel.rasterReferences();
+  QVector< QgsRasterCalculatorEntry > entries;
+  QVector< QgsCoordinateReferenceSystem > crs;
+  for ( const QString &reference : references )
+  {
+    auto it = std::find_if( mRasterEntries.constBegin(), mRasterEntries.constEnd(), [&reference]( const QgsRasterCalculatorEntry & entry ) { return entry.ref == reference; } );
+    if ( it == mRasterEntries.constEnd() )
+    {
+      mLastError = QObject::tr( "No raster layer for entry %1" ).arg( reference );
+      return false;
+    }
+    entries << *it;
+    crs << it->raster->crs();
+  }
+
+  // providers cannot be shared between threads, each strip being computed uses its own set of providers.
+  // The clones are detached from this thread, the strip using them assigns them to its thread.
+  const int maxPendingStrips = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() ) + 1;
+  std::vector< std::vector< std::unique_ptr< QgsRasterDataProvider > > > providerSets( static_cast< std::size_t >( maxPendingStrips ) );
+  QVector< std::vector< std::unique_ptr< QgsRasterDataProvider > > * > freeProviderSets;
+  for ( std::vector< std::unique_ptr< QgsRasterDataProvider > > &providers : providerSets )
+  {
+    for ( const QgsRasterCalculatorEntry &entry : std::as_const( entries ) )
+    {
+      std::unique_ptr< QgsRasterDataProvider > provider( entry.raster->dataProvider()->clone() );
+      if ( !provider )
+      {
+        mLastError = QObject::tr( "Could not read raster data for %1" ).arg( entry.ref );
+        return false;
+      }
+      provider->moveToThread( nullptr );
+      providers.emplace_back( std::move( provider ) );
+    }
+    freeProviderSets << &providers;
+  }
+  QMutex freeProviderSetsMutex;
+
+  const int stripRows = static_cast< int >( std::max< qgssize >( 1, STRIP_PIXELS / static_cast< qgssize >( mNumOutputColumns ) ) );
+  const int stripCount = ( mNumOutputRows + stripRows - 1 ) / stripRows;
+  const double rowHeight = mOutputRectangle.height() / mNumOutputRows;
+
+  const auto calculateStrip = [&]( int strip ) -> std::vector< float >
+  {
+    std::vector< std::unique_ptr< QgsRasterDataProvider > > *providers = nullptr;
+    {
+      QMutexLocker locker( &freeProviderSetsMutex );
+      providers = freeProviderSets.takeLast();
+    }
+
+    const int firstRow = strip * stripRows;
+    const int rows = std::min( stripRows, mNumOutputRows - firstRow );
+    QgsRectangle rect( mOutputRectangle );
+    rect.setYMaximum( mOutputRectangle.yMaximum() - rowHeight * firstRow );
+    rect.setYMinimum( rect.yMaximum() - rowHeight * rows );
+
+    std::vector< std::unique_ptr< QgsRasterBlock > > blocks;
+    std::vector< const QgsRasterBlock * > inputs;
+    for ( int i = 0; i < entries.size(); ++i )
+    {
+      QgsRasterDataProvider *provider = ( *providers )[ static_cast< std::size_t >( i ) ].get();
+      QgsScopedAssignObjectToCurrentThread assignProvider( provider );
+      if ( crs.at( i ) != mOutputCrs )
+      {
+        QgsRasterProjector proj;
+        proj.setCrs( crs.at( i ), mOutputCrs, mTransformContext );
+        proj.setInput( provider );
+        proj.setPrecision( QgsRasterProjector::Exact );
+        blocks.emplace_back( proj.block( entries.at( i ).bandNumber, rect, mNumOutputColumns, rows ) );
+      }
+      else
+      {
+        blocks.emplace_back( provider->block( entries.at( i ).bandNumber, rect, mNumOutputColumns, rows ) );
+      }
+      inputs.push_back( blocks.back().get() );
+    }
+
+    std::vector< float > result( static_cast< std::size_t >( mNumOutputColumns ) * rows );
+    kernel.evaluate( inputs, result.size(), result.data() );
+
+    QMutexLocker locker( &freeProviderSetsMutex );
+    freeProviderSets << providers;
+    return result;
+  };
+
+  // strips are computed in parallel and written in order, waiting on the oldest one
+  std::deque< QFuture< std::vector< float > > > pendingStrips;
+  int nextStrip = 0;
+  for ( int strip = 0; strip < stripCount; ++strip )
+  {
+    while ( nextStrip < stripCount && static_cast< int >( pendingStrips.size() ) < maxPendingStrips && !( feedback && feedback->isCanceled() ) )
+    {
+      pendingStrips.push_back( QtConcurrent::run( calculateStrip, nextStrip++ ) );
+    }
+    if ( pendingStrips.empty() )
+      break;
+
+    std::vector< float > result = pendingStrips.front().result();
+    pendingStrips.pop_front();
+
+    const int firstRow = strip * stripRows;
+    const int rows = static_cast< int >( result.size() / static_cast< std::size_t >( mNumOutputColumns ) );
+    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, firstRow, mNumOutputColumns, rows, result.data(), mNumOutputColumns, rows, GDT_Float32, 0, 0 ) != CE_None )
+    {
+      QgsDebugError( QStringLiteral( "RasterIO error!" ) );
+    }
+
+    if ( feedback )
+    {
+      feedback->setProgress( 100.0 * static_cast< double >( firstRow + rows ) / mNumOutputRows );
+    }
+  }
+
+  // strips still being computed use the providers and the kernel
+  for ( QFuture< std::vector< float > > &future : pendingStrips )
+  {
+    future.waitForFinished();
+  }
+
+  return true;
+}
+
 #ifdef HAVE_OPENCL
 QgsRasterCalculator::Result QgsRasterCalculator::processCalculationGPU( std::unique_ptr< QgsRasterCalcNode > calcNode, QgsFeedback *feedback )
 {
@@ -30,6 +30,7 @@
 
 class QgsRasterLayer;
 class QgsFeedback;
+class QgsRasterCalcKernel;
 
 /**
  * \ingroup analysis
@@ -200,6 +201,13 @@ class ANALYSIS_EXPORT QgsRasterCalculator
     //! Execute calculations on GPU
     Result processCalculationGPU( std::unique_ptr< QgsRasterCalcNode > calcNode, QgsFeedback *feedback = nullptr );
 
+    /**
+     * Evaluates \a kernel on strips of output rows computed in parallel, and writes
+     * them in order to \a outputRasterBand.
+     * \returns FALSE if the calculation failed
+     */
+    bool processStrips( const QgsRasterCalcKernel &kernel, GDALRasterBandH outputRasterBand, QgsFeedback *feedback );
+
     QString mFormulaString;
     QString mOutputFile;
     QString mOutputFormat;
@@ -84,3 +84,20 @@ float QgsRuggednessFilter::processNineCellWindow( float *x11, float *x21, float
   return std::sqrt( sum );
 }
 
+void QgsRuggednessFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *output, int count )
+{
+  const float nodata = mInputNodataValue;
+  for ( int i = 0; i < count; ++i )
+  {
+    const float x22 = row[i + 1];
+    const float neighbors[8] = { rowAbove[i], rowAbove[i + 1], rowAbove[i + 2], row[i], row[i + 2], rowBelow[i], rowBelow[i + 1], rowBelow[i + 2] };
+
+    // same summation order as processNineCellWindow(), nodata neighbors are skipped
+    double sum = 0;
+    for ( const float neighbor : neighbors )
+    {
+      sum += neighbor != nodata ? ( neighbor - x22 ) * ( neighbor - x22 ) : 0.0f;
+    }
+    output[i] = x22 == nodata ? mOutputNodataValue : static_cast< float >( std::sqrt( sum ) );
+  }
+}
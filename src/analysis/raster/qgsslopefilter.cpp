@@ -17,6 +17,7 @@
 
 #include "qgsslopefilter.h"
 #include <cmath>
+#include <vector>
 
 QgsSlopeFilter::QgsSlopeFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : QgsDerivativeFilter( inputFile, outputFile, outputFormat )
@@ -40,3 +41,15 @@ float QgsSlopeFilter::processNineCellWindow(
   return std::atan( std::sqrt( derX * derX + derY * derY ) ) * 180.0 / M_PI;
 }
 
+void QgsSlopeFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *output, int count )
+{
+  std::vector< float > derX( count );
+  std::vector< float > derY( count );
+  calcFirstDerRow( rowAbove, row, rowBelow, derX.data(), derY.data(), count );
+
+  for ( int i = 0; i < count; ++i )
+  {
+    const bool nodata = derX[i] == mOutputNodataValue || derY[i] == mOutputNodataValue;
+    output[i] = nodata ? mOutputNodataValue : static_cast< float >( std::atan( std::sqrt( derX[i] * derX[i] + derY[i] * derY[i] ) ) * 180.0 / M_PI );
+  }
+}
@@ -41,3 +41,30 @@ float QgsTotalCurvatureFilter::processNineCellWindow( float *x11, float *x21, fl
 
   return dxx * dxx + 2 * dxy * dxy + dyy * dyy;
 }
+
+void QgsTotalCurvatureFilter::processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *output, int count )
+{
+  const float nodata = mInputNodataValue;
+  const double cellSizeAvg = ( mCellSizeX + mCellSizeY ) / 2.0;
+  for ( int i = 0; i < count; ++i )
+  {
+    const float x11 = rowAbove[i];
+    const float x21 = rowAbove[i + 1];
+    const float x31 = rowAbove[i + 2];
+    const float x12 = row[i];
+    const float x22 = row[i + 1];
+    const float x32 = row[i + 2];
+    const float x13 = rowBelow[i];
+    const float x23 = rowBelow[i + 1];
+    const float x33 = rowBelow[i + 2];
+
+    //nodata if one value is the nodata value
+    const bool hasNodata = x11 == nodata || x21 == nodata || x31 == nodata || x12 == nodata || x22 == nodata
+                           || x32 == nodata || x13 == nodata || x23 == nodata || x33 == nodata;
+
+    const double dxx = ( x32 - 2 * x22 + x12 ) / ( mCellSizeX * mCellSizeX );
+    const double dxy = ( -x11 + x31 + x13 - x33 ) / ( 4 * cellSizeAvg * cellSizeAvg );
+    const double dyy = ( x21 - 2 * x22 + x23 ) / ( mCellSizeY * mCellSizeY );
+    output[i] = hasNodata ? mOutputNodataValue : static_cast< float >( dxx * dxx + 2 * dxy * dxy + dyy * dyy );
+  }
+}
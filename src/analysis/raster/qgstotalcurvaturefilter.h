@@ -20,6 +20,7 @@
 
 #include "qgsninecellfilter.h"
 #include "qgis_analysis.h"
+#include "qgis_sip.h"
 
 /**
  * \ingroup analysis
@@ -35,6 +36,8 @@ class ANALYSIS_EXPORT QgsTotalCurvatureFilter: public QgsNineCellFilter
     float processNineCellWindow( float *x11, float *x21, float *x31,
                                  float *x12, float *x22, float *x32,
                                  float *x13, float *x23, float *x33 ) override;
+
+    void processNineCellRow( float *rowAbove, float *row, float *rowBelow, float *output, int count ) override SIP_SKIP;
 };
 
 #endif // QGSTOTALCURVATUREFILTER_H
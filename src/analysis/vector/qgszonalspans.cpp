@@ -0,0 +1,212 @@
+/***************************************************************************
+                         qgszonalspans.cpp
+                         -----------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgszonalspans.h"
+#include "qgsgeometry.h"
+#include "qgscurvepolygon.h"
+#include "qgslinestring.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+QgsZonalSpans::QgsZonalSpans( const QgsRectangle &extent, int width, int height, double cellSizeX, double cellSizeY )
+  : mExtent( extent )
+  , mWidth( width )
+  , mHeight( height )
+  , mCellSizeX( std::fabs( cellSizeX ) )
+  , mCellSizeY( std::fabs( cellSizeY ) )
+{
+}
+
+qgssize QgsZonalSpans::addZone( int zone, const QgsGeometry &geometry )
+{
+  if ( geometry.isEmpty() || mWidth <= 0 || mHeight <= 0 )
+    return 0;
+
+  std::vector< Edge > edges;
+  for ( auto partIt = geometry.const_parts_begin(); partIt != geometry.const_parts_end(); ++partIt )
+  {
+    const QgsCurvePolygon *polygon = qgsgeometry_cast< const QgsCurvePolygon * >( *partIt );
+    if ( !polygon )
+      continue;
+
+    for ( int ringIndex = -1; ringIndex < polygon->numInteriorRings(); ++ringIndex )
+    {
+      const QgsCurve *ring = ringIndex < 0 ? polygon->exteriorRing() : polygon->interiorRing( ringIndex );
+      if ( !ring )
+        continue;
+
+      if ( const QgsLineString *line = qgsgeometry_cast< const QgsLineString * >( ring ) )
+      {
+        addRing( line->xData(), line->yData(), line->numPoints(), edges );
+      }
+      else
+      {
+        const std::unique_ptr< QgsLineString > segmentized( ring->curveToLine() );
+        addRing( segmentized->xData(), segmentized->yData(), segmentized->numPoints(), edges );
+      }
+    }
+  }
+
+  if ( edges.empty() )
+    return 0;
+
+  // active edge list swept from the top row down
+  std::sort( edges.begin(), edges.end(), []( const Edge & a, const Edge & b ) { return a.firstRow < b.firstRow; } );
+  int lastRow = 0;
+  for ( const Edge &edge : edges )
+    lastRow = std::max( lastRow, edge.lastRow );
+
+  std::vector< const Edge * > active;
+  std::vector< double > crossings;
+  std::vector< std::pair< int, int > > columns;
+  std::vector< std::pair< int, int > > columnsBelow;
+  std::vector< std::pair< int, int > > columnsBoth;
+  qgssize cellCount = 0;
+  std::size_t nextEdge = 0;
+  for ( int row = edges.front().firstRow; row <= lastRow; ++row )
+  {
+    while ( nextEdge < edges.size() && edges[ nextEdge ].firstRow <= row )
+    {
+      active.push_back( &edges[ nextEdge++ ] );
+    }
+    active.erase( std::remove_if( active.begin(), active.end(), [row]( const Edge * edge ) { return edge->lastRow < row; } ), active.end() );
+    if ( active.empty() )
+    {
+      if ( nextEdge == edges.size() )
+        break;
+      row = edges[ nextEdge ].firstRow - 1;
+      continue;
+    }
+
+    const double y = mExtent.yMaximum() - ( row + 0.5 ) * mCellSizeY;
+
+    // edges are crossed when the row is in [min y, max y), so vertices are only counted once
+    crossings.clear();
+    bool onVertex = false;
+    for ( const Edge *edge : std::as_const( active ) )
+    {
+      if ( y == edge->y1 || y == edge->y2 )
+        onVertex = true;
+      if ( std::min( edge->y1, edge->y2 ) <= y && y < std::max( edge->y1, edge->y2 ) )
+        crossings.push_back( edge->x1 + ( y - edge->y1 ) * ( edge->x2 - edge->x1 ) / ( edge->y2 - edge->y1 ) );
+    }
+    columns.clear();
+    crossingsToColumns( crossings, columns );
+
+    if ( onVertex )
+    {
+      // centers on a horizontal edge or on a vertex are inside the polygon just above the row
+      // and just below it at the same time only when they are in its interior
+      crossings.clear();
+      for ( const Edge *edge : std::as_const( active ) )
+      {
+        if ( std::min( edge->y1, edge->y2 ) < y && y <= std::max( edge->y1, edge->y2 ) )
+          crossings.push_back( edge->x1 + ( y - edge->y1 ) * ( edge->x2 - edge->x1 ) / ( edge->y2 - edge->y1 ) );
+      }
+      columnsBelow.clear();
+      crossingsToColumns( crossings, columnsBelow );
+
+      columnsBoth.clear();
+      auto above = columns.cbegin();
+      auto below = columnsBelow.cbegin();
+      while ( above != columns.cend() && below != columnsBelow.cend() )
+      {
+        const int first = std::max( above->first, below->first );
+        const int end = std::min( above->second, below->second );
+        if ( first < end )
+          columnsBoth.emplace_back( first, end );
+        if ( above->second < below->second )
+          ++above;
+        else
+          ++below;
+      }
+      columns.swap( columnsBoth );
+    }
+
+    for ( const std::pair< int, int > &range : std::as_const( columns ) )
+    {
+      mSpans.push_back( Span{ zone, range.first, range.second } );
+      mSpanRows.push_back( row );
+      cellCount += static_cast< qgssize >( range.second - range.first );
+    }
+  }
+
+  return cellCount;
+}
+
+void QgsZonalSpans::finalize()
+{
+  // counting sort of the spans by row, keeping the order of the zones within a row
+  mRowOffsets.assign( static_cast< std::size_t >( mHeight ) + 1, 0 );
+  for ( const int row : std::as_const( mSpanRows ) )
+  {
+    ++mRowOffsets[ static_cast< std::size_t >( row ) + 1 ];
+  }
+  for ( std::size_t row = 1; row < mRowOffsets.size(); ++row )
+  {
+    mRowOffsets[ row ] += mRowOffsets[ row - 1 ];
+  }
+
+  std::vector< Span > sorted( mSpans.size() );
+  std::vector< std::size_t > next( mRowOffsets.begin(), mRowOffsets.end() - 1 );
+  for ( std::size_t i = 0; i < mSpans.size(); ++i )
+  {
+    sorted[ next[ static_cast< std::size_t >( mSpanRows[ i ] ) ]++ ] = mSpans[ i ];
+  }
+  mSpans.swap( sorted );
+  mSpanRows = std::vector< int >();
+}
+
+void QgsZonalSpans::addRing( const double *x, const double *y, int count, std::vector< Edge > &edges ) const
+{
+  // rows are kept within the grid, one more row on each side avoids missing rows to rounding
+  const double maxRow = static_cast< double >( mHeight ) - 1;
+  for ( int i = 0; i < count; ++i )
+  {
+    const int j = i + 1 < count ? i + 1 : 0;
+    if ( y[ i ] == y[ j ] )
+      continue;
+
+    const double minY = std::min( y[ i ], y[ j ] );
+    const double maxY = std::max( y[ i ], y[ j ] );
+    const double firstRow = std::ceil( ( mExtent.yMaximum() - maxY ) / mCellSizeY - 0.5 ) - 1;
+    const double lastRow = std::floor( ( mExtent.yMaximum() - minY ) / mCellSizeY - 0.5 ) + 1;
+    if ( lastRow < 0 || firstRow > maxRow )
+      continue;
+
+    edges.push_back( Edge{ x[ i ], y[ i ], x[ j ], y[ j ],
+                           static_cast< int >( std::max( 0.0, firstRow ) ),
+                           static_cast< int >( std::min( maxRow, lastRow ) ) } );
+  }
+}
+
+void QgsZonalSpans::crossingsToColumns( std::vector< double > &crossings, std::vector< std::pair< int, int > > &columns ) const
+{
+  std::sort( crossings.begin(), crossings.end() );
+  const double width = mWidth;
+  for ( std::size_t i = 0; i + 1 < crossings.size(); i += 2 )
+  {
+    // columns with a center strictly between the crossings
+    const double first = std::floor( ( crossings[ i ] - mExtent.xMinimum() ) / mCellSizeX - 0.5 ) + 1;
+    const double end = std::ceil( ( crossings[ i + 1 ] - mExtent.xMinimum() ) / mCellSizeX - 0.5 );
+    const int clampedFirst = static_cast< int >( std::clamp( first, 0.0, width ) );
+    const int clampedEnd = static_cast< int >( std::clamp( end, 0.0, width ) );
+    if ( clampedFirst < clampedEnd )
+      columns.emplace_back( clampedFirst, clampedEnd );
+  }
+}
@@ -0,0 +1,126 @@
+/***************************************************************************
+                         qgszonalspans.h
+                         ---------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSZONALSPANS_H
+#define QGSZONALSPANS_H
+
+#include "qgis_analysis.h"
+#include "qgis_sip.h"
+#include "qgis.h"
+#include "qgsrectangle.h"
+
+#include <utility>
+#include <vector>
+
+class QgsGeometry;
+
+#define SIP_NO_FILE
+
+/**
+ * \ingroup analysis
+ * \brief Polygon zones rasterized to horizontal runs of cells of a raster grid.
+ *
+ * A cell belongs to a zone when its center lies in the interior of the zone's
+ * polygon, like the middle point test of the zonal statistics. Zones are
+ * rasterized with a sweep over the edges of their rings, computing where each
+ * row of cell centers crosses the edges, so no point in polygon test is made.
+ * Cells whose center lies on the boundary of a zone are not part of it.
+ *
+ * Once all zones are added, finalize() sorts the spans by row so that the
+ * spans of any row can be visited while streaming over the raster.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.34
+ */
+class ANALYSIS_EXPORT QgsZonalSpans
+{
+  public:
+
+    //! Horizontal run of cells of a zone on a row
+    struct Span
+    {
+      //! Zone index
+      int zone;
+      //! First column of the run
+      int firstColumn;
+      //! Column after the last one of the run
+      int endColumn;
+    };
+
+    /**
+     * Constructor for QgsZonalSpans, for a grid of \a width by \a height cells covering \a extent.
+     *
+     * The cells are \a cellSizeX by \a cellSizeY map units, the first row being at the top of the extent.
+     */
+    QgsZonalSpans( const QgsRectangle &extent, int width, int height, double cellSizeX, double cellSizeY );
+
+    /**
+     * Rasterizes the (multi)polygon \a geometry as the \a zone index.
+     *
+     * Curved rings are segmentized. Returns the number of cells covered by the zone.
+     */
+    qgssize addZone( int zone, const QgsGeometry &geometry );
+
+    /**
+     * Sorts the spans of all zones by row. Must be called after the last addZone()
+     * and before reading the spans of rows.
+     */
+    void finalize();
+
+    //! Returns the first span of \a row, spans of a row are in the order their zones were added.
+    const Span *rowBegin( int row ) const { return mSpans.data() + mRowOffsets[ static_cast< std::size_t >( row ) ]; }
+
+    //! Returns the span after the last span of \a row.
+    const Span *rowEnd( int row ) const { return mSpans.data() + mRowOffsets[ static_cast< std::size_t >( row ) + 1 ]; }
+
+    //! Returns the number of rows of the grid.
+    int height() const { return mHeight; }
+
+    //! Returns the number of columns of the grid.
+    int width() const { return mWidth; }
+
+  private:
+
+    struct Edge
+    {
+      double x1;
+      double y1;
+      double x2;
+      double y2;
+      int firstRow;
+      int lastRow;
+    };
+
+    void addRing( const double *x, const double *y, int count, std::vector< Edge > &edges ) const;
+
+    /**
+     * Sorts the \a crossings of a row with the edges of a zone, and appends to \a columns
+     * the ranges of the cells with a center strictly between pairs of crossings.
+     */
+    void crossingsToColumns( std::vector< double > &crossings, std::vector< std::pair< int, int > > &columns ) const;
+
+    QgsRectangle mExtent;
+    int mWidth = 0;
+    int mHeight = 0;
+    double mCellSizeX = 0;
+    double mCellSizeY = 0;
+
+    //! Spans of all zones, in the order the zones were added until finalize() sorts them by row
+    std::vector< Span > mSpans;
+    std::vector< int > mSpanRows;
+    std::vector< std::size_t > mRowOffsets;
+};
+
+#endif // QGSZONALSPANS_H
@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgszonalstatistics.h"
+#include "qgszonalspans.h"
 
 #include "qgsfeatureiterator.h"
 #include "qgsfeedback.h"
@@ -24,11 +25,20 @@
 #include "qgsvectorlayer.h"
 #include "processing/qgsrasteranalysisutils.h"
 #include "qgsrasterdataprovider.h"
+#include "qgsrasterblock.h"
 #include "qgsrasterlayer.h"
 #include "qgslogger.h"
 #include "qgsproject.h"
+#include "qgsthreadingutils.h"
 
 #include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <deque>
+#include <unordered_map>
 
 QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QString &attributePrefix, int rasterBand, QgsZonalStatistics::Statistics stats )
   : QgsZonalStatistics( polygonLayer,
@@ -57,7 +67,7 @@ QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterI
 
 QgsZonalStatistics::Result QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
 {
-  if ( !mRasterInterface )
+  if ( !mRasterInterface || mCellSizeX <= 0 || mCellSizeY <= 0 )
   {
     return RasterInvalid;
   }
@@ -119,9 +129,14 @@ QgsZonalStatistics::Result QgsZonalStatistics::calculateStatistics( QgsFeedback
   QgsFeatureIterator fi = vectorProvider->getFeatures( request );
   QgsFeature feature;
 
+  // all zones are rasterized to spans of cells once, and the raster is then read a single time for all of them
+  const QgsRectangle rasterBBox = mRasterInterface->extent();
+  QgsZonalSpans spans( rasterBBox, mRasterInterface->xSize(), mRasterInterface->ySize(), mCellSizeX, mCellSizeY );
+  QVector< QgsFeatureId > zoneIds;
+  QVector< QgsGeometry > zoneGeometries;
+
   int featureCounter = 0;
 
-  QgsChangedAttributesMap changeMap;
   while ( fi.nextFeature( feature ) )
   {
     ++featureCounter;
@@ -132,12 +147,51 @@ QgsZonalStatistics::Result QgsZonalStatistics::calculateStatistics( QgsFeedback
 
     if ( feedback )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
+      feedback->setProgress( 20.0 * static_cast< double >( featureCounter ) / featureCount );
     }
 
-    QgsGeometry featureGeometry = feature.geometry();
+    const QgsGeometry featureGeometry = feature.geometry();
+    if ( featureGeometry.isEmpty() || featureGeometry.boundingBox().intersect( rasterBBox ).isEmpty() )
+      continue;
+
+    spans.addZone( zoneIds.size(), featureGeometry );
+    zoneIds << feature.id();
+    zoneGeometries << featureGeometry;
+  }
+  spans.finalize();
 
-    QMap<QgsZonalStatistics::Statistic, QVariant> results = calculateStatistics( mRasterInterface, featureGeometry, mCellSizeX, mCellSizeY, mRasterBand, mStatistics );
+  const bool statsStoreValues = ( mStatistics & QgsZonalStatistics::Median ) ||
+                                ( mStatistics & QgsZonalStatistics::StDev ) ||
+                                ( mStatistics & QgsZonalStatistics::Variance );
+  const bool statsStoreValueCount = ( mStatistics & QgsZonalStatistics::Minority ) ||
+                                    ( mStatistics & QgsZonalStatistics::Majority );
+
+  std::vector< FeatureStats > zoneStats( static_cast< std::size_t >( zoneIds.size() ), FeatureStats( statsStoreValues, statsStoreValueCount ) );
+  if ( !( feedback && feedback->isCanceled() ) )
+  {
+    accumulateSpans( spans, zoneStats, statsStoreValues, statsStoreValueCount, feedback );
+  }
+
+  QgsChangedAttributesMap changeMap;
+  for ( int zone = 0; zone < zoneIds.size(); ++zone )
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      break;
+    }
+
+    FeatureStats &featureStats = zoneStats[ static_cast< std::size_t >( zone ) ];
+    QMap<QgsZonalStatistics::Statistic, QVariant> results;
+    if ( featureStats.count <= 1 )
+    {
+      //the cell resolution is probably larger than the polygon area, calculate the statistics of this zone with precise pixel - polygon intersection
+      results = calculateStatistics( mRasterInterface, zoneGeometries.at( zone ), mCellSizeX, mCellSizeY, mRasterBand, mStatistics );
+    }
+    else
+    {
+      results = statisticsFromFeatureStats( featureStats, mStatistics );
+    }
+    featureStats = FeatureStats();
 
     if ( results.empty() )
       continue;
@@ -148,7 +202,7 @@ QgsZonalStatistics::Result QgsZonalStatistics::calculateStatistics( QgsFeedback
       changeAttributeMap.insert( statFieldIndexes.value( result.first ), result.second );
     }
 
-    changeMap.insert( feature.id(), changeAttributeMap );
+    changeMap.insert( zoneIds.at( zone ), changeAttributeMap );
   }
 
   vectorProvider->changeAttributeValues( changeMap );
@@ -165,6 +219,155 @@ QgsZonalStatistics::Result QgsZonalStatistics::calculateStatistics( QgsFeedback
   return Success;
 }
 
+void QgsZonalStatistics::accumulateSpans( const QgsZonalSpans &spans, std::vector< FeatureStats > &zoneStats, bool storeValues, bool storeValueCounts, QgsFeedback *feedback )
+{
+  // number of cells of the strips of rows read by a thread
+  constexpr qgssize STRIP_CELLS = 512 * 512;
+
+  // providers cannot be shared between threads, each strip being read uses its own clone of the provider.
+  // The clones are detached from this thread, the strip using one assigns it to its thread. Other raster
+  // interfaces are read by the calling thread only.
+  const int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+  std::vector< std::unique_ptr< QgsRasterDataProvider > > providers;
+  QVector< QgsRasterInterface * > freeInterfaces;
+  if ( QgsRasterDataProvider *provider = dynamic_cast< QgsRasterDataProvider * >( mRasterInterface ) )
+  {
+    for ( int i = 0; maxThreads > 1 && i < maxThreads + 1; ++i )
+    {
+      std::unique_ptr< QgsRasterDataProvider > clone( provider->clone() );
+      if ( !clone )
+        break;
+      clone->moveToThread( nullptr );
+      freeInterfaces << clone.get();
+      providers.emplace_back( std::move( clone ) );
+    }
+  }
+  const bool concurrent = freeInterfaces.size() > 1;
+  if ( !concurrent )
+  {
+    freeInterfaces = { mRasterInterface };
+  }
+  const int maxPendingStrips = freeInterfaces.size();
+  QMutex freeInterfacesMutex;
+
+  const QgsRectangle rasterBBox = mRasterInterface->extent();
+  const int height = spans.height();
+  const int stripRows = static_cast< int >( std::max< qgssize >( 1, STRIP_CELLS / static_cast< qgssize >( std::max( 1, spans.width() ) ) ) );
+  const int stripCount = ( height + stripRows - 1 ) / stripRows;
+
+  using StripStats = std::unordered_map< int, FeatureStats >;
+  const auto calculateStrip = [&]( int strip ) -> StripStats
+  {
+    StripStats stripStats;
+    const int firstRow = strip * stripRows;
+    const int rows = std::min( stripRows, height - firstRow );
+
+    // only the columns covered by zones are read
+    int firstColumn = spans.width();
+    int endColumn = 0;
+    for ( int row = firstRow; row < firstRow + rows; ++row )
+    {
+      for ( const QgsZonalSpans::Span *span = spans.rowBegin( row ); span != spans.rowEnd( row ); ++span )
+      {
+        firstColumn = std::min( firstColumn, span->firstColumn );
+        endColumn = std::max( endColumn, span->endColumn );
+      }
+    }
+    if ( firstColumn >= endColumn )
+      return stripStats;
+
+    const QgsRectangle stripExtent( rasterBBox.xMinimum() + firstColumn * mCellSizeX,
+                                    rasterBBox.yMaximum() - ( firstRow + rows ) * mCellSizeY,
+                                    rasterBBox.xMinimum() + endColumn * mCellSizeX,
+                                    rasterBBox.yMaximum() - firstRow * mCellSizeY );
+
+    QgsRasterInterface *rasterInterface = nullptr;
+    {
+      QMutexLocker locker( &freeInterfacesMutex );
+      rasterInterface = freeInterfaces.takeLast();
+    }
+    std::unique_ptr< QgsRasterBlock > block;
+    if ( concurrent )
+    {
+      QgsScopedAssignObjectToCurrentThread assignProvider( static_cast< QgsRasterDataProvider * >( rasterInterface ) );
+      block.reset( rasterInterface->block( mRasterBand, stripExtent, endColumn - firstColumn, rows ) );
+    }
+    else
+    {
+      block.reset( rasterInterface->block( mRasterBand, stripExtent, endColumn - firstColumn, rows ) );
+    }
+    {
+      QMutexLocker locker( &freeInterfacesMutex );
+      freeInterfaces << rasterInterface;
+    }
+    if ( !block || !block->isValid() )
+      return stripStats;
+
+    bool isNoData = false;
+    for ( int row = firstRow; row < firstRow + rows; ++row )
+    {
+      for ( const QgsZonalSpans::Span *span = spans.rowBegin( row ); span != spans.rowEnd( row ); ++span )
+      {
+        FeatureStats &featureStats = stripStats.try_emplace( span->zone, storeValues, storeValueCounts ).first->second;
+        for ( int column = span->firstColumn; column < span->endColumn; ++column )
+        {
+          const double pixelValue = block->valueAndNoData( row - firstRow, column - firstColumn, isNoData );
+          if ( !isNoData && QgsRasterAnalysisUtils::validPixel( pixelValue ) )
+          {
+            featureStats.addValue( pixelValue );
+          }
+        }
+      }
+    }
+    return stripStats;
+  };
+
+  const auto mergeStrip = [&zoneStats]( const StripStats & stripStats )
+  {
+    for ( const auto &it : stripStats )
+    {
+      zoneStats[ static_cast< std::size_t >( it.first ) ].merge( it.second );
+    }
+  };
+
+  // strips are read in parallel and merged in order, waiting on the oldest one
+  std::deque< QFuture< StripStats > > pendingStrips;
+  int nextStrip = 0;
+  for ( int strip = 0; strip < stripCount; ++strip )
+  {
+    if ( concurrent )
+    {
+      while ( nextStrip < stripCount && static_cast< int >( pendingStrips.size() ) < maxPendingStrips && !( feedback && feedback->isCanceled() ) )
+      {
+        pendingStrips.push_back( QtConcurrent::run( calculateStrip, nextStrip++ ) );
+      }
+      if ( pendingStrips.empty() )
+        break;
+
+      mergeStrip( pendingStrips.front().result() );
+      pendingStrips.pop_front();
+    }
+    else
+    {
+      if ( feedback && feedback->isCanceled() )
+        break;
+
+      mergeStrip( calculateStrip( strip ) );
+    }
+
+    if ( feedback )
+    {
+      feedback->setProgress( 20.0 + 75.0 * static_cast< double >( strip + 1 ) / stripCount );
+    }
+  }
+
+  // strips still being read use the providers
+  for ( QFuture< StripStats > &future : pendingStrips )
+  {
+    future.waitForFinished();
+  }
+}
+
 QString QgsZonalStatistics::getUniqueFieldName( const QString &fieldName, const QList<QgsField> &newFields )
 {
   QgsVectorDataProvider *dp = mPolygonLayer->dataProvider();
@@ -339,6 +542,13 @@ QMap<QgsZonalStatistics::Statistic, QVariant> QgsZonalStatistics::calculateStati
     QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( rasterInterface, rasterBand, geometry, nCellsX, nCellsY, cellSizeX, cellSizeY, rasterBlockExtent, [ &featureStats ]( double value, double weight ) { featureStats.addValue( value, weight ); } );
   }
 
+  return statisticsFromFeatureStats( featureStats, statistics );
+}
+
+QMap<QgsZonalStatistics::Statistic, QVariant> QgsZonalStatistics::statisticsFromFeatureStats( FeatureStats &featureStats, QgsZonalStatistics::Statistics statistics )
+{
+  QMap<QgsZonalStatistics::Statistic, QVariant> results;
+
   // calculate the statistics
 
   if ( statistics & QgsZonalStatistics::Count )
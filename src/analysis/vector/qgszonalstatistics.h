@@ -23,6 +23,7 @@
 
 #include <limits>
 #include <cfloat>
+#include <vector>
 
 #include "qgis_analysis.h"
 #include "qgsfeedback.h"
@@ -38,6 +39,7 @@ class QgsRectangle;
 class QgsField;
 class QgsFeatureSink;
 class QgsFeatureSource;
+class QgsZonalSpans;
 
 /**
  * \ingroup analysis
@@ -214,6 +216,18 @@ class ANALYSIS_EXPORT QgsZonalStatistics
           if ( mStoreValues )
             values.append( value );
         }
+
+        //! Adds the values accumulated by \a other, which stores the same values and value counts
+        void merge( const FeatureStats &other )
+        {
+          sum += other.sum;
+          count += other.count;
+          min = std::min( min, other.min );
+          max = std::max( max, other.max );
+          for ( auto it = other.valueCount.constBegin(); it != other.valueCount.constEnd(); ++it )
+            valueCount.insert( it.key(), valueCount.value( it.key(), 0 ) + it.value() );
+          values.append( other.values );
+        }
         double sum = 0.0;
         double count = 0.0;
         double max = std::numeric_limits<double>::lowest();
@@ -226,6 +240,15 @@ class ANALYSIS_EXPORT QgsZonalStatistics
         bool mStoreValueCounts = false;
     };
 
+    //! Returns the \a statistics calculated from the values accumulated in \a featureStats
+    static QMap<QgsZonalStatistics::Statistic, QVariant> statisticsFromFeatureStats( FeatureStats &featureStats, QgsZonalStatistics::Statistics statistics );
+
+    /**
+     * Accumulates in \a zoneStats the values of the cells of each zone in \a spans, reading
+     * strips of rows of the raster in parallel.
+     */
+    void accumulateSpans( const QgsZonalSpans &spans, std::vector< FeatureStats > &zoneStats, bool storeValues, bool storeValueCounts, QgsFeedback *feedback );
+
     QString getUniqueFieldName( const QString &fieldName, const QList<QgsField> &newFields );
 
     QgsRasterInterface *mRasterInterface = nullptr;
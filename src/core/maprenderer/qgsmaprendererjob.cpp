@@ -1107,6 +1107,8 @@ void QgsMapRendererJob::cleanupSecondPassJobs( std::vector< LayerRenderJob > &jo
 
 void QgsMapRendererJob::cleanupLabelJob( LabelRenderJob &job )
 {
+  mLabelingRenderingTime = job.renderingTime;
+
   if ( job.img )
   {
     if ( mCache && !job.cached && !job.context.renderingStopped() )
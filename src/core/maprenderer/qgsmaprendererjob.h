@@ -427,6 +427,13 @@ class CORE_EXPORT QgsMapRendererJob : public QObject SIP_ABSTRACT
      */
     QHash< QgsMapLayer *, int > perLayerRenderingTime() const SIP_SKIP;
 
+    /**
+     * Returns the time (in ms) it took to render the labels, or -1 if labels were not rendered.
+     * \see perLayerRenderingTime()
+     * \since QGIS 3.34
+     */
+    int labelingRenderingTime() const { return mLabelingRenderingTime; }
+
     /**
      * Sets approximate render times (in ms) for map layers.
      *
@@ -519,6 +526,9 @@ class CORE_EXPORT QgsMapRendererJob : public QObject SIP_ABSTRACT
     //! Render time (in ms) per layer, by layer ID
     QHash< QgsWeakMapLayerPointer, int > mPerLayerRenderingTime;
 
+    //! Render time (in ms) of the labels
+    int mLabelingRenderingTime = -1;
+
     /**
      * Approximate expected layer rendering time per layer, by layer ID
      *
@@ -28,10 +28,22 @@
 #include "qgsprocessingparametertype.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgsprocessingmodelgroupbox.h"
+#include "qgsprocessingfeaturepipe.h"
+#include "qgsprocessingcheckpoint.h"
+#include "qgsprocessingprovider.h"
 
 #include <QFile>
 #include <QTextStream>
 #include <QRegularExpression>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <functional>
+#include <map>
+
 ///@cond NOT_STABLE
 
 QgsProcessingModelAlgorithm::QgsProcessingModelAlgorithm( const QString &name, const QString &group, const QString &groupId )
@@ -294,6 +306,94 @@ bool QgsProcessingModelAlgorithm::childOutputIsRequired( const QString &childId,
   return false;
 }
 
+/**
+ * Returns TRUE if the child \a algorithm of a model can be run in a worker thread. Models run the steps of their
+ * own children on the main thread, and Python algorithms need the interpreter lock held by the main thread, so
+ * both are run in the model thread like the algorithms which aren't thread safe. Only the algorithms of the C++
+ * providers are known not to be implemented in Python.
+ */
+static bool canRunInWorkerThread( const QgsProcessingAlgorithm *algorithm )
+{
+  if ( algorithm->flags() & QgsProcessingAlgorithm::FlagNoThreading || dynamic_cast< const QgsProcessingModelAlgorithm * >( algorithm ) )
+    return false;
+
+  const QString providerId = algorithm->provider() ? algorithm->provider()->id() : QString();
+  return providerId == QLatin1String( "native" ) || providerId == QLatin1String( "3d" ) || providerId == QLatin1String( "pdal" );
+}
+
+//! Child algorithm of a model which was prepared and is being run
+struct QgsProcessingModelRunningChild
+{
+  QString childId;
+  std::unique_ptr< QgsProcessingAlgorithm > algorithm;
+  QVariantMap parameters;
+  QVariantMap results;
+  bool skipGenericLogging = false;
+  QElapsedTimer time;
+
+  // only set for children running in a worker thread
+  std::unique_ptr< QgsProcessingContext > context;
+  std::unique_ptr< QgsProcessingBufferedFeedback > feedback;
+  std::atomic< double > progress { 0 };
+  bool failed = false;
+  // copies of the layers of the model's context read by the child, by id, which are only used by its worker thread
+  std::vector< std::pair< QString, std::unique_ptr< QgsMapLayer > > > layers;
+
+  // pipes streaming the features of the input and of the output of the child,
+  // from and to the children running at the same time
+  QString producerId;
+  std::shared_ptr< QgsProcessingFeaturePipe > inputPipe;
+  std::shared_ptr< QgsProcessingFeaturePipe > outputPipe;
+};
+
+/**
+ * Clears the checkpoint file of a context while the children of a model are run with it, so that
+ * they don't overwrite the progress of the model. The file is restored when the object is deleted.
+ */
+class QgsProcessingModelCheckpointFileOverride
+{
+  public:
+
+    explicit QgsProcessingModelCheckpointFileOverride( QgsProcessingContext &context )
+      : mContext( context )
+      , mFile( context.checkpointFile() )
+    {
+      mContext.setCheckpointFile( QString() );
+    }
+
+    ~QgsProcessingModelCheckpointFileOverride()
+    {
+      mContext.setCheckpointFile( mFile );
+    }
+
+  private:
+
+    QgsProcessingContext &mContext;
+    QString mFile;
+};
+
+/**
+ * Cancels a feedback when the object is deleted, so that the children of a model still running in worker
+ * threads are stopped when the model fails, before waiting for them.
+ */
+class QgsProcessingModelChildrenCanceler
+{
+  public:
+
+    explicit QgsProcessingModelChildrenCanceler( QgsFeedback &feedback )
+      : mFeedback( feedback )
+    {}
+
+    ~QgsProcessingModelChildrenCanceler()
+    {
+      mFeedback.cancel();
+    }
+
+  private:
+
+    QgsFeedback &mFeedback;
+};
+
 QVariantMap QgsProcessingModelAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
   QSet< QString > toExecute;
@@ -326,258 +426,762 @@ QVariantMap QgsProcessingModelAlgorithm::processAlgorithm( const QVariantMap &pa
 
   QVariantMap finalResults;
   QSet< QString > executed;
-  bool executedAlg = true;
-  while ( executedAlg && executed.count() < toExecute.count() )
+
+  // the children executed by a previous run with the same parameters, which was interrupted
+  QgsProcessingCheckpoint checkpoint( this, parameters, context );
+  const bool resuming = checkpoint.load();
+  QgsProcessingModelCheckpointFileOverride checkpointFileOverride( context );
+
+  QThread *modelThread = QThread::currentThread();
+
+  // cancels the children running in worker threads, when the model is canceled or fails
+  QgsFeedback childrenFeedback;
+  if ( feedback )
+    QObject::connect( feedback, &QgsFeedback::canceled, &childrenFeedback, &QgsFeedback::cancel, Qt::DirectConnection );
+
+  // children which can run in a background thread are run concurrently with the other children
+  // whose dependencies were executed, the prepare and post process steps are still run one at a time
+  const int maxConcurrentChildren = std::max( 1, context.maximumThreads() );
+  std::map< QString, std::unique_ptr< QgsProcessingModelRunningChild > > runningChildren;
+  // copies of the temporary layers which are not used by a running child
+  std::multimap< QString, std::unique_ptr< QgsMapLayer > > idleLayerCopies;
+  QStringList finishedChildren;
+  QMutex finishedChildrenMutex;
+  QWaitCondition childFinished;
+  // the pools are destroyed first, waiting for the children still running
+  QThreadPool childPool;
+  childPool.setMaxThreadCount( maxConcurrentChildren );
+  // children reading from a pipe each have their own thread, so that the child writing to the pipe never waits
+  // for them to be started. They are counted against the maximum number of threads, a child is only streamed
+  // to another one while a thread of this pool is left.
+  QThreadPool pipedChildPool;
+  pipedChildPool.setMaxThreadCount( std::max( 1, maxConcurrentChildren - 1 ) );
+  int pipedChildCount = 0;
+  // deleted before the pools, the children still running when the model fails are stopped
+  QgsProcessingModelChildrenCanceler childrenCanceler( childrenFeedback );
+
+  // the OUTPUT of a feature based child which is only read by the INPUT of another feature based child is
+  // streamed to it through a pipe, so both run at the same time and the features aren't stored in between. As
+  // streamed features can't be restored from a checkpoint, children aren't piped when the progress is saved
+  QMap< QString, QString > pipedConsumers;
+  if ( maxConcurrentChildren > 1 && !checkpoint.isEnabled() )
   {
-    executedAlg = false;
-    for ( const QString &childId : std::as_const( toExecute ) )
+    for ( const QString &producerId : std::as_const( toExecute ) )
     {
-      if ( feedback && feedback->isCanceled() )
-        break;
-
-      if ( executed.contains( childId ) )
+      const QgsProcessingModelChildAlgorithm &producer = mChildAlgorithms[ producerId ];
+      if ( !dynamic_cast< const QgsProcessingFeatureBasedAlgorithm * >( producer.algorithm() )
+           || !canRunInWorkerThread( producer.algorithm() )
+           || producer.algorithm()->flags() & QgsProcessingAlgorithm::FlagPruneModelBranchesBasedOnAlgorithmResults )
         continue;
 
-      bool canExecute = true;
-      const QSet< QString > dependencies = dependsOnChildAlgorithms( childId );
-      for ( const QString &dependency : dependencies )
+      bool canPipe = true;
+      const QMap<QString, QgsProcessingModelOutput> producerOutputs = producer.modelOutputs();
+      for ( const QgsProcessingModelOutput &output : producerOutputs )
       {
-        if ( !executed.contains( dependency ) )
+        if ( output.childOutputName() == QLatin1String( "OUTPUT" ) )
+          canPipe = false;
+      }
+
+      QString consumerId;
+      QString consumerParameter;
+      int references = 0;
+      for ( auto it = mChildAlgorithms.constBegin(); canPipe && it != mChildAlgorithms.constEnd(); ++it )
+      {
+        const QList< QgsProcessingModelChildDependency > dependencies = it->dependencies();
+        for ( const QgsProcessingModelChildDependency &dependency : dependencies )
         {
-          canExecute = false;
-          break;
+          if ( dependency.childId == producerId )
+            canPipe = false;
+        }
+
+        const QMap<QString, QgsProcessingModelChildParameterSources> sources = it->parameterSources();
+        for ( auto sourceIt = sources.constBegin(); sourceIt != sources.constEnd(); ++sourceIt )
+        {
+          for ( const QgsProcessingModelChildParameterSource &source : sourceIt.value() )
+          {
+            if ( source.source() == QgsProcessingModelChildParameterSource::ChildOutput && source.outputChildId() == producerId )
+            {
+              references++;
+              consumerId = it->childId();
+              consumerParameter = sourceIt.key();
+              if ( source.outputName() != QLatin1String( "OUTPUT" ) )
+                canPipe = false;
+            }
+          }
         }
       }
+      if ( !canPipe || references != 1 || !toExecute.contains( consumerId ) )
+        continue;
 
-      if ( !canExecute )
+      // feature based algorithms declare their input parameter first
+      const QgsProcessingModelChildAlgorithm &consumer = mChildAlgorithms[ consumerId ];
+      const QgsProcessingAlgorithm *consumerAlg = consumer.algorithm();
+      if ( !dynamic_cast< const QgsProcessingFeatureBasedAlgorithm * >( consumerAlg )
+           || !canRunInWorkerThread( consumerAlg )
+           || consumerAlg->parameterDefinitions().isEmpty()
+           || consumerAlg->parameterDefinitions().at( 0 )->name() != consumerParameter
+           || consumer.parameterSources().value( consumerParameter ).size() != 1 )
         continue;
 
-      executedAlg = true;
+      // expressions of the consumer may use the other results of the producer, which are only known once it's done
+      const QMap<QString, QgsProcessingModelChildParameterSources> consumerSources = consumer.parameterSources();
+      for ( const QgsProcessingModelChildParameterSources &sources : consumerSources )
+      {
+        for ( const QgsProcessingModelChildParameterSource &source : sources )
+        {
+          if ( source.source() == QgsProcessingModelChildParameterSource::Expression || source.source() == QgsProcessingModelChildParameterSource::ExpressionText )
+            canPipe = false;
+        }
+      }
+      if ( canPipe )
+        pipedConsumers.insert( producerId, consumerId );
+    }
+  }
 
-      const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ childId ];
-      std::unique_ptr< QgsProcessingAlgorithm > childAlg( child.algorithm()->create( child.configuration() ) );
+  // layers created by the previous children are only stored in the model's context, so children
+  // running in a worker thread are given copies of the layers instead of their ids. Layers can't be
+  // used by several threads at once, a copy is only given to one running child, and reused by the
+  // next children once that child is finished. Copies of memory layers share their features.
+  std::function< QVariant( const QVariant &, QgsProcessingModelRunningChild & ) > temporaryLayersAsCopies;
+  temporaryLayersAsCopies = [&]( const QVariant & value, QgsProcessingModelRunningChild & running ) -> QVariant
+  {
+    if ( value.type() == QVariant::List )
+    {
+      QVariantList list;
+      const QVariantList values = value.toList();
+      for ( const QVariant &v : values )
+        list << temporaryLayersAsCopies( v, running );
+      return list;
+    }
+    else if ( value.type() == QVariant::String )
+    {
+      const QString layerId = value.toString();
+      if ( QgsMapLayer *layer = context.temporaryLayerStore()->mapLayer( layerId ) )
+      {
+        std::unique_ptr< QgsMapLayer > copy;
+        auto idleCopy = idleLayerCopies.find( layerId );
+        if ( idleCopy != idleLayerCopies.end() )
+        {
+          copy = std::move( idleCopy->second );
+          idleLayerCopies.erase( idleCopy );
+        }
+        else
+        {
+          copy.reset( layer->clone() );
+        }
+        // the worker thread pulls the copy to its own thread
+        copy->moveToThread( nullptr );
+        const QVariant copyValue = QVariant::fromValue( copy.get() );
+        running.layers.emplace_back( layerId, std::move( copy ) );
+        return copyValue;
+      }
+    }
+    return value;
+  };
 
-      const bool skipGenericLogging = !verboseLog || childAlg->flags() & QgsProcessingAlgorithm::FlagSkipGenericModelLogging;
-      if ( feedback && !skipGenericLogging )
-        feedback->pushDebugInfo( QObject::tr( "Prepare algorithm: %1" ).arg( childId ) );
+  const auto prepareChild = [&]( const QString & childId, const QVariantMap & parameterOverrides ) -> std::unique_ptr< QgsProcessingModelRunningChild >
+  {
+    std::unique_ptr< QgsProcessingModelRunningChild > running = std::make_unique< QgsProcessingModelRunningChild >();
+    running->childId = childId;
+
+    const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ childId ];
+    running->algorithm.reset( child.algorithm()->create( child.configuration() ) );
+    QgsProcessingAlgorithm *childAlg = running->algorithm.get();
+
+    running->skipGenericLogging = !verboseLog || childAlg->flags() & QgsProcessingAlgorithm::FlagSkipGenericModelLogging;
+    if ( feedback && !running->skipGenericLogging )
+      feedback->pushDebugInfo( QObject::tr( "Prepare algorithm: %1" ).arg( childId ) );
+
+    QgsExpressionContext expContext = baseContext;
+    expContext << QgsExpressionContextUtils::processingAlgorithmScope( child.algorithm(), parameters, context )
+               << createExpressionContextScopeForChildAlgorithm( childId, context, parameters, childResults );
+    context.setExpressionContext( expContext );
+
+    QString error;
+    QVariantMap &childParams = running->parameters;
+    childParams = parametersForChildAlgorithm( child, parameters, childResults, expContext, error, &context );
+    if ( !error.isEmpty() )
+      throw QgsProcessingException( error );
+    for ( auto it = parameterOverrides.constBegin(); it != parameterOverrides.constEnd(); ++it )
+      childParams.insert( it.key(), it.value() );
+
+    if ( feedback && !running->skipGenericLogging )
+      feedback->setProgressText( QObject::tr( "Running %1 [%2/%3]" ).arg( child.description() ).arg( executed.count() + static_cast< int >( runningChildren.size() ) + 1 ).arg( toExecute.count() ) );
+
+    childInputs.insert( childId, QgsProcessingUtils::removePointerValuesFromMap( childParams ) );
+    QStringList params;
+    for ( auto childParamIt = childParams.constBegin(); childParamIt != childParams.constEnd(); ++childParamIt )
+    {
+      params << QStringLiteral( "%1: %2" ).arg( childParamIt.key(),
+             child.algorithm()->parameterDefinition( childParamIt.key() )->valueAsPythonString( childParamIt.value(), context ) );
+    }
 
-      QgsExpressionContext expContext = baseContext;
-      expContext << QgsExpressionContextUtils::processingAlgorithmScope( child.algorithm(), parameters, context )
-                 << createExpressionContextScopeForChildAlgorithm( childId, context, parameters, childResults );
-      context.setExpressionContext( expContext );
+    if ( feedback && !running->skipGenericLogging )
+    {
+      feedback->pushInfo( QObject::tr( "Input Parameters:" ) );
+      feedback->pushCommandInfo( QStringLiteral( "{ %1 }" ).arg( params.join( QLatin1String( ", " ) ) ) );
+    }
 
-      QString error;
-      QVariantMap childParams = parametersForChildAlgorithm( child, parameters, childResults, expContext, error, &context );
-      if ( !error.isEmpty() )
-        throw QgsProcessingException( error );
+    running->time.start();
+
+    bool ok = false;
 
-      if ( feedback && !skipGenericLogging )
-        feedback->setProgressText( QObject::tr( "Running %1 [%2/%3]" ).arg( child.description() ).arg( executed.count() + 1 ).arg( toExecute.count() ) );
+    auto prepareOnMainThread = [modelThread, &ok, childAlg, &childParams, &context, &modelFeedback]
+    {
+      Q_ASSERT_X( QThread::currentThread() == qApp->thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "childAlg->prepare() must be run on the main thread" );
+      ok = childAlg->prepare( childParams, context, &modelFeedback );
+      context.pushToThread( modelThread );
+    };
+
+    // Make sure we only run prepare steps on the main thread!
+    if ( modelThread == qApp->thread() )
+      ok = childAlg->prepare( childParams, context, &modelFeedback );
+    else
+    {
+      context.pushToThread( qApp->thread() );
+      QMetaObject::invokeMethod( qApp, prepareOnMainThread, Qt::BlockingQueuedConnection );
+    }
+
+    Q_ASSERT_X( QThread::currentThread() == context.thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "context was not transferred back to model thread" );
 
-      childInputs.insert( childId, QgsProcessingUtils::removePointerValuesFromMap( childParams ) );
-      QStringList params;
-      for ( auto childParamIt = childParams.constBegin(); childParamIt != childParams.constEnd(); ++childParamIt )
+    if ( !ok )
+    {
+      const QString error = ( childAlg->flags() & QgsProcessingAlgorithm::FlagCustomException ) ? QString() : QObject::tr( "Error encountered while running %1" ).arg( child.description() );
+      throw QgsProcessingException( error );
+    }
+
+    return running;
+  };
+
+  // runs a prepared child in the model thread, or in the main thread when it can't be run in a background thread
+  const auto runChild = [&]( QgsProcessingModelRunningChild & running )
+  {
+    const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ running.childId ];
+    QgsProcessingAlgorithm *childAlg = running.algorithm.get();
+    QVariantMap &childParams = running.parameters;
+    QVariantMap &results = running.results;
+    try
+    {
+      if ( childAlg->flags() & QgsProcessingAlgorithm::FlagNoThreading )
       {
-        params << QStringLiteral( "%1: %2" ).arg( childParamIt.key(),
-               child.algorithm()->parameterDefinition( childParamIt.key() )->valueAsPythonString( childParamIt.value(), context ) );
-      }
+        // child algorithm run step must be called on main thread
+        auto runOnMainThread = [modelThread, &context, &modelFeedback, &results, childAlg, &childParams]
+        {
+          Q_ASSERT_X( QThread::currentThread() == qApp->thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "childAlg->runPrepared() must be run on the main thread" );
+          results = childAlg->runPrepared( childParams, context, &modelFeedback );
+          context.pushToThread( modelThread );
+        };
+
+        if ( feedback && !running.skipGenericLogging && modelThread != qApp->thread() )
+          feedback->pushWarning( QObject::tr( "Algorithm “%1” cannot be run in a background thread, switching to main thread for this step" ).arg( childAlg->displayName() ) );
 
-      if ( feedback && !skipGenericLogging )
+        context.pushToThread( qApp->thread() );
+        QMetaObject::invokeMethod( qApp, runOnMainThread, Qt::BlockingQueuedConnection );
+      }
+      else
       {
-        feedback->pushInfo( QObject::tr( "Input Parameters:" ) );
-        feedback->pushCommandInfo( QStringLiteral( "{ %1 }" ).arg( params.join( QLatin1String( ", " ) ) ) );
+        // safe to run on model thread
+        results = childAlg->runPrepared( childParams, context, &modelFeedback );
       }
+    }
+    catch ( QgsProcessingException & )
+    {
+      const QString error = ( childAlg->flags() & QgsProcessingAlgorithm::FlagCustomException ) ? QString() : QObject::tr( "Error encountered while running %1" ).arg( child.description() );
+      throw QgsProcessingException( error );
+    }
 
-      QElapsedTimer childTime;
-      childTime.start();
-
-      bool ok = false;
+    Q_ASSERT_X( QThread::currentThread() == context.thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "context was not transferred back to model thread" );
+  };
 
-      QThread *modelThread = QThread::currentThread();
+  // starts running a prepared child in a worker thread of the pool
+  const auto startChild = [&]( std::unique_ptr< QgsProcessingModelRunningChild > running, QThreadPool & pool )
+  {
+    // runPrepared() runs the child with a copy of this context made in the worker thread, which is pushed back
+    // to the thread of this context. postProcess() then merges it into the model's context on the main thread.
+    running->context = std::make_unique< QgsProcessingContext >();
+    running->context->copyThreadSafeSettings( context );
+    running->context->pushToThread( qApp->thread() );
+    running->feedback = std::make_unique< QgsProcessingBufferedFeedback >( &childrenFeedback );
+    for ( auto it = running->parameters.begin(); it != running->parameters.end(); ++it )
+      it.value() = temporaryLayersAsCopies( it.value(), *running );
+
+    QgsProcessingModelRunningChild *child = running.get();
+    // the progress is reported to the model's feedback by the model thread
+    QObject::connect( child->feedback.get(), &QgsFeedback::progressChanged, child->feedback.get(), [child]( double progress ) { child->progress = progress; }, Qt::DirectConnection );
+    runningChildren[ running->childId ] = std::move( running );
+    pool.start( [child, modelThread, &finishedChildren, &finishedChildrenMutex, &childFinished, &childrenFeedback]
+    {
+      for ( const auto &layer : child->layers )
+        layer.second->moveToThread( QThread::currentThread() );
 
-      auto prepareOnMainThread = [modelThread, &ok, &childAlg, &childParams, &context, &modelFeedback]
+      // the execution time doesn't include the time spent waiting for a thread
+      child->time.start();
+      try
       {
-        Q_ASSERT_X( QThread::currentThread() == qApp->thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "childAlg->prepare() must be run on the main thread" );
-        ok = childAlg->prepare( childParams, context, &modelFeedback );
-        context.pushToThread( modelThread );
-      };
-
-      // Make sure we only run prepare steps on the main thread!
-      if ( modelThread == qApp->thread() )
-        ok = childAlg->prepare( childParams, context, &modelFeedback );
-      else
+        child->results = child->algorithm->runPrepared( child->parameters, *child->context, child->feedback.get() );
+      }
+      catch ( ... )
       {
-        context.pushToThread( qApp->thread() );
-        QMetaObject::invokeMethod( qApp, prepareOnMainThread, Qt::BlockingQueuedConnection );
+        child->failed = true;
       }
+      // unblock the children at the other end of the pipes, in case the child stopped before its sink or source were deleted
+      if ( child->outputPipe )
+        child->outputPipe->closeWriting();
+      if ( child->inputPipe )
+        child->inputPipe->closeReading();
 
-      Q_ASSERT_X( QThread::currentThread() == context.thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "context was not transferred back to model thread" );
+      // the copies of the layers are reused or deleted by the model thread
+      for ( const auto &layer : child->layers )
+        layer.second->moveToThread( modelThread );
 
-      if ( !ok )
+      const bool failed = child->failed;
       {
-        const QString error = ( childAlg->flags() & QgsProcessingAlgorithm::FlagCustomException ) ? QString() : QObject::tr( "Error encountered while running %1" ).arg( child.description() );
-        throw QgsProcessingException( error );
+        QMutexLocker locker( &finishedChildrenMutex );
+        finishedChildren << child->childId;
+        childFinished.wakeAll();
       }
 
-      QVariantMap results;
-      try
+      // the model fails with this child, the other children are stopped. This child was added to the
+      // finished children first, so that it's finished before the children it cancels.
+      if ( failed )
+        childrenFeedback.cancel();
+    } );
+  };
+
+  // copies the child alg's outputs which are model outputs to the final model outputs
+  const auto addModelOutputs = [&]( const QString & childId, const QVariantMap & results )
+  {
+    const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ childId ];
+    const QMap<QString, QgsProcessingModelOutput> outputs = child.modelOutputs();
+    for ( auto outputIt = outputs.constBegin(); outputIt != outputs.constEnd(); ++outputIt )
+    {
+      const int outputSortKey = mOutputOrder.indexOf( QStringLiteral( "%1:%2" ).arg( childId, outputIt->childOutputName() ) );
+      switch ( mInternalVersion )
       {
-        if ( childAlg->flags() & QgsProcessingAlgorithm::FlagNoThreading )
-        {
-          // child algorithm run step must be called on main thread
-          auto runOnMainThread = [modelThread, &context, &modelFeedback, &results, &childAlg, &childParams]
+        case QgsProcessingModelAlgorithm::InternalVersion::Version1:
+          finalResults.insert( childId + ':' + outputIt->name(), results.value( outputIt->childOutputName() ) );
+          break;
+        case QgsProcessingModelAlgorithm::InternalVersion::Version2:
+          if ( const QgsProcessingParameterDefinition *modelParam = modelParameterFromChildIdAndOutputName( child.childId(), outputIt.key() ) )
           {
-            Q_ASSERT_X( QThread::currentThread() == qApp->thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "childAlg->runPrepared() must be run on the main thread" );
-            results = childAlg->runPrepared( childParams, context, &modelFeedback );
-            context.pushToThread( modelThread );
-          };
+            finalResults.insert( modelParam->name(), results.value( outputIt->childOutputName() ) );
+          }
+          break;
+      }
 
-          if ( feedback && !skipGenericLogging && modelThread != qApp->thread() )
-            feedback->pushWarning( QObject::tr( "Algorithm “%1” cannot be run in a background thread, switching to main thread for this step" ).arg( childAlg->displayName() ) );
+      if ( !results.value( outputIt->childOutputName() ).toString().isEmpty() )
+      {
+        QgsProcessingContext::LayerDetails &details = context.layerToLoadOnCompletionDetails( results.value( outputIt->childOutputName() ).toString() );
+        details.groupName = mOutputGroup;
+        if ( outputSortKey > 0 )
+          details.layerSortKey = outputSortKey;
+      }
+    }
+  };
 
-          context.pushToThread( qApp->thread() );
-          QMetaObject::invokeMethod( qApp, runOnMainThread, Qt::BlockingQueuedConnection );
-        }
-        else
-        {
-          // safe to run on model thread
-          results = childAlg->runPrepared( childParams, context, &modelFeedback );
-        }
+  // saves the children executed so far, and their results
+  const auto saveCheckpoint = [&]
+  {
+    QVariantMap state;
+    state.insert( QStringLiteral( "executed" ), QStringList( executed.constBegin(), executed.constEnd() ) );
+    state.insert( QStringLiteral( "results" ), childResults );
+    checkpoint.setState( state );
+    checkpoint.save();
+  };
+
+  const auto finishChild = [&]( QgsProcessingModelRunningChild & running )
+  {
+    const QString &childId = running.childId;
+    const QgsProcessingModelChildAlgorithm &child = mChildAlgorithms[ childId ];
+    QgsProcessingAlgorithm *childAlg = running.algorithm.get();
+
+    // the copies of the layers read by the child are given to the next children
+    for ( auto &layer : running.layers )
+      idleLayerCopies.emplace( layer.first, std::move( layer.second ) );
+    running.layers.clear();
+
+    if ( running.feedback )
+    {
+      // report what the child algorithm logged while running in its worker thread
+      if ( feedback && !running.skipGenericLogging )
+        feedback->pushDebugInfo( QObject::tr( "Finished algorithm: %1" ).arg( childId ) );
+      if ( feedback )
+      {
+        QgsProcessingBufferedFeedback::reportMessages( running.feedback->takeMessages(), feedback );
       }
-      catch ( QgsProcessingException & )
+
+      if ( running.failed )
       {
         const QString error = ( childAlg->flags() & QgsProcessingAlgorithm::FlagCustomException ) ? QString() : QObject::tr( "Error encountered while running %1" ).arg( child.description() );
         throw QgsProcessingException( error );
       }
+    }
 
-      Q_ASSERT_X( QThread::currentThread() == context.thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "context was not transferred back to model thread" );
+    // a child stopped by the user didn't complete its outputs, it's run again when the model is resumed
+    if ( feedback && feedback->isCanceled() )
+    {
+      if ( running.inputPipe )
+        pipedChildCount--;
+      running.algorithm.reset( nullptr );
+      return;
+    }
 
-      QVariantMap ppRes;
-      auto postProcessOnMainThread = [modelThread, &ppRes, &childAlg, &context, &modelFeedback]
-      {
-        Q_ASSERT_X( QThread::currentThread() == qApp->thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "childAlg->postProcess() must be run on the main thread" );
-        ppRes = childAlg->postProcess( context, &modelFeedback );
-        context.pushToThread( modelThread );
-      };
+    QVariantMap &results = running.results;
+    QVariantMap ppRes;
+    auto postProcessOnMainThread = [modelThread, &ppRes, childAlg, &context, &modelFeedback]
+    {
+      Q_ASSERT_X( QThread::currentThread() == qApp->thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "childAlg->postProcess() must be run on the main thread" );
+      ppRes = childAlg->postProcess( context, &modelFeedback );
+      context.pushToThread( modelThread );
+    };
+
+    // Make sure we only run postProcess steps on the main thread!
+    if ( modelThread == qApp->thread() )
+      ppRes = childAlg->postProcess( context, &modelFeedback );
+    else
+    {
+      context.pushToThread( qApp->thread() );
+      QMetaObject::invokeMethod( qApp, postProcessOnMainThread, Qt::BlockingQueuedConnection );
+    }
 
-      // Make sure we only run postProcess steps on the main thread!
-      if ( modelThread == qApp->thread() )
-        ppRes = childAlg->postProcess( context, &modelFeedback );
-      else
-      {
-        context.pushToThread( qApp->thread() );
-        QMetaObject::invokeMethod( qApp, postProcessOnMainThread, Qt::BlockingQueuedConnection );
-      }
+    Q_ASSERT_X( QThread::currentThread() == context.thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "context was not transferred back to model thread" );
 
-      Q_ASSERT_X( QThread::currentThread() == context.thread(), "QgsProcessingModelAlgorithm::processAlgorithm", "context was not transferred back to model thread" );
+    if ( !ppRes.isEmpty() )
+      results = ppRes;
 
-      if ( !ppRes.isEmpty() )
-        results = ppRes;
+    // the features streamed through a pipe were only kept until they were read, there's no output left to report
+    if ( running.outputPipe )
+      results.remove( QStringLiteral( "OUTPUT" ) );
+    if ( running.inputPipe )
+      pipedChildCount--;
 
-      childResults.insert( childId, results );
+    childResults.insert( childId, results );
+    addModelOutputs( childId, results );
+    executed.insert( childId );
 
-      // look through child alg's outputs to determine whether any of these should be copied
-      // to the final model outputs
-      const QMap<QString, QgsProcessingModelOutput> outputs = child.modelOutputs();
-      for ( auto outputIt = outputs.constBegin(); outputIt != outputs.constEnd(); ++outputIt )
+    std::function< void( const QString &, const QString & )> pruneAlgorithmBranchRecursive;
+    pruneAlgorithmBranchRecursive = [&]( const QString & id, const QString &branch = QString() )
+    {
+      const QSet<QString> toPrune = dependentChildAlgorithms( id, branch );
+      for ( const QString &targetId : toPrune )
       {
-        const int outputSortKey = mOutputOrder.indexOf( QStringLiteral( "%1:%2" ).arg( childId, outputIt->childOutputName() ) );
-        switch ( mInternalVersion )
+        if ( executed.contains( targetId ) )
+          continue;
+
+        executed.insert( targetId );
+        pruneAlgorithmBranchRecursive( targetId, branch );
+      }
+    };
+
+    // prune remaining algorithms if they are dependent on a branch from this child which didn't eventuate
+    const QgsProcessingOutputDefinitions outputDefs = childAlg->outputDefinitions();
+    for ( const QgsProcessingOutputDefinition *outputDef : outputDefs )
+    {
+      if ( outputDef->type() == QgsProcessingOutputConditionalBranch::typeName() && !results.value( outputDef->name() ).toBool() )
+      {
+        pruneAlgorithmBranchRecursive( childId, outputDef->name() );
+      }
+    }
+
+    if ( childAlg->flags() & QgsProcessingAlgorithm::FlagPruneModelBranchesBasedOnAlgorithmResults )
+    {
+      // check if any dependent algorithms should be canceled based on the outputs of this algorithm run
+      // first find all direct dependencies of this algorithm by looking through all remaining child algorithms
+      for ( const QString &candidateId : std::as_const( toExecute ) )
+      {
+        if ( executed.contains( candidateId ) )
+          continue;
+
+        // a pending algorithm was found..., check it's parameter sources to see if it links to any of the current
+        // algorithm's outputs
+        const QgsProcessingModelChildAlgorithm &candidate = mChildAlgorithms[ candidateId ];
+        const QMap<QString, QgsProcessingModelChildParameterSources> candidateParams = candidate.parameterSources();
+        QMap<QString, QgsProcessingModelChildParameterSources>::const_iterator paramIt = candidateParams.constBegin();
+        bool pruned = false;
+        for ( ; paramIt != candidateParams.constEnd(); ++paramIt )
         {
-          case QgsProcessingModelAlgorithm::InternalVersion::Version1:
-            finalResults.insert( childId + ':' + outputIt->name(), results.value( outputIt->childOutputName() ) );
-            break;
-          case QgsProcessingModelAlgorithm::InternalVersion::Version2:
-            if ( const QgsProcessingParameterDefinition *modelParam = modelParameterFromChildIdAndOutputName( child.childId(), outputIt.key() ) )
+          for ( const QgsProcessingModelChildParameterSource &source : paramIt.value() )
+          {
+            if ( source.source() == QgsProcessingModelChildParameterSource::ChildOutput && source.outputChildId() == childId )
             {
-              finalResults.insert( modelParam->name(), results.value( outputIt->childOutputName() ) );
+              // ok, this one is dependent on the current alg. Did we get a value for it?
+              if ( !results.contains( source.outputName() ) )
+              {
+                // oh no, nothing returned for this parameter. Gotta trim the branch back!
+                pruned = true;
+                // skip the dependent alg..
+                executed.insert( candidateId );
+                //... and everything which depends on it
+                pruneAlgorithmBranchRecursive( candidateId, QString() );
+                break;
+              }
             }
+          }
+          if ( pruned )
             break;
         }
+      }
+    }
 
-        if ( !results.value( outputIt->childOutputName() ).toString().isEmpty() )
+    running.algorithm.reset( nullptr );
+    modelFeedback.setCurrentStep( executed.count() );
+    if ( feedback && !running.skipGenericLogging )
+      feedback->pushInfo( QObject::tr( "OK. Execution took %1 s (%n output(s)).", nullptr, results.count() ).arg( running.time.elapsed() / 1000.0 ) );
+
+    if ( checkpoint.isEnabled() )
+      saveCheckpoint();
+  };
+
+  if ( resuming )
+  {
+    // the results of a child are only reused if its outputs can still be read, the layers which were
+    // only stored in the context of the previous run are lost
+    const auto outputsExist = [&]( const QString & childId, const QVariantMap & results ) -> bool
+    {
+      const QgsProcessingOutputDefinitions outputDefs = mChildAlgorithms[ childId ].algorithm()->outputDefinitions();
+      for ( const QgsProcessingOutputDefinition *outputDef : outputDefs )
+      {
+        const QString type = outputDef->type();
+        const bool isLayer = type == QgsProcessingOutputMapLayer::typeName() || type == QgsProcessingOutputVectorLayer::typeName()
+                             || type == QgsProcessingOutputRasterLayer::typeName() || type == QgsProcessingOutputPointCloudLayer::typeName()
+                             || type == QgsProcessingOutputVectorTileLayer::typeName() || type == QgsProcessingOutputMultipleLayers::typeName();
+        const bool isFile = type == QgsProcessingOutputFile::typeName() || type == QgsProcessingOutputFolder::typeName() || type == QgsProcessingOutputHtml::typeName();
+        if ( !isLayer && !isFile )
+          continue;
+
+        const QVariant value = results.value( outputDef->name() );
+        const QStringList paths = value.type() == QVariant::List ? value.toStringList() : QStringList( value.toString() );
+        for ( const QString &path : paths )
         {
-          QgsProcessingContext::LayerDetails &details = context.layerToLoadOnCompletionDetails( results.value( outputIt->childOutputName() ).toString() );
-          details.groupName = mOutputGroup;
-          if ( outputSortKey > 0 )
-            details.layerSortKey = outputSortKey;
+          if ( path.isEmpty() )
+            continue;
+          if ( isLayer && !QgsProcessingUtils::mapLayerFromString( path, context ) )
+            return false;
+          if ( isFile && !QFileInfo::exists( path ) )
+            return false;
         }
       }
+      return true;
+    };
+
+    const QVariantMap state = checkpoint.state();
+    const QVariantMap savedResults = state.value( QStringLiteral( "results" ) ).toMap();
+    const QStringList savedExecuted = state.value( QStringLiteral( "executed" ) ).toStringList();
+    QSet< QString > restored;
+    for ( const QString &childId : savedExecuted )
+    {
+      // children without results were pruned
+      if ( toExecute.contains( childId ) && ( !savedResults.contains( childId ) || outputsExist( childId, savedResults.value( childId ).toMap() ) ) )
+        restored.insert( childId );
+    }
+    // the children depending on a child which is run again are run again too
+    for ( const QString &childId : std::as_const( toExecute ) )
+    {
+      if ( !restored.contains( childId ) )
+        restored.subtract( dependentChildAlgorithms( childId ) );
+    }
 
+    for ( const QString &childId : std::as_const( restored ) )
+    {
       executed.insert( childId );
+      if ( savedResults.contains( childId ) )
+      {
+        const QVariantMap results = savedResults.value( childId ).toMap();
+        childResults.insert( childId, results );
+        addModelOutputs( childId, results );
+      }
+    }
+    modelFeedback.setCurrentStep( executed.count() );
+    if ( feedback )
+      feedback->pushInfo( QObject::tr( "Resuming from checkpoint %1, skipping %n algorithm(s) already executed", nullptr, executed.count() ).arg( checkpoint.file() ) );
+  }
+
+  // starts a child, and the chain of children reading the features it writes as they are written
+  std::function< void( const QString &, const QString &, const std::shared_ptr< QgsProcessingFeaturePipe > & ) > startPipedChildren;
+  startPipedChildren = [&]( const QString & childId, const QString & producerId, const std::shared_ptr< QgsProcessingFeaturePipe > &inputPipe )
+  {
+    // the consumer can only be started along with this child if it only depends on children which
+    // were executed, and on this child and the children writing to it through pipes
+    QString consumerId = pipedChildCount < maxConcurrentChildren - 1 ? pipedConsumers.value( childId ) : QString();
+    if ( !consumerId.isEmpty() )
+    {
+      const QSet< QString > childDependencies = dependsOnChildAlgorithms( childId );
+      const QSet< QString > consumerDependencies = dependsOnChildAlgorithms( consumerId );
+      for ( const QString &dependency : consumerDependencies )
+      {
+        if ( !executed.contains( dependency ) && dependency != childId && !childDependencies.contains( dependency ) )
+          consumerId.clear();
+      }
+    }
+
+    QVariantMap parameterOverrides;
+    std::shared_ptr< QgsProcessingFeaturePipe > outputPipe;
+    if ( !consumerId.isEmpty() )
+    {
+      // the thread of the consumer is reserved before this child is started, so that the chain never waits for a thread
+      pipedChildCount++;
+      outputPipe = QgsProcessingFeaturePipe::create();
+      parameterOverrides.insert( QStringLiteral( "OUTPUT" ), outputPipe->uri() );
+    }
+
+    std::unique_ptr< QgsProcessingModelRunningChild > running;
+    try
+    {
+      running = prepareChild( childId, parameterOverrides );
+    }
+    catch ( QgsProcessingException & )
+    {
+      // don't leave the producer waiting for this child to read its features
+      if ( inputPipe )
+        inputPipe->closeReading();
+      throw;
+    }
+    running->producerId = producerId;
+    running->inputPipe = inputPipe;
+    running->outputPipe = outputPipe;
+    if ( inputPipe )
+    {
+      startChild( std::move( running ), pipedChildPool );
+    }
+    else
+    {
+      startChild( std::move( running ), childPool );
+    }
 
-      std::function< void( const QString &, const QString & )> pruneAlgorithmBranchRecursive;
-      pruneAlgorithmBranchRecursive = [&]( const QString & id, const QString &branch = QString() )
+    if ( outputPipe )
+    {
+      // the consumer is prepared once the fields of the features it reads are known
+      outputPipe->waitForSink();
+      childResults.insert( childId, QVariantMap( { { QStringLiteral( "OUTPUT" ), outputPipe->uri() } } ) );
+      startPipedChildren( consumerId, childId, outputPipe );
+    }
+  };
+
+  try
+  {
+    while ( executed.count() < toExecute.count() )
+    {
+      bool startedAlg = false;
+      for ( const QString &childId : std::as_const( toExecute ) )
       {
-        const QSet<QString> toPrune = dependentChildAlgorithms( id, branch );
-        for ( const QString &targetId : toPrune )
+        if ( feedback && feedback->isCanceled() )
+          break;
+
+        if ( executed.contains( childId ) || runningChildren.count( childId ) )
+          continue;
+
+        bool canExecute = true;
+        const QSet< QString > dependencies = dependsOnChildAlgorithms( childId );
+        for ( const QString &dependency : dependencies )
         {
-          if ( executed.contains( targetId ) )
-            continue;
+          if ( !executed.contains( dependency ) )
+          {
+            canExecute = false;
+            break;
+          }
+        }
 
-          executed.insert( targetId );
-          pruneAlgorithmBranchRecursive( targetId, branch );
+        if ( !canExecute )
+          continue;
+
+        startedAlg = true;
+
+        if ( pipedConsumers.contains( childId ) )
+        {
+          startPipedChildren( childId, QString(), nullptr );
+          continue;
         }
-      };
 
-      // prune remaining algorithms if they are dependent on a branch from this child which didn't eventuate
-      const QgsProcessingOutputDefinitions outputDefs = childAlg->outputDefinitions();
-      for ( const QgsProcessingOutputDefinition *outputDef : outputDefs )
-      {
-        if ( outputDef->type() == QgsProcessingOutputConditionalBranch::typeName() && !results.value( outputDef->name() ).toBool() )
+        std::unique_ptr< QgsProcessingModelRunningChild > running = prepareChild( childId, QVariantMap() );
+        if ( maxConcurrentChildren > 1 && canRunInWorkerThread( running->algorithm.get() ) )
         {
-          pruneAlgorithmBranchRecursive( childId, outputDef->name() );
+          startChild( std::move( running ), childPool );
+        }
+        else
+        {
+          runChild( *running );
+          finishChild( *running );
         }
       }
 
-      if ( childAlg->flags() & QgsProcessingAlgorithm::FlagPruneModelBranchesBasedOnAlgorithmResults )
+      if ( feedback && feedback->isCanceled() )
+        break;
+
+      if ( runningChildren.empty() )
       {
-        // check if any dependent algorithms should be canceled based on the outputs of this algorithm run
-        // first find all direct dependencies of this algorithm by looking through all remaining child algorithms
-        for ( const QString &candidateId : std::as_const( toExecute ) )
+        if ( !startedAlg )
+          break;
+        continue;
+      }
+
+      // wait for one of the children running in worker threads to be done. Children reading
+      // from a pipe are only finished after the child writing to it, unless they failed.
+      QString finishedId;
+      {
+        QMutexLocker locker( &finishedChildrenMutex );
+        while ( finishedId.isEmpty() )
         {
-          if ( executed.contains( candidateId ) )
-            continue;
+          int finishedIndex = -1;
+          for ( int i = 0; i < finishedChildren.size(); ++i )
+          {
+            const QgsProcessingModelRunningChild &candidate = *runningChildren.at( finishedChildren.at( i ) );
+            if ( candidate.failed )
+            {
+              finishedIndex = i;
+              break;
+            }
+            if ( finishedIndex < 0 && ( candidate.producerId.isEmpty() || executed.contains( candidate.producerId ) ) )
+              finishedIndex = i;
+          }
 
-          // a pending algorithm was found..., check it's parameter sources to see if it links to any of the current
-          // algorithm's outputs
-          const QgsProcessingModelChildAlgorithm &candidate = mChildAlgorithms[ candidateId ];
-          const QMap<QString, QgsProcessingModelChildParameterSources> candidateParams = candidate.parameterSources();
-          QMap<QString, QgsProcessingModelChildParameterSources>::const_iterator paramIt = candidateParams.constBegin();
-          bool pruned = false;
-          for ( ; paramIt != candidateParams.constEnd(); ++paramIt )
+          if ( finishedIndex >= 0 )
           {
-            for ( const QgsProcessingModelChildParameterSource &source : paramIt.value() )
+            finishedId = finishedChildren.takeAt( finishedIndex );
+          }
+          else
+          {
+            const bool woken = childFinished.wait( &finishedChildrenMutex, modelThread == qApp->thread() ? 10 : 100 );
+            if ( modelThread == qApp->thread() )
             {
-              if ( source.source() == QgsProcessingModelChildParameterSource::ChildOutput && source.outputChildId() == childId )
-              {
-                // ok, this one is dependent on the current alg. Did we get a value for it?
-                if ( !results.contains( source.outputName() ) )
-                {
-                  // oh no, nothing returned for this parameter. Gotta trim the branch back!
-                  pruned = true;
-                  // skip the dependent alg..
-                  executed.insert( candidateId );
-                  //... and everything which depends on it
-                  pruneAlgorithmBranchRecursive( candidateId, QString() );
-                  break;
-                }
-              }
+              // children running in worker threads may wait for the main thread, e.g. for network requests
+              locker.unlock();
+              QCoreApplication::processEvents( QEventLoop::ExcludeUserInputEvents );
+              locker.relock();
+            }
+            if ( !woken && feedback )
+            {
+              // the progress of the model includes the progress of the children running in worker threads
+              double progress = executed.count();
+              for ( const auto &running : runningChildren )
+                progress += running.second->progress / 100.0;
+              feedback->setProgress( 100.0 * progress / toExecute.count() );
             }
-            if ( pruned )
-              break;
           }
         }
       }
-
-      childAlg.reset( nullptr );
-      modelFeedback.setCurrentStep( executed.count() );
-      if ( feedback && !skipGenericLogging )
-        feedback->pushInfo( QObject::tr( "OK. Execution took %1 s (%n output(s)).", nullptr, results.count() ).arg( childTime.elapsed() / 1000.0 ) );
+      auto finishedIt = runningChildren.find( finishedId );
+      std::unique_ptr< QgsProcessingModelRunningChild > finished = std::move( finishedIt->second );
+      runningChildren.erase( finishedIt );
+      finishChild( *finished );
     }
+  }
+  catch ( QgsProcessingException & )
+  {
+    // keep the children executed before the failure, the model is resumed from the failed child
+    if ( checkpoint.isEnabled() )
+      saveCheckpoint();
+    throw;
+  }
+  // children still running when the model was canceled
+  childPool.waitForDone();
+  pipedChildPool.waitForDone();
 
+  if ( checkpoint.isEnabled() )
+  {
     if ( feedback && feedback->isCanceled() )
-      break;
+      saveCheckpoint();
+    else
+      checkpoint.remove();
   }
   if ( feedback )
     feedback->pushDebugInfo( QObject::tr( "Model processed OK. Executed %n algorithm(s) total in %1 s.", nullptr, executed.count() ).arg( totalTime.elapsed() / 1000.0 ) );
@@ -30,8 +30,21 @@
 #include "qgsmeshlayer.h"
 #include "qgspointcloudlayer.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsprocessingcheckpoint.h"
+#include "qgsprocessingfeaturepipe.h"
+#include "qgsvectordataprovider.h"
 #include <QRegularExpression>
 #include <QRegularExpressionMatch>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
 
 QgsProcessingAlgorithm::~QgsProcessingAlgorithm()
 {
@@ -1110,11 +1123,120 @@ QgsCoordinateReferenceSystem QgsProcessingFeatureBasedAlgorithm::sourceCrs() con
     return QgsCoordinateReferenceSystem();
 }
 
+///@cond PRIVATE
+
+/**
+ * Returns TRUE if the \a output of a feature based algorithm is a file which is kept after the
+ * algorithm is run, so that it can be reopened to resume the algorithm from a checkpoint. Layers
+ * written through a provider, such as memory layers and database tables, and the temporary
+ * outputs of the context are not.
+ */
+static bool isCheckpointOutputFile( const QString &output, const QgsProcessingContext &context )
+{
+  const QFileInfo outputInfo( output.section( '|', 0, 0 ) );
+  if ( !outputInfo.isFile() )
+    return false;
+
+  const QString tempFolder = QDir( QgsProcessingUtils::tempFolder( &context ) ).absolutePath() + '/';
+  return !outputInfo.absoluteFilePath().startsWith( tempFolder );
+}
+
+/**
+ * Removes the features written to the \a output file after the checkpoint was saved, when
+ * resuming a run interrupted before it committed them. Throws a QgsProcessingException if
+ * features written before the checkpoint are missing.
+ */
+static void restoreCheckpointOutput( const QString &output, long long writtenCount, const QString &checkpointFile, QgsProcessingContext &context )
+{
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( output, QString(), QStringLiteral( "ogr" ), QgsVectorLayer::LayerOptions( context.transformContext() ) );
+  if ( !layer->isValid() )
+    throw QgsProcessingException( QObject::tr( "Could not open %1 to resume from checkpoint %2, delete the checkpoint to run the algorithm from the start" ).arg( output, checkpointFile ) );
+
+  std::vector< QgsFeatureId > ids;
+  QgsFeatureIterator it = layer->dataProvider()->getFeatures( QgsFeatureRequest().setFlags( QgsFeatureRequest::NoGeometry ).setNoAttributes() );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+    ids.emplace_back( f.id() );
+
+  if ( static_cast< long long >( ids.size() ) < writtenCount )
+    throw QgsProcessingException( QObject::tr( "%1 has fewer features than when checkpoint %2 was saved, delete the checkpoint to run the algorithm from the start" ).arg( output, checkpointFile ) );
+
+  if ( static_cast< long long >( ids.size() ) > writtenCount )
+  {
+    // features are appended, so the ones written after the checkpoint have the highest ids
+    std::sort( ids.begin(), ids.end() );
+    QgsFeatureIds extraIds;
+    for ( auto extraId = ids.begin() + writtenCount; extraId != ids.end(); ++extraId )
+      extraIds.insert( *extraId );
+
+    if ( !( layer->dataProvider()->capabilities() & QgsVectorDataProvider::DeleteFeatures ) || !layer->dataProvider()->deleteFeatures( extraIds ) )
+      throw QgsProcessingException( QObject::tr( "Could not remove the features written to %1 after checkpoint %2 was saved" ).arg( output, checkpointFile ) );
+  }
+}
+
+///@endcond
+
 QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
   prepareSource( parameters, context );
+
+  QgsFeature f;
+  QgsFeatureIterator it = mSource->getFeatures( request(), sourceFlags() );
+
+  // the progress of a previous run with the same parameters, which was interrupted
+  QgsProcessingCheckpoint checkpoint( this, parameters, context );
+  QVariantMap sinkParameters = parameters;
+  QString resumedOutput;
+  long long processedCount = 0;
+  long long writtenCount = 0;
+  QgsFeatureId lastProcessedId = FID_NULL;
+  // features processed by stateful algorithms depend on the ones processed before, which aren't saved
+  const bool checkpointEnabled = ( flags() & FlagSupportsCheckpoints ) && checkpoint.isEnabled();
+  bool resuming = checkpointEnabled && checkpoint.load();
+  if ( resuming && !isCheckpointOutputFile( checkpoint.state().value( QStringLiteral( "output" ) ).toString(), context ) )
+  {
+    feedback->pushInfo( QObject::tr( "The output saved to checkpoint %1 is missing, running the algorithm from the start" ).arg( checkpoint.file() ) );
+    resuming = false;
+  }
+  if ( resuming )
+  {
+    const QVariantMap state = checkpoint.state();
+    resumedOutput = state.value( QStringLiteral( "output" ) ).toString();
+    processedCount = state.value( QStringLiteral( "processed" ) ).toLongLong();
+    writtenCount = state.value( QStringLiteral( "written" ) ).toLongLong();
+    lastProcessedId = state.value( QStringLiteral( "last_feature_id" ) ).toLongLong();
+
+    feedback->pushInfo( QObject::tr( "Resuming from checkpoint %1, skipping %n feature(s) already processed", nullptr, processedCount ).arg( checkpoint.file() ) );
+    long long skipped = 0;
+    while ( skipped < processedCount && it.nextFeature( f ) )
+      skipped++;
+    if ( skipped < processedCount || ( processedCount > 0 && f.id() != lastProcessedId ) )
+      throw QgsProcessingException( QObject::tr( "The input features differ from the ones processed before checkpoint %1 was saved, delete the checkpoint to run the algorithm from the start" ).arg( checkpoint.file() ) );
+
+    restoreCheckpointOutput( resumedOutput, writtenCount, checkpoint.file(), context );
+
+    // the remaining features are appended to the output of the interrupted run
+    QgsProcessingOutputLayerDefinition output = parameters.value( QStringLiteral( "OUTPUT" ) ).userType() == QMetaType::type( "QgsProcessingOutputLayerDefinition" )
+        ? parameters.value( QStringLiteral( "OUTPUT" ) ).value< QgsProcessingOutputLayerDefinition >()
+        : QgsProcessingOutputLayerDefinition();
+    output.sink = QgsProperty::fromValue( QStringLiteral( "ogr:%1" ).arg( resumedOutput ) );
+    const QgsFields fields = outputFields( mSource->fields() );
+    QMap< QString, QgsProperty > fieldMap;
+    for ( const QgsField &field : fields )
+      fieldMap.insert( field.name(), QgsProperty::fromField( field.name() ) );
+    QgsRemappingSinkDefinition remapping;
+    remapping.setFieldMap( fieldMap );
+    remapping.setSourceCrs( outputCrs( mSource->sourceCrs() ) );
+    output.setRemappingDefinition( remapping );
+    sinkParameters.insert( QStringLiteral( "OUTPUT" ), output );
+  }
+
+  // the algorithm reading the features streamed through a pipe reports its progress from the expected number of features
+  if ( const std::shared_ptr< QgsProcessingFeaturePipe > pipe = QgsProcessingFeaturePipe::fromUri( sinkParameters.value( QStringLiteral( "OUTPUT" ) ).toString() ) )
+    pipe->setFeatureCount( mSource->featureCount() );
+
   QString dest;
-  std::unique_ptr< QgsFeatureSink > sink( parameterAsSink( parameters, QStringLiteral( "OUTPUT" ), context, dest,
+  std::unique_ptr< QgsFeatureSink > sink( parameterAsSink( sinkParameters, QStringLiteral( "OUTPUT" ), context, dest,
                                           outputFields( mSource->fields() ),
                                           outputWkbType( mSource->wkbType() ),
                                           outputCrs( mSource->sourceCrs() ),
@@ -1122,6 +1244,49 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   if ( !sink )
     throw QgsProcessingException( invalidSinkError( parameters, QStringLiteral( "OUTPUT" ) ) );
 
+  if ( !resumedOutput.isEmpty() )
+  {
+    // report the output file rather than the layer it was appended through
+    QMap< QString, QgsProcessingContext::LayerDetails > layersToLoad = context.layersToLoadOnCompletion();
+    if ( layersToLoad.contains( dest ) )
+    {
+      layersToLoad.insert( resumedOutput, layersToLoad.take( dest ) );
+      context.setLayersToLoadOnCompletion( layersToLoad );
+    }
+    dest = resumedOutput;
+  }
+
+  const bool saveCheckpoints = checkpointEnabled && isCheckpointOutputFile( dest, context );
+  if ( checkpointEnabled && !saveCheckpoints )
+    feedback->pushWarning( QObject::tr( "Progress is only saved to checkpoint %1 for outputs written to files, which are not temporary" ).arg( checkpoint.file() ) );
+
+  const auto saveCheckpoint = [&]
+  {
+    // the features must be committed before the checkpoint refers to them
+    if ( !sink->flushBuffer() )
+      throw QgsProcessingException( QObject::tr( "Could not write features to %1: %2" ).arg( dest, sink->lastError() ) );
+
+    QVariantMap state;
+    state.insert( QStringLiteral( "output" ), dest );
+    state.insert( QStringLiteral( "processed" ), processedCount );
+    state.insert( QStringLiteral( "last_feature_id" ), lastProcessedId );
+    state.insert( QStringLiteral( "written" ), writtenCount );
+    state.insert( QStringLiteral( "progress" ), feedback->progress() );
+    checkpoint.setState( state );
+    checkpoint.save();
+  };
+  const auto featuresWritten = [&]( int inputCount, QgsFeatureId lastInputId, int outputCount )
+  {
+    if ( inputCount == 0 )
+      return;
+
+    processedCount += inputCount;
+    lastProcessedId = lastInputId;
+    writtenCount += outputCount;
+    if ( saveCheckpoints && checkpoint.isDue() )
+      saveCheckpoint();
+  };
+
   // prepare expression context for feature iteration
   QgsExpressionContext prevContext = context.expressionContext();
   QgsExpressionContext algContext = prevContext;
@@ -1131,25 +1296,39 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
 
   long count = mSource->featureCount();
 
-  QgsFeature f;
-  QgsFeatureIterator it = mSource->getFeatures( request(), sourceFlags() );
-
   double step = count > 0 ? 100.0 / count : 1;
-  int current = 0;
-  while ( it.nextFeature( f ) )
+  if ( ( flags() & FlagThreadSafeFeatureProcessing ) && context.maximumThreads() > 1 )
   {
-    if ( feedback->isCanceled() )
+    processFeaturesConcurrently( it, sink.get(), step, processedCount, context, feedback, featuresWritten );
+  }
+  else
+  {
+    long long current = processedCount;
+    while ( it.nextFeature( f ) )
     {
-      break;
-    }
+      if ( feedback->isCanceled() )
+      {
+        break;
+      }
 
-    context.expressionContext().setFeature( f );
-    const QgsFeatureList transformed = processFeature( f, context, feedback );
-    for ( QgsFeature transformedFeature : transformed )
-      sink->addFeature( transformedFeature, QgsFeatureSink::FastInsert );
+      context.expressionContext().setFeature( f );
+      const QgsFeatureList transformed = processFeature( f, context, feedback );
+      for ( QgsFeature transformedFeature : transformed )
+        sink->addFeature( transformedFeature, QgsFeatureSink::FastInsert );
 
-    feedback->setProgress( current * step );
-    current++;
+      feedback->setProgress( current * step );
+      current++;
+
+      featuresWritten( 1, f.id(), transformed.size() );
+    }
+  }
+
+  if ( saveCheckpoints )
+  {
+    if ( feedback->isCanceled() )
+      saveCheckpoint();
+    else
+      checkpoint.remove();
   }
 
   mSource.reset();
@@ -1162,6 +1341,127 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   return outputs;
 }
 
+///@cond PRIVATE
+
+//! Result of the processing of a batch of features
+struct QgsProcessingFeatureBatch
+{
+  QgsFeatureList features;
+  //! Number of input features processed, less than the batch size if the processing was canceled
+  int inputCount = 0;
+  QgsFeatureId lastInputId = FID_NULL;
+  std::vector< QgsProcessingBufferedFeedback::Message > messages;
+  bool failed = false;
+  QString error;
+};
+
+///@endcond
+
+void QgsProcessingFeatureBasedAlgorithm::processFeaturesConcurrently( QgsFeatureIterator &iterator, QgsFeatureSink *sink, double step, long long processedCount, QgsProcessingContext &context, QgsProcessingFeedback *feedback,
+    const std::function< void( int inputCount, QgsFeatureId lastInputId, int outputCount ) > &featuresWritten )
+{
+  // number of features processed at once by a thread
+  constexpr int BATCH_SIZE = 100;
+
+  // each batch being processed uses its own context
+  const int threads = context.maximumThreads();
+  const int maxPendingBatches = 2 * threads;
+  std::vector< std::unique_ptr< QgsProcessingContext > > contexts;
+  QVector< QgsProcessingContext * > freeContexts;
+  for ( int i = 0; i < maxPendingBatches; ++i )
+  {
+    std::unique_ptr< QgsProcessingContext > batchContext = std::make_unique< QgsProcessingContext >();
+    batchContext->copyThreadSafeSettings( context );
+    freeContexts << batchContext.get();
+    contexts.emplace_back( std::move( batchContext ) );
+  }
+  QMutex freeContextsMutex;
+
+  const auto processBatch = [&]( const QgsFeatureList & features ) -> QgsProcessingFeatureBatch
+  {
+    QgsProcessingFeatureBatch batch;
+
+    QgsProcessingContext *batchContext = nullptr;
+    {
+      QMutexLocker locker( &freeContextsMutex );
+      batchContext = freeContexts.takeLast();
+    }
+
+    QgsProcessingBufferedFeedback batchFeedback( feedback );
+    for ( const QgsFeature &feature : features )
+    {
+      if ( feedback->isCanceled() )
+        break;
+
+      batchContext->expressionContext().setFeature( feature );
+      try
+      {
+        batch.features.append( processFeature( feature, *batchContext, &batchFeedback ) );
+        batch.inputCount++;
+        batch.lastInputId = feature.id();
+      }
+      catch ( QgsProcessingException &e )
+      {
+        batch.failed = true;
+        batch.error = e.what();
+        break;
+      }
+    }
+    batch.messages = batchFeedback.takeMessages();
+
+    QMutexLocker locker( &freeContextsMutex );
+    freeContexts << batchContext;
+    return batch;
+  };
+
+  // the pool is destroyed first, waiting for the batches still being processed with the contexts
+  QThreadPool pool;
+  pool.setMaxThreadCount( threads );
+
+  // batches are processed in parallel and written in order, waiting on the oldest one
+  std::deque< QFuture< QgsProcessingFeatureBatch > > pendingBatches;
+  bool atEnd = false;
+  long long current = processedCount;
+  QgsFeature f;
+  while ( !feedback->isCanceled() )
+  {
+    while ( !atEnd && static_cast< int >( pendingBatches.size() ) < maxPendingBatches )
+    {
+      QgsFeatureList features;
+      features.reserve( BATCH_SIZE );
+      while ( features.size() < BATCH_SIZE && iterator.nextFeature( f ) )
+      {
+        features << f;
+      }
+      atEnd = features.size() < BATCH_SIZE;
+      if ( features.isEmpty() )
+        break;
+
+      pendingBatches.push_back( QtConcurrent::run( &pool, processBatch, features ) );
+    }
+    if ( pendingBatches.empty() )
+      break;
+
+    QgsProcessingFeatureBatch batch = pendingBatches.front().result();
+    pendingBatches.pop_front();
+
+    QgsProcessingBufferedFeedback::reportMessages( batch.messages, feedback );
+    if ( batch.failed )
+    {
+      throw QgsProcessingException( batch.error );
+    }
+
+    for ( QgsFeature transformedFeature : std::as_const( batch.features ) )
+      sink->addFeature( transformedFeature, QgsFeatureSink::FastInsert );
+
+    current += batch.inputCount;
+    feedback->setProgress( current * step );
+
+    if ( featuresWritten )
+      featuresWritten( batch.inputCount, batch.lastInputId, batch.features.size() );
+  }
+}
+
 QgsFeatureRequest QgsProcessingFeatureBasedAlgorithm::request() const
 {
   return QgsFeatureRequest();
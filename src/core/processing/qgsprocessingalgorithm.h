@@ -28,10 +28,12 @@
 #include <QString>
 #include <QVariant>
 #include <QIcon>
+#include <functional>
 
 class QgsProcessingProvider;
 class QgsProcessingFeedback;
 class QgsFeatureSink;
+class QgsFeatureIterator;
 class QgsProcessingModelAlgorithm;
 class QgsProcessingAlgorithmConfigurationWidget;
 class QgsMeshLayer;
@@ -82,6 +84,8 @@ class CORE_EXPORT QgsProcessingAlgorithm
       FlagSkipGenericModelLogging = 1 << 12, //!< When running as part of a model, the generic algorithm setup and results logging should be skipped
       FlagNotAvailableInStandaloneTool = 1 << 13, //!< Algorithm should not be available from the standalone "qgis_process" tool. Used to flag algorithms which make no sense outside of the QGIS application, such as "select by..." style algorithms.
       FlagRequiresProject = 1 << 14, //!< The algorithm requires that a valid QgsProject is available from the processing context in order to execute
+      FlagThreadSafeFeatureProcessing = 1 << 15, //!< The QgsProcessingFeatureBasedAlgorithm::processFeature() implementation of the algorithm is thread safe, and can process several features concurrently (since QGIS 3.34)
+      FlagSupportsCheckpoints = 1 << 16, //!< The QgsProcessingFeatureBasedAlgorithm::processFeature() implementation of the algorithm doesn't depend on the features processed before, so that an interrupted run can be resumed from a checkpoint (since QGIS 3.34)
       FlagDeprecated = FlagHideFromToolbox | FlagHideFromModeler, //!< Algorithm is deprecated
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -1202,6 +1206,11 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
      * prevent the algorithm execution from continuing. This can be annoying for users though as it
      * can break valid model execution - so use with extreme caution, and consider using
      * \a feedback to instead report non-fatal processing failures for features instead.
+     *
+     * Algorithms which return the QgsProcessingAlgorithm::FlagThreadSafeFeatureProcessing flag have
+     * this method called from several threads at once, for batches of features. Each thread uses
+     * its own copy of the \a context, and messages pushed to \a feedback are reported once the
+     * batch is written. The output features are added to the sink in the order of the input features.
      */
     virtual QgsFeatureList processFeature( const QgsFeature &feature, QgsProcessingContext &context, QgsProcessingFeedback *feedback ) SIP_THROW( QgsProcessingException ) = 0 SIP_VIRTUALERRORHANDLER( processing_exception_handler );
 
@@ -1336,6 +1345,16 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
 
   private:
 
+    /**
+     * Processes the features of \a iterator in batches computed in parallel,
+     * and adds the results to \a sink in the order of the input features.
+     *
+     * The progress starts after the \a processedCount features skipped when resuming from a checkpoint. The
+     * optional \a featuresWritten callback is called after each batch is added to \a sink.
+     */
+    void processFeaturesConcurrently( QgsFeatureIterator &iterator, QgsFeatureSink *sink, double step, long long processedCount, QgsProcessingContext &context, QgsProcessingFeedback *feedback,
+                                      const std::function< void( int inputCount, QgsFeatureId lastInputId, int outputCount ) > &featuresWritten = nullptr ) SIP_SKIP;
+
     std::unique_ptr< QgsProcessingFeatureSource > mSource;
 
 };
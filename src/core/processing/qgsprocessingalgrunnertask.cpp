@@ -22,6 +22,8 @@
 #include "qgsprocessingutils.h"
 #include "qgsvectorlayer.h"
 
+#include <QFile>
+
 QgsProcessingAlgRunnerTask::QgsProcessingAlgRunnerTask( const QgsProcessingAlgorithm *algorithm, const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback, Flags flags )
   : QgsTask(
       tr( "Executing “%1”" ).arg( algorithm->displayName() ),
@@ -73,9 +75,17 @@ bool QgsProcessingAlgRunnerTask::run()
   {
     QgsMessageLog::logMessage( e.what(), QObject::tr( "Processing" ), Qgis::MessageLevel::Critical );
     mFeedback->reportError( e.what() );
+  }
+
+  if ( !ok || mFeedback->isCanceled() )
+  {
+    // algorithms supporting checkpoints keep their progress when they fail or are canceled
+    const QString checkpointFile = mContext.checkpointFile();
+    if ( !checkpointFile.isEmpty() && QFile::exists( checkpointFile ) )
+      mFeedback->pushInfo( tr( "Progress was saved to checkpoint %1, run the algorithm again with the same parameters to resume it" ).arg( checkpointFile ) );
     return false;
   }
-  return ok && !mFeedback->isCanceled();
+  return true;
 }
 
 void QgsProcessingAlgRunnerTask::finished( bool result )
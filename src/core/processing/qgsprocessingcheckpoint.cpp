@@ -0,0 +1,98 @@
+/***************************************************************************
+                         qgsprocessingcheckpoint.cpp
+                         ---------------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsprocessingcheckpoint.h"
+#include "qgsprocessingalgorithm.h"
+#include "qgsprocessingcontext.h"
+#include "qgsprocessingparameters.h"
+#include "qgsexception.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+QgsProcessingCheckpoint::QgsProcessingCheckpoint( const QgsProcessingAlgorithm *algorithm, const QVariantMap &parameters, QgsProcessingContext &context )
+  : mFile( context.checkpointFile() )
+  , mInterval( context.checkpointInterval() )
+  , mAlgorithmId( algorithm->id() )
+{
+  if ( mFile.isEmpty() )
+    return;
+
+  // the parameter values are compared as they would be written in a python script
+  QCryptographicHash hash( QCryptographicHash::Sha256 );
+  const QgsProcessingParameterDefinitions definitions = algorithm->parameterDefinitions();
+  for ( const QgsProcessingParameterDefinition *definition : definitions )
+  {
+    hash.addData( definition->name().toUtf8() );
+    hash.addData( "=" );
+    hash.addData( definition->valueAsPythonString( parameters.value( definition->name() ), context ).toUtf8() );
+    hash.addData( "\n" );
+  }
+  mParametersHash = QString::fromLatin1( hash.result().toHex() );
+
+  mSinceSave.start();
+}
+
+bool QgsProcessingCheckpoint::load()
+{
+  if ( mFile.isEmpty() )
+    return false;
+
+  QFile file( mFile );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  const QVariantMap checkpoint = QJsonDocument::fromJson( file.readAll() ).toVariant().toMap();
+  if ( checkpoint.value( QStringLiteral( "algorithm" ) ).toString() != mAlgorithmId
+       || checkpoint.value( QStringLiteral( "parameters" ) ).toString() != mParametersHash )
+    return false;
+
+  mState = checkpoint.value( QStringLiteral( "state" ) ).toMap();
+  return true;
+}
+
+bool QgsProcessingCheckpoint::isDue() const
+{
+  return !mFile.isEmpty() && mSinceSave.elapsed() >= 1000LL * mInterval;
+}
+
+void QgsProcessingCheckpoint::save()
+{
+  if ( mFile.isEmpty() )
+    return;
+
+  QVariantMap checkpoint;
+  checkpoint.insert( QStringLiteral( "algorithm" ), mAlgorithmId );
+  checkpoint.insert( QStringLiteral( "parameters" ), mParametersHash );
+  checkpoint.insert( QStringLiteral( "saved" ), QDateTime::currentDateTimeUtc().toString( Qt::ISODate ) );
+  checkpoint.insert( QStringLiteral( "state" ), mState );
+
+  // the previous checkpoint is only replaced once the new one is completely written
+  QSaveFile file( mFile );
+  if ( !file.open( QIODevice::WriteOnly ) || file.write( QJsonDocument::fromVariant( checkpoint ).toJson() ) < 0 || !file.commit() )
+    throw QgsProcessingException( QObject::tr( "Could not write checkpoint file %1: %2" ).arg( mFile, file.errorString() ) );
+
+  mSinceSave.restart();
+}
+
+void QgsProcessingCheckpoint::remove()
+{
+  if ( !mFile.isEmpty() )
+    QFile::remove( mFile );
+}
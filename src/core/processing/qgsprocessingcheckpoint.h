@@ -0,0 +1,109 @@
+/***************************************************************************
+                         qgsprocessingcheckpoint.h
+                         -------------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPROCESSINGCHECKPOINT_H
+#define QGSPROCESSINGCHECKPOINT_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVariantMap>
+
+#define SIP_NO_FILE
+
+class QgsProcessingAlgorithm;
+class QgsProcessingContext;
+
+/**
+ * \ingroup core
+ * \brief Progress of an algorithm saved to the checkpoint file of a processing context, so that
+ * the algorithm can be resumed if it is interrupted.
+ *
+ * A checkpoint is identified by the algorithm and its parameter values: a checkpoint saved by
+ * another algorithm, or with other parameter values, is ignored. What the progress consists of
+ * is up to the algorithm.
+ *
+ * \see QgsProcessingContext::checkpointFile()
+ * \note Not available in Python bindings
+ * \since QGIS 3.34
+ */
+class CORE_EXPORT QgsProcessingCheckpoint
+{
+  public:
+
+    /**
+     * Constructor for QgsProcessingCheckpoint, for the \a algorithm run with the specified \a parameters
+     * and \a context.
+     */
+    QgsProcessingCheckpoint( const QgsProcessingAlgorithm *algorithm, const QVariantMap &parameters, QgsProcessingContext &context );
+
+    /**
+     * Returns TRUE if the context has a checkpoint file.
+     */
+    bool isEnabled() const { return !mFile.isEmpty(); }
+
+    /**
+     * Returns the path of the checkpoint file.
+     */
+    QString file() const { return mFile; }
+
+    /**
+     * Reads the progress saved to the checkpoint file.
+     *
+     * Returns FALSE if there is no checkpoint file, or if it was saved by another algorithm or with other parameter values.
+     */
+    bool load();
+
+    /**
+     * Returns the progress read by load() or set with setState().
+     */
+    QVariantMap state() const { return mState; }
+
+    /**
+     * Sets the progress of the algorithm, which is written by the next save().
+     */
+    void setState( const QVariantMap &state ) { mState = state; }
+
+    /**
+     * Returns TRUE if the checkpoint interval of the context elapsed since the progress was last saved.
+     */
+    bool isDue() const;
+
+    /**
+     * Writes the progress to the checkpoint file, replacing the previous one.
+     *
+     * Throws a QgsProcessingException if the file can't be written.
+     */
+    void save();
+
+    /**
+     * Removes the checkpoint file, once the algorithm completed.
+     */
+    void remove();
+
+  private:
+
+    QString mFile;
+    int mInterval = 0;
+    QString mAlgorithmId;
+    QString mParametersHash;
+    QVariantMap mState;
+    QElapsedTimer mSinceSave;
+};
+
+#endif // QGSPROCESSINGCHECKPOINT_H
@@ -122,7 +122,11 @@ std::function<void ( const QgsFeature & )> QgsProcessingContext::defaultInvalidG
 
 void QgsProcessingContext::takeResultsFrom( QgsProcessingContext &context )
 {
-  setLayersToLoadOnCompletion( context.mLayersToLoadOnCompletion );
+  // merge the layers to load, as this context may already have layers to load from other results
+  for ( auto it = context.mLayersToLoadOnCompletion.constBegin(); it != context.mLayersToLoadOnCompletion.constEnd(); ++it )
+  {
+    addLayerToLoadOnCompletion( it.key(), it.value() );
+  }
   context.mLayersToLoadOnCompletion.clear();
   tempLayerStore.transferLayersFromStore( context.temporaryLayerStore() );
 }
@@ -167,6 +171,36 @@ void QgsProcessingContext::setMaximumThreads( int threads )
   mMaximumThreads = threads;
 }
 
+qint64 QgsProcessingContext::memoryBudget() const
+{
+  return mMemoryBudget;
+}
+
+void QgsProcessingContext::setMemoryBudget( qint64 bytes )
+{
+  mMemoryBudget = bytes;
+}
+
+QString QgsProcessingContext::checkpointFile() const
+{
+  return mCheckpointFile;
+}
+
+void QgsProcessingContext::setCheckpointFile( const QString &path )
+{
+  mCheckpointFile = path;
+}
+
+int QgsProcessingContext::checkpointInterval() const
+{
+  return mCheckpointInterval;
+}
+
+void QgsProcessingContext::setCheckpointInterval( int seconds )
+{
+  mCheckpointInterval = seconds;
+}
+
 QVariantMap QgsProcessingContext::exportToMap() const
 {
   QVariantMap res;
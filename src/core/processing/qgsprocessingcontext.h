@@ -102,6 +102,9 @@ class CORE_EXPORT QgsProcessingContext
       mLogLevel = other.mLogLevel;
       mTemporaryFolderOverride = other.mTemporaryFolderOverride;
       mMaximumThreads = other.mMaximumThreads;
+      mMemoryBudget = other.mMemoryBudget;
+      mCheckpointFile = other.mCheckpointFile;
+      mCheckpointInterval = other.mCheckpointInterval;
     }
 
     /**
@@ -727,6 +730,78 @@ class CORE_EXPORT QgsProcessingContext
      */
     void setMaximumThreads( int threads );
 
+    /**
+     * Returns the (optional) amount of memory, in bytes, algorithms should try not to exceed when
+     * holding features in memory.
+     *
+     * Algorithms supporting it write features to temporary files in temporaryFolder() once their
+     * working set exceeds this budget. A value of 0 means there is no limit.
+     *
+     * \warning Not all algorithms respect this setting.
+     *
+     * \see setMemoryBudget()
+     * \since QGIS 3.34
+     */
+    qint64 memoryBudget() const;
+
+    /**
+     * Sets the (optional) amount of memory, in \a bytes, algorithms should try not to exceed when
+     * holding features in memory.
+     *
+     * A value of 0 means there is no limit.
+     *
+     * \see memoryBudget()
+     * \since QGIS 3.34
+     */
+    void setMemoryBudget( qint64 bytes );
+
+    /**
+     * Returns the (optional) path of the file algorithms save their progress to while running.
+     *
+     * Feature based algorithms with the QgsProcessingAlgorithm::FlagSupportsCheckpoints flag periodically
+     * save the input features processed and the features written to their output, when it's written to
+     * a file. Models save the child algorithms executed. Running them again with
+     * the same parameters and checkpoint file resumes them from the last saved progress. The file is
+     * removed once an algorithm completes.
+     *
+     * An empty path means that no progress is saved. Models clear this setting while running their child
+     * algorithms, so that the children don't overwrite the progress of the model.
+     *
+     * \warning Not all algorithms respect this setting.
+     *
+     * \see setCheckpointFile()
+     * \see checkpointInterval()
+     * \since QGIS 3.34
+     */
+    QString checkpointFile() const;
+
+    /**
+     * Sets the (optional) \a path of the file algorithms save their progress to while running.
+     *
+     * \see checkpointFile()
+     * \see setCheckpointInterval()
+     * \since QGIS 3.34
+     */
+    void setCheckpointFile( const QString &path );
+
+    /**
+     * Returns the minimum interval, in seconds, between the saves of the progress of an algorithm to the checkpointFile().
+     *
+     * \see setCheckpointInterval()
+     * \since QGIS 3.34
+     */
+    int checkpointInterval() const;
+
+    /**
+     * Sets the minimum interval, in \a seconds, between the saves of the progress of an algorithm to the checkpointFile().
+     *
+     * A value of 0 saves the progress whenever it changes.
+     *
+     * \see checkpointInterval()
+     * \since QGIS 3.34
+     */
+    void setCheckpointInterval( int seconds );
+
     /**
      * Exports the context's settings to a variant map.
      *
@@ -785,6 +860,9 @@ class CORE_EXPORT QgsProcessingContext
 
     QString mTemporaryFolderOverride;
     int mMaximumThreads = QThread::idealThreadCount();
+    qint64 mMemoryBudget = 0;
+    QString mCheckpointFile;
+    int mCheckpointInterval = 60;
 
 #ifdef SIP_RUN
     QgsProcessingContext( const QgsProcessingContext &other );
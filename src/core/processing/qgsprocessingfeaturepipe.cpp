@@ -0,0 +1,312 @@
+/***************************************************************************
+                         qgsprocessingfeaturepipe.cpp
+                         ----------------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsprocessingfeaturepipe.h"
+#include "qgsfeaturesink.h"
+#include "qgsfeaturesource.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeaturerequest.h"
+#include "qgscoordinatetransform.h"
+#include "qgsexception.h"
+#include "qgsgeometry.h"
+
+#include <QHash>
+#include <QObject>
+#include <QUuid>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+///@cond PRIVATE
+
+//! Pipes which exist, by uri
+static QMutex sPipesMutex;
+static QHash< QString, std::weak_ptr< QgsProcessingFeaturePipe > > sPipes;
+
+//! Sink writing to a pipe, which closes the pipe for writing when deleted
+class QgsProcessingFeaturePipeSink : public QgsFeatureSink
+{
+  public:
+
+    QgsProcessingFeaturePipeSink( std::shared_ptr< QgsProcessingFeaturePipe > pipe, QgsFeatureSink::SinkFlags flags )
+      : mPipe( std::move( pipe ) )
+      , mRegenerateIds( flags & QgsFeatureSink::RegeneratePrimaryKey )
+    {}
+
+    ~QgsProcessingFeaturePipeSink() override
+    {
+      mPipe->closeWriting();
+    }
+
+    bool addFeatures( QgsFeatureList &features, QgsFeatureSink::Flags = QgsFeatureSink::Flags() ) override
+    {
+      // features written once the reading algorithm is done are dropped, like the algorithm would have done
+      for ( QgsFeature &feature : features )
+      {
+        if ( mRegenerateIds )
+          feature.setId( mNextId++ );
+        if ( !mPipe->write( feature ) )
+          break;
+      }
+      return true;
+    }
+
+  private:
+
+    std::shared_ptr< QgsProcessingFeaturePipe > mPipe;
+    bool mRegenerateIds = false;
+    QgsFeatureId mNextId = 1;
+};
+
+//! Iterator over the features read from a pipe
+class QgsProcessingFeaturePipeIterator : public QgsAbstractFeatureIterator
+{
+  public:
+
+    QgsProcessingFeaturePipeIterator( std::shared_ptr< QgsProcessingFeaturePipe > pipe, const QgsFields &fields, const QgsCoordinateReferenceSystem &crs, const QgsFeatureRequest &request )
+      : QgsAbstractFeatureIterator( request )
+      , mPipe( std::move( pipe ) )
+      , mFields( fields )
+    {
+      if ( mRequest.destinationCrs().isValid() && mRequest.destinationCrs() != crs )
+      {
+        mTransform = QgsCoordinateTransform( crs, mRequest.destinationCrs(), mRequest.transformContext() );
+      }
+      try
+      {
+        mFilterRect = filterRectToSourceCrs( mTransform );
+      }
+      catch ( QgsCsException & )
+      {
+        // can't reproject mFilterRect
+        close();
+      }
+    }
+
+    bool rewind() override
+    {
+      // features are only streamed once
+      return false;
+    }
+
+    bool close() override
+    {
+      mClosed = true;
+      return true;
+    }
+
+  protected:
+
+    bool fetchFeature( QgsFeature &feature ) override
+    {
+      feature.setValid( false );
+      if ( mClosed )
+        return false;
+
+      while ( mPipe->read( feature ) )
+      {
+        if ( mRequest.filterType() == QgsFeatureRequest::FilterFid && feature.id() != mRequest.filterFid() )
+          continue;
+
+        if ( !mFilterRect.isNull() )
+        {
+          if ( !feature.hasGeometry() )
+            continue;
+          if ( mRequest.spatialFilterType() == Qgis::SpatialFilterType::BoundingBox && mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+          {
+            if ( !feature.geometry().intersects( mFilterRect ) )
+              continue;
+          }
+          else if ( !feature.geometry().boundingBoxIntersects( mFilterRect ) )
+          {
+            continue;
+          }
+        }
+
+        // geometry must be in destination crs before we can perform distance within check
+        geometryToDestinationCrs( feature, mTransform );
+        if ( mRequest.spatialFilterType() == Qgis::SpatialFilterType::DistanceWithin
+             && ( !feature.hasGeometry() || feature.geometry().distance( mRequest.referenceGeometry() ) > mRequest.distanceWithin() ) )
+          continue;
+
+        feature.setFields( mFields ); // allow name-based attribute lookups
+        feature.setValid( true );
+        return true;
+      }
+
+      close();
+      return false;
+    }
+
+  private:
+
+    std::shared_ptr< QgsProcessingFeaturePipe > mPipe;
+    QgsFields mFields;
+    QgsCoordinateTransform mTransform;
+    QgsRectangle mFilterRect;
+};
+
+/**
+ * Source reading from a pipe. Algorithms may create sources only to get the fields of their
+ * input, so the pipe isn't closed for reading when a source is deleted.
+ */
+class QgsProcessingFeaturePipeSource : public QgsFeatureSource
+{
+  public:
+
+    QgsProcessingFeaturePipeSource( std::shared_ptr< QgsProcessingFeaturePipe > pipe, const QgsFields &fields, Qgis::WkbType wkbType, const QgsCoordinateReferenceSystem &crs )
+      : mPipe( std::move( pipe ) )
+      , mFields( fields )
+      , mWkbType( wkbType )
+      , mCrs( crs )
+    {}
+
+    QgsFeatureIterator getFeatures( const QgsFeatureRequest &request = QgsFeatureRequest() ) const override
+    {
+      return QgsFeatureIterator( new QgsProcessingFeaturePipeIterator( mPipe, mFields, mCrs, request ) );
+    }
+
+    QString sourceName() const override { return QObject::tr( "Pipe" ); }
+    QgsCoordinateReferenceSystem sourceCrs() const override { return mCrs; }
+    QgsFields fields() const override { return mFields; }
+    Qgis::WkbType wkbType() const override { return mWkbType; }
+
+    // the features of a pipe are only known once they are read, the writer may tell how many it expects
+    long long featureCount() const override { return mPipe->featureCount(); }
+    QgsRectangle sourceExtent() const override { return QgsRectangle(); }
+
+  private:
+
+    std::shared_ptr< QgsProcessingFeaturePipe > mPipe;
+    QgsFields mFields;
+    Qgis::WkbType mWkbType = Qgis::WkbType::Unknown;
+    QgsCoordinateReferenceSystem mCrs;
+};
+
+///@endcond
+
+QgsProcessingFeaturePipe::QgsProcessingFeaturePipe( int capacity )
+  : mUri( QStringLiteral( "pipe:%1" ).arg( QUuid::createUuid().toString( QUuid::WithoutBraces ) ) )
+  , mCapacity( static_cast< std::size_t >( std::max( 1, capacity ) ) )
+{
+}
+
+std::shared_ptr< QgsProcessingFeaturePipe > QgsProcessingFeaturePipe::create( int capacity )
+{
+  std::shared_ptr< QgsProcessingFeaturePipe > pipe( new QgsProcessingFeaturePipe( capacity ) );
+  QMutexLocker locker( &sPipesMutex );
+  sPipes.insert( pipe->uri(), pipe );
+  return pipe;
+}
+
+bool QgsProcessingFeaturePipe::isPipeUri( const QString &uri )
+{
+  return uri.startsWith( QLatin1String( "pipe:" ) );
+}
+
+std::shared_ptr< QgsProcessingFeaturePipe > QgsProcessingFeaturePipe::fromUri( const QString &uri )
+{
+  QMutexLocker locker( &sPipesMutex );
+  return sPipes.value( uri ).lock();
+}
+
+QgsProcessingFeaturePipe::~QgsProcessingFeaturePipe()
+{
+  QMutexLocker locker( &sPipesMutex );
+  sPipes.remove( mUri );
+}
+
+QgsFeatureSink *QgsProcessingFeaturePipe::createSink( const QgsFields &fields, Qgis::WkbType wkbType, const QgsCoordinateReferenceSystem &crs, QgsFeatureSink::SinkFlags flags )
+{
+  QMutexLocker locker( &mMutex );
+  mFields = fields;
+  mWkbType = wkbType;
+  mCrs = crs;
+  mHasSink = true;
+  mNotEmpty.wakeAll();
+  return new QgsProcessingFeaturePipeSink( shared_from_this(), flags );
+}
+
+void QgsProcessingFeaturePipe::setFeatureCount( long long count )
+{
+  QMutexLocker locker( &mMutex );
+  mFeatureCount = count;
+}
+
+long long QgsProcessingFeaturePipe::featureCount() const
+{
+  QMutexLocker locker( &mMutex );
+  return mFeatureCount;
+}
+
+QgsFeatureSource *QgsProcessingFeaturePipe::createSource()
+{
+  waitForSink();
+
+  QMutexLocker locker( &mMutex );
+  return new QgsProcessingFeaturePipeSource( shared_from_this(), mFields, mWkbType, mCrs );
+}
+
+void QgsProcessingFeaturePipe::waitForSink()
+{
+  QMutexLocker locker( &mMutex );
+  while ( !mHasSink && !mWritingClosed )
+    mNotEmpty.wait( &mMutex );
+}
+
+void QgsProcessingFeaturePipe::closeWriting()
+{
+  QMutexLocker locker( &mMutex );
+  mWritingClosed = true;
+  mNotEmpty.wakeAll();
+}
+
+void QgsProcessingFeaturePipe::closeReading()
+{
+  QMutexLocker locker( &mMutex );
+  mReadingClosed = true;
+  mFeatures.clear();
+  mNotFull.wakeAll();
+}
+
+bool QgsProcessingFeaturePipe::write( const QgsFeature &feature )
+{
+  QMutexLocker locker( &mMutex );
+  while ( mFeatures.size() >= mCapacity && !mReadingClosed )
+    mNotFull.wait( &mMutex );
+
+  if ( mReadingClosed )
+    return false;
+
+  mFeatures.push_back( feature );
+  mNotEmpty.wakeOne();
+  return true;
+}
+
+bool QgsProcessingFeaturePipe::read( QgsFeature &feature )
+{
+  QMutexLocker locker( &mMutex );
+  while ( mFeatures.empty() && !mWritingClosed )
+    mNotEmpty.wait( &mMutex );
+
+  if ( mFeatures.empty() )
+    return false;
+
+  feature = std::move( mFeatures.front() );
+  mFeatures.pop_front();
+  mNotFull.wakeOne();
+  return true;
+}
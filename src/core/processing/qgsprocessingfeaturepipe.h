@@ -0,0 +1,166 @@
+/***************************************************************************
+                         qgsprocessingfeaturepipe.h
+                         --------------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPROCESSINGFEATUREPIPE_H
+#define QGSPROCESSINGFEATUREPIPE_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgis.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
+#include "qgscoordinatereferencesystem.h"
+#include "qgsfeaturesink.h"
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <deque>
+#include <memory>
+
+#define SIP_NO_FILE
+
+class QgsFeatureSource;
+
+/**
+ * \ingroup core
+ * \brief Bounded queue of features streamed from an algorithm writing them to another one reading them.
+ *
+ * A pipe is identified by a "pipe:" uri, which can be used as the destination of a feature
+ * sink parameter and as the value of a feature source parameter. The algorithm writing to the
+ * pipe and the one reading from it must run at the same time in different threads: writing
+ * blocks while the pipe is full and reading blocks while it is empty, so the features are never
+ * all held in memory.
+ *
+ * The features of a pipe can only be read once, in the order they were written.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.34
+ */
+class CORE_EXPORT QgsProcessingFeaturePipe : public std::enable_shared_from_this< QgsProcessingFeaturePipe >
+{
+  public:
+
+    //! Default number of features a pipe holds before writing blocks
+    static constexpr int DEFAULT_CAPACITY = 1000;
+
+    /**
+     * Creates a new pipe holding at most \a capacity features.
+     *
+     * The pipe can be found from its uri() as long as it exists.
+     */
+    static std::shared_ptr< QgsProcessingFeaturePipe > create( int capacity = DEFAULT_CAPACITY );
+
+    //! Returns TRUE if \a uri is the uri of a pipe.
+    static bool isPipeUri( const QString &uri );
+
+    //! Returns the pipe with the specified \a uri, or NULLPTR if it does not exist anymore.
+    static std::shared_ptr< QgsProcessingFeaturePipe > fromUri( const QString &uri );
+
+    ~QgsProcessingFeaturePipe();
+
+    QgsProcessingFeaturePipe( const QgsProcessingFeaturePipe &other ) = delete;
+    QgsProcessingFeaturePipe &operator=( const QgsProcessingFeaturePipe &other ) = delete;
+
+    //! Returns the uri of the pipe.
+    QString uri() const { return mUri; }
+
+    /**
+     * Creates the sink writing to the pipe, with the \a fields, \a wkbType and \a crs of its features.
+     *
+     * If the sink \a flags contain QgsFeatureSink::RegeneratePrimaryKey, the features written to the
+     * pipe are given new sequential ids.
+     *
+     * The pipe is closed for writing when the sink is deleted. Caller takes ownership of the returned sink.
+     */
+    QgsFeatureSink *createSink( const QgsFields &fields, Qgis::WkbType wkbType, const QgsCoordinateReferenceSystem &crs, QgsFeatureSink::SinkFlags flags = QgsFeatureSink::SinkFlags() );
+
+    /**
+     * Sets the expected number of features written to the pipe, reported by the sources reading
+     * from it so that the reading algorithm can report its progress. Must be called before the sink
+     * is created.
+     *
+     * \see featureCount()
+     */
+    void setFeatureCount( long long count );
+
+    /**
+     * Returns the expected number of features written to the pipe, or -1 if it is not known.
+     *
+     * \see setFeatureCount()
+     */
+    long long featureCount() const;
+
+    /**
+     * Creates a source reading from the pipe. Blocks until the sink writing to the pipe is
+     * created, so that the fields of the features are known.
+     *
+     * Deleting the source doesn't close the pipe for reading, closeReading() must be called once
+     * the reading algorithm is done. Caller takes ownership of the returned source.
+     */
+    QgsFeatureSource *createSource();
+
+    /**
+     * Waits until the sink writing to the pipe is created or until the pipe is closed for writing.
+     */
+    void waitForSink();
+
+    /**
+     * Closes the pipe for writing: once the features in the pipe are read, reading from it ends.
+     */
+    void closeWriting();
+
+    /**
+     * Closes the pipe for reading: the features still in the pipe are discarded, and features
+     * written afterwards are dropped.
+     */
+    void closeReading();
+
+    /**
+     * Appends a \a feature to the pipe, waiting while it is full.
+     *
+     * Returns FALSE if the pipe was closed for reading.
+     */
+    bool write( const QgsFeature &feature );
+
+    /**
+     * Takes the next \a feature from the pipe, waiting while it is empty.
+     *
+     * Returns FALSE once the pipe is closed for writing and all its features were read.
+     */
+    bool read( QgsFeature &feature );
+
+  private:
+
+    explicit QgsProcessingFeaturePipe( int capacity );
+
+    QString mUri;
+    const std::size_t mCapacity;
+
+    mutable QMutex mMutex;
+    QWaitCondition mNotEmpty;
+    QWaitCondition mNotFull;
+    std::deque< QgsFeature > mFeatures;
+    bool mHasSink = false;
+    bool mWritingClosed = false;
+    bool mReadingClosed = false;
+    long long mFeatureCount = -1;
+
+    QgsFields mFields;
+    Qgis::WkbType mWkbType = Qgis::WkbType::Unknown;
+    QgsCoordinateReferenceSystem mCrs;
+};
+
+#endif // QGSPROCESSINGFEATUREPIPE_H
@@ -216,3 +216,68 @@ void QgsProcessingMultiStepFeedback::updateOverallProgress( double progress )
   mFeedback->setProgress( baseProgress + currentAlgorithmProgress );
 }
 
+
+///@cond PRIVATE
+
+QgsProcessingBufferedFeedback::QgsProcessingBufferedFeedback( QgsFeedback *feedback )
+  : QgsProcessingFeedback( false )
+{
+  if ( feedback )
+  {
+    connect( feedback, &QgsFeedback::canceled, this, &QgsFeedback::cancel, Qt::DirectConnection );
+    if ( feedback->isCanceled() )
+      cancel();
+  }
+}
+
+void QgsProcessingBufferedFeedback::setProgressText( const QString &text )
+{
+  mMessages.emplace_back( [text]( QgsProcessingFeedback * feedback ) { feedback->setProgressText( text ); } );
+}
+
+void QgsProcessingBufferedFeedback::reportError( const QString &error, bool fatalError )
+{
+  mMessages.emplace_back( [error, fatalError]( QgsProcessingFeedback * feedback ) { feedback->reportError( error, fatalError ); } );
+}
+
+void QgsProcessingBufferedFeedback::pushWarning( const QString &warning )
+{
+  mMessages.emplace_back( [warning]( QgsProcessingFeedback * feedback ) { feedback->pushWarning( warning ); } );
+}
+
+void QgsProcessingBufferedFeedback::pushInfo( const QString &info )
+{
+  mMessages.emplace_back( [info]( QgsProcessingFeedback * feedback ) { feedback->pushInfo( info ); } );
+}
+
+void QgsProcessingBufferedFeedback::pushCommandInfo( const QString &info )
+{
+  mMessages.emplace_back( [info]( QgsProcessingFeedback * feedback ) { feedback->pushCommandInfo( info ); } );
+}
+
+void QgsProcessingBufferedFeedback::pushDebugInfo( const QString &info )
+{
+  mMessages.emplace_back( [info]( QgsProcessingFeedback * feedback ) { feedback->pushDebugInfo( info ); } );
+}
+
+void QgsProcessingBufferedFeedback::pushConsoleInfo( const QString &info )
+{
+  mMessages.emplace_back( [info]( QgsProcessingFeedback * feedback ) { feedback->pushConsoleInfo( info ); } );
+}
+
+std::vector< QgsProcessingBufferedFeedback::Message > QgsProcessingBufferedFeedback::takeMessages()
+{
+  std::vector< Message > messages;
+  messages.swap( mMessages );
+  return messages;
+}
+
+void QgsProcessingBufferedFeedback::reportMessages( const std::vector< Message > &messages, QgsProcessingFeedback *feedback )
+{
+  for ( const Message &message : messages )
+  {
+    message( feedback );
+  }
+}
+
+///@endcond
@@ -22,6 +22,9 @@
 #include "qgsfeedback.h"
 #include "qgsmessagelog.h"
 
+#include <functional>
+#include <vector>
+
 class QgsProcessingProvider;
 
 /**
@@ -203,6 +206,56 @@ class CORE_EXPORT QgsProcessingMultiStepFeedback : public QgsProcessingFeedback
 
 };
 
+#ifndef SIP_RUN
+///@cond PRIVATE
+
+/**
+ * \class QgsProcessingBufferedFeedback
+ * \ingroup core
+ *
+ * \brief Processing feedback of a worker thread, which keeps the messages reported to it.
+ *
+ * The messages are reported to the feedback of the algorithm by the thread running it,
+ * once the work done by the worker thread is collected.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.34
+ */
+class CORE_EXPORT QgsProcessingBufferedFeedback : public QgsProcessingFeedback
+{
+  public:
+
+    //! A message kept by the feedback, which reports itself to the feedback it is given
+    using Message = std::function< void( QgsProcessingFeedback * ) >;
+
+    /**
+     * Constructor for QgsProcessingBufferedFeedback, which is canceled when the
+     * optional \a feedback is canceled.
+     */
+    explicit QgsProcessingBufferedFeedback( QgsFeedback *feedback = nullptr );
+
+    void setProgressText( const QString &text ) override;
+    void reportError( const QString &error, bool fatalError = false ) override;
+    void pushWarning( const QString &warning ) override;
+    void pushInfo( const QString &info ) override;
+    void pushCommandInfo( const QString &info ) override;
+    void pushDebugInfo( const QString &info ) override;
+    void pushConsoleInfo( const QString &info ) override;
+
+    //! Returns the messages kept since the last call, and clears them
+    std::vector< Message > takeMessages();
+
+    //! Reports the \a messages to \a feedback, in order
+    static void reportMessages( const std::vector< Message > &messages, QgsProcessingFeedback *feedback );
+
+  private:
+
+    std::vector< Message > mMessages;
+};
+
+///@endcond
+#endif
+
 #endif // QGSPROCESSINGFEEDBACK_H
 
 
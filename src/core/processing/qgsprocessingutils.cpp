@@ -37,6 +37,7 @@
 #include "qgspointcloudlayer.h"
 #include "qgsannotationlayer.h"
 #include "qgstiledmeshlayer.h"
+#include "qgsprocessingfeaturepipe.h"
 #include <QRegularExpression>
 #include <QTextCodec>
 #include <QUuid>
@@ -542,6 +543,19 @@ QgsProcessingFeatureSource *QgsProcessingUtils::variantToSource( const QVariant
   if ( layerRef.isEmpty() )
     return nullptr;
 
+  if ( QgsProcessingFeaturePipe::isPipeUri( layerRef ) )
+  {
+    // features streamed by an algorithm running at the same time
+    const std::shared_ptr< QgsProcessingFeaturePipe > pipe = QgsProcessingFeaturePipe::fromUri( layerRef );
+    if ( !pipe )
+      return nullptr;
+
+    std::unique_ptr< QgsProcessingFeatureSource> source = std::make_unique< QgsProcessingFeatureSource >( pipe->createSource(), context, true, featureLimit, filterExpression );
+    if ( overrideGeometryCheck )
+      source->setInvalidGeometryCheck( geometryCheck );
+    return source.release();
+  }
+
   QgsVectorLayer *vl = qobject_cast< QgsVectorLayer *>( QgsProcessingUtils::mapLayerFromString( layerRef, context, true, LayerHint::Vector ) );
   if ( !vl )
     return nullptr;
@@ -878,6 +892,26 @@ QgsFeatureSink *QgsProcessingUtils::createFeatureSink( QString &destination, Qgs
     options.insert( QStringLiteral( "fileEncoding" ), context.defaultEncoding().isEmpty() ? QStringLiteral( "system" ) : context.defaultEncoding() );
   }
 
+  if ( QgsProcessingFeaturePipe::isPipeUri( destination ) )
+  {
+    // features are streamed to an algorithm running at the same time
+    const std::shared_ptr< QgsProcessingFeaturePipe > pipe = QgsProcessingFeaturePipe::fromUri( destination );
+    if ( !pipe )
+      throw QgsProcessingException( QObject::tr( "Could not create pipe %1" ).arg( destination ) );
+
+    if ( remappingDefinition )
+    {
+      // the features are remapped to the fields of the definition before being streamed
+      std::unique_ptr< QgsFeatureSink > pipeSink( pipe->createSink( remappingDefinition->destinationFields(), remappingDefinition->destinationWkbType(), remappingDefinition->destinationCrs(), sinkFlags ) );
+      context.expressionContext().setFields( fields );
+      std::unique_ptr< QgsRemappingProxyFeatureSink > remapSink = std::make_unique< QgsRemappingProxyFeatureSink >( *remappingDefinition, pipeSink.release(), true );
+      remapSink->setExpressionContext( context.expressionContext() );
+      remapSink->setTransformContext( context.transformContext() );
+      return remapSink.release();
+    }
+    return pipe->createSink( fields, geometryType, crs, sinkFlags );
+  }
+
   if ( destination.isEmpty() || destination.startsWith( QLatin1String( "memory:" ) ) )
   {
     // strip "memory:" from start of destination
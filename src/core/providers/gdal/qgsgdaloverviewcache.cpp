@@ -0,0 +1,251 @@
+/***************************************************************************
+  qgsgdaloverviewcache.cpp
+  --------------------------------------
+  Date                 : October 2023
+  Copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsgdaloverviewcache.h"
+#include "qgsgdalproviderbase.h"
+#include "qgsogrutils.h"
+#include "qgslogger.h"
+#include "qgssettingsentryimpl.h"
+#include "qgssettingstree.h"
+
+#include <QFileInfo>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+///@cond PRIVATE
+
+// Maximum size of the overview of all the bands of a raster
+constexpr qint64 MEMORY_BUDGET = 64 * 1024 * 1024;
+
+// Number of overview rows built from each read of the source raster
+constexpr int BUILD_STRIP_ROWS = 64;
+
+const QgsSettingsEntryBool *QgsGdalOverviewCache::settingsEnabled = new QgsSettingsEntryBool( QStringLiteral( "memory-overviews-enabled" ), QgsSettingsTree::sTreeRaster, false, QStringLiteral( "Build overviews in memory for zoomed out reads of large local rasters without overviews" ) );
+
+const QgsSettingsEntryInteger *QgsGdalOverviewCache::settingsMaximumMemory = new QgsSettingsEntryInteger( QStringLiteral( "memory-overviews-maximum-size" ), QgsSettingsTree::sTreeRaster, 256, QStringLiteral( "Maximum memory used by all the overviews built in memory, in MB" ), Qgis::SettingsOptions(), 0 );
+
+std::atomic< qint64 > QgsGdalOverviewCache::sTotalMemoryUsage { 0 };
+
+std::shared_ptr< QgsGdalOverviewCache > QgsGdalOverviewCache::create( const QString &uri, int width, int height, const QList< GDALDataType > &dataTypes, bool maskBandExposedAsAlpha )
+{
+  if ( !settingsEnabled->value() )
+    return nullptr;
+
+  // the overview is built by reading the whole raster, which is only acceptable for local files
+  const QVariantMap parts = QgsGdalProviderBase::decodeGdalUri( uri );
+  if ( !parts.value( QStringLiteral( "vsiPrefix" ) ).toString().isEmpty() || !QFileInfo( parts.value( QStringLiteral( "path" ) ).toString() ).isFile() )
+    return nullptr;
+
+  const qint64 maximumMemory = static_cast< qint64 >( settingsMaximumMemory->value() ) * 1024 * 1024;
+  const qint64 budget = std::min( MEMORY_BUDGET, maximumMemory );
+
+  qint64 pixelSize = 0;
+  for ( const GDALDataType type : dataTypes )
+    pixelSize += GDALGetDataTypeSizeBytes( type );
+
+  if ( width <= 0 || height <= 0 || pixelSize == 0 || budget <= 0 || static_cast< qint64 >( width ) * height * pixelSize <= budget )
+    return nullptr;
+
+  // the finest power of two decimation fitting the budget
+  int factor = 2;
+  while ( static_cast< qint64 >( ( width + factor - 1 ) / factor ) * ( ( height + factor - 1 ) / factor ) * pixelSize > budget )
+    factor *= 2;
+
+  return std::shared_ptr< QgsGdalOverviewCache >( new QgsGdalOverviewCache( uri, width, height, factor, dataTypes, maskBandExposedAsAlpha, maximumMemory ) );
+}
+
+QgsGdalOverviewCache::QgsGdalOverviewCache( const QString &uri, int width, int height, int factor, const QList< GDALDataType > &dataTypes,
+    bool maskBandExposedAsAlpha, qint64 maximumMemory )
+  : mUri( uri )
+  , mWidth( width )
+  , mHeight( height )
+  , mFactor( factor )
+  , mOverviewWidth( std::max( 1, ( width + factor - 1 ) / factor ) )
+  , mOverviewHeight( std::max( 1, ( height + factor - 1 ) / factor ) )
+  , mDataTypes( dataTypes )
+  , mMaskBandExposedAsAlpha( maskBandExposedAsAlpha )
+  , mMaximumMemory( maximumMemory )
+{
+  for ( const GDALDataType type : dataTypes )
+    mMemoryUsage += static_cast< qint64 >( mOverviewWidth ) * mOverviewHeight * GDALGetDataTypeSizeBytes( type );
+}
+
+qint64 QgsGdalOverviewCache::totalMemoryUsage()
+{
+  return sTotalMemoryUsage;
+}
+
+bool QgsGdalOverviewCache::reserveMemory()
+{
+  qint64 usage = sTotalMemoryUsage.load();
+  do
+  {
+    if ( usage + mMemoryUsage > mMaximumMemory )
+      return false;
+  }
+  while ( !sTotalMemoryUsage.compare_exchange_weak( usage, usage + mMemoryUsage ) );
+
+  mMemoryReserved = true;
+  return true;
+}
+
+void QgsGdalOverviewCache::releaseMemory()
+{
+  if ( !mMemoryReserved )
+    return;
+
+  sTotalMemoryUsage -= mMemoryUsage;
+  mMemoryReserved = false;
+}
+
+QgsGdalOverviewCache::~QgsGdalOverviewCache()
+{
+  mCanceled = true;
+  mBuild.waitForFinished();
+  releaseMemory();
+}
+
+bool QgsGdalOverviewCache::read( int bandNo, int sourceLeft, int sourceTop, int sourceWidth, int sourceHeight,
+                                 void *data, int bufferWidth, int bufferHeight, GDALDataType type )
+{
+  if ( bandNo < 1 || bandNo > mDataTypes.size() || type != mDataTypes.at( bandNo - 1 ) )
+    return false;
+
+  if ( bufferWidth <= 0 || bufferHeight <= 0 )
+    return false;
+
+  // the overview is only used when it is at least as fine as the requested resolution
+  const double xStep = static_cast< double >( sourceWidth ) / bufferWidth;
+  const double yStep = static_cast< double >( sourceHeight ) / bufferHeight;
+  if ( xStep < mFactor || yStep < mFactor )
+    return false;
+
+  int state = mState.load( std::memory_order_acquire );
+  if ( state == NotBuilt )
+  {
+    if ( mState.compare_exchange_strong( state, Building ) )
+    {
+      // the build is attempted again by a later read once other overviews free enough memory
+      if ( !reserveMemory() )
+      {
+        QgsDebugMsgLevel( QStringLiteral( "Not enough memory left for the overview of %1" ).arg( mUri ), 2 );
+        mState = NotBuilt;
+        return false;
+      }
+
+      QgsDebugMsgLevel( QStringLiteral( "Building overview 1:%1 of %2 in memory" ).arg( mFactor ).arg( mUri ), 2 );
+      mBuild = QtConcurrent::run( [this] { build(); } );
+    }
+    return false;
+  }
+  if ( state != Ready )
+    return false;
+
+  const std::vector< unsigned char > &band = mBands[static_cast< std::size_t >( bandNo - 1 )];
+  const int dataSize = GDALGetDataTypeSizeBytes( type );
+  const double xScale = static_cast< double >( mOverviewWidth ) / mWidth;
+  const double yScale = static_cast< double >( mOverviewHeight ) / mHeight;
+
+  // the overview column of each buffer column, sampled at the center of the buffer cells
+  std::vector< int > columns( static_cast< std::size_t >( bufferWidth ) );
+  for ( int col = 0; col < bufferWidth; ++col )
+  {
+    const double sourceX = sourceLeft + ( col + 0.5 ) * xStep;
+    columns[col] = std::clamp( static_cast< int >( sourceX * xScale ), 0, mOverviewWidth - 1 );
+  }
+
+  unsigned char *output = static_cast< unsigned char * >( data );
+  for ( int row = 0; row < bufferHeight; ++row )
+  {
+    const double sourceY = sourceTop + ( row + 0.5 ) * yStep;
+    const int overviewRow = std::clamp( static_cast< int >( sourceY * yScale ), 0, mOverviewHeight - 1 );
+    const unsigned char *input = band.data() + static_cast< std::size_t >( overviewRow ) * mOverviewWidth * dataSize;
+    for ( int col = 0; col < bufferWidth; ++col )
+    {
+      std::memcpy( output, input + static_cast< std::size_t >( columns[col] ) * dataSize, dataSize );
+      output += dataSize;
+    }
+  }
+  return true;
+}
+
+void QgsGdalOverviewCache::build()
+{
+  // the building thread uses its own dataset, GDAL datasets cannot be shared between threads
+  const gdal::dataset_unique_ptr dataset( QgsGdalProviderBase::gdalOpen( mUri, GDAL_OF_READONLY ) );
+  const int rasterCount = dataset ? GDALGetRasterCount( dataset.get() ) : 0;
+  if ( !dataset || GDALGetRasterXSize( dataset.get() ) != mWidth || GDALGetRasterYSize( dataset.get() ) != mHeight
+       || rasterCount + ( mMaskBandExposedAsAlpha ? 1 : 0 ) < mDataTypes.size() || rasterCount == 0 )
+  {
+    QgsDebugError( QStringLiteral( "Could not open %1 to build its overview" ).arg( mUri ) );
+    releaseMemory();
+    mState = Failed;
+    return;
+  }
+
+  std::vector< std::vector< unsigned char > > bands( static_cast< std::size_t >( mDataTypes.size() ) );
+  for ( int bandIndex = 0; bandIndex < mDataTypes.size(); ++bandIndex )
+  {
+    const GDALDataType type = mDataTypes.at( bandIndex );
+    const int dataSize = GDALGetDataTypeSizeBytes( type );
+    std::vector< unsigned char > &band = bands[static_cast< std::size_t >( bandIndex )];
+    band.resize( static_cast< std::size_t >( mOverviewWidth ) * mOverviewHeight * dataSize );
+
+    // the alpha band exposed by the provider is the mask band of the dataset
+    GDALRasterBandH gdalBand = bandIndex < rasterCount ? GDALGetRasterBand( dataset.get(), bandIndex + 1 )
+                               : GDALGetMaskBand( GDALGetRasterBand( dataset.get(), 1 ) );
+    const double rowHeight = static_cast< double >( mHeight ) / mOverviewHeight;
+    for ( int startRow = 0; startRow < mOverviewHeight; startRow += BUILD_STRIP_ROWS )
+    {
+      if ( mCanceled )
+      {
+        releaseMemory();
+        mState = Failed;
+        return;
+      }
+
+      const int rows = std::min( BUILD_STRIP_ROWS, mOverviewHeight - startRow );
+
+      GDALRasterIOExtraArg extraArg;
+      INIT_RASTERIO_EXTRA_ARG( extraArg );
+      extraArg.eResampleAlg = GRIORA_NearestNeighbour;
+      extraArg.bFloatingPointWindowValidity = true;
+      extraArg.dfXOff = 0;
+      extraArg.dfXSize = mWidth;
+      extraArg.dfYOff = startRow * rowHeight;
+      extraArg.dfYSize = rows * rowHeight;
+
+      const int yOff = static_cast< int >( std::floor( extraArg.dfYOff ) );
+      const int yEnd = std::min( mHeight, static_cast< int >( std::ceil( extraArg.dfYOff + extraArg.dfYSize ) ) );
+      if ( GDALRasterIOEx( gdalBand, GF_Read, 0, yOff, mWidth, std::max( 1, yEnd - yOff ),
+                           band.data() + static_cast< std::size_t >( startRow ) * mOverviewWidth * dataSize,
+                           mOverviewWidth, rows, type, 0, 0, &extraArg ) != CE_None )
+      {
+        QgsDebugError( QStringLiteral( "Could not read %1 to build its overview: %2" ).arg( mUri, QString::fromUtf8( CPLGetLastErrorMsg() ) ) );
+        releaseMemory();
+        mState = Failed;
+        return;
+      }
+    }
+  }
+
+  mBands = std::move( bands );
+  mState.store( Ready, std::memory_order_release );
+  QgsDebugMsgLevel( QStringLiteral( "Overview 1:%1 of %2 built in memory" ).arg( mFactor ).arg( mUri ), 2 );
+}
+
+///@endcond
@@ -0,0 +1,141 @@
+/***************************************************************************
+  qgsgdaloverviewcache.h
+  --------------------------------------
+  Date                 : October 2023
+  Copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSGDALOVERVIEWCACHE_H
+#define QGSGDALOVERVIEWCACHE_H
+
+#include "qgis_core.h"
+
+#include <QFuture>
+#include <QList>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <gdal.h>
+
+///@cond PRIVATE
+#define SIP_NO_FILE
+
+class QgsSettingsEntryBool;
+class QgsSettingsEntryInteger;
+
+/**
+ * \brief Overview of a GDAL raster without overviews, kept in memory.
+ *
+ * Zoomed out reads of a raster without overviews have to go through all the
+ * full resolution blocks. When enabled in the settings, the GDAL provider creates
+ * a cache for large local rasters which decimates the raster once, in the background,
+ * the first time a zoomed out read would benefit from it. The cache is shared by the
+ * provider and its clones, and reads are served from it once it has been built.
+ *
+ * The overview is built with nearest neighbour sampling and read again with nearest
+ * neighbour sampling, so the pixels it returns can be neighbours of the pixels a direct
+ * zoomed out read would return, as with the overviews built by GDAL.
+ *
+ * The memory used by all the overviews is limited by settingsMaximumMemory, overviews
+ * which would exceed it are not built.
+ *
+ * \since QGIS 3.34
+ */
+class CORE_EXPORT QgsGdalOverviewCache
+{
+  public:
+
+    //! Settings entry for building overviews in memory, disabled by default
+    static const QgsSettingsEntryBool *settingsEnabled;
+
+    //! Settings entry for the maximum memory used by all the overviews, in MB
+    static const QgsSettingsEntryInteger *settingsMaximumMemory;
+
+    /**
+     * Creates a cache for the raster opened from \a uri, with the given \a width and \a height,
+     * and the \a dataTypes used to read its bands. If \a maskBandExposedAsAlpha is TRUE, the
+     * last data type is the one of the mask band exposed as an alpha band.
+     *
+     * Returns NULLPTR if the cache is disabled, the raster is not a local file or it is small
+     * enough to be read at full resolution.
+     */
+    static std::shared_ptr< QgsGdalOverviewCache > create( const QString &uri, int width, int height, const QList< GDALDataType > &dataTypes, bool maskBandExposedAsAlpha );
+
+    ~QgsGdalOverviewCache();
+
+    QgsGdalOverviewCache( const QgsGdalOverviewCache & ) = delete;
+    QgsGdalOverviewCache &operator=( const QgsGdalOverviewCache & ) = delete;
+
+    //! Returns the decimation factor of the overview
+    int factor() const { return mFactor; }
+
+    /**
+     * Reads the source window of band \a bandNo to \a data, with \a bufferWidth columns
+     * and \a bufferHeight rows of the given \a type, like GDALRasterIO().
+     *
+     * Returns FALSE if the read cannot be served by the overview, because the requested
+     * resolution is finer than the overview or the overview is not built yet. The
+     * background build is started by the first read which could be served by the overview,
+     * if the memory used by the other overviews leaves room for it.
+     */
+    bool read( int bandNo, int sourceLeft, int sourceTop, int sourceWidth, int sourceHeight,
+               void *data, int bufferWidth, int bufferHeight, GDALDataType type );
+
+    //! Returns the memory used by all the overviews which are built or being built, in bytes
+    static qint64 totalMemoryUsage();
+
+  private:
+
+    enum State
+    {
+      NotBuilt,
+      Building,
+      Ready,
+      Failed
+    };
+
+    QgsGdalOverviewCache( const QString &uri, int width, int height, int factor, const QList< GDALDataType > &dataTypes,
+                          bool maskBandExposedAsAlpha, qint64 maximumMemory );
+
+    //! Builds the overview from a dataset opened by the building thread
+    void build();
+
+    //! Reserves the memory of the overview within the memory of all the overviews
+    bool reserveMemory();
+
+    //! Releases the memory reserved for the overview
+    void releaseMemory();
+
+    QString mUri;
+    int mWidth = 0;
+    int mHeight = 0;
+    int mFactor = 1;
+    int mOverviewWidth = 0;
+    int mOverviewHeight = 0;
+    QList< GDALDataType > mDataTypes;
+    bool mMaskBandExposedAsAlpha = false;
+    qint64 mMemoryUsage = 0;
+    qint64 mMaximumMemory = 0;
+    bool mMemoryReserved = false;
+    std::vector< std::vector< unsigned char > > mBands;
+
+    std::atomic< int > mState { NotBuilt };
+    std::atomic< bool > mCanceled { false };
+    QFuture< void > mBuild;
+
+    static std::atomic< qint64 > sTotalMemoryUsage;
+};
+
+///@endcond
+
+#endif // QGSGDALOVERVIEWCACHE_H
@@ -17,6 +17,7 @@
  ***************************************************************************/
 
 #include "qgsgdalprovider.h"
+#include "qgsgdaloverviewcache.h"
 ///@cond PRIVATE
 
 #include "qgis.h"
@@ -33,6 +34,7 @@
 #include "qgsrectangle.h"
 #include "qgscoordinatereferencesystem.h"
 #include "qgsrasterbandstats.h"
+#include "qgsrasterblockcache.h"
 #include "qgsrasteridentifyresult.h"
 #include "qgsrasterpyramid.h"
 #include "qgspointxy.h"
@@ -245,6 +247,7 @@ QgsGdalProvider::QgsGdalProvider( const QgsGdalProvider &other )
   mSubLayers = other.mSubLayers;
   mMaskBandExposedAsAlpha = other.mMaskBandExposedAsAlpha;
   mBandCount = other.mBandCount;
+  mOverviewCache = other.mOverviewCache;
   copyBaseSettings( other );
 }
 
@@ -473,6 +476,7 @@ void QgsGdalProvider::closeDataset()
 
   GDALClose( mGdalDataset );
   mGdalDataset = nullptr;
+  mOverviewCache.reset();
 
   closeCachedGdalHandlesFor( this );
 }
@@ -481,6 +485,7 @@ void QgsGdalProvider::reloadProviderData()
 {
   QMutexLocker locker( mpMutex );
   closeDataset();
+  QgsRasterBlockCache::invalidate( blockCachePrefix() );
 
   mHasInit = false;
   ( void )initIfNeeded();
@@ -828,12 +833,95 @@ static GDALRIOResampleAlg getGDALResamplingAlg( QgsGdalProvider::ResamplingMetho
   return eResampleAlg;
 }
 
+CPLErr QgsGdalProvider::readDecimatedWindow( int bandNo, GDALRasterBandH gdalBand,
+    int srcLeft, int srcTop, int srcWidth, int srcHeight,
+    void *data, int bufferWidth, int bufferHeight, GDALDataType type,
+    QgsRasterBlockFeedback *feedback )
+{
+  // when enabled, zoomed out reads of large local rasters without overviews are
+  // served by the overview cache, which is built on the first read it could serve
+  if ( mOverviewCache && mOverviewCache->read( bandNo, srcLeft, srcTop, srcWidth, srcHeight, data, bufferWidth, bufferHeight, type ) )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "using overview cache 1:%1" ).arg( mOverviewCache->factor() ), 5 );
+    return CE_None;
+  }
+
+  return gdalRasterIO( gdalBand, GF_Read,
+                       srcLeft, srcTop, srcWidth, srcHeight,
+                       data, bufferWidth, bufferHeight, type,
+                       0, 0, feedback );
+}
+
+QString QgsGdalProvider::blockCachePrefix() const
+{
+  return QStringLiteral( "gdal\n" ) + dataSourceUri() + '\n';
+}
+
+QString QgsGdalProvider::blockCacheSource() const
+{
+  // datasets opened for writing change while they are read
+  if ( mUpdate )
+    return QString();
+
+  // the values read depend on the modification time of the file and on the resampling settings
+  const QString path = decodeGdalUri( dataSourceUri() ).value( QStringLiteral( "path" ) ).toString();
+  const QFileInfo fileInfo( path );
+  const qint64 modified = fileInfo.exists() ? fileInfo.lastModified().toMSecsSinceEpoch() : 0;
+  return blockCachePrefix() + QStringLiteral( "%1\n%2,%3,%4,%5" ).arg( modified )
+         .arg( mProviderResamplingEnabled )
+         .arg( static_cast< int >( mZoomedInResamplingMethod ) )
+         .arg( static_cast< int >( mZoomedOutResamplingMethod ) )
+         .arg( mMaxOversampling );
+}
+
 bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &reqExtent, int bufferWidthPix, int bufferHeightPix, void *data, QgsRasterBlockFeedback *feedback )
 {
   QMutexLocker locker( mpMutex );
   if ( !initIfNeeded() )
     return false;
 
+  const QString cacheSource = blockCacheSource();
+  const QgsRectangle intersectExtent = reqExtent.intersect( mExtent );
+  if ( cacheSource.isEmpty() || intersectExtent.isEmpty() )
+    return readDatasetBlock( bandNo, reqExtent, bufferWidthPix, bufferHeightPix, data, feedback );
+
+  // only the part of the buffer covered by the raster is read, the rest is left untouched
+  const QRect subRect = QgsRasterBlock::subRect( reqExtent, bufferWidthPix, bufferHeightPix, intersectExtent );
+  const size_t dataSize = static_cast<size_t>( dataTypeSize( bandNo ) );
+  const size_t rowSize = dataSize * subRect.width();
+  char *buffer = static_cast<char *>( data );
+
+  QByteArray cached;
+  if ( QgsRasterBlockCache::block( cacheSource, bandNo, reqExtent, bufferWidthPix, bufferHeightPix, cached )
+       && static_cast<size_t>( cached.size() ) == rowSize * subRect.height() )
+  {
+    for ( int row = 0; row < subRect.height(); ++row )
+    {
+      memcpy( buffer + ( static_cast<size_t>( subRect.top() + row ) * bufferWidthPix + subRect.left() ) * dataSize,
+              cached.constData() + row * rowSize, rowSize );
+    }
+    return true;
+  }
+
+  if ( !readDatasetBlock( bandNo, reqExtent, bufferWidthPix, bufferHeightPix, data, feedback ) )
+    return false;
+
+  if ( feedback && feedback->isCanceled() )
+    return true;
+
+  QByteArray read( static_cast<int>( rowSize * subRect.height() ), Qt::Uninitialized );
+  for ( int row = 0; row < subRect.height(); ++row )
+  {
+    memcpy( read.data() + row * rowSize,
+            buffer + ( static_cast<size_t>( subRect.top() + row ) * bufferWidthPix + subRect.left() ) * dataSize, rowSize );
+  }
+  QgsRasterBlockCache::insertBlock( cacheSource, bandNo, reqExtent, bufferWidthPix, bufferHeightPix, read );
+  return true;
+}
+
+bool QgsGdalProvider::readDatasetBlock( int bandNo, QgsRectangle  const &reqExtent, int bufferWidthPix, int bufferHeightPix, void *data, QgsRasterBlockFeedback *feedback )
+{
+
   QgsDebugMsgLevel( "bufferWidthPix = "  + QString::number( bufferWidthPix ), 5 );
   QgsDebugMsgLevel( "bufferHeightPix = "  + QString::number( bufferHeightPix ), 5 );
   QgsDebugMsgLevel( "reqExtent: " + reqExtent.toString(), 5 );
@@ -1061,11 +1149,10 @@ bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &reqExtent, int
     CPLErrorReset();
 
 
-    CPLErr err = gdalRasterIO( gdalBand, GF_Read,
-                               srcLeft, srcTop, srcWidth, srcHeight,
-                               static_cast<void *>( tmpBlock ),
-                               tmpWidth, tmpHeight, type,
-                               0, 0, feedback );
+    CPLErr err = readDecimatedWindow( bandNo, gdalBand,
+                                      srcLeft, srcTop, srcWidth, srcHeight,
+                                      static_cast<void *>( tmpBlock ),
+                                      tmpWidth, tmpHeight, type, feedback );
 
     if ( err != CPLE_None )
     {
@@ -1168,11 +1255,10 @@ bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &reqExtent, int
   }
   CPLErrorReset();
 
-  CPLErr err = gdalRasterIO( gdalBand, GF_Read,
-                             srcLeft, srcTop, srcWidth, srcHeight,
-                             static_cast<void *>( tmpBlock ),
-                             tmpWidth, tmpHeight, type,
-                             0, 0, feedback );
+  CPLErr err = readDecimatedWindow( bandNo, gdalBand,
+                                    srcLeft, srcTop, srcWidth, srcHeight,
+                                    static_cast<void *>( tmpBlock ),
+                                    tmpWidth, tmpHeight, type, feedback );
 
   if ( err != CPLE_None )
   {
@@ -2288,6 +2374,8 @@ QString QgsGdalProvider::buildPyramids( const QList<QgsRasterPyramid> &rasterPyr
       QgsDebugMsgLevel( QStringLiteral( "Building pyramids finished OK" ), 2 );
       //make sure the raster knows it has pyramids
       mHasPyramids = true;
+      mOverviewCache.reset();
+      QgsRasterBlockCache::invalidate( blockCachePrefix() );
     }
   }
   catch ( CPLErr )
@@ -3180,6 +3268,46 @@ QgsRasterBandStats QgsGdalProvider::bandStatistics( int bandNo, int stats, const
 
 } // QgsGdalProvider::bandStatistics
 
+QgsRasterQuantileSketch QgsGdalProvider::quantileSketch( int bandNo, const QgsRectangle &extent, int sampleSize, QgsRasterBlockFeedback *feedback )
+{
+  QMutexLocker locker( mpMutex );
+  if ( !initIfNeeded() )
+    return QgsRasterQuantileSketch();
+
+  QgsRasterBandStats sketchStatistics;
+  initStatistics( sketchStatistics, bandNo, QgsRasterBandStats::None, extent, sampleSize );
+
+  // sketches are only stored with the dataset for the full extent and the source no data values
+  if ( sketchStatistics.extent != this->extent() ||
+       ( sourceHasNoDataValue( bandNo ) && !useSourceNoDataValue( bandNo ) ) ||
+       !userNoDataValues( bandNo ).isEmpty() )
+  {
+    return QgsRasterDataProvider::quantileSketch( bandNo, extent, sampleSize, feedback );
+  }
+
+  // the key includes the size, as sketches of different sample sizes differ
+  GDALRasterBandH myGdalBand = getBand( bandNo );
+  const QByteArray key = QStringLiteral( "QUANTILE_SKETCH_%1x%2" ).arg( sketchStatistics.width ).arg( sketchStatistics.height ).toUtf8();
+  if ( const char *stored = GDALGetMetadataItem( myGdalBand, key.constData(), "QGIS" ) )
+  {
+    bool ok = false;
+    const QgsRasterQuantileSketch sketch = QgsRasterQuantileSketch::fromString( QString::fromUtf8( stored ), &ok );
+    if ( ok )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Using quantile sketch stored with the dataset." ), 2 );
+      return sketch;
+    }
+  }
+
+  const QgsRasterQuantileSketch sketch = QgsRasterDataProvider::quantileSketch( bandNo, extent, sampleSize, feedback );
+  if ( sketch.count() > 0 && !( feedback && feedback->isCanceled() ) )
+  {
+    // persisted to the .aux.xml file by GDAL PAM, like the GDAL statistics
+    GDALSetMetadataItem( myGdalBand, key.constData(), sketch.toString().toUtf8().constData(), "QGIS" );
+  }
+  return sketch;
+}
+
 static void sanitizeVRTFile( QString const &fileName )
 {
   Q_UNUSED( fileName );
@@ -3871,6 +3999,12 @@ void QgsGdalProvider::initBaseDataset()
     mGdalDataType.append( GDT_Byte );
   }
 
+  // clones opening their own dataset keep the cache shared with the main provider
+  if ( !mOverviewCache && !mUpdate && !mHasPyramids && mGdalDataset == mGdalBaseDataset )
+  {
+    mOverviewCache = QgsGdalOverviewCache::create( dataSourceUri( true ), mWidth, mHeight, mGdalDataType, mMaskBandExposedAsAlpha );
+  }
+
   loadMetadata();
 }
 
@@ -3934,6 +4068,9 @@ bool QgsGdalProvider::write( void *data, int band, int width, int height, int xO
     gdalDataType = GDT_Float64;
 #endif
 
+  // other providers of the dataset may have cached the previous values
+  QgsRasterBlockCache::invalidate( blockCachePrefix() );
+
   return gdalRasterIO( rasterBand, GF_Write, xOffset, yOffset, width, height, data, width, height, gdalDataType, 0, 0 ) == CE_None;
 }
 
@@ -4172,6 +4309,7 @@ bool QgsGdalProvider::setEditable( bool enabled )
   }
 
   closeDataset();
+  QgsRasterBlockCache::invalidate( blockCachePrefix() );
 
   mUpdate = enabled;
 
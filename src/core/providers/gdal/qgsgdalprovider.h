@@ -34,12 +34,15 @@
 #include <QMap>
 #include <QVector>
 
+#include <memory>
+
 ///@cond PRIVATE
 #define SIP_NO_FILE
 
 class QMutex;
 
 class QgsRasterPyramid;
+class QgsGdalOverviewCache;
 
 /**
  * \ingroup core
@@ -175,6 +178,10 @@ class QgsGdalProvider final: public QgsRasterDataProvider, QgsGdalProviderBase
                                        const QgsRectangle &boundingBox = QgsRectangle(),
                                        int sampleSize = 0, QgsRasterBlockFeedback *feedback = nullptr ) override;
 
+    QgsRasterQuantileSketch quantileSketch( int bandNo,
+                                            const QgsRectangle &extent = QgsRectangle(),
+                                            int sampleSize = 0, QgsRasterBlockFeedback *feedback = nullptr ) override;
+
     bool hasHistogram( int bandNo,
                        int binCount = 0,
                        double minimum = std::numeric_limits<double>::quiet_NaN(),
@@ -368,6 +375,24 @@ class QgsGdalProvider final: public QgsRasterDataProvider, QgsGdalProviderBase
       const QgsRectangle &reqExtent,
       int bufferWidthPix,
       int bufferHeightPix );
+
+    //! Reads a block from the dataset, without the block cache
+    bool readDatasetBlock( int bandNo, QgsRectangle  const &reqExtent, int bufferWidthPix, int bufferHeightPix, void *data, QgsRasterBlockFeedback *feedback );
+
+    //! Returns the prefix of the block cache sources of the dataset
+    QString blockCachePrefix() const;
+
+    //! Returns the block cache source of the dataset with the current settings, or an empty string if blocks must not be cached
+    QString blockCacheSource() const;
+
+    //! Reads a source window decimated to the buffer size, from the overview cache when possible
+    CPLErr readDecimatedWindow( int bandNo, GDALRasterBandH gdalBand,
+                                int srcLeft, int srcTop, int srcWidth, int srcHeight,
+                                void *data, int bufferWidth, int bufferHeight, GDALDataType type,
+                                QgsRasterBlockFeedback *feedback );
+
+    //! Overview kept in memory for zoomed out reads of large rasters without overviews, shared with the clones
+    std::shared_ptr< QgsGdalOverviewCache > mOverviewCache;
 };
 
 /**
@@ -135,6 +135,11 @@ QString QgsRemappingProxyFeatureSink::lastError() const
   return mSink->lastError();
 }
 
+bool QgsRemappingProxyFeatureSink::flushBuffer()
+{
+  return mSink->flushBuffer();
+}
+
 QVariant QgsRemappingSinkDefinition::toVariant() const
 {
   QVariantMap map;
@@ -236,13 +236,21 @@ void QgsRuntimeProfiler::start( const QString &name, const QString &group )
 }
 
 void QgsRuntimeProfiler::end( const QString &group )
+{
+  endNode( group, -1 );
+}
+
+void QgsRuntimeProfiler::endNode( const QString &group, double elapsed )
 {
   if ( mCurrentStack[group].empty() )
     return;
 
   QgsRuntimeProfilerNode *node = mCurrentStack[group].top();
   mCurrentStack[group].pop();
-  node->stop();
+  if ( elapsed >= 0 )
+    node->setElapsed( elapsed );
+  else
+    node->stop();
 
   const QModelIndex nodeIndex = node2index( node );
   const QModelIndex col2Index = index( nodeIndex.row(), 1, nodeIndex.parent() );
@@ -283,6 +291,13 @@ void QgsRuntimeProfiler::clear( const QString &group )
   }
 }
 
+void QgsRuntimeProfiler::record( const QString &name, double time, const QString &group )
+{
+  start( name, group );
+  // the recorded time is set before the event is reported as ended, to the main thread profiler too
+  endNode( group, std::max( 0.0, time ) );
+}
+
 double QgsRuntimeProfiler::totalTime( const QString &group )
 {
   if ( QgsRuntimeProfilerNode *node = pathToNode( group, QString() ) )
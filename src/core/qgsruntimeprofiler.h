@@ -219,6 +219,17 @@ class CORE_EXPORT QgsRuntimeProfiler : public QAbstractItemModel
      */
     void end( const QString &group = "startup" );
 
+    /**
+     * Records a completed profile event with the given \a name, which took \a time seconds.
+     *
+     * The event is added as a child of the current profile event of the \a group. This
+     * allows timings measured elsewhere (e.g. by a map renderer job in worker threads)
+     * to be reported alongside the profiled events.
+     *
+     * \since QGIS 3.34
+     */
+    void record( const QString &name, double time, const QString &group = "startup" );
+
     /**
      * Returns the profile time for the specified \a name.
      * \since QGIS 3.14
@@ -292,6 +303,12 @@ class CORE_EXPORT QgsRuntimeProfiler : public QAbstractItemModel
     QgsRuntimeProfilerNode *pathToNode( const QString &group, const QString &path ) const;
     QgsRuntimeProfilerNode *pathToNode( const QString &group, const QStringList &path ) const;
     QModelIndex node2index( QgsRuntimeProfilerNode *node ) const;
+
+    /**
+     * Ends the current profiling event of a \a group, recording an \a elapsed time in seconds, or the
+     * time elapsed since the event was started if \a elapsed is negative.
+     */
+    void endNode( const QString &group, double elapsed );
     QModelIndex indexOfParentNode( QgsRuntimeProfilerNode *parentNode ) const;
 
     /**
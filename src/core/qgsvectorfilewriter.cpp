@@ -2604,6 +2604,26 @@ QString QgsVectorFileWriter::lastError() const
   return mErrorMessage;
 }
 
+bool QgsVectorFileWriter::flushBuffer()
+{
+  if ( !mUsingTransaction )
+    return OGRERR_NONE == OGR_L_SyncToDisk( mLayer );
+
+  if ( OGRERR_NONE != OGR_L_CommitTransaction( mLayer ) )
+  {
+    mUsingTransaction = false;
+    mErrorMessage = QObject::tr( "Error while committing transaction on OGRLayer (OGR error: %1)" ).arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
+    return false;
+  }
+
+  // the next features are written in a new transaction
+  if ( OGRERR_NONE != OGR_L_StartTransaction( mLayer ) )
+  {
+    mUsingTransaction = false;
+  }
+  return true;
+}
+
 bool QgsVectorFileWriter::addFeatureWithStyle( QgsFeature &feature, QgsFeatureRenderer *renderer, Qgis::DistanceUnit outputUnit )
 {
   // create the feature
@@ -846,6 +846,12 @@ class CORE_EXPORT QgsVectorFileWriter : public QgsFeatureSink
     bool addFeatures( QgsFeatureList &features, QgsFeatureSink::Flags flags = QgsFeatureSink::Flags() ) override;
     QString lastError() const override;
 
+    /**
+     * Commits the features written so far, or writes them to disk when the data source isn't
+     * written in a transaction, so that they are kept if the writing is interrupted.
+     */
+    bool flushBuffer() override;
+
     /**
      * Adds a \a feature to the currently opened data source, using the style from a specified \a renderer.
      * \since QGIS 3.0
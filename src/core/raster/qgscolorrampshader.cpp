@@ -31,13 +31,29 @@ originally part of the larger QgsRasterLayer class
 #include "qgssymbollayerutils.h"
 #include "qgsreadwritecontext.h"
 #include "qgscolorramplegendnodesettings.h"
+#include "qgscontrastenhancement.h"
+
+#include <QMutex>
+#include <QMutexLocker>
 
 #include <cmath>
+#include <limits>
+#include <map>
+
+///@cond PRIVATE
+struct QgsColorRampShader::LookupTableCache
+{
+  QMutex mutex;
+  std::map< Qgis::DataType, std::shared_ptr< const QgsColorRampLookupTable > > tables;
+};
+///@endcond
+
 QgsColorRampShader::QgsColorRampShader( double minimumValue, double maximumValue, QgsColorRamp *colorRamp, Type type, ClassificationMode classificationMode )
   : QgsRasterShaderFunction( minimumValue, maximumValue )
   , mColorRampType( type )
   , mClassificationMode( classificationMode )
   , mLegendSettings( std::make_unique< QgsColorRampLegendNodeSettings >() )
+  , mLookupTableCache( std::make_shared< LookupTableCache >() )
 {
   QgsDebugMsgLevel( QStringLiteral( "called." ), 4 );
 
@@ -56,6 +72,8 @@ QgsColorRampShader::QgsColorRampShader( const QgsColorRampShader &other )
   , mLUTInitialized( other.mLUTInitialized )
   , mClip( other.mClip )
   , mLegendSettings( other.legendSettings() ? new QgsColorRampLegendNodeSettings( *other.legendSettings() ) : new QgsColorRampLegendNodeSettings() )
+  , mQuantizedLookupTableSize( other.mQuantizedLookupTableSize )
+  , mLookupTableCache( other.mLookupTableCache )
 {
   if ( auto *lSourceColorRamp = other.sourceColorRamp() )
     mSourceColorRamp.reset( lSourceColorRamp->clone() );
@@ -79,6 +97,8 @@ QgsColorRampShader &QgsColorRampShader::operator=( const QgsColorRampShader &oth
   mClip = other.mClip;
   mColorRampItemList = other.mColorRampItemList;
   mLegendSettings.reset( other.legendSettings() ? new QgsColorRampLegendNodeSettings( *other.legendSettings() ) : new QgsColorRampLegendNodeSettings() );
+  mQuantizedLookupTableSize = other.mQuantizedLookupTableSize;
+  mLookupTableCache = other.mLookupTableCache;
   return *this;
 }
 
@@ -102,11 +122,13 @@ void QgsColorRampShader::setColorRampItemList( const QList<QgsColorRampShader::C
   // Reset the look up table when the color ramp is changed
   mLUTInitialized = false;
   mLUT.clear();
+  resetLookupTables();
 }
 
 void QgsColorRampShader::setColorRampType( QgsColorRampShader::Type colorRampType )
 {
   mColorRampType = colorRampType;
+  resetLookupTables();
 }
 
 bool QgsColorRampShader::isEmpty() const
@@ -128,6 +150,13 @@ void QgsColorRampShader::setColorRampType( const QString &type )
   {
     mColorRampType = Exact;
   }
+  resetLookupTables();
+}
+
+void QgsColorRampShader::setClip( bool clip )
+{
+  mClip = clip;
+  resetLookupTables();
 }
 
 QgsColorRamp *QgsColorRampShader::sourceColorRamp() const
@@ -569,6 +598,8 @@ QDomElement QgsColorRampShader::writeXml( QDomDocument &doc, const QgsReadWriteC
   colorRampShaderElem.setAttribute( QStringLiteral( "minimumValue" ), mMinimumValue );
   colorRampShaderElem.setAttribute( QStringLiteral( "maximumValue" ), mMaximumValue );
   colorRampShaderElem.setAttribute( QStringLiteral( "labelPrecision" ), mLabelPrecision );
+  if ( mQuantizedLookupTableSize > 0 )
+    colorRampShaderElem.setAttribute( QStringLiteral( "quantizedLookupTableSize" ), mQuantizedLookupTableSize );
 
   // save source color ramp
   if ( sourceColorRamp() )
@@ -611,6 +642,7 @@ void QgsColorRampShader::readXml( const QDomElement &colorRampShaderElem, const
   setMinimumValue( colorRampShaderElem.attribute( QStringLiteral( "minimumValue" ) ).toDouble() );
   setMaximumValue( colorRampShaderElem.attribute( QStringLiteral( "maximumValue" ) ).toDouble() );
   setLabelPrecision( colorRampShaderElem.attribute( QStringLiteral( "labelPrecision" ), QStringLiteral( "6" ) ).toDouble() );
+  setQuantizedLookupTableSize( colorRampShaderElem.attribute( QStringLiteral( "quantizedLookupTableSize" ), QStringLiteral( "0" ) ).toInt() );
 
   QList<QgsColorRampShader::ColorRampItem> itemList;
   QDomElement itemElem;
@@ -649,3 +681,91 @@ void QgsColorRampShader::setLegendSettings( QgsColorRampLegendNodeSettings *sett
     return;
   mLegendSettings.reset( settings );
 }
+
+void QgsColorRampShader::setQuantizedLookupTableSize( int size )
+{
+  const int newSize = std::max( size, 0 );
+  if ( newSize == mQuantizedLookupTableSize )
+    return;
+
+  mQuantizedLookupTableSize = newSize;
+  resetLookupTables();
+}
+
+std::shared_ptr< const QgsColorRampLookupTable > QgsColorRampShader::lookupTable( Qgis::DataType dataType ) const
+{
+  if ( mColorRampItemList.isEmpty() )
+    return nullptr;
+
+  double minimum = 0;
+  double maximum = 0;
+  int size = 0;
+  switch ( dataType )
+  {
+    case Qgis::DataType::Byte:
+    case Qgis::DataType::Int8:
+    case Qgis::DataType::UInt16:
+    case Qgis::DataType::Int16:
+      // every value of the type has its own entry, colors are exact
+      minimum = QgsContrastEnhancement::minimumValuePossible( dataType );
+      maximum = QgsContrastEnhancement::maximumValuePossible( dataType );
+      size = static_cast< int >( maximum - minimum ) + 1;
+      break;
+
+    case Qgis::DataType::Float32:
+    case Qgis::DataType::Float64:
+      // exact ramps only color values equal to their items, they cannot be sampled
+      if ( mQuantizedLookupTableSize < 2 || mColorRampType == Exact )
+        return nullptr;
+      minimum = mColorRampItemList.constFirst().value;
+      maximum = mColorRampItemList.constLast().value;
+      if ( !std::isfinite( minimum ) || !std::isfinite( maximum ) || maximum <= minimum )
+        return nullptr;
+      size = mQuantizedLookupTableSize;
+      break;
+
+    case Qgis::DataType::UInt32:
+    case Qgis::DataType::Int32:
+    case Qgis::DataType::CInt16:
+    case Qgis::DataType::CInt32:
+    case Qgis::DataType::CFloat32:
+    case Qgis::DataType::CFloat64:
+    case Qgis::DataType::ARGB32:
+    case Qgis::DataType::ARGB32_Premultiplied:
+    case Qgis::DataType::UnknownDataType:
+      return nullptr;
+  }
+
+  QMutexLocker locker( &mLookupTableCache->mutex );
+  std::shared_ptr< const QgsColorRampLookupTable > &table = mLookupTableCache->tables[ dataType ];
+  if ( !table )
+    table = std::make_shared< const QgsColorRampLookupTable >( *this, minimum, maximum, size );
+  return table;
+}
+
+void QgsColorRampShader::resetLookupTables()
+{
+  // copies of this shader keep using the tables built for the previous settings
+  mLookupTableCache = std::make_shared< LookupTableCache >();
+}
+
+QgsColorRampLookupTable::QgsColorRampLookupTable( const QgsColorRampShader &shader, double minimum, double maximum, int size )
+  : mMinimum( minimum )
+  , mMaximum( maximum )
+  , mScale( size > 1 ? ( size - 1 ) / ( maximum - minimum ) : 0 )
+  , mColors( static_cast< std::size_t >( std::max( size, 1 ) ) )
+  , mRendered( mColors.size() )
+{
+  const double step = size > 1 ? ( maximum - minimum ) / ( size - 1 ) : 0;
+  int red = 0;
+  int green = 0;
+  int blue = 0;
+  int alpha = 0;
+  for ( std::size_t i = 0; i < mColors.size(); ++i )
+  {
+    // the last entry is computed from the maximum to avoid rounding errors
+    const double value = i + 1 == mColors.size() ? maximum : minimum + static_cast< double >( i ) * step;
+    mRendered[i] = shader.shade( value, &red, &green, &blue, &alpha );
+    mColors[i] = mRendered[i] ? qRgba( red, green, blue, alpha ) : 0;
+  }
+}
@@ -26,6 +26,7 @@ originally part of the larger QgsRasterLayer class
 #include <QColor>
 #include <QVector>
 #include <memory>
+#include <vector>
 
 #include "qgsrastershaderfunction.h"
 #include "qgsrectangle.h"
@@ -34,6 +35,7 @@ originally part of the larger QgsRasterLayer class
 
 class QgsColorRamp;
 class QgsRasterInterface;
+class QgsColorRampLookupTable;
 
 /**
  * \ingroup core
@@ -222,7 +224,7 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
      * \param clip set to TRUE to clip values which are out of range.
      * \see clip()
      */
-    void setClip( bool clip ) { mClip = clip; }
+    void setClip( bool clip );
 
     /**
      * Returns whether the shader will clip values which are out of range.
@@ -248,6 +250,47 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
      */
     void setLegendSettings( QgsColorRampLegendNodeSettings *settings SIP_TRANSFER );
 
+    /**
+     * Sets the number of entries of the lookup tables used to shade floating point rasters.
+     *
+     * When \a size is greater than 0, values of Float32 and Float64 rasters within the range
+     * of the color ramp items are shaded with the color of the nearest of \a size evenly spaced
+     * values, instead of being shaded exactly. A size of 0 (the default) disables the
+     * quantized lookup tables. Exact color ramps are never quantized.
+     *
+     * \see quantizedLookupTableSize()
+     * \since QGIS 3.34
+     */
+    void setQuantizedLookupTableSize( int size );
+
+    /**
+     * Returns the number of entries of the lookup tables used to shade floating point rasters,
+     * or 0 if floating point values are shaded exactly.
+     *
+     * \see setQuantizedLookupTableSize()
+     * \since QGIS 3.34
+     */
+    int quantizedLookupTableSize() const { return mQuantizedLookupTableSize; }
+
+#ifndef SIP_RUN
+
+    /**
+     * Returns the lookup table of the colors of the shader for rasters of the given \a dataType,
+     * or NULLPTR if values of this type must be shaded with shade().
+     *
+     * Integer types up to 16 bits get a dense table indexed by the raw values. Floating point types
+     * get a quantized table when quantizedLookupTableSize() is greater than 0.
+     *
+     * Tables are built once and shared by the copies of the shader, so that the renderers of
+     * concurrently rendered tiles do not build them again. They are rebuilt when the color ramp
+     * items, type or clipping change.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.34
+     */
+    std::shared_ptr< const QgsColorRampLookupTable > lookupTable( Qgis::DataType dataType ) const;
+#endif
+
   protected:
 
     //! Source color ramp
@@ -281,6 +324,72 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
 
     std::unique_ptr< QgsColorRampLegendNodeSettings > mLegendSettings;
 
+    int mQuantizedLookupTableSize = 0;
+
+    struct LookupTableCache;
+
+    //! Lookup tables built for this shader, shared with its copies until one of them is modified
+    std::shared_ptr< LookupTableCache > mLookupTableCache;
+
+    void resetLookupTables();
+
 };
 
+#ifndef SIP_RUN
+
+/**
+ * \ingroup core
+ * \brief Table of the colors of a QgsColorRampShader for evenly spaced values.
+ *
+ * The table trades the search of the color ramp items done by QgsColorRampShader::shade()
+ * for a single indexed read. Tables covering the whole range of an integer data type
+ * give exactly the same colors as the shader.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.34
+ */
+class CORE_EXPORT QgsColorRampLookupTable
+{
+  public:
+
+    /**
+     * Builds a table of \a size entries shading the evenly spaced values from \a minimum
+     * to \a maximum with \a shader.
+     */
+    QgsColorRampLookupTable( const QgsColorRampShader &shader, double minimum, double maximum, int size );
+
+    /**
+     * Returns TRUE if \a value is within the range of the table.
+     */
+    bool covers( double value ) const { return value >= mMinimum && value <= mMaximum; }
+
+    /**
+     * Sets \a color to the unpremultiplied color of the table entry nearest to \a value,
+     * which must be covered by the table.
+     *
+     * \returns FALSE if the shader does not render the value
+     */
+    bool color( double value, QRgb &color ) const
+    {
+      const std::size_t index = static_cast< std::size_t >( ( value - mMinimum ) * mScale + 0.5 );
+      color = mColors[index];
+      return mRendered[index];
+    }
+
+    /**
+     * Returns the number of entries of the table.
+     */
+    int size() const { return static_cast< int >( mColors.size() ); }
+
+  private:
+
+    double mMinimum = 0;
+    double mMaximum = 0;
+    double mScale = 1;
+    std::vector< QRgb > mColors;
+    std::vector< quint8 > mRendered;
+};
+
+#endif
+
 #endif
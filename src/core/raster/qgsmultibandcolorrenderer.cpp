@@ -18,6 +18,7 @@
 #include "qgsmultibandcolorrenderer.h"
 #include "qgscontrastenhancement.h"
 #include "qgsrastertransparency.h"
+#include "qgsrasterblockkernels.h"
 #include "qgsrasterviewport.h"
 #include "qgslayertreemodellegendnode.h"
 #include "qgssymbol.h"
@@ -27,6 +28,39 @@
 #include <QImage>
 #include <QSet>
 
+#include <vector>
+
+///@cond PRIVATE
+
+// Returns whether the band values can be stretched with the block kernels, and the range of the displayable values
+static bool canStretchWithKernels( const QgsRasterBlock *block, QgsContrastEnhancement *enhancement, double &displayableMinimum, double &displayableMaximum )
+{
+  if ( !block || !enhancement || enhancement->contrastEnhancementAlgorithm() != QgsContrastEnhancement::StretchToMinimumMaximum )
+    return false;
+
+  displayableMinimum = QgsContrastEnhancement::minimumValuePossible( block->dataType() );
+  displayableMaximum = QgsContrastEnhancement::maximumValuePossible( block->dataType() );
+  return enhancement->isValueInDisplayableRange( displayableMinimum ) && enhancement->isValueInDisplayableRange( displayableMaximum );
+}
+
+// Stretches a span of band values to 8 bit levels and adds the band nodata pixels to noData
+static bool stretchSpan( const QgsRasterBlock *block, const QgsContrastEnhancement *enhancement, double displayableMinimum, double displayableMaximum,
+                         qgssize start, qgssize size, double *values, quint8 *bandNoData, quint8 *noData, quint8 *levels )
+{
+  if ( !block->readValues( start, size, values, bandNoData ) )
+    return false;
+
+  QgsRasterBlockKernels::maskOutsideRange( values, size, displayableMinimum, displayableMaximum, bandNoData );
+  QgsRasterBlockKernels::linearStretch( values, size, enhancement->minimumValue(), enhancement->maximumValue(), levels );
+  for ( qgssize i = 0; i < size; ++i )
+  {
+    noData[i] |= bandNoData[i];
+  }
+  return true;
+}
+
+///@endcond
+
 QgsMultiBandColorRenderer::QgsMultiBandColorRenderer( QgsRasterInterface *input, int redBand, int greenBand, int blueBand,
     QgsContrastEnhancement *redEnhancement,
     QgsContrastEnhancement *greenEnhancement,
@@ -269,7 +303,37 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
   }
 
   const qgssize count = ( qgssize )width * height;
-  for ( qgssize i = 0; i < count; i++ )
+
+  // opaque linear stretches are rendered span by span with the block kernels, the per pixel loop is then skipped
+  bool stretched = false;
+  double redMinimum = 0, redMaximum = 0, greenMinimum = 0, greenMaximum = 0, blueMinimum = 0, blueMaximum = 0;
+  if ( !fastDraw && !usesTransparency()
+       && canStretchWithKernels( redBlock, mRedContrastEnhancement, redMinimum, redMaximum )
+       && canStretchWithKernels( greenBlock, mGreenContrastEnhancement, greenMinimum, greenMaximum )
+       && canStretchWithKernels( blueBlock, mBlueContrastEnhancement, blueMinimum, blueMaximum ) )
+  {
+    const qgssize spanSize = std::min( count, QgsRasterBlockKernels::SPAN_SIZE );
+    std::vector<double> values( spanSize );
+    std::vector<quint8> bandNoData( spanSize );
+    std::vector<quint8> noData( spanSize );
+    std::vector<quint8> red( spanSize );
+    std::vector<quint8> green( spanSize );
+    std::vector<quint8> blue( spanSize );
+
+    stretched = true;
+    for ( qgssize start = 0; stretched && start < count; start += spanSize )
+    {
+      const qgssize size = std::min( count - start, spanSize );
+      std::fill( noData.begin(), noData.end(), 0 );
+      stretched = stretchSpan( redBlock, mRedContrastEnhancement, redMinimum, redMaximum, start, size, values.data(), bandNoData.data(), noData.data(), red.data() )
+                  && stretchSpan( greenBlock, mGreenContrastEnhancement, greenMinimum, greenMaximum, start, size, values.data(), bandNoData.data(), noData.data(), green.data() )
+                  && stretchSpan( blueBlock, mBlueContrastEnhancement, blueMinimum, blueMaximum, start, size, values.data(), bandNoData.data(), noData.data(), blue.data() );
+      if ( stretched )
+        QgsRasterBlockKernels::packRgb( red.data(), green.data(), blue.data(), noData.data(), size, myDefaultColor, outputBlockColorData + start );
+    }
+  }
+
+  for ( qgssize i = 0; i < count && !stretched; i++ )
   {
     if ( fastDraw ) //fast rendering if no transparency, stretching, color inversion, etc.
     {
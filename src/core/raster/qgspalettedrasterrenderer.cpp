@@ -25,19 +25,31 @@
 #include "qgslayertreemodellegendnode.h"
 #include "qgscolorrampimpl.h"
 #include "qgsrasterattributetable.h"
+#include "qgscontrastenhancement.h"
 
 #include <QColor>
 #include <QDomDocument>
 #include <QDomElement>
 #include <QImage>
 #include <QVector>
+#include <cmath>
 #include <memory>
 #include <set>
+#include <vector>
 #include <QRegularExpression>
 #include <QTextStream>
 
 const int QgsPalettedRasterRenderer::MAX_FLOAT_CLASSES = 65536;
 
+///@cond PRIVATE
+struct QgsPalettedRasterRenderer::DenseColorTable
+{
+  double minimum = 0;
+  std::vector< QRgb > colors;
+  std::vector< quint8 > found;
+};
+///@endcond
+
 QgsPalettedRasterRenderer::QgsPalettedRasterRenderer( QgsRasterInterface *input, int bandNumber, const ClassData &classes )
   : QgsRasterRenderer( input, QStringLiteral( "paletted" ) )
   , mBand( bandNumber )
@@ -78,6 +90,12 @@ QgsPalettedRasterRenderer *QgsPalettedRasterRenderer::clone() const
 
   renderer->copyCommonProperties( this );
 
+  // the classes are the same, the clones of the pipe used for concurrent rendering reuse the tables
+  {
+    QMutexLocker locker( &mDenseColorTablesMutex );
+    renderer->mDenseColorTables = mDenseColorTables;
+  }
+
   return renderer.release();
 }
 
@@ -221,6 +239,10 @@ QgsRasterBlock *QgsPalettedRasterRenderer::block( int, QgsRectangle  const &exte
   Q_ASSERT( outputBlock ); // to make cppcheck happy
   unsigned int *outputData = ( unsigned int * )( outputBlock->bits() );
 
+  // values of integer rasters of up to 16 bits index a dense table of the colors
+  // instead of being searched in the color map for every pixel
+  const std::shared_ptr< const DenseColorTable > denseTable = denseColorTable( inputBlock->dataType() );
+
   const qgssize rasterSize = ( qgssize )width * height;
   bool isNoData = false;
   for ( qgssize i = 0; i < rasterSize; ++i )
@@ -231,15 +253,32 @@ QgsRasterBlock *QgsPalettedRasterRenderer::block( int, QgsRectangle  const &exte
       outputData[i] = myDefaultColor;
       continue;
     }
-    if ( !mColors.contains( value ) )
+
+    QRgb c;
+    if ( denseTable )
     {
-      outputData[i] = myDefaultColor;
-      continue;
+      const std::size_t index = static_cast< std::size_t >( value - denseTable->minimum );
+      if ( !denseTable->found[index] )
+      {
+        outputData[i] = myDefaultColor;
+        continue;
+      }
+      c = denseTable->colors[index];
+    }
+    else
+    {
+      const auto it = mColors.constFind( value );
+      if ( it == mColors.constEnd() )
+      {
+        outputData[i] = myDefaultColor;
+        continue;
+      }
+      c = it.value();
     }
 
     if ( !hasTransparency )
     {
-      outputData[i] = mColors.value( value );
+      outputData[i] = c;
     }
     else
     {
@@ -262,7 +301,6 @@ QgsRasterBlock *QgsPalettedRasterRenderer::block( int, QgsRectangle  const &exte
         }
       }
 
-      const QRgb c = mColors.value( value );
       outputData[i] = qRgba( currentOpacity * qRed( c ), currentOpacity * qGreen( c ), currentOpacity * qBlue( c ), currentOpacity * qAlpha( c ) );
     }
   }
@@ -807,9 +845,50 @@ QgsPalettedRasterRenderer::ClassData QgsPalettedRasterRenderer::classData() cons
   return data;
 }
 
+std::shared_ptr< const QgsPalettedRasterRenderer::DenseColorTable > QgsPalettedRasterRenderer::denseColorTable( Qgis::DataType dataType ) const
+{
+  switch ( dataType )
+  {
+    case Qgis::DataType::Byte:
+    case Qgis::DataType::Int8:
+    case Qgis::DataType::UInt16:
+    case Qgis::DataType::Int16:
+      break;
+
+    default:
+      return nullptr;
+  }
+
+  QMutexLocker locker( &mDenseColorTablesMutex );
+  std::shared_ptr< const DenseColorTable > &table = mDenseColorTables[ dataType ];
+  if ( !table )
+  {
+    std::shared_ptr< DenseColorTable > newTable = std::make_shared< DenseColorTable >();
+    newTable->minimum = QgsContrastEnhancement::minimumValuePossible( dataType );
+    const double maximum = QgsContrastEnhancement::maximumValuePossible( dataType );
+    newTable->colors.resize( static_cast< std::size_t >( maximum - newTable->minimum ) + 1 );
+    newTable->found.resize( newTable->colors.size() );
+    for ( auto it = mColors.constBegin(); it != mColors.constEnd(); ++it )
+    {
+      if ( it.key() >= newTable->minimum && it.key() <= maximum && it.key() == std::floor( it.key() ) )
+      {
+        const std::size_t index = static_cast< std::size_t >( it.key() - newTable->minimum );
+        newTable->colors[index] = it.value();
+        newTable->found[index] = 1;
+      }
+    }
+    table = std::move( newTable );
+  }
+  return table;
+}
+
 void QgsPalettedRasterRenderer::updateArrays()
 {
   mColors.clear();
+  {
+    QMutexLocker locker( &mDenseColorTablesMutex );
+    mDenseColorTables.clear();
+  }
 
   MultiValueClassData::const_iterator it = mMultiValueClassData.constBegin();
   for ( ; it != mMultiValueClassData.constEnd(); ++it )
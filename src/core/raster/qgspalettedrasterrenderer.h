@@ -21,6 +21,10 @@
 #include "qgis_core.h"
 #include "qgis_sip.h"
 #include <QVector>
+#include <QMutex>
+
+#include <map>
+#include <memory>
 
 #include "qgsrasterrenderer.h"
 #include "qgscolorrampshader.h"
@@ -237,6 +241,17 @@ class CORE_EXPORT QgsPalettedRasterRenderer: public QgsRasterRenderer
     QMap< double, QRgb > mColors;
     void updateArrays();
 
+#ifndef SIP_RUN
+    struct DenseColorTable;
+
+    //! Returns the colors indexed by value for integer rasters of \a dataType, or NULLPTR for other data types
+    std::shared_ptr< const DenseColorTable > denseColorTable( Qgis::DataType dataType ) const;
+
+    //! Dense color tables built from mColors by data type, shared with clones and reset with the classes
+    mutable QMutex mDenseColorTablesMutex;
+    mutable std::map< Qgis::DataType, std::shared_ptr< const DenseColorTable > > mDenseColorTables;
+#endif
+
     // Maximum number of allowed classes for float rasters
     static const int MAX_FLOAT_CLASSES;
 };
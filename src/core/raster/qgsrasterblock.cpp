@@ -15,6 +15,7 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <algorithm>
 #include <limits>
 
 #include <QByteArray>
@@ -27,6 +28,18 @@
 // See #9101 before any change of NODATA_COLOR!
 const QRgb QgsRasterBlock::NO_DATA_COLOR = qRgba( 0, 0, 0, 0 );
 
+///@cond PRIVATE
+template <typename T>
+static void convertValues( const void *data, qgssize index, qgssize count, double *values )
+{
+  const T *source = static_cast< const T * >( data ) + index;
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    values[i] = static_cast< double >( source[i] );
+  }
+}
+///@endcond
+
 QgsRasterBlock::QgsRasterBlock()
   : mNoDataValue( std::numeric_limits<double>::quiet_NaN() )
 {
@@ -494,6 +507,91 @@ void QgsRasterBlock::setData( const QByteArray &data, int offset )
   }
 }
 
+bool QgsRasterBlock::readValues( qgssize index, qgssize count, double *values, quint8 *noData ) const
+{
+  if ( !mData || index + count > static_cast< qgssize >( mWidth ) * mHeight )
+    return false;
+
+  // the data type is resolved once, the conversion loops are specialized for each type
+  switch ( mDataType )
+  {
+    case Qgis::DataType::Byte:
+      convertValues< quint8 >( mData, index, count, values );
+      break;
+    case Qgis::DataType::Int8:
+      convertValues< qint8 >( mData, index, count, values );
+      break;
+    case Qgis::DataType::UInt16:
+      convertValues< quint16 >( mData, index, count, values );
+      break;
+    case Qgis::DataType::Int16:
+      convertValues< qint16 >( mData, index, count, values );
+      break;
+    case Qgis::DataType::UInt32:
+      convertValues< quint32 >( mData, index, count, values );
+      break;
+    case Qgis::DataType::Int32:
+      convertValues< qint32 >( mData, index, count, values );
+      break;
+    case Qgis::DataType::Float32:
+      convertValues< float >( mData, index, count, values );
+      break;
+    case Qgis::DataType::Float64:
+      convertValues< double >( mData, index, count, values );
+      break;
+    case Qgis::DataType::CInt16:
+    case Qgis::DataType::CInt32:
+    case Qgis::DataType::CFloat32:
+    case Qgis::DataType::CFloat64:
+    case Qgis::DataType::ARGB32:
+    case Qgis::DataType::ARGB32_Premultiplied:
+    case Qgis::DataType::UnknownDataType:
+      return false;
+  }
+
+  if ( !noData )
+    return true;
+
+  if ( mHasNoDataValue )
+  {
+    // same test as isNoDataValue(), written without branches
+    const double noDataValue = mNoDataValue;
+    const double epsilon = 4 * std::numeric_limits<double>::epsilon();
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      const double diff = values[i] - noDataValue;
+      noData[i] = static_cast< quint8 >( ( values[i] != values[i] ) | ( ( diff > -epsilon ) & ( diff <= epsilon ) ) );
+    }
+  }
+  else if ( mNoDataBitmap )
+  {
+    // the bitmap is stored by rows, unpack it row segment by row segment
+    const unsigned char *bitmap = reinterpret_cast< const unsigned char * >( mNoDataBitmap );
+    qgssize position = index;
+    qgssize done = 0;
+    while ( done < count )
+    {
+      const qgssize row = position / mWidth;
+      const qgssize firstColumn = position % mWidth;
+      const qgssize segment = std::min( count - done, static_cast< qgssize >( mWidth ) - firstColumn );
+      const unsigned char *bitmapRow = bitmap + row * mNoDataBitmapWidth;
+      for ( qgssize i = 0; i < segment; ++i )
+      {
+        const qgssize column = firstColumn + i;
+        noData[done + i] = ( bitmapRow[column / 8] >> ( 7 - column % 8 ) ) & 1;
+      }
+      done += segment;
+      position += segment;
+    }
+  }
+  else
+  {
+    memset( noData, 0, count );
+  }
+
+  return true;
+}
+
 char *QgsRasterBlock::bits( qgssize index )
 {
   // Not testing type to avoid too much overhead because this method is called per pixel
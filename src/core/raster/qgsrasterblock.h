@@ -239,6 +239,23 @@ class CORE_EXPORT QgsRasterBlock
      */
     inline double valueAndNoData( qgssize index, bool &isNoData ) const SIP_SKIP;
 
+    /**
+     * Reads \a count values starting at the data matrix \a index into \a values, if type of block is numeric.
+     *
+     * If \a noData is not NULLPTR, it is filled with 1 for the pixels representing a nodata value and 0 for
+     * the other ones. Unlike valueAndNoData(), the data type is only resolved once for the whole range, so that
+     * the conversion and the nodata test run as tight loops which can be vectorized by the compiler.
+     *
+     * \a values and \a noData must be allocated for at least \a count items.
+     *
+     * \returns FALSE if the block type is not numeric or if the range is outside the block
+     *
+     * \note Not available in Python bindings
+     * \see valueAndNoData()
+     * \since QGIS 3.34
+     */
+    bool readValues( qgssize index, qgssize count, double *values, quint8 *noData = nullptr ) const SIP_SKIP;
+
     /**
      * Gives direct access to the raster block data.
      * The data type of the block must be Qgis::DataType::Byte otherwise it returns NULLPTR.
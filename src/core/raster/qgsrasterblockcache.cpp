@@ -0,0 +1,84 @@
+/***************************************************************************
+                         qgsrasterblockcache.cpp
+                         -----------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrasterblockcache.h"
+#include "qgsrectangle.h"
+
+#include <algorithm>
+
+QCache<QString, QByteArray> QgsRasterBlockCache::sBlockCache( 256 * 1024 * 1024 );
+QMutex QgsRasterBlockCache::sBlockCacheMutex;
+
+void QgsRasterBlockCache::insertBlock( const QString &source, int bandNo, const QgsRectangle &extent, int width, int height, const QByteArray &data )
+{
+  const QString blockKey = key( source, bandNo, extent, width, height );
+  const QMutexLocker locker( &sBlockCacheMutex );
+  // large blocks would evict most of the other blocks
+  if ( data.size() > sBlockCache.maxCost() / 4 )
+    return;
+  sBlockCache.insert( blockKey, new QByteArray( data ), std::max( 1, data.size() ) );
+}
+
+bool QgsRasterBlockCache::block( const QString &source, int bandNo, const QgsRectangle &extent, int width, int height, QByteArray &data )
+{
+  const QString blockKey = key( source, bandNo, extent, width, height );
+  const QMutexLocker locker( &sBlockCacheMutex );
+  if ( const QByteArray *cached = sBlockCache.object( blockKey ) )
+  {
+    // implicitly shared, the data is not copied
+    data = *cached;
+    return true;
+  }
+  return false;
+}
+
+void QgsRasterBlockCache::invalidate( const QString &sourcePrefix )
+{
+  const QMutexLocker locker( &sBlockCacheMutex );
+  const QList< QString > keys = sBlockCache.keys();
+  for ( const QString &blockKey : keys )
+  {
+    if ( blockKey.startsWith( sourcePrefix ) )
+      sBlockCache.remove( blockKey );
+  }
+}
+
+int QgsRasterBlockCache::totalCost()
+{
+  const QMutexLocker locker( &sBlockCacheMutex );
+  return sBlockCache.totalCost();
+}
+
+int QgsRasterBlockCache::maxCost()
+{
+  const QMutexLocker locker( &sBlockCacheMutex );
+  return sBlockCache.maxCost();
+}
+
+void QgsRasterBlockCache::setMaxCost( int bytes )
+{
+  const QMutexLocker locker( &sBlockCacheMutex );
+  sBlockCache.setMaxCost( bytes );
+}
+
+QString QgsRasterBlockCache::key( const QString &source, int bandNo, const QgsRectangle &extent, int width, int height )
+{
+  // the extent is kept at full precision, blocks of slightly different extents are different blocks
+  return source + '\n' + QString::number( bandNo ) + '\n'
+         + QString::number( extent.xMinimum(), 'g', 17 ) + ',' + QString::number( extent.yMinimum(), 'g', 17 ) + ','
+         + QString::number( extent.xMaximum(), 'g', 17 ) + ',' + QString::number( extent.yMaximum(), 'g', 17 ) + '\n'
+         + QString::number( width ) + 'x' + QString::number( height );
+}
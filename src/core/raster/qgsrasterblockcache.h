@@ -0,0 +1,84 @@
+/***************************************************************************
+                         qgsrasterblockcache.h
+                         ---------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSRASTERBLOCKCACHE_H
+#define QGSRASTERBLOCKCACHE_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QString>
+
+class QgsRectangle;
+
+#define SIP_NO_FILE
+
+/**
+ * \ingroup core
+ * \brief Process wide cache of decoded raster data, shared by all the layers and threads.
+ *
+ * Providers store the data read for a band, an extent and a size, so layers and
+ * pipes over the same dataset, and repeated renders of the same area, avoid
+ * reading and decoding the same blocks again. The least recently used data is
+ * evicted once the total size of the cached data exceeds maxCost().
+ *
+ * The \a source passed to the methods identifies the data source, and must change
+ * when the values read from it change (e.g. include the modification time of the
+ * file and the resampling settings of the provider).
+ *
+ * The class is thread safe (its methods can be called from any thread).
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.34
+ */
+class CORE_EXPORT QgsRasterBlockCache
+{
+  public:
+
+    //! Adds the \a data read from \a source for band \a bandNo, \a extent, \a width and \a height to the cache
+    static void insertBlock( const QString &source, int bandNo, const QgsRectangle &extent, int width, int height, const QByteArray &data );
+
+    /**
+     * Tries to retrieve the data read from \a source for band \a bandNo, \a extent, \a width and \a height.
+     * \returns TRUE if the data was in the cache
+     */
+    static bool block( const QString &source, int bandNo, const QgsRectangle &extent, int width, int height, QByteArray &data );
+
+    //! Removes all the data of the sources starting with \a sourcePrefix from the cache
+    static void invalidate( const QString &sourcePrefix );
+
+    //! Returns the size in bytes of the data stored in the cache
+    static int totalCost();
+
+    //! Returns the maximum size in bytes of the data stored in the cache
+    static int maxCost();
+
+    //! Sets the maximum size in bytes of the data stored in the cache, evicting data if needed
+    static void setMaxCost( int bytes );
+
+  private:
+
+    static QString key( const QString &source, int bandNo, const QgsRectangle &extent, int width, int height );
+
+    //! in-memory cache
+    static QCache<QString, QByteArray> sBlockCache;
+    //! mutex to protect the in-memory cache
+    static QMutex sBlockCacheMutex;
+};
+
+#endif // QGSRASTERBLOCKCACHE_H
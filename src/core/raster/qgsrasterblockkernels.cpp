@@ -0,0 +1,116 @@
+/***************************************************************************
+                         qgsrasterblockkernels.cpp
+                         -------------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrasterblockkernels.h"
+#include "qgsrasterblock.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+bool QgsRasterBlockKernels::minimumMaximum( const QgsRasterBlock &block, double &minimum, double &maximum )
+{
+  const qgssize count = static_cast< qgssize >( block.width() ) * block.height();
+  std::vector<double> values( std::min( count, SPAN_SIZE ) );
+  std::vector<quint8> noData( values.size() );
+
+  double spanMinimum = std::numeric_limits<double>::max();
+  double spanMaximum = std::numeric_limits<double>::lowest();
+  bool found = false;
+  for ( qgssize start = 0; start < count; start += SPAN_SIZE )
+  {
+    const qgssize size = std::min( count - start, SPAN_SIZE );
+    if ( !block.readValues( start, size, values.data(), noData.data() ) )
+      return false;
+
+    const double *v = values.data();
+    const quint8 *n = noData.data();
+    bool spanFound = false;
+    for ( qgssize i = 0; i < size; ++i )
+    {
+      // v - v is 0 for finite values and NaN for infinite and NaN values
+      const bool valid = !n[i] & ( v[i] - v[i] == 0.0 );
+      spanMinimum = valid && v[i] < spanMinimum ? v[i] : spanMinimum;
+      spanMaximum = valid && v[i] > spanMaximum ? v[i] : spanMaximum;
+      spanFound |= valid;
+    }
+    found |= spanFound;
+  }
+
+  if ( !found )
+    return false;
+
+  minimum = spanMinimum;
+  maximum = spanMaximum;
+  return true;
+}
+
+void QgsRasterBlockKernels::maskOutsideRange( const double *values, qgssize count, double minimum, double maximum, quint8 *noData )
+{
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    // written as !( v >= min && v <= max ) so that NaN values are masked
+    noData[i] |= static_cast< quint8 >( !( ( values[i] >= minimum ) & ( values[i] <= maximum ) ) );
+  }
+}
+
+void QgsRasterBlockKernels::linearStretch( const double *values, qgssize count, double minimum, double maximum, quint8 *output )
+{
+  const double range = maximum - minimum;
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    // same operation order as QgsLinearMinMaxEnhancement, clamped before the truncation
+    const double stretched = ( values[i] - minimum ) / range * 255.0;
+    const double clamped = std::min( std::max( stretched, 0.0 ), 255.0 );
+    output[i] = static_cast< quint8 >( clamped );
+  }
+}
+
+void QgsRasterBlockKernels::lookupColors( const quint8 *indexes, const quint8 *noData, qgssize count, const std::array<QRgb, 256> &table, QRgb noDataColor, QRgb *output )
+{
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    output[i] = noData[i] ? noDataColor : table[indexes[i]];
+  }
+}
+
+void QgsRasterBlockKernels::packRgb( const quint8 *red, const quint8 *green, const quint8 *blue, const quint8 *noData, qgssize count, QRgb noDataColor, QRgb *output )
+{
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    const QRgb color = 0xff000000u | ( static_cast< QRgb >( red[i] ) << 16 ) | ( static_cast< QRgb >( green[i] ) << 8 ) | blue[i];
+    output[i] = noData[i] ? noDataColor : color;
+  }
+}
+
+std::array<QRgb, 256> QgsRasterBlockKernels::grayTable( double opacity, bool invert )
+{
+  std::array<QRgb, 256> table;
+  const bool opaque = qgsDoubleNear( opacity, 1.0 );
+  for ( int level = 0; level < 256; ++level )
+  {
+    const int gray = invert ? 255 - level : level;
+    if ( opaque )
+    {
+      table[level] = qRgba( gray, gray, gray, 255 );
+    }
+    else
+    {
+      table[level] = qRgba( static_cast< int >( opacity * gray ), static_cast< int >( opacity * gray ), static_cast< int >( opacity * gray ), static_cast< int >( opacity * 255 ) );
+    }
+  }
+  return table;
+}
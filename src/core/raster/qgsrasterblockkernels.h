@@ -0,0 +1,96 @@
+/***************************************************************************
+                         qgsrasterblockkernels.h
+                         -----------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSRASTERBLOCKKERNELS_H
+#define QGSRASTERBLOCKKERNELS_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgis.h"
+
+#include <QRgb>
+#include <array>
+
+class QgsRasterBlock;
+
+#define SIP_NO_FILE
+
+/**
+ * \ingroup core
+ * \brief Whole block kernels used by the raster renderers.
+ *
+ * The kernels work on spans of pixels read with QgsRasterBlock::readValues(), so the
+ * raster data type is dispatched once per span rather than once per pixel. They are
+ * written as branch free loops over contiguous arrays, which lets the compiler
+ * vectorize them with the SIMD instructions of the target architecture.
+ *
+ * No data pixels are described by a mask holding 1 for no data and 0 for valid pixels.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.34
+ */
+class CORE_EXPORT QgsRasterBlockKernels
+{
+  public:
+
+    /**
+     * Number of pixels processed at once, small enough for the working
+     * buffers of a span to stay in the CPU cache.
+     */
+    static constexpr qgssize SPAN_SIZE = 4096;
+
+    /**
+     * Computes the \a minimum and \a maximum of the finite values of \a block,
+     * ignoring no data pixels.
+     *
+     * \returns FALSE if the block is not numeric or has no finite value
+     */
+    static bool minimumMaximum( const QgsRasterBlock &block, double &minimum, double &maximum );
+
+    /**
+     * Marks as no data in \a noData the \a count \a values which are not within
+     * the [\a minimum, \a maximum] range. NaN values are always marked.
+     */
+    static void maskOutsideRange( const double *values, qgssize count, double minimum, double maximum, quint8 *noData );
+
+    /**
+     * Linearly stretches \a count \a values from the [\a minimum, \a maximum] range
+     * to [0, 255], truncating the results and clamping them to the output range.
+     *
+     * This is the kernel of QgsLinearMinMaxEnhancement::enhance(). Values in \a output
+     * are undefined for NaN input values, which must be masked.
+     */
+    static void linearStretch( const double *values, qgssize count, double minimum, double maximum, quint8 *output );
+
+    /**
+     * Maps \a count 8 bit \a indexes to colors through the 256 colors \a table.
+     * Pixels flagged in \a noData are set to \a noDataColor.
+     */
+    static void lookupColors( const quint8 *indexes, const quint8 *noData, qgssize count, const std::array<QRgb, 256> &table, QRgb noDataColor, QRgb *output );
+
+    /**
+     * Packs \a count opaque colors from the 8 bit \a red, \a green and \a blue channels.
+     * Pixels flagged in \a noData are set to \a noDataColor.
+     */
+    static void packRgb( const quint8 *red, const quint8 *green, const quint8 *blue, const quint8 *noData, qgssize count, QRgb noDataColor, QRgb *output );
+
+    /**
+     * Returns the premultiplied gray colors table for 8 bit gray levels, with
+     * the given \a opacity. When \a invert is TRUE, levels go from white to black.
+     */
+    static std::array<QRgb, 256> grayTable( double opacity, bool invert );
+};
+
+#endif // QGSRASTERBLOCKKERNELS_H
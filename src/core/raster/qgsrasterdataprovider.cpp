@@ -418,6 +418,10 @@ void QgsRasterDataProvider::setUserNoDataValue( int bandNo, const QgsRasterRange
     {
       return histogram.bandNumber == bandNo;
     } ), mHistograms.end() );
+    mQuantileSketches.erase( std::remove_if( mQuantileSketches.begin(), mQuantileSketches.end(), [bandNo]( const QPair< QgsRasterBandStats, QgsRasterQuantileSketch > &sketch )
+    {
+      return sketch.first.bandNumber == bandNo;
+    } ), mQuantileSketches.end() );
     mUserNoDataValue[bandNo - 1] = noData;
   }
 }
@@ -20,15 +20,24 @@
 #include "qgsrasterdrawer.h"
 #include "qgsrasterinterface.h"
 #include "qgsrasteriterator.h"
+#include "qgsrasterpipe.h"
 #include "qgsrasterviewport.h"
 #include "qgsmaptopixel.h"
 #include "qgsrendercontext.h"
 #include <QImage>
+#include <QMutex>
 #include <QPainter>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
 #ifndef QT_NO_PRINTER
 #include <QPrinter>
 #endif
 
+#include <atomic>
+
 QgsRasterDrawer::QgsRasterDrawer( QgsRasterIterator *iterator, double dpiTarget )
   : mIterator( iterator )
   , mDpiTarget( dpiTarget )
@@ -67,6 +76,12 @@ void QgsRasterDrawer::draw( QPainter *p, QgsRasterViewPort *viewPort, const QgsM
     mDpiScaleFactor = mDpiTarget / p->device()->logicalDpiX();
   }
 
+  if ( mConcurrentPipe && mMaximumThreads > 1 )
+  {
+    drawConcurrently( p, viewPort, qgsMapToPixel, feedback );
+    return;
+  }
+
   // last pipe filter has only 1 band
   const int bandNumber = 1;
   mIterator->startRasterRead( bandNumber, viewPort->mWidth * p->device()->devicePixelRatio(), viewPort->mHeight * p->device()->devicePixelRatio(), viewPort->mDrawnExtent, feedback );
@@ -92,52 +107,309 @@ void QgsRasterDrawer::draw( QPainter *p, QgsRasterViewPort *viewPort, const QgsM
       continue;
     }
 
-    QImage img = block->image();
+    drawTileImage( p, viewPort, block->image(), topLeftCol, topLeftRow, qgsMapToPixel, feedback );
+
+    // OK this does not matter much anyway as the tile size quite big so most of the time
+    // there would be just one tile for the whole display area, but it won't hurt...
+    if ( feedback && feedback->isCanceled() )
+      break;
+  }
+}
 
+void QgsRasterDrawer::drawTileImage( QPainter *p, QgsRasterViewPort *viewPort, QImage img, int topLeftCol, int topLeftRow, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback )
+{
 #ifndef QT_NO_PRINTER
-    // Because of bug in Acrobat Reader we must use "white" transparent color instead
-    // of "black" for PDF. See #9101.
-    QPrinter *printer = dynamic_cast<QPrinter *>( p->device() );
-    if ( printer && printer->outputFormat() == QPrinter::PdfFormat )
-    {
-      QgsDebugMsgLevel( QStringLiteral( "PdfFormat" ), 4 );
+  // Because of bug in Acrobat Reader we must use "white" transparent color instead
+  // of "black" for PDF. See #9101.
+  QPrinter *printer = dynamic_cast<QPrinter *>( p->device() );
+  if ( printer && printer->outputFormat() == QPrinter::PdfFormat )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "PdfFormat" ), 4 );
 
-      img = img.convertToFormat( QImage::Format_ARGB32 );
-      const QRgb transparentBlack = qRgba( 0, 0, 0, 0 );
-      const QRgb transparentWhite = qRgba( 255, 255, 255, 0 );
-      for ( int x = 0; x < img.width(); x++ )
+    img = img.convertToFormat( QImage::Format_ARGB32 );
+    const QRgb transparentBlack = qRgba( 0, 0, 0, 0 );
+    const QRgb transparentWhite = qRgba( 255, 255, 255, 0 );
+    for ( int x = 0; x < img.width(); x++ )
+    {
+      for ( int y = 0; y < img.height(); y++ )
       {
-        for ( int y = 0; y < img.height(); y++ )
+        if ( img.pixel( x, y ) == transparentBlack )
         {
-          if ( img.pixel( x, y ) == transparentBlack )
-          {
-            img.setPixel( x, y, transparentWhite );
-          }
+          img.setPixel( x, y, transparentWhite );
         }
       }
     }
+  }
 #endif
 
-    if ( feedback && feedback->renderPartialOutput() )
+  if ( feedback && feedback->renderPartialOutput() )
+  {
+    // there could have been partial preview written before
+    // so overwrite anything with the resulting image.
+    // (we are guaranteed to have a temporary image for this layer, see QgsMapRendererJob::needTemporaryImage)
+    p->setCompositionMode( QPainter::CompositionMode_Source );
+  }
+
+  drawImage( p, viewPort, img, topLeftCol, topLeftRow, qgsMapToPixel );
+
+  if ( feedback && feedback->renderPartialOutput() )
+  {
+    // go back to the default composition mode
+    p->setCompositionMode( QPainter::CompositionMode_SourceOver );
+  }
+}
+
+///@cond PRIVATE
+
+/**
+ * Tiles shared by the threads of a concurrent raster draw.
+ */
+class QgsRasterDrawerTiles
+{
+  public:
+
+    struct Tile
     {
-      // there could have been partial preview written before
-      // so overwrite anything with the resulting image.
-      // (we are guaranteed to have a temporary image for this layer, see QgsMapRendererJob::needTemporaryImage)
-      p->setCompositionMode( QPainter::CompositionMode_Source );
+      QgsRectangle blockExtent;
+      int blockColumns = 0;
+      int blockRows = 0;
+      QRect tileRect; // area of the tile within the block
+      int topLeftColumn = 0;
+      int topLeftRow = 0;
+      QImage image;
+    };
+
+    explicit QgsRasterDrawerTiles( int maxReadyTiles )
+      : mMaxReadyTiles( maxReadyTiles )
+    {}
+
+    std::vector<Tile> tiles;
+
+    //! Returns the index of the next tile to render, or -1 once all tiles have been claimed
+    int claimTile()
+    {
+      const int index = mNextTile.fetch_add( 1 );
+      return index < static_cast< int >( tiles.size() ) ? index : -1;
     }
 
-    drawImage( p, viewPort, img, topLeftCol, topLeftRow, qgsMapToPixel );
+    //! Renders the tile at \a index with the pipe ending at \a input
+    void renderTile( int index, QgsRasterInterface *input, QgsRasterBlockFeedback *feedback )
+    {
+      Tile &tile = tiles[ static_cast< std::size_t >( index )];
+      std::unique_ptr< QgsRasterBlock > block( input->block( 1, tile.blockExtent, tile.blockColumns, tile.blockRows, feedback ) );
+      if ( !block )
+      {
+        QgsDebugError( QStringLiteral( "Cannot get block" ) );
+        return;
+      }
+
+      const QImage image = block->image();
+      tile.image = tile.tileRect == image.rect() ? image : image.copy( tile.tileRect );
+    }
 
-    if ( feedback && feedback->renderPartialOutput() )
+    //! Called by the worker threads when a tile is rendered, blocks while too many tiles wait to be painted
+    void addReadyTile( int index, const QgsFeedback *feedback )
     {
-      // go back to the default composition mode
-      p->setCompositionMode( QPainter::CompositionMode_SourceOver );
+      QMutexLocker locker( &mMutex );
+      while ( mReadyTiles.size() >= mMaxReadyTiles && !feedback->isCanceled() && !mStopped )
+        mSpaceAvailable.wait( &mMutex, 100 );
+      mReadyTiles.append( index );
+      mTileReady.wakeAll();
     }
 
-    // OK this does not matter much anyway as the tile size quite big so most of the time
-    // there would be just one tile for the whole display area, but it won't hurt...
-    if ( feedback && feedback->isCanceled() )
+    //! Returns the rendered tiles waiting to be painted, waiting for one when \a wait is TRUE and workers are running
+    QList<int> takeReadyTiles( bool wait )
+    {
+      QMutexLocker locker( &mMutex );
+      while ( wait && mReadyTiles.isEmpty() && mRunningWorkers > 0 )
+        mTileReady.wait( &mMutex );
+      const QList<int> ready = mReadyTiles;
+      mReadyTiles.clear();
+      mSpaceAvailable.wakeAll();
+      return ready;
+    }
+
+    void workerStarted()
+    {
+      QMutexLocker locker( &mMutex );
+      mRunningWorkers++;
+    }
+
+    void workerFinished()
+    {
+      QMutexLocker locker( &mMutex );
+      mRunningWorkers--;
+      mTileReady.wakeAll();
+    }
+
+    bool hasRunningWorkers()
+    {
+      QMutexLocker locker( &mMutex );
+      return mRunningWorkers > 0;
+    }
+
+    //! Releases the workers blocked on painting, once the draw is canceled
+    void stop()
+    {
+      QMutexLocker locker( &mMutex );
+      mStopped = true;
+      mSpaceAvailable.wakeAll();
+    }
+
+  private:
+
+    std::atomic<int> mNextTile { 0 };
+    int mMaxReadyTiles = 1;
+    bool mStopped = false;
+
+    QMutex mMutex;
+    QWaitCondition mTileReady;
+    QWaitCondition mSpaceAvailable;
+    QList<int> mReadyTiles;
+    int mRunningWorkers = 0;
+};
+
+/**
+ * Renders tiles with its own copy of the pipe until all tiles are claimed.
+ */
+class QgsRasterDrawerWorker : public QRunnable
+{
+  public:
+
+    QgsRasterDrawerWorker( QgsRasterDrawerTiles *tiles, QgsRasterBlockFeedback *feedback )
+      : mTiles( tiles )
+      , mFeedback( feedback )
+    {}
+
+    //! Hands its copy of the pipe to the worker, once the worker got a thread
+    void setPipe( std::unique_ptr< QgsRasterPipe > pipe )
+    {
+      mPipe = std::move( pipe );
+      mPipeSet.release();
+    }
+
+    void run() override
+    {
+      mPipeSet.acquire();
+      // the copy of the pipe was created by the drawing thread and detached from it
+      mPipe->moveToThread( QThread::currentThread() );
+      int index = -1;
+      while ( !mFeedback->isCanceled() && ( index = mTiles->claimTile() ) >= 0 )
+      {
+        mTiles->renderTile( index, mPipe->last(), mFeedback );
+        mTiles->addReadyTile( index, mFeedback );
+      }
+      mTiles->workerFinished();
+    }
+
+  private:
+
+    QgsRasterDrawerTiles *mTiles = nullptr;
+    QgsRasterBlockFeedback *mFeedback = nullptr;
+    std::unique_ptr< QgsRasterPipe > mPipe;
+    QSemaphore mPipeSet;
+};
+
+///@endcond
+
+void QgsRasterDrawer::drawConcurrently( QPainter *p, QgsRasterViewPort *viewPort, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback )
+{
+  // last pipe filter has only 1 band
+  const int bandNumber = 1;
+  mIterator->startRasterRead( bandNumber, viewPort->mWidth * p->device()->devicePixelRatio(), viewPort->mHeight * p->device()->devicePixelRatio(), viewPort->mDrawnExtent, feedback );
+
+  QgsRasterDrawerTiles tiles( mMaximumThreads );
+  QgsRasterDrawerTiles::Tile tile;
+  int tileColumns = 0;
+  int tileRows = 0;
+  int tileTopLeftColumn = 0;
+  int tileTopLeftRow = 0;
+  while ( mIterator->next( bandNumber, tile.blockColumns, tile.blockRows, tile.topLeftColumn, tile.topLeftRow, tile.blockExtent,
+                           tileColumns, tileRows, tileTopLeftColumn, tileTopLeftRow ) )
+  {
+    tile.tileRect = QRect( tileTopLeftColumn - tile.topLeftColumn, tileTopLeftRow - tile.topLeftRow, tileColumns, tileRows );
+    tile.topLeftColumn = tileTopLeftColumn;
+    tile.topLeftRow = tileTopLeftRow;
+    tiles.tiles.push_back( tile );
+  }
+
+  // worker threads are only started when the pool has an idle thread, so that
+  // a draw running itself on a pool thread can never wait for queued workers,
+  // and the pipe is only copied for the workers which got a thread
+  std::vector< std::unique_ptr< QgsRasterBlockFeedback > > workerFeedbacks;
+  // the calling thread is one of the threads
+  const int maxWorkers = std::min( static_cast< int >( tiles.tiles.size() ), mMaximumThreads ) - 1;
+  for ( int i = 0; i < maxWorkers; ++i )
+  {
+    std::unique_ptr< QgsRasterBlockFeedback > workerFeedback = std::make_unique< QgsRasterBlockFeedback >();
+    if ( feedback )
+    {
+      workerFeedback->setRenderContext( feedback->renderContext() );
+      workerFeedback->setPreviewOnly( feedback->isPreviewOnly() );
+      QObject::connect( feedback, &QgsFeedback::canceled, workerFeedback.get(), &QgsFeedback::cancel, Qt::DirectConnection );
+    }
+
+    tiles.workerStarted();
+    QgsRasterDrawerWorker *worker = new QgsRasterDrawerWorker( &tiles, workerFeedback.get() );
+    if ( !QThreadPool::globalInstance()->tryStart( worker ) )
+    {
+      delete worker;
+      tiles.workerFinished();
       break;
+    }
+    // the worker waits for its pipe, nothing else uses the original pipe while it is copied. The
+    // copy is detached from this thread, so that the worker can pull it to its own thread
+    std::unique_ptr< QgsRasterPipe > workerPipe = std::make_unique< QgsRasterPipe >( *mConcurrentPipe );
+    workerPipe->moveToThread( nullptr );
+    worker->setPipe( std::move( workerPipe ) );
+    workerFeedbacks.push_back( std::move( workerFeedback ) );
+  }
+
+  const auto paintReadyTiles = [&]( bool wait )
+  {
+    const QList<int> ready = tiles.takeReadyTiles( wait );
+    for ( const int index : ready )
+    {
+      QgsRasterDrawerTiles::Tile &readyTile = tiles.tiles[ static_cast< std::size_t >( index ) ];
+      if ( !readyTile.image.isNull() )
+        drawTileImage( p, viewPort, readyTile.image, readyTile.topLeftColumn, readyTile.topLeftRow, qgsMapToPixel, feedback );
+      readyTile.image = QImage();
+    }
+  };
+
+  // the calling thread renders tiles too, and paints the tiles rendered by the workers in between
+  int index = -1;
+  while ( !( feedback && feedback->isCanceled() ) && ( index = tiles.claimTile() ) >= 0 )
+  {
+    tiles.renderTile( index, mConcurrentPipe->last(), feedback );
+    QgsRasterDrawerTiles::Tile &ownTile = tiles.tiles[ static_cast< std::size_t >( index ) ];
+    if ( !ownTile.image.isNull() )
+      drawTileImage( p, viewPort, ownTile.image, ownTile.topLeftColumn, ownTile.topLeftRow, qgsMapToPixel, feedback );
+    ownTile.image = QImage();
+
+    paintReadyTiles( false );
+  }
+
+  while ( tiles.hasRunningWorkers() )
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      // workers were canceled along with the feedback, do not let them wait for painting
+      tiles.stop();
+    }
+    paintReadyTiles( true );
+  }
+  if ( !( feedback && feedback->isCanceled() ) )
+    paintReadyTiles( false );
+
+  for ( const std::unique_ptr< QgsRasterBlockFeedback > &workerFeedback : workerFeedbacks )
+  {
+    const QStringList errors = workerFeedback->errors();
+    for ( const QString &error : errors )
+    {
+      if ( feedback )
+        feedback->appendError( error );
+    }
   }
 }
 
@@ -20,6 +20,7 @@
 
 #include "qgis_core.h"
 #include "qgis_sip.h"
+#include <QList>
 #include <QMap>
 
 class QPainter;
@@ -29,6 +30,7 @@ class QgsRenderContext;
 struct QgsRasterViewPort;
 class QgsRasterBlockFeedback;
 class QgsRasterIterator;
+class QgsRasterPipe;
 
 /**
  * \ingroup core
@@ -70,6 +72,24 @@ class CORE_EXPORT QgsRasterDrawer
      */
     void draw( QgsRenderContext &context, QgsRasterViewPort *viewPort, QgsRasterBlockFeedback *feedback = nullptr );
 
+    /**
+     * Enables the concurrent rendering of the iterator tiles on up to \a maximumThreads
+     * threads, including the calling thread.
+     *
+     * \a pipe must be the pipe whose last interface feeds the iterator. As pipe
+     * interfaces cannot be used by several threads at once, each worker thread
+     * started on the global thread pool renders its tiles with its own copy of
+     * \a pipe, which is only made once the worker got a thread. The calling
+     * thread renders tiles with \a pipe and paints the tiles as soon as they are
+     * ready. The number of tiles in flight is bounded by \a maximumThreads.
+     *
+     * Ownership of \a pipe is not transferred.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.34
+     */
+    void setConcurrentPipe( const QgsRasterPipe *pipe, int maximumThreads ) SIP_SKIP { mConcurrentPipe = pipe; mMaximumThreads = maximumThreads; }
+
   protected:
 
     /**
@@ -85,7 +105,13 @@ class CORE_EXPORT QgsRasterDrawer
     void drawImage( QPainter *p, QgsRasterViewPort *viewPort, const QImage &img, int topLeftCol, int topLeftRow, const QgsMapToPixel *mapToPixel = nullptr ) const SIP_SKIP;
 
   private:
+
+    void drawTileImage( QPainter *p, QgsRasterViewPort *viewPort, QImage img, int topLeftCol, int topLeftRow, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback );
+    void drawConcurrently( QPainter *p, QgsRasterViewPort *viewPort, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback );
+
     QgsRasterIterator *mIterator = nullptr;
+    const QgsRasterPipe *mConcurrentPipe = nullptr;
+    int mMaximumThreads = 1;
     double mDpiTarget = -1.0;
     double mDpiScaleFactor = 1.0;
 };
@@ -21,11 +21,17 @@
 #include <QByteArray>
 #include <QTime>
 #include <QStringList>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <deque>
+#include <memory>
 
 #include "qgslogger.h"
 #include "qgsrasterbandstats.h"
+#include "qgsrasterblockkernels.h"
 #include "qgsrasterhistogram.h"
 #include "qgsrasterinterface.h"
+#include "qgsrasterquantilesketch.h"
 #include "qgsrectangle.h"
 
 QgsRasterInterface::QgsRasterInterface( QgsRasterInterface *input )
@@ -33,6 +39,244 @@ QgsRasterInterface::QgsRasterInterface( QgsRasterInterface *input )
 {
 }
 
+///@cond PRIVATE
+
+/**
+ * Statistics of a part of a raster collected in a single pass, which can be merged
+ * with the statistics of the other parts.
+ */
+class QgsRasterStatisticsAccumulator
+{
+  public:
+
+    enum class Mode
+    {
+      MinimumMaximum, //!< Only the minimum and maximum, computed with the block kernels
+      All, //!< All statistics
+      AllWithSketch, //!< All statistics and a quantile sketch
+    };
+
+    explicit QgsRasterStatisticsAccumulator( Mode mode )
+      : mode( mode )
+    {}
+
+    void addBlock( const QgsRasterBlock &block )
+    {
+      if ( mode == Mode::MinimumMaximum )
+      {
+        double blockMinimum = 0;
+        double blockMaximum = 0;
+        if ( QgsRasterBlockKernels::minimumMaximum( block, blockMinimum, blockMaximum ) )
+          addMinimumMaximum( blockMinimum, blockMaximum );
+        return;
+      }
+
+      const qgssize cellCount = static_cast< qgssize >( block.width() ) * block.height();
+      std::vector< double > values( std::min( cellCount, QgsRasterBlockKernels::SPAN_SIZE ) );
+      std::vector< quint8 > noData( values.size() );
+      for ( qgssize start = 0; start < cellCount; start += QgsRasterBlockKernels::SPAN_SIZE )
+      {
+        const qgssize size = std::min( cellCount - start, QgsRasterBlockKernels::SPAN_SIZE );
+        if ( !block.readValues( start, size, values.data(), noData.data() ) )
+        {
+          bool isNoData = false;
+          for ( qgssize i = start; i < start + size; ++i )
+          {
+            const double value = block.valueAndNoData( i, isNoData );
+            if ( !isNoData )
+              addValue( value );
+          }
+          continue;
+        }
+
+        for ( qgssize i = 0; i < size; ++i )
+        {
+          if ( !noData[i] )
+            addValue( values[i] );
+        }
+      }
+    }
+
+    void addValue( double value )
+    {
+      sum += value;
+      count++;
+
+      if ( !std::isfinite( value ) ) return; // inf
+
+      addMinimumMaximum( value, value );
+
+      // Single pass stdev
+      const double delta = value - mean;
+      mean += delta / count;
+      sumOfSquares += delta * ( value - mean );
+
+      if ( mode == Mode::AllWithSketch )
+        sketch.add( value );
+    }
+
+    void addMinimumMaximum( double partMinimum, double partMaximum )
+    {
+      if ( !found )
+      {
+        found = true;
+        minimum = partMinimum;
+        maximum = partMaximum;
+      }
+      else
+      {
+        minimum = std::min( minimum, partMinimum );
+        maximum = std::max( maximum, partMaximum );
+      }
+    }
+
+    void merge( const QgsRasterStatisticsAccumulator &other )
+    {
+      if ( other.found )
+        addMinimumMaximum( other.minimum, other.maximum );
+      if ( mode == Mode::MinimumMaximum || other.count == 0 )
+        return;
+
+      // parallel variant of the single pass stdev (Chan et al.)
+      const qgssize total = count + other.count;
+      const double delta = other.mean - mean;
+      mean += delta * static_cast< double >( other.count ) / total;
+      sumOfSquares += other.sumOfSquares + delta * delta * static_cast< double >( count ) * other.count / total;
+      sum += other.sum;
+      count = total;
+
+      if ( mode == Mode::AllWithSketch )
+        sketch.merge( other.sketch );
+    }
+
+    void fillStatistics( QgsRasterBandStats &statistics ) const
+    {
+      if ( found )
+      {
+        statistics.minimumValue = minimum;
+        statistics.maximumValue = maximum;
+      }
+      statistics.range = statistics.maximumValue - statistics.minimumValue;
+      if ( mode == Mode::MinimumMaximum )
+        return;
+
+      statistics.sum = sum;
+      statistics.elementCount = count;
+      statistics.mean = sum / count;
+      statistics.sumOfSquares = sumOfSquares; // OK with single pass?
+
+      // stdDev may differ  from GDAL stats, because GDAL is using naive single pass
+      // algorithm which is more error prone (because of rounding errors)
+      // Divide result by sample size - 1 and get square root to get stdev
+      statistics.stdDev = std::sqrt( sumOfSquares / ( count - 1 ) );
+    }
+
+    Mode mode = Mode::All;
+    bool found = false;
+    double minimum = 0;
+    double maximum = 0;
+    qgssize count = 0;
+    double sum = 0;
+    double mean = 0;
+    double sumOfSquares = 0;
+    QgsRasterQuantileSketch sketch;
+};
+
+///@endcond
+
+/**
+ * Collects the statistics of the cells of \a extent read from \a interface at the \a width and \a height resolution.
+ *
+ * Blocks are read in order by the calling thread, as interfaces are not thread safe, and the
+ * statistics of large rasters are collected in parallel. The statistics of the blocks are merged
+ * in the order of the blocks, so the results do not depend on the threads.
+ *
+ * Returns FALSE if the collection was canceled.
+ */
+static bool collectStatistics( QgsRasterInterface *interface, int bandNo, const QgsRectangle &extent, int width, int height,
+                               QgsRasterBlockFeedback *feedback, QgsRasterStatisticsAccumulator &result )
+{
+  // the values of smaller rasters are collected by the calling thread
+  constexpr qgssize PARALLEL_MIN_CELLS = 4 * 1024 * 1024;
+
+  int myXBlockSize = interface->xBlockSize();
+  int myYBlockSize = interface->yBlockSize();
+  if ( myXBlockSize == 0 ) // should not happen, but happens
+  {
+    myXBlockSize = 500;
+  }
+  if ( myYBlockSize == 0 ) // should not happen, but happens
+  {
+    myYBlockSize = 500;
+  }
+
+  const int myNXBlocks = ( width + myXBlockSize - 1 ) / myXBlockSize;
+  const int myNYBlocks = ( height + myYBlockSize - 1 ) / myYBlockSize;
+
+  const double myXRes = extent.width() / width;
+  const double myYRes = extent.height() / height;
+
+  const bool parallel = result.mode != QgsRasterStatisticsAccumulator::Mode::MinimumMaximum
+                        && myNXBlocks * myNYBlocks > 1
+                        && static_cast< qgssize >( width ) * height >= PARALLEL_MIN_CELLS;
+  const int maxPendingBlocks = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() ) + 1;
+  std::deque< QFuture< QgsRasterStatisticsAccumulator > > pendingBlocks;
+  const QgsRasterStatisticsAccumulator::Mode mode = result.mode;
+
+  bool canceled = false;
+  for ( int myYBlock = 0; myYBlock < myNYBlocks && !canceled; myYBlock++ )
+  {
+    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
+    {
+      if ( feedback && feedback->isCanceled() )
+      {
+        canceled = true;
+        break;
+      }
+
+      QgsDebugMsgLevel( QStringLiteral( "myYBlock = %1 myXBlock = %2" ).arg( myYBlock ).arg( myXBlock ), 4 );
+      const int myBlockWidth = std::min( myXBlockSize, width - myXBlock * myXBlockSize );
+      const int myBlockHeight = std::min( myYBlockSize, height - myYBlock * myYBlockSize );
+
+      const double xmin = extent.xMinimum() + myXBlock * myXBlockSize * myXRes;
+      const double xmax = xmin + myBlockWidth * myXRes;
+      const double ymin = extent.yMaximum() - myYBlock * myYBlockSize * myYRes;
+      const double ymax = ymin - myBlockHeight * myYRes;
+
+      const QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
+
+      std::shared_ptr< QgsRasterBlock > blk( interface->block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback ) );
+      if ( !blk )
+        continue;
+
+      if ( !parallel )
+      {
+        result.addBlock( *blk );
+        continue;
+      }
+
+      if ( static_cast< int >( pendingBlocks.size() ) >= maxPendingBlocks )
+      {
+        result.merge( pendingBlocks.front().result() );
+        pendingBlocks.pop_front();
+      }
+      pendingBlocks.push_back( QtConcurrent::run( [blk, mode]
+      {
+        QgsRasterStatisticsAccumulator accumulator( mode );
+        accumulator.addBlock( *blk );
+        return accumulator;
+      } ) );
+    }
+  }
+
+  while ( !pendingBlocks.empty() )
+  {
+    result.merge( pendingBlocks.front().result() );
+    pendingBlocks.pop_front();
+  }
+  return !canceled;
+}
+
 void QgsRasterInterface::initStatistics( QgsRasterBandStats &statistics,
     int bandNo,
     int stats,
@@ -135,104 +379,24 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int bandNo,
     }
   }
 
-  const QgsRectangle myExtent = myRasterBandStats.extent;
-  const int myWidth = myRasterBandStats.width;
-  const int myHeight = myRasterBandStats.height;
-
-  //int myDataType = dataType( bandNo );
+  // minimum and maximum alone are computed with the block kernels, without the per pixel loop
+  const int minMaxStats = QgsRasterBandStats::Min | QgsRasterBandStats::Max | QgsRasterBandStats::Range;
+  const bool minMaxOnly = stats != QgsRasterBandStats::None && ( stats & ~minMaxStats ) == 0;
 
-  int myXBlockSize = xBlockSize();
-  int myYBlockSize = yBlockSize();
-  if ( myXBlockSize == 0 ) // should not happen, but happens
-  {
-    myXBlockSize = 500;
-  }
-  if ( myYBlockSize == 0 ) // should not happen, but happens
-  {
-    myYBlockSize = 500;
-  }
-
-  const int myNXBlocks = ( myWidth + myXBlockSize - 1 ) / myXBlockSize;
-  const int myNYBlocks = ( myHeight + myYBlockSize - 1 ) / myYBlockSize;
-
-  const double myXRes = myExtent.width() / myWidth;
-  const double myYRes = myExtent.height() / myHeight;
   // TODO: progress signals
+  QgsRasterStatisticsAccumulator accumulator( minMaxOnly ? QgsRasterStatisticsAccumulator::Mode::MinimumMaximum : QgsRasterStatisticsAccumulator::Mode::All );
+  if ( !collectStatistics( this, bandNo, myRasterBandStats.extent, myRasterBandStats.width, myRasterBandStats.height, feedback, accumulator ) )
+    return myRasterBandStats;
 
-  // used by single pass stdev
-  double myMean = 0;
-  double mySumOfSquares = 0;
+  accumulator.fillStatistics( myRasterBandStats );
 
-  bool myFirstIterationFlag = true;
-  bool isNoData = false;
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
+  if ( minMaxOnly )
   {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
-    {
-      if ( feedback && feedback->isCanceled() )
-        return myRasterBandStats;
-
-      QgsDebugMsgLevel( QStringLiteral( "myYBlock = %1 myXBlock = %2" ).arg( myYBlock ).arg( myXBlock ), 4 );
-      const int myBlockWidth = std::min( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      const int myBlockHeight = std::min( myYBlockSize, myHeight - myYBlock * myYBlockSize );
-
-      const double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      const double xmax = xmin + myBlockWidth * myXRes;
-      const double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      const double ymax = ymin - myBlockHeight * myYRes;
-
-      const QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
-
-      std::unique_ptr< QgsRasterBlock > blk( block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback ) );
-
-      // Collect the histogram counts.
-      for ( qgssize i = 0; i < ( static_cast< qgssize >( myBlockHeight ) ) * myBlockWidth; i++ )
-      {
-        const double myValue = blk->valueAndNoData( i, isNoData );
-        if ( isNoData )
-          continue; // NULL
-
-        myRasterBandStats.sum += myValue;
-        myRasterBandStats.elementCount++;
-
-        if ( !std::isfinite( myValue ) ) continue; // inf
-
-        if ( myFirstIterationFlag )
-        {
-          myFirstIterationFlag = false;
-          myRasterBandStats.minimumValue = myValue;
-          myRasterBandStats.maximumValue = myValue;
-        }
-        else
-        {
-          if ( myValue < myRasterBandStats.minimumValue )
-          {
-            myRasterBandStats.minimumValue = myValue;
-          }
-          if ( myValue > myRasterBandStats.maximumValue )
-          {
-            myRasterBandStats.maximumValue = myValue;
-          }
-        }
-
-        // Single pass stdev
-        const double myDelta = myValue - myMean;
-        myMean += myDelta / myRasterBandStats.elementCount;
-        mySumOfSquares += myDelta * ( myValue - myMean );
-      }
-    }
+    myRasterBandStats.statsGathered = minMaxStats;
+    mStatistics.append( myRasterBandStats );
+    return myRasterBandStats;
   }
 
-  myRasterBandStats.range = myRasterBandStats.maximumValue - myRasterBandStats.minimumValue;
-  myRasterBandStats.mean = myRasterBandStats.sum / myRasterBandStats.elementCount;
-
-  myRasterBandStats.sumOfSquares = mySumOfSquares; // OK with single pass?
-
-  // stdDev may differ  from GDAL stats, because GDAL is using naive single pass
-  // algorithm which is more error prone (because of rounding errors)
-  // Divide result by sample size - 1 and get square root to get stdev
-  myRasterBandStats.stdDev = std::sqrt( mySumOfSquares / ( myRasterBandStats.elementCount - 1 ) );
-
   QgsDebugMsgLevel( QStringLiteral( "************ STATS **************" ), 4 );
   QgsDebugMsgLevel( QStringLiteral( "MIN %1" ).arg( myRasterBandStats.minimumValue ), 4 );
   QgsDebugMsgLevel( QStringLiteral( "MAX %1" ).arg( myRasterBandStats.maximumValue ), 4 );
@@ -520,6 +684,36 @@ QgsRasterHistogram QgsRasterInterface::histogram( int bandNo,
   return myHistogram;
 }
 
+QgsRasterQuantileSketch QgsRasterInterface::quantileSketch( int bandNo, const QgsRectangle &extent, int sampleSize, QgsRasterBlockFeedback *feedback )
+{
+  QgsDebugMsgLevel( QStringLiteral( "theBandNo = %1 sampleSize = %2" ).arg( bandNo ).arg( sampleSize ), 4 );
+
+  QgsRasterBandStats sketchStatistics;
+  initStatistics( sketchStatistics, bandNo, QgsRasterBandStats::None, extent, sampleSize );
+
+  for ( const QPair< QgsRasterBandStats, QgsRasterQuantileSketch > &sketch : std::as_const( mQuantileSketches ) )
+  {
+    if ( sketch.first.contains( sketchStatistics ) )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Using cached quantile sketch." ), 4 );
+      return sketch.second;
+    }
+  }
+
+  QgsRasterStatisticsAccumulator accumulator( QgsRasterStatisticsAccumulator::Mode::AllWithSketch );
+  if ( !collectStatistics( this, bandNo, sketchStatistics.extent, sketchStatistics.width, sketchStatistics.height, feedback, accumulator ) )
+    return QgsRasterQuantileSketch();
+
+  // the statistics were collected in the same pass
+  QgsRasterBandStats myRasterBandStats = sketchStatistics;
+  accumulator.fillStatistics( myRasterBandStats );
+  myRasterBandStats.statsGathered = QgsRasterBandStats::All;
+  mStatistics.append( myRasterBandStats );
+
+  mQuantileSketches.append( qMakePair( sketchStatistics, accumulator.sketch ) );
+  return accumulator.sketch;
+}
+
 void QgsRasterInterface::cumulativeCut( int bandNo,
                                         double lowerCount, double upperCount,
                                         double &lowerValue, double &upperValue,
@@ -534,6 +728,20 @@ void QgsRasterInterface::cumulativeCut( int bandNo,
   lowerValue = std::numeric_limits<double>::quiet_NaN();
   upperValue = std::numeric_limits<double>::quiet_NaN();
 
+  // histograms of floating point values would need many bins to be precise, the
+  // values are estimated from a quantile sketch collected in a single pass instead
+  if ( mySrcDataType == Qgis::DataType::Float32 || mySrcDataType == Qgis::DataType::Float64 )
+  {
+    const QgsRasterQuantileSketch sketch = quantileSketch( bandNo, extent, sampleSize );
+    if ( sketch.count() == 0 )
+      return;
+
+    lowerValue = sketch.quantile( lowerCount );
+    upperValue = sketch.quantile( upperCount );
+    QgsDebugMsgLevel( QStringLiteral( "sketch lowerValue = %1 upperValue = %2" ).arg( lowerValue ).arg( upperValue ), 4 );
+    return;
+  }
+
   //get band stats to specify real histogram min/max (fix #9793 Byte bands)
   const QgsRasterBandStats stats = bandStatistics( bandNo, QgsRasterBandStats::Min, extent, sampleSize );
   if ( stats.maximumValue < stats.minimumValue )
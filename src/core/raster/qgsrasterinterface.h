@@ -29,6 +29,7 @@
 #include "qgsrasterbandstats.h"
 #include "qgsrasterblock.h"
 #include "qgsrasterhistogram.h"
+#include "qgsrasterquantilesketch.h"
 #include "qgsrectangle.h"
 #include "qgsrendercontext.h"
 
@@ -484,6 +485,9 @@ class CORE_EXPORT QgsRasterInterface
      * \param upperValue  Location into which the upper value will be set.
      * \param extent Extent used to calc histogram, if empty, whole raster extent is used.
      * \param sampleSize Approximate number of cells in sample. If 0, all cells (whole raster will be used). If raster does not have exact size (WCS without exact size for example), provider decides size of sample.
+     *
+     * Since QGIS 3.34, the values of floating point bands are estimated from the quantileSketch() of the
+     * band, integer bands still use an exact histogram.
      */
     virtual void cumulativeCut( int bandNo,
                                 double lowerCount,
@@ -493,6 +497,25 @@ class CORE_EXPORT QgsRasterInterface
                                 const QgsRectangle &extent = QgsRectangle(),
                                 int sampleSize = 0 );
 
+    /**
+     * Returns an approximate quantile sketch of the values of a band. Sketches are cached.
+     *
+     * The sketch is collected in a single pass over the raster, together with the statistics of
+     * the same extent and sample size, which are cached too so that a following call to
+     * bandStatistics() does not read the raster again.
+     *
+     * \param bandNo The band (number).
+     * \param extent Extent used to calc the sketch, if empty, whole raster extent is used.
+     * \param sampleSize Approximate number of cells in sample. If 0, all cells (whole raster will be used).
+     * \param feedback optional feedback object
+     *
+     * \note Not available in Python bindings
+     * \since QGIS 3.34
+     */
+    virtual QgsRasterQuantileSketch quantileSketch( int bandNo,
+        const QgsRectangle &extent = QgsRectangle(),
+        int sampleSize = 0, QgsRasterBlockFeedback *feedback = nullptr ) SIP_SKIP;
+
     //! Write base class members to xml.
     virtual void writeXml( QDomDocument &doc, QDomElement &parentElem ) const { Q_UNUSED( doc ) Q_UNUSED( parentElem ); }
     //! Sets base class members from xml. Usually called from create() methods of subclasses
@@ -508,6 +531,11 @@ class CORE_EXPORT QgsRasterInterface
     //! \brief List  of cached histograms, all bands mixed
     QList<QgsRasterHistogram> mHistograms;
 
+#ifndef SIP_RUN
+    //! List of cached quantile sketches, with the band, extent and size they were collected for
+    QList< QPair< QgsRasterBandStats, QgsRasterQuantileSketch > > mQuantileSketches;
+#endif
+
     // On/off state, if off, it does not do anything, replicates input
     bool mOn = true;
 
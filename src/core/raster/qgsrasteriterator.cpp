@@ -104,6 +104,11 @@ bool QgsRasterIterator::next( int bandNumber, int &columns, int &rows, int &topL
   return readNextRasterPartInternal( bandNumber, columns, rows, nullptr, topLeftColumn, topLeftRow, &blockExtent, outTileColumns, outTileRows, outTileTopLeftColumn, outTileTopLeftRow );
 }
 
+bool QgsRasterIterator::next( int bandNumber, int &columns, int &rows, int &topLeftColumn, int &topLeftRow, QgsRectangle &blockExtent, int &tileColumns, int &tileRows, int &tileTopLeftColumn, int &tileTopLeftRow )
+{
+  return readNextRasterPartInternal( bandNumber, columns, rows, nullptr, topLeftColumn, topLeftRow, &blockExtent, tileColumns, tileRows, tileTopLeftColumn, tileTopLeftRow );
+}
+
 bool QgsRasterIterator::readNextRasterPart( int bandNumber,
     int &nCols, int &nRows,
     QgsRasterBlock **block,
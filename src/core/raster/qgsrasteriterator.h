@@ -92,6 +92,31 @@ class CORE_EXPORT QgsRasterIterator
     */
     bool next( int bandNumber, int &columns SIP_OUT, int &rows SIP_OUT, int &topLeftColumn SIP_OUT, int &topLeftRow SIP_OUT, QgsRectangle &blockExtent SIP_OUT );
 
+    /**
+     * Fetches details of the next part of the raster data, without fetching the raster data itself.
+     *
+     * In addition to the block details returned by the other next() overload, this method
+     * returns the area of the tile within the block, i.e. the block without the overlapping
+     * pixels requested in the constructor.
+     *
+     * \param bandNumber band to read
+     * \param columns number of columns on output device
+     * \param rows number of rows on output device
+     * \param topLeftColumn top left column
+     * \param topLeftRow top left row
+     * \param blockExtent exact extent of returned raster block
+     * \param tileColumns number of columns of the tile, excluding overlapping pixels
+     * \param tileRows number of rows of the tile, excluding overlapping pixels
+     * \param tileTopLeftColumn top left column of the tile, excluding overlapping pixels
+     * \param tileTopLeftRow top left row of the tile, excluding overlapping pixels
+     * \returns FALSE if the last part was already returned
+     *
+     * \note Not available in Python bindings
+     * \since QGIS 3.34
+    */
+    bool next( int bandNumber, int &columns, int &rows, int &topLeftColumn, int &topLeftRow, QgsRectangle &blockExtent,
+               int &tileColumns, int &tileRows, int &tileTopLeftColumn, int &tileTopLeftRow ) SIP_SKIP;
+
     /**
      * Fetches next part of raster data, caller takes ownership of the block and
      * caller should delete the block.
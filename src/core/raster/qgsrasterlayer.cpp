@@ -981,6 +981,7 @@ void QgsRasterLayer::setDataProvider( QString const &provider, const QgsDataProv
 
   // projector (may be anywhere in pipe)
   QgsRasterProjector *projector = new QgsRasterProjector;
+  projector->setPrecision( QgsRasterProjector::settingsDefaultPrecision->value() );
   mPipe->set( projector );
 
   // Set default identify format - use the richest format available
@@ -2255,6 +2256,16 @@ bool QgsRasterLayer::readSymbology( const QDomNode &layer_node, QString &errorMe
     }
   }
 
+  // Reprojection precision, layers saved without one use the default Approximate precision
+  if ( QgsRasterProjector *projector = mPipe->projector() )
+  {
+    const QDomElement projectorElem = pipeNode.firstChildElement( QStringLiteral( "rasterprojector" ) );
+    if ( !projectorElem.isNull() )
+      projector->readXml( projectorElem );
+    else
+      projector->setPrecision( QgsRasterProjector::Approximate );
+  }
+
   // Resampling stage
   const QDomNode resamplingStageElement = pipeNode.namedItem( QStringLiteral( "resamplingStage" ) );
   if ( !resamplingStageElement.isNull() )
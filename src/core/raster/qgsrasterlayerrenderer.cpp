@@ -35,6 +35,7 @@
 #include <QElapsedTimer>
 #include <QPointer>
 #include <QThread>
+#include <QThreadPool>
 
 ///@cond PRIVATE
 
@@ -361,9 +362,29 @@ bool QgsRasterLayerRenderer::render()
   // important -- disable SmoothPixmapTransform for raster layer renders. We want individual pixels to be clearly defined!
   renderContext()->painter()->setRenderHint( QPainter::SmoothPixmapTransform, false );
 
+  // Large rasters are split in tiles rendered concurrently, each thread pulling its tiles through
+  // its own copy of the pipe. Tiles overlap by one pixel so that neighborhood based renderers
+  // such as hillshade do not show seams.
+  constexpr int CONCURRENT_TILE_SIZE = 512;
+  const int outputWidth = static_cast< int >( mRasterViewPort->mWidth * renderContext()->devicePixelRatio() );
+  const int outputHeight = static_cast< int >( mRasterViewPort->mHeight * renderContext()->devicePixelRatio() );
+  const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  const bool concurrent = threadCount > 1 && !mFeedback->renderPartialOutput()
+                          && static_cast< qgssize >( outputWidth ) * outputHeight > 2 * static_cast< qgssize >( CONCURRENT_TILE_SIZE ) * CONCURRENT_TILE_SIZE;
+
   // Drawer to pipe?
-  QgsRasterIterator iterator( mPipe->last() );
+  QgsRasterIterator iterator( mPipe->last(), concurrent ? 1 : 0 );
   QgsRasterDrawer drawer( &iterator );
+
+  if ( concurrent )
+  {
+    iterator.setMaximumTileWidth( std::min( iterator.maximumTileWidth(), CONCURRENT_TILE_SIZE ) );
+    iterator.setMaximumTileHeight( std::min( iterator.maximumTileHeight(), CONCURRENT_TILE_SIZE ) );
+
+    const int tileCount = ( outputWidth / iterator.maximumTileWidth() + 1 ) * ( outputHeight / iterator.maximumTileHeight() + 1 );
+    drawer.setConcurrentPipe( mPipe.get(), std::min( threadCount, tileCount ) );
+  }
+
   drawer.draw( *( renderContext() ), mRasterViewPort, mFeedback );
 
   if ( mDrawElevationMap )
@@ -21,6 +21,15 @@
 #include "qgsrasterprojector.h"
 #include "qgscoordinatetransform.h"
 #include "qgsexception.h"
+#include "qgssettingsentryenumflag.h"
+#include "qgssettingstree.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <limits>
+
+const QgsSettingsEntryEnumFlag<QgsRasterProjector::Precision> *QgsRasterProjector::settingsDefaultPrecision = new QgsSettingsEntryEnumFlag<QgsRasterProjector::Precision>( QStringLiteral( "default-reprojection-precision" ), QgsSettingsTree::sTreeRaster, QgsRasterProjector::Approximate, QStringLiteral( "Precision of the reprojection of new raster layers" ) );
 
 Q_NOWARN_DEPRECATED_PUSH // because of deprecated members
 QgsRasterProjector::QgsRasterProjector()
@@ -65,6 +74,132 @@ Qgis::DataType QgsRasterProjector::dataType( int bandNo ) const
 
 /// @cond PRIVATE
 
+namespace
+{
+  //! Size in pixels of the initial cells of the adaptive grids
+  constexpr int ADAPTIVE_CELL_SIZE = 64;
+
+  //! Size in pixels below which cells which cannot be interpolated are not split anymore, their pixels are transformed
+  constexpr int ADAPTIVE_MIN_CELL_SIZE = 4;
+
+  //! Maximum error of the interpolated source coordinates, in destination pixels
+  constexpr double ADAPTIVE_TOLERANCE = 0.125;
+
+  //! Maximum number of destination pixels of the cached adaptive grids
+  constexpr qgssize MAX_CACHED_GRID_PIXELS = 4 * 1024 * 1024;
+
+  /**
+   * Transforms points in place with a single call to PROJ. Points which cannot be
+   * transformed are set to non finite values.
+   */
+  void transformPoints( const QgsCoordinateTransform &ct, std::vector<double> &x, std::vector<double> &y )
+  {
+    if ( x.empty() || !ct.isValid() )
+      return;
+
+    const std::vector<double> originalX = x;
+    const std::vector<double> originalY = y;
+    std::vector<double> z( x.size(), 0.0 );
+    try
+    {
+      ct.transformCoords( static_cast< int >( x.size() ), x.data(), y.data(), z.data() );
+      // a fallback operation is used for all the points as soon as one of them fails,
+      // in that case points are transformed one by one as with single point transforms
+      if ( !ct.fallbackOperationOccurred() )
+        return;
+    }
+    catch ( QgsCsException & )
+    {
+    }
+
+    for ( std::size_t i = 0; i < x.size(); ++i )
+    {
+      x[i] = originalX[i];
+      y[i] = originalY[i];
+      double pointZ = 0;
+      try
+      {
+        ct.transformInPlace( x[i], y[i], pointZ );
+      }
+      catch ( QgsCsException & )
+      {
+        x[i] = std::numeric_limits<double>::quiet_NaN();
+        y[i] = std::numeric_limits<double>::quiet_NaN();
+      }
+    }
+  }
+
+  /**
+   * Cache of the adaptive grids, so that rendering the same extent again
+   * (e.g. when the map is refreshed) does not reproject it again.
+   */
+  class AdaptiveGridCache
+  {
+    public:
+
+      struct Key
+      {
+        QgsCoordinateReferenceSystem sourceCrs;
+        QgsCoordinateReferenceSystem destinationCrs;
+        QgsCoordinateTransformContext context;
+        QgsRectangle destExtent;
+        int destCols;
+        int destRows;
+        QgsRectangle extent;
+        double maxSrcXRes;
+        double maxSrcYRes;
+
+        bool operator==( const Key &other ) const
+        {
+          return destCols == other.destCols && destRows == other.destRows
+                 && destExtent == other.destExtent && extent == other.extent
+                 && maxSrcXRes == other.maxSrcXRes && maxSrcYRes == other.maxSrcYRes
+                 && sourceCrs == other.sourceCrs && destinationCrs == other.destinationCrs
+                 && context == other.context;
+        }
+      };
+
+      std::shared_ptr< const ProjectorData::AdaptiveGrid > grid( const Key &key )
+      {
+        QMutexLocker locker( &mMutex );
+        for ( int i = 0; i < mEntries.size(); ++i )
+        {
+          if ( mEntries.at( i ).first == key )
+          {
+            mEntries.move( i, 0 );
+            return mEntries.at( 0 ).second;
+          }
+        }
+        return nullptr;
+      }
+
+      void insert( const Key &key, const std::shared_ptr< const ProjectorData::AdaptiveGrid > &grid )
+      {
+        const qgssize pixels = static_cast< qgssize >( key.destCols ) * key.destRows;
+        if ( pixels > MAX_CACHED_GRID_PIXELS )
+          return;
+
+        QMutexLocker locker( &mMutex );
+        mEntries.prepend( qMakePair( key, grid ) );
+        mPixels += pixels;
+        while ( mPixels > MAX_CACHED_GRID_PIXELS )
+        {
+          mPixels -= static_cast< qgssize >( mEntries.constLast().first.destCols ) * mEntries.constLast().first.destRows;
+          mEntries.removeLast();
+        }
+      }
+
+    private:
+
+      QMutex mMutex;
+      //! Most recently used first
+      QList< QPair< Key, std::shared_ptr< const ProjectorData::AdaptiveGrid > > > mEntries;
+      qgssize mPixels = 0;
+  };
+}
+
+Q_GLOBAL_STATIC( AdaptiveGridCache, sAdaptiveGridCache )
+
 void QgsRasterProjector::setCrs( const QgsCoordinateReferenceSystem &srcCRS,
                                  const QgsCoordinateReferenceSystem &destCRS,
                                  int srcDatumTransform,
@@ -156,6 +291,12 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
     mApproximate = false;
   }
 
+  if ( precision == QgsRasterProjector::Adaptive )
+  {
+    initAdaptive( feedback );
+    return;
+  }
+
   // Always try to calculate mCPMatrix, it is used in calcSrcExtent() for both Approximate and Exact
   // Initialize the matrix by corners and middle points
   mCPCols = mCPRows = 3;
@@ -274,6 +415,11 @@ void ProjectorData::calcSrcExtent()
   }
   // Expand a bit to avoid possible approx coords falling out because of representation error?
 
+  alignSrcExtent();
+}
+
+void ProjectorData::alignSrcExtent()
+{
   // Combine with maximum source  extent
   mSrcExtent = mSrcExtent.intersect( mExtent );
 
@@ -488,7 +634,11 @@ void ProjectorData::nextHelper()
 
 bool ProjectorData::srcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
 {
-  if ( mApproximate )
+  if ( mAdaptiveGrid )
+  {
+    return adaptiveSrcRowCol( destRow, destCol, srcRow, srcCol );
+  }
+  else if ( mApproximate )
   {
     return approximateSrcRowCol( destRow, destCol, srcRow, srcCol );
   }
@@ -505,25 +655,16 @@ bool ProjectorData::preciseSrcRowCol( int destRow, int destCol, int *srcRow, int
   QgsDebugMsgLevel( QStringLiteral( "theDestRow = %1 mDestExtent.yMaximum() = %2 mDestYRes = %3" ).arg( destRow ).arg( mDestExtent.yMaximum() ).arg( mDestYRes ), 5 );
 #endif
 
-  // Get coordinate of center of destination cell
-  double x = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
-  double y = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
-  double z = 0;
-
-#if 0
-  QgsDebugMsgLevel( QStringLiteral( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
-#endif
-
-  if ( mInverseCt.isValid() )
+  // Coordinates of the centers of destination cells are transformed a row at a time
+  if ( destRow != mPreciseRow )
   {
-    try
-    {
-      mInverseCt.transformInPlace( x, y, z );
-    }
-    catch ( QgsCsException & )
-    {
-      return false;
-    }
+    calcPreciseRow( destRow );
+  }
+  const double x = mPreciseX[destCol];
+  const double y = mPreciseY[destCol];
+  if ( !std::isfinite( x ) || !std::isfinite( y ) )
+  {
+    return false;
   }
 
 #if 0
@@ -611,6 +752,317 @@ bool ProjectorData::approximateSrcRowCol( int destRow, int destCol, int *srcRow,
   return true;
 }
 
+void ProjectorData::calcPreciseRow( int destRow )
+{
+  mPreciseX.resize( static_cast< std::size_t >( mDestCols ) );
+  mPreciseY.resize( static_cast< std::size_t >( mDestCols ) );
+  const double y = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
+  {
+    mPreciseX[destCol] = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
+    mPreciseY[destCol] = y;
+  }
+  if ( mInverseCt.isValid() )
+  {
+    transformPoints( mInverseCt, mPreciseX, mPreciseY );
+  }
+  mPreciseRow = destRow;
+}
+
+inline bool ProjectorData::adaptiveSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol ) const
+{
+  const qgssize index = static_cast< qgssize >( destRow ) * mDestCols + destCol;
+  *srcRow = mAdaptiveGrid->rows[index];
+  *srcCol = mAdaptiveGrid->cols[index];
+  return *srcRow >= 0;
+}
+
+void ProjectorData::initAdaptive( QgsRasterBlockFeedback *feedback )
+{
+  const AdaptiveGridCache::Key key { mInverseCt.sourceCrs(), mInverseCt.destinationCrs(), mInverseCt.context(),
+                                     mDestExtent, mDestCols, mDestRows, mExtent, mMaxSrcXRes, mMaxSrcYRes };
+  mAdaptiveGrid = sAdaptiveGridCache()->grid( key );
+
+  if ( !mAdaptiveGrid )
+  {
+    std::vector<double> srcX;
+    std::vector<double> srcY;
+    if ( !calcAdaptiveGrid( srcX, srcY, feedback ) )
+      return;
+
+    // the source extent covers the corners of the destination extent and the centers of all its cells
+    std::vector<double> cornersX { mDestExtent.xMinimum(), mDestExtent.xMaximum(), mDestExtent.xMinimum(), mDestExtent.xMaximum() };
+    std::vector<double> cornersY { mDestExtent.yMaximum(), mDestExtent.yMaximum(), mDestExtent.yMinimum(), mDestExtent.yMinimum() };
+    transformPoints( mInverseCt, cornersX, cornersY );
+
+    bool found = false;
+    const auto combine = [this, &found]( double x, double y )
+    {
+      if ( !std::isfinite( x ) || !std::isfinite( y ) )
+        return;
+      if ( found )
+      {
+        mSrcExtent.combineExtentWith( x, y );
+      }
+      else
+      {
+        mSrcExtent = QgsRectangle( x, y, x, y );
+        found = true;
+      }
+    };
+    for ( std::size_t i = 0; i < cornersX.size(); ++i )
+      combine( cornersX[i], cornersY[i] );
+    for ( std::size_t i = 0; i < srcX.size(); ++i )
+      combine( srcX[i], srcY[i] );
+
+    std::shared_ptr< AdaptiveGrid > grid = std::make_shared< AdaptiveGrid >();
+    grid->rows.assign( srcX.size(), -1 );
+    grid->cols.assign( srcX.size(), -1 );
+    if ( found )
+    {
+      alignSrcExtent();
+      calcSrcRowsCols();
+    }
+
+    if ( found && mSrcRows > 0 && mSrcCols > 0 )
+    {
+      mSrcYRes = mSrcExtent.height() / mSrcRows;
+      mSrcXRes = mSrcExtent.width() / mSrcCols;
+      for ( std::size_t i = 0; i < srcX.size(); ++i )
+      {
+        const double x = srcX[i];
+        const double y = srcY[i];
+        if ( !std::isfinite( x ) || !std::isfinite( y ) || !mExtent.contains( x, y ) )
+          continue;
+
+        const int row = static_cast< int >( std::floor( ( mSrcExtent.yMaximum() - y ) / mSrcYRes ) );
+        const int col = static_cast< int >( std::floor( ( x - mSrcExtent.xMinimum() ) / mSrcXRes ) );
+        if ( row < 0 || row >= mSrcRows || col < 0 || col >= mSrcCols )
+          continue;
+
+        grid->rows[i] = row;
+        grid->cols[i] = col;
+      }
+    }
+    else
+    {
+      mSrcRows = 0;
+      mSrcCols = 0;
+    }
+    grid->srcExtent = mSrcExtent;
+    grid->srcRows = mSrcRows;
+    grid->srcCols = mSrcCols;
+
+    mAdaptiveGrid = grid;
+    sAdaptiveGridCache()->insert( key, mAdaptiveGrid );
+  }
+
+  mSrcExtent = mAdaptiveGrid->srcExtent;
+  mSrcRows = mAdaptiveGrid->srcRows;
+  mSrcCols = mAdaptiveGrid->srcCols;
+  if ( mSrcRows > 0 && mSrcCols > 0 )
+  {
+    mSrcYRes = mSrcExtent.height() / mSrcRows;
+    mSrcXRes = mSrcExtent.width() / mSrcCols;
+  }
+}
+
+bool ProjectorData::calcAdaptiveGrid( std::vector<double> &srcX, std::vector<double> &srcY, QgsRasterBlockFeedback *feedback )
+{
+  struct Cell
+  {
+    int row0;
+    int col0;
+    int row1;
+    int col1;
+  };
+
+  const qgssize count = static_cast< qgssize >( mDestRows ) * mDestCols;
+  srcX.assign( count, std::numeric_limits<double>::quiet_NaN() );
+  srcY.assign( count, std::numeric_limits<double>::quiet_NaN() );
+
+  const auto destX = [this]( int col ) { return mDestExtent.xMinimum() + ( col + 0.5 ) * mDestXRes; };
+  const auto destY = [this]( int row ) { return mDestExtent.yMaximum() - ( row + 0.5 ) * mDestYRes; };
+
+  // cells are delimited by the centers of their corner pixels, adjacent cells share their edges
+  std::vector<Cell> cells;
+  for ( int row0 = 0; ; row0 += ADAPTIVE_CELL_SIZE )
+  {
+    const int row1 = std::min( row0 + ADAPTIVE_CELL_SIZE, mDestRows - 1 );
+    for ( int col0 = 0; ; col0 += ADAPTIVE_CELL_SIZE )
+    {
+      const int col1 = std::min( col0 + ADAPTIVE_CELL_SIZE, mDestCols - 1 );
+      cells.push_back( { row0, col0, row1, col1 } );
+      if ( col1 >= mDestCols - 1 )
+        break;
+    }
+    if ( row1 >= mDestRows - 1 )
+      break;
+  }
+
+  // corners, edge midpoints and center of a cell
+  constexpr int CELL_POINTS = 9;
+  std::vector<Cell> nextCells;
+  std::vector<Cell> exactCells;
+  std::vector<double> x;
+  std::vector<double> y;
+  while ( !cells.empty() )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return false;
+
+    // the points of all the cells of a refinement level are transformed at once
+    x.clear();
+    y.clear();
+    x.reserve( cells.size() * CELL_POINTS );
+    y.reserve( cells.size() * CELL_POINTS );
+    for ( const Cell &cell : cells )
+    {
+      const int midRow = ( cell.row0 + cell.row1 ) / 2;
+      const int midCol = ( cell.col0 + cell.col1 ) / 2;
+      for ( const int row : { cell.row0, cell.row1 } )
+      {
+        for ( const int col : { cell.col0, cell.col1 } )
+        {
+          x.push_back( destX( col ) );
+          y.push_back( destY( row ) );
+        }
+      }
+      x.insert( x.end(), { destX( midCol ), destX( midCol ), destX( cell.col0 ), destX( cell.col1 ), destX( midCol ) } );
+      y.insert( y.end(), { destY( cell.row0 ), destY( cell.row1 ), destY( midRow ), destY( midRow ), destY( midRow ) } );
+    }
+    transformPoints( mInverseCt, x, y );
+
+    nextCells.clear();
+    for ( std::size_t i = 0; i < cells.size(); ++i )
+    {
+      const Cell &cell = cells[i];
+      const double *px = x.data() + i * CELL_POINTS;
+      const double *py = y.data() + i * CELL_POINTS;
+      const int rowSpan = cell.row1 - cell.row0;
+      const int colSpan = cell.col1 - cell.col0;
+
+      const auto interpolate = [ = ]( int row, int col, double & ix, double & iy )
+      {
+        const double rowFrac = rowSpan > 0 ? static_cast< double >( row - cell.row0 ) / rowSpan : 0.0;
+        const double colFrac = colSpan > 0 ? static_cast< double >( col - cell.col0 ) / colSpan : 0.0;
+        const double topX = px[0] + ( px[1] - px[0] ) * colFrac;
+        const double topY = py[0] + ( py[1] - py[0] ) * colFrac;
+        const double bottomX = px[2] + ( px[3] - px[2] ) * colFrac;
+        const double bottomY = py[2] + ( py[3] - py[2] ) * colFrac;
+        ix = topX + ( bottomX - topX ) * rowFrac;
+        iy = topY + ( bottomY - topY ) * rowFrac;
+      };
+
+      if ( rowSpan <= 1 && colSpan <= 1 )
+      {
+        // all the pixels of the cell are its corners
+        int point = 0;
+        for ( const int row : { cell.row0, cell.row1 } )
+        {
+          for ( const int col : { cell.col0, cell.col1 } )
+          {
+            const qgssize index = static_cast< qgssize >( row ) * mDestCols + col;
+            srcX[index] = px[point];
+            srcY[index] = py[point];
+            ++point;
+          }
+        }
+        continue;
+      }
+
+      bool interpolable = std::all_of( px, px + CELL_POINTS, []( double v ) { return std::isfinite( v ); } )
+                          && std::all_of( py, py + CELL_POINTS, []( double v ) { return std::isfinite( v ); } );
+      if ( interpolable )
+      {
+        // size of a destination pixel in source units, along the cell edges
+        double pixelSize = std::numeric_limits<double>::max();
+        if ( colSpan > 0 )
+          pixelSize = std::min( pixelSize, std::hypot( px[1] - px[0], py[1] - py[0] ) / colSpan );
+        if ( rowSpan > 0 )
+          pixelSize = std::min( pixelSize, std::hypot( px[2] - px[0], py[2] - py[0] ) / rowSpan );
+
+        const int midRow = ( cell.row0 + cell.row1 ) / 2;
+        const int midCol = ( cell.col0 + cell.col1 ) / 2;
+        const int checkRows[] = { cell.row0, cell.row1, midRow, midRow, midRow };
+        const int checkCols[] = { midCol, midCol, cell.col0, cell.col1, midCol };
+        double maxSqrError = 0;
+        for ( int check = 0; check < 5; ++check )
+        {
+          double ix, iy;
+          interpolate( checkRows[check], checkCols[check], ix, iy );
+          const double dx = ix - px[4 + check];
+          const double dy = iy - py[4 + check];
+          maxSqrError = std::max( maxSqrError, dx * dx + dy * dy );
+        }
+        const double tolerance = ADAPTIVE_TOLERANCE * pixelSize;
+        interpolable = maxSqrError <= tolerance * tolerance;
+      }
+
+      if ( interpolable )
+      {
+        for ( int row = cell.row0; row <= cell.row1; ++row )
+        {
+          qgssize index = static_cast< qgssize >( row ) * mDestCols + cell.col0;
+          for ( int col = cell.col0; col <= cell.col1; ++col, ++index )
+          {
+            interpolate( row, col, srcX[index], srcY[index] );
+          }
+        }
+      }
+      else if ( rowSpan <= ADAPTIVE_MIN_CELL_SIZE && colSpan <= ADAPTIVE_MIN_CELL_SIZE )
+      {
+        exactCells.push_back( cell );
+      }
+      else
+      {
+        const int midRow = ( cell.row0 + cell.row1 ) / 2;
+        const int midCol = ( cell.col0 + cell.col1 ) / 2;
+        std::vector<std::pair<int, int>> rowRanges { { cell.row0, cell.row1 } };
+        std::vector<std::pair<int, int>> colRanges { { cell.col0, cell.col1 } };
+        if ( rowSpan > 1 )
+          rowRanges = { { cell.row0, midRow }, { midRow, cell.row1 } };
+        if ( colSpan > 1 )
+          colRanges = { { cell.col0, midCol }, { midCol, cell.col1 } };
+        for ( const std::pair<int, int> &rows : rowRanges )
+        {
+          for ( const std::pair<int, int> &cols : colRanges )
+          {
+            nextCells.push_back( { rows.first, cols.first, rows.second, cols.second } );
+          }
+        }
+      }
+    }
+    cells.swap( nextCells );
+  }
+
+  // the pixels of the cells which cannot be interpolated, typically at the limits of the
+  // valid area of the transform, are all transformed
+  x.clear();
+  y.clear();
+  std::vector<qgssize> indexes;
+  for ( const Cell &cell : exactCells )
+  {
+    for ( int row = cell.row0; row <= cell.row1; ++row )
+    {
+      for ( int col = cell.col0; col <= cell.col1; ++col )
+      {
+        indexes.push_back( static_cast< qgssize >( row ) * mDestCols + col );
+        x.push_back( destX( col ) );
+        y.push_back( destY( row ) );
+      }
+    }
+  }
+  transformPoints( mInverseCt, x, y );
+  for ( std::size_t i = 0; i < indexes.size(); ++i )
+  {
+    srcX[indexes[i]] = x[i];
+    srcY[indexes[i]] = y[i];
+  }
+
+  return !feedback || !feedback->isCanceled();
+}
+
 void ProjectorData::insertRows( const QgsCoordinateTransform &ct )
 {
   for ( int r = 0; r < mCPRows - 1; r++ )
@@ -801,10 +1253,35 @@ QString QgsRasterProjector::precisionLabel( Precision precision )
       return tr( "Approximate" );
     case Exact:
       return tr( "Exact" );
+    case Adaptive:
+      return tr( "Adaptive" );
   }
   return QStringLiteral( "Unknown" );
 }
 
+void QgsRasterProjector::writeXml( QDomDocument &doc, QDomElement &parentElem ) const
+{
+  // the CRSs are set for every render, only the precision belongs to the layer
+  if ( parentElem.isNull() || mPrecision == Approximate )
+  {
+    return;
+  }
+
+  QDomElement projectorElem = doc.createElement( QStringLiteral( "rasterprojector" ) );
+  projectorElem.setAttribute( QStringLiteral( "precision" ), qgsEnumValueToKey( mPrecision ) );
+  parentElem.appendChild( projectorElem );
+}
+
+void QgsRasterProjector::readXml( const QDomElement &filterElem )
+{
+  if ( filterElem.isNull() )
+  {
+    return;
+  }
+
+  mPrecision = qgsEnumKeyToValue( filterElem.attribute( QStringLiteral( "precision" ) ), Approximate );
+}
+
 QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &extent, int width, int height, QgsRasterBlockFeedback *feedback )
 {
   QgsDebugMsgLevel( QStringLiteral( "extent:\n%1" ).arg( extent.toString() ), 4 );
@@ -34,8 +34,11 @@
 #include "qgsrasterinterface.h"
 
 #include <cmath>
+#include <memory>
+#include <vector>
 
 class QgsPointXY;
+template<class T> class QgsSettingsEntryEnumFlag;
 
 /**
  * \ingroup core
@@ -58,9 +61,16 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
     {
       Approximate = 0, //!< Approximate (default), fast but possibly inaccurate
       Exact = 1,   //!< Exact, precise but slow
+      Adaptive = 2, //!< Precise to a fraction of a pixel, using an interpolation grid refined where the reprojection is not linear enough. Nearly as fast as Approximate (since QGIS 3.34)
     };
     Q_ENUM( Precision )
 
+    /**
+     * Precision of the projectors of new raster layers.
+     * \since QGIS 3.34
+     */
+    static const QgsSettingsEntryEnumFlag<QgsRasterProjector::Precision> *settingsDefaultPrecision SIP_SKIP;
+
     QgsRasterProjector();
 
     QgsRasterProjector *clone() const override SIP_FACTORY;
@@ -94,6 +104,9 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
     // Translated precision mode, for use in ComboBox etc.
     static QString precisionLabel( Precision precision );
 
+    void writeXml( QDomDocument &doc, QDomElement &parentElem ) const override;
+    void readXml( const QDomElement &filterElem ) override;
+
     QgsRasterBlock *block( int bandNo, const QgsRectangle &extent, int width, int height, QgsRasterBlockFeedback *feedback = nullptr ) override SIP_FACTORY;
 
     //! Calculate destination extent and size from source extent and size
@@ -145,6 +158,17 @@ class ProjectorData
     ProjectorData( const ProjectorData &other ) = delete;
     ProjectorData &operator=( const ProjectorData &other ) = delete;
 
+    //! Source rows and columns of the destination pixels computed in Adaptive precision
+    struct AdaptiveGrid
+    {
+      QgsRectangle srcExtent;
+      int srcRows = 0;
+      int srcCols = 0;
+      //! Source row and column of each destination pixel, -1 if outside of the source
+      std::vector<int> rows;
+      std::vector<int> cols;
+    };
+
     /**
      * Returns the source row and column indexes for current source extent and resolution.
      * If the source pixel is outside source extent srcRow and srcCol are left unchanged.
@@ -173,6 +197,25 @@ class ProjectorData
     //! Returns approximate source row and column indexes for current source extent and resolution.
     inline bool approximateSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
 
+    //! Returns source row and column indexes from the adaptive grid.
+    inline bool adaptiveSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol ) const;
+
+    //! Transforms the centers of the destination pixels of \a destRow to the source CRS
+    void calcPreciseRow( int destRow );
+
+    /**
+     * Calculates the source coordinates of every destination pixel, interpolating them over
+     * grid cells which are recursively split until the interpolation error is below tolerance.
+     * \returns FALSE if canceled
+     */
+    bool calcAdaptiveGrid( std::vector<double> &srcX, std::vector<double> &srcY, QgsRasterBlockFeedback *feedback );
+
+    //! Builds the adaptive grid, or takes it from the cache of grids
+    void initAdaptive( QgsRasterBlockFeedback *feedback );
+
+    //! Aligns the source extent to the source resolution and clips it to the source raster extent
+    void alignSrcExtent();
+
     //! \brief insert rows to matrix
     void insertRows( const QgsCoordinateTransform &ct );
 
@@ -293,6 +336,14 @@ class ProjectorData
     double mMaxSrcXRes;
     double mMaxSrcYRes;
 
+    //! Destination row transformed in mPreciseX and mPreciseY in Exact precision
+    int mPreciseRow = -1;
+    std::vector<double> mPreciseX;
+    std::vector<double> mPreciseY;
+
+    //! Source row and columns of the destination pixels in Adaptive precision
+    std::shared_ptr< const AdaptiveGrid > mAdaptiveGrid;
+
 };
 
 /// @endcond
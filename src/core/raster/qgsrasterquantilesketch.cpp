@@ -0,0 +1,220 @@
+/***************************************************************************
+                         qgsrasterquantilesketch.cpp
+                         ---------------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrasterquantilesketch.h"
+
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+QgsRasterQuantileSketch::QgsRasterQuantileSketch( double compression )
+  : mCompression( compression )
+{
+}
+
+void QgsRasterQuantileSketch::merge( const QgsRasterQuantileSketch &other )
+{
+  other.flush();
+  if ( other.mTotalWeight == 0 )
+    return;
+
+  flush();
+  if ( mTotalWeight == 0 )
+  {
+    mMinimum = other.mMinimum;
+    mMaximum = other.mMaximum;
+  }
+  else
+  {
+    mMinimum = std::min( mMinimum, other.mMinimum );
+    mMaximum = std::max( mMaximum, other.mMaximum );
+  }
+  mCentroids.insert( mCentroids.end(), other.mCentroids.begin(), other.mCentroids.end() );
+  mTotalWeight += other.mTotalWeight;
+  compress();
+}
+
+qgssize QgsRasterQuantileSketch::count() const
+{
+  flush();
+  return static_cast< qgssize >( mTotalWeight );
+}
+
+double QgsRasterQuantileSketch::minimum() const
+{
+  flush();
+  return mTotalWeight > 0 ? mMinimum : std::numeric_limits<double>::quiet_NaN();
+}
+
+double QgsRasterQuantileSketch::maximum() const
+{
+  flush();
+  return mTotalWeight > 0 ? mMaximum : std::numeric_limits<double>::quiet_NaN();
+}
+
+double QgsRasterQuantileSketch::quantile( double q ) const
+{
+  flush();
+  if ( mTotalWeight == 0 || std::isnan( q ) )
+    return std::numeric_limits<double>::quiet_NaN();
+  if ( q <= 0 )
+    return mMinimum;
+  if ( q >= 1 )
+    return mMaximum;
+
+  // values are interpolated between the centers of the centroids, the minimum and maximum being the outer bounds
+  const double target = q * mTotalWeight;
+  double previousCenter = 0;
+  double previousValue = mMinimum;
+  double cumulativeWeight = 0;
+  for ( const Centroid &centroid : mCentroids )
+  {
+    const double center = cumulativeWeight + centroid.weight / 2;
+    if ( target < center )
+    {
+      const double fraction = ( target - previousCenter ) / ( center - previousCenter );
+      return previousValue + fraction * ( centroid.mean - previousValue );
+    }
+    previousCenter = center;
+    previousValue = centroid.mean;
+    cumulativeWeight += centroid.weight;
+  }
+
+  const double fraction = ( target - previousCenter ) / ( mTotalWeight - previousCenter );
+  return previousValue + fraction * ( mMaximum - previousValue );
+}
+
+QString QgsRasterQuantileSketch::toString() const
+{
+  flush();
+  QStringList parts;
+  parts.reserve( static_cast< int >( mCentroids.size() ) + 5 );
+  parts << QStringLiteral( "tdigest" )
+        << QString::number( mCompression, 'g', 17 )
+        << QString::number( mTotalWeight, 'g', 17 )
+        << QString::number( mMinimum, 'g', 17 )
+        << QString::number( mMaximum, 'g', 17 );
+  for ( const Centroid &centroid : std::as_const( mCentroids ) )
+  {
+    parts << QStringLiteral( "%1,%2" ).arg( QString::number( centroid.mean, 'g', 17 ), QString::number( centroid.weight, 'g', 17 ) );
+  }
+  return parts.join( ';' );
+}
+
+QgsRasterQuantileSketch QgsRasterQuantileSketch::fromString( const QString &string, bool *ok )
+{
+  if ( ok )
+    *ok = false;
+
+  const QStringList parts = string.split( ';' );
+  if ( parts.size() < 5 || parts.at( 0 ) != QLatin1String( "tdigest" ) )
+    return QgsRasterQuantileSketch();
+
+  bool valid = true;
+  bool partOk = false;
+  QgsRasterQuantileSketch sketch( parts.at( 1 ).toDouble( &partOk ) );
+  valid &= partOk && sketch.mCompression > 0;
+  sketch.mTotalWeight = parts.at( 2 ).toDouble( &partOk );
+  valid &= partOk;
+  sketch.mMinimum = parts.at( 3 ).toDouble( &partOk );
+  valid &= partOk;
+  sketch.mMaximum = parts.at( 4 ).toDouble( &partOk );
+  valid &= partOk;
+
+  double centroidsWeight = 0;
+  sketch.mCentroids.reserve( static_cast< std::size_t >( parts.size() - 5 ) );
+  for ( int i = 5; i < parts.size() && valid; ++i )
+  {
+    const QStringList centroid = parts.at( i ).split( ',' );
+    if ( centroid.size() != 2 )
+    {
+      valid = false;
+      break;
+    }
+    bool meanOk = false;
+    bool weightOk = false;
+    const double mean = centroid.at( 0 ).toDouble( &meanOk );
+    const double weight = centroid.at( 1 ).toDouble( &weightOk );
+    valid &= meanOk && weightOk && weight > 0;
+    sketch.mCentroids.push_back( Centroid { mean, weight } );
+    centroidsWeight += weight;
+  }
+
+  if ( !valid || !qgsDoubleNear( centroidsWeight, sketch.mTotalWeight ) )
+    return QgsRasterQuantileSketch();
+
+  if ( ok )
+    *ok = true;
+  return sketch;
+}
+
+void QgsRasterQuantileSketch::flush() const
+{
+  if ( mBuffer.empty() )
+    return;
+
+  if ( mTotalWeight == 0 )
+  {
+    mMinimum = mBuffer.front();
+    mMaximum = mBuffer.front();
+  }
+  mCentroids.reserve( mCentroids.size() + mBuffer.size() );
+  for ( const double value : std::as_const( mBuffer ) )
+  {
+    mMinimum = std::min( mMinimum, value );
+    mMaximum = std::max( mMaximum, value );
+    mCentroids.push_back( Centroid { value, 1 } );
+  }
+  mTotalWeight += static_cast< double >( mBuffer.size() );
+  mBuffer.clear();
+  compress();
+}
+
+void QgsRasterQuantileSketch::compress() const
+{
+  if ( mCentroids.size() < 2 )
+    return;
+
+  std::sort( mCentroids.begin(), mCentroids.end(), []( const Centroid & a, const Centroid & b ) { return a.mean < b.mean; } );
+
+  // neighbor centroids are merged while the merged centroid stays below the size allowed at its
+  // position, which is proportional to q * ( 1 - q ) and so keeps the tails accurate
+  std::vector< Centroid > merged;
+  merged.reserve( static_cast< std::size_t >( 2 * mCompression ) );
+  const double sizeFactor = 4 * mTotalWeight / mCompression;
+  double weightSoFar = 0;
+  Centroid current = mCentroids.front();
+  for ( auto it = mCentroids.begin() + 1; it != mCentroids.end(); ++it )
+  {
+    const double proposedWeight = current.weight + it->weight;
+    const double q0 = weightSoFar / mTotalWeight;
+    const double q2 = ( weightSoFar + proposedWeight ) / mTotalWeight;
+    if ( proposedWeight <= sizeFactor * std::min( q0 * ( 1 - q0 ), q2 * ( 1 - q2 ) ) )
+    {
+      current.mean += ( it->mean - current.mean ) * it->weight / proposedWeight;
+      current.weight = proposedWeight;
+    }
+    else
+    {
+      weightSoFar += current.weight;
+      merged.push_back( current );
+      current = *it;
+    }
+  }
+  merged.push_back( current );
+  mCentroids.swap( merged );
+}
@@ -0,0 +1,115 @@
+/***************************************************************************
+                         qgsrasterquantilesketch.h
+                         -------------------------
+    begin                : October 2023
+    copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSRASTERQUANTILESKETCH_H
+#define QGSRASTERQUANTILESKETCH_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgis.h"
+
+#include <QString>
+#include <vector>
+
+#define SIP_NO_FILE
+
+/**
+ * \ingroup core
+ * \brief Approximate quantiles of a stream of raster values, stored in a bounded amount of memory.
+ *
+ * The sketch is a merging t-digest: values are summarized by weighted centroids, which
+ * are kept small near the tails of the distribution so that quantiles used for cumulative
+ * cuts (like 2% and 98%) are accurate. Sketches computed from parts of a raster can be
+ * merged, so the parts can be processed in parallel.
+ *
+ * Sketches can be serialized to a string with toString(), for example to be stored
+ * with the raster and reused in later sessions.
+ *
+ * \note Not available in Python bindings
+ * \since QGIS 3.34
+ */
+class CORE_EXPORT QgsRasterQuantileSketch
+{
+  public:
+
+    /**
+     * Constructor for an empty sketch.
+     *
+     * The \a compression controls the number of centroids, and so the size and the accuracy of the sketch.
+     */
+    explicit QgsRasterQuantileSketch( double compression = 100 );
+
+    //! Adds a \a value to the sketch
+    void add( double value )
+    {
+      mBuffer.push_back( value );
+      if ( mBuffer.size() >= BUFFER_SIZE )
+        flush();
+    }
+
+    //! Adds the values summarized by the \a other sketch to this sketch
+    void merge( const QgsRasterQuantileSketch &other );
+
+    //! Returns the number of values added to the sketch
+    qgssize count() const;
+
+    //! Returns the minimum value added to the sketch, or NaN if the sketch is empty
+    double minimum() const;
+
+    //! Returns the maximum value added to the sketch, or NaN if the sketch is empty
+    double maximum() const;
+
+    /**
+     * Returns the approximate value below which the fraction \a q of the values lies, with
+     * \a q from 0 to 1. Returns NaN if the sketch is empty.
+     */
+    double quantile( double q ) const;
+
+    //! Serializes the sketch to a string, which can be restored with fromString()
+    QString toString() const;
+
+    /**
+     * Restores a sketch serialized with toString().
+     *
+     * \a ok is set to FALSE if the \a string is not a valid sketch.
+     */
+    static QgsRasterQuantileSketch fromString( const QString &string, bool *ok = nullptr );
+
+  private:
+
+    struct Centroid
+    {
+      double mean;
+      double weight;
+    };
+
+    //! Number of values buffered before they are merged into the centroids
+    static constexpr std::size_t BUFFER_SIZE = 4096;
+
+    //! Merges the buffered values into the centroids
+    void flush() const;
+
+    //! Sorts the centroids and merges the neighbors which are small enough for their position
+    void compress() const;
+
+    double mCompression = 100;
+    mutable std::vector< Centroid > mCentroids;
+    mutable std::vector< double > mBuffer;
+    mutable double mTotalWeight = 0;
+    mutable double mMinimum = 0;
+    mutable double mMaximum = 0;
+};
+
+#endif // QGSRASTERQUANTILESKETCH_H
@@ -18,6 +18,7 @@
 #include "qgssinglebandgrayrenderer.h"
 #include "qgscontrastenhancement.h"
 #include "qgsrastertransparency.h"
+#include "qgsrasterblockkernels.h"
 #include "qgscolorramplegendnode.h"
 #include "qgscolorramplegendnodesettings.h"
 #include "qgsreadwritecontext.h"
@@ -29,6 +30,7 @@
 #include <QImage>
 #include <QColor>
 #include <memory>
+#include <vector>
 
 QgsSingleBandGrayRenderer::QgsSingleBandGrayRenderer( QgsRasterInterface *input, int grayBand )
   : QgsRasterRenderer( input, QStringLiteral( "singlebandgray" ) )
@@ -135,6 +137,52 @@ QgsRasterBlock *QgsSingleBandGrayRenderer::block( int bandNo, const QgsRectangle
   }
 
   const QRgb myDefaultColor = renderColorForNodataPixel();
+
+  // linear stretches without per pixel transparency are rendered span by span with the block kernels
+  const QgsContrastEnhancement::ContrastEnhancementAlgorithm algorithm = mContrastEnhancement ? mContrastEnhancement->contrastEnhancementAlgorithm() : QgsContrastEnhancement::NoEnhancement;
+  if ( mAlphaBand <= 0 && ( !mRasterTransparency || mRasterTransparency->isEmpty() )
+       && ( algorithm == QgsContrastEnhancement::StretchToMinimumMaximum || algorithm == QgsContrastEnhancement::StretchAndClipToMinimumMaximum ) )
+  {
+    double displayableMinimum = mContrastEnhancement->minimumValue();
+    double displayableMaximum = mContrastEnhancement->maximumValue();
+    if ( algorithm == QgsContrastEnhancement::StretchToMinimumMaximum )
+    {
+      displayableMinimum = QgsContrastEnhancement::minimumValuePossible( inputBlock->dataType() );
+      displayableMaximum = QgsContrastEnhancement::maximumValuePossible( inputBlock->dataType() );
+    }
+
+    if ( mContrastEnhancement->isValueInDisplayableRange( displayableMinimum ) && mContrastEnhancement->isValueInDisplayableRange( displayableMaximum ) )
+    {
+      // an empty transparency still rounds the opacity to an 8 bit alpha value
+      const double opacity = mRasterTransparency ? static_cast< int >( mOpacity * 255 ) / 255.0 : mOpacity;
+      const std::array<QRgb, 256> colors = QgsRasterBlockKernels::grayTable( opacity, mGradient == WhiteToBlack );
+
+      const qgssize count = static_cast< qgssize >( width ) * height;
+      const qgssize spanSize = std::min( count, QgsRasterBlockKernels::SPAN_SIZE );
+      std::vector<double> values( spanSize );
+      std::vector<quint8> noData( spanSize );
+      std::vector<quint8> levels( spanSize );
+      QRgb *outputData = outputBlock->colorData();
+
+      bool rendered = true;
+      for ( qgssize start = 0; start < count; start += spanSize )
+      {
+        const qgssize size = std::min( count - start, spanSize );
+        if ( !inputBlock->readValues( start, size, values.data(), noData.data() ) )
+        {
+          rendered = false;
+          break;
+        }
+        QgsRasterBlockKernels::maskOutsideRange( values.data(), size, displayableMinimum, displayableMaximum, noData.data() );
+        QgsRasterBlockKernels::linearStretch( values.data(), size, mContrastEnhancement->minimumValue(), mContrastEnhancement->maximumValue(), levels.data() );
+        QgsRasterBlockKernels::lookupColors( levels.data(), noData.data(), size, colors, myDefaultColor, outputData + start );
+      }
+
+      if ( rendered )
+        return outputBlock.release();
+    }
+  }
+
   bool isNoData = false;
   for ( qgssize i = 0; i < ( qgssize )width * height; i++ )
   {
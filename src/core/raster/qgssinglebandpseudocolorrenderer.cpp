@@ -20,6 +20,7 @@
 #include "qgscolorrampshader.h"
 #include "qgsrastershader.h"
 #include "qgsrastertransparency.h"
+#include "qgsrasterblockkernels.h"
 #include "qgsrasterviewport.h"
 #include "qgsstyleentityvisitor.h"
 #include "qgscolorramplegendnode.h"
@@ -28,6 +29,8 @@
 #include <QDomElement>
 #include <QImage>
 
+#include <vector>
+
 QgsSingleBandPseudoColorRenderer::QgsSingleBandPseudoColorRenderer( QgsRasterInterface *input, int band, QgsRasterShader *shader )
   : QgsRasterRenderer( input, QStringLiteral( "singlebandpseudocolor" ) )
   , mShader( shader )
@@ -240,11 +243,43 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
   QRgb *outputBlockData = outputBlock->colorData();
   const QgsRasterShaderFunction *fcn = mShader->rasterShaderFunction();
 
+  // color ramps are sampled once per data type, so that pixels are colored with a single table read
+  std::shared_ptr< const QgsColorRampLookupTable > lookupTable;
+  if ( const QgsColorRampShader *colorRampShader = dynamic_cast< const QgsColorRampShader * >( fcn ) )
+    lookupTable = colorRampShader->lookupTable( inputBlock->dataType() );
+
   const qgssize count = ( qgssize )width * height;
+
+  // values and nodata flags are read span by span, so that the data type is not dispatched for every pixel
+  const qgssize spanSize = std::min( count, QgsRasterBlockKernels::SPAN_SIZE );
+  std::vector<double> values( spanSize );
+  std::vector<quint8> noData( spanSize );
+  qgssize spanStart = 0;
+  qgssize spanEnd = 0;
+  const bool readSpans = inputBlock->readValues( 0, spanSize, values.data(), noData.data() );
+  if ( readSpans )
+    spanEnd = spanSize;
+
   bool isNoData = false;
   for ( qgssize i = 0; i < count; i++ )
   {
-    const double val = inputBlock->valueAndNoData( i, isNoData );
+    double val = 0;
+    if ( readSpans )
+    {
+      if ( i == spanEnd )
+      {
+        spanStart = spanEnd;
+        spanEnd = std::min( count, spanStart + spanSize );
+        inputBlock->readValues( spanStart, spanEnd - spanStart, values.data(), noData.data() );
+      }
+      val = values[i - spanStart];
+      isNoData = noData[i - spanStart];
+    }
+    else
+    {
+      val = inputBlock->valueAndNoData( i, isNoData );
+    }
+
     if ( isNoData )
     {
       outputBlockData[i] = myDefaultColor;
@@ -252,7 +287,20 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
     }
 
     int red, green, blue, alpha;
-    if ( !fcn->shade( val, &red, &green, &blue, &alpha ) )
+    if ( lookupTable && lookupTable->covers( val ) )
+    {
+      QRgb color;
+      if ( !lookupTable->color( val, color ) )
+      {
+        outputBlockData[i] = myDefaultColor;
+        continue;
+      }
+      red = qRed( color );
+      green = qGreen( color );
+      blue = qBlue( color );
+      alpha = qAlpha( color );
+    }
+    else if ( !fcn->shade( val, &red, &green, &blue, &alpha ) )
     {
       outputBlockData[i] = myDefaultColor;
       continue;
@@ -42,6 +42,7 @@
 #endif
 
 #include <iostream>
+#include <limits>
 #include <string>
 #include <QObject>
 #include <QLibrary>
@@ -227,6 +228,21 @@ std::unique_ptr< QgsPythonUtils > QgsProcessingExec::loadPythonSupport()
 }
 #endif
 
+/**
+ * Converts a memory budget \a value in megabytes to \a bytes. Returns FALSE if the value is not
+ * a non-negative number of megabytes.
+ */
+static bool memoryBudgetFromMegabytes( const QVariant &value, qint64 &bytes )
+{
+  bool ok = false;
+  const qint64 megabytes = value.toLongLong( &ok );
+  if ( !ok || megabytes < 0 || megabytes > std::numeric_limits< qint64 >::max() / ( 1024 * 1024 ) )
+    return false;
+
+  bytes = megabytes * 1024 * 1024;
+  return true;
+}
+
 QgsProcessingExec::QgsProcessingExec()
 {
 
@@ -364,6 +380,8 @@ int QgsProcessingExec::run( const QStringList &constArgs )
     Qgis::DistanceUnit distanceUnit = Qgis::DistanceUnit::Unknown;
     Qgis::AreaUnit areaUnit = Qgis::AreaUnit::Unknown;
     QString projectPath;
+    qint64 memoryBudget = 0;
+    QString checkpointPath;
     QVariantMap params;
 
     if ( args.size() == 4 && args.at( 3 ) == '-' )
@@ -395,6 +413,12 @@ int QgsProcessingExec::run( const QStringList &constArgs )
 
       ellipsoid = json.value( QStringLiteral( "ellipsoid" ) ).toString();
       projectPath = json.value( QStringLiteral( "project_path" ) ).toString();
+      if ( json.contains( "memory_budget" ) && !memoryBudgetFromMegabytes( json.value( QStringLiteral( "memory_budget" ) ), memoryBudget ) )
+      {
+        std::cerr << QStringLiteral( "%1 is not a valid memory budget value." ).arg( json.value( QStringLiteral( "memory_budget" ) ).toString() ).toLocal8Bit().constData() << std::endl;
+        return 1;
+      }
+      checkpointPath = json.value( QStringLiteral( "checkpoint" ) ).toString();
       if ( json.contains( "distance_units" ) )
       {
         bool ok = false;
@@ -455,6 +479,19 @@ int QgsProcessingExec::run( const QStringList &constArgs )
           {
             projectPath = parts.mid( 1 ).join( '=' );
           }
+          else if ( name.compare( QLatin1String( "memory_budget" ), Qt::CaseInsensitive ) == 0 )
+          {
+            const QString memoryBudgetString = parts.mid( 1 ).join( '=' );
+            if ( !memoryBudgetFromMegabytes( memoryBudgetString, memoryBudget ) )
+            {
+              std::cerr << QStringLiteral( "%1 is not a valid memory budget value." ).arg( memoryBudgetString ).toLocal8Bit().constData() << std::endl;
+              return 1;
+            }
+          }
+          else if ( name.compare( QLatin1String( "checkpoint" ), Qt::CaseInsensitive ) == 0 )
+          {
+            checkpointPath = parts.mid( 1 ).join( '=' );
+          }
           else
           {
             const QString value = parts.mid( 1 ).join( '=' );
@@ -524,7 +561,7 @@ int QgsProcessingExec::run( const QStringList &constArgs )
       }
     }
 
-    return execute( algId, params, ellipsoid, distanceUnit, areaUnit, logLevel, useJson, projectPath );
+    return execute( algId, params, ellipsoid, distanceUnit, areaUnit, logLevel, useJson, projectPath, memoryBudget, checkpointPath );
   }
   else
   {
@@ -556,7 +593,9 @@ void QgsProcessingExec::showUsage( const QString &appName )
       << "\t\t\tAlternatively, a '-' character in place of the parameters argument indicates that the parameters should be read from STDIN as a JSON object. The JSON should be structured as a map containing at least the \"inputs\" key specifying a map of input parameter values. This implies the --json option for output as a JSON object.\n"
       << "\t\t\tIf required, the ellipsoid to use for distance and area calculations can be specified via the \"--ELLIPSOID=name\" argument.\n"
       << "\t\t\tIf required, an existing QGIS project to use during the algorithm execution can be specified via the \"--PROJECT_PATH=path\" argument.\n"
-      << "\t\t\tWhen passing parameters as a JSON object from STDIN, these extra arguments can be provided as an \"ellipsoid\" and a \"project_path\" key respectively.\n";
+      << "\t\t\tIf required, the memory (in megabytes) algorithms can use for grouping, joining and sorting features before spilling them to temporary files can be specified via the \"--MEMORY_BUDGET=megabytes\" argument.\n"
+      << "\t\t\tIf required, a file algorithms periodically save their progress to can be specified via the \"--CHECKPOINT=path\" argument. Running an interrupted algorithm again with the same parameters and checkpoint resumes it from the saved progress.\n"
+      << "\t\t\tWhen passing parameters as a JSON object from STDIN, these extra arguments can be provided as an \"ellipsoid\", a \"project_path\", a \"memory_budget\" and a \"checkpoint\" key respectively.\n";
 
   std::cout << msg.join( QString() ).toLocal8Bit().constData();
 }
@@ -1011,7 +1050,7 @@ int QgsProcessingExec::showAlgorithmHelp( const QString &inputId, bool useJson )
   return 0;
 }
 
-int QgsProcessingExec::execute( const QString &inputId, const QVariantMap &inputs, const QString &ellipsoid, Qgis::DistanceUnit distanceUnit, Qgis::AreaUnit areaUnit, QgsProcessingContext::LogLevel logLevel, bool useJson, const QString &projectPath )
+int QgsProcessingExec::execute( const QString &inputId, const QVariantMap &inputs, const QString &ellipsoid, Qgis::DistanceUnit distanceUnit, Qgis::AreaUnit areaUnit, QgsProcessingContext::LogLevel logLevel, bool useJson, const QString &projectPath, qint64 memoryBudget, const QString &checkpointPath )
 {
   QVariantMap json;
   if ( useJson )
@@ -1160,6 +1199,20 @@ int QgsProcessingExec::execute( const QString &inputId, const QVariantMap &input
     else
       json.insert( QStringLiteral( "area_unit" ), QgsUnitTypes::toString( areaUnit ) );
   }
+  if ( memoryBudget > 0 )
+  {
+    if ( !useJson )
+      std::cout << "Using memory budget:\t" << memoryBudget / ( 1024 * 1024 ) << " MB\n";
+    else
+      json.insert( QStringLiteral( "memory_budget" ), memoryBudget / ( 1024 * 1024 ) );
+  }
+  if ( !checkpointPath.isEmpty() )
+  {
+    if ( !useJson )
+      std::cout << "Using checkpoint:\t" << checkpointPath.toLocal8Bit().constData() << '\n';
+    else
+      json.insert( QStringLiteral( "checkpoint" ), checkpointPath );
+  }
 
 
   QgsProcessingContext context;
@@ -1169,6 +1222,8 @@ int QgsProcessingExec::execute( const QString &inputId, const QVariantMap &input
   if ( project )
     context.setProject( project );
   context.setLogLevel( logLevel );
+  context.setMemoryBudget( memoryBudget );
+  context.setCheckpointFile( checkpointPath );
 
   const QgsProcessingParameterDefinitions defs = alg->parameterDefinitions();
   QList< const QgsProcessingParameterDefinition * > missingParams;
@@ -1228,6 +1283,9 @@ int QgsProcessingExec::execute( const QString &inputId, const QVariantMap &input
 
   QVariantMap res = alg->run( params, context, &feedback, &ok );
 
+  if ( ( !ok || feedback.isCanceled() ) && !checkpointPath.isEmpty() && QFile::exists( checkpointPath ) )
+    std::cerr << QStringLiteral( "Progress was saved to checkpoint %1, run the algorithm again with the same parameters to resume it\n" ).arg( checkpointPath ).toLocal8Bit().constData();
+
   if ( ok )
   {
     QVariantMap resultsJson;
@@ -86,7 +86,9 @@ class QgsProcessingExec
                  Qgis::AreaUnit areaUnit,
                  QgsProcessingContext::LogLevel logLevel,
                  bool useJson,
-                 const QString &projectPath = QString() );
+                 const QString &projectPath = QString(),
+                 qint64 memoryBudget = 0,
+                 const QString &checkpointPath = QString() );
 
     void addVersionInformation( QVariantMap &json );
     void addAlgorithmInformation( QVariantMap &json, const QgsProcessingAlgorithm *algorithm );
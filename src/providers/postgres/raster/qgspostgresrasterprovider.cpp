@@ -911,6 +911,7 @@ bool QgsPostgresRasterProvider::setSubsetString( const QString &subset, bool upd
   }
 
   mStatistics.clear();
+  mQuantileSketches.clear();
   mShared->invalidateCache();
 
   // Update datasource uri too
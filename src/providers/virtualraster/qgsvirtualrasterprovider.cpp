@@ -17,6 +17,12 @@
 #include "qgsrasterlayer.h"
 #include "qgsrasterprojector.h"
 #include "qgsapplication.h"
+#include "qgsproviderregistry.h"
+#include "qgsrasterblockcache.h"
+
+#include <QFileInfo>
+
+#include <limits>
 
 #define PROVIDER_KEY QStringLiteral( "virtualraster" )
 #define PROVIDER_DESCRIPTION QStringLiteral( "Virtual Raster data provider" )
@@ -151,6 +157,26 @@ QgsRasterBlock *QgsVirtualRasterProvider::block( int bandNo, const QgsRectangle
   std::unique_ptr< QgsRasterBlock > tblock = std::make_unique< QgsRasterBlock >( Qgis::DataType::Float64, width, height );
   double *outputData = ( double * )( tblock->bits() );
 
+  // the results only depend on the formula and on the input rasters, identified by their sources and modification times
+  QString cacheSource = QStringLiteral( "virtualraster\n" ) + dataSourceUri();
+  for ( const QgsRasterCalculatorEntry &entry : std::as_const( mRasterEntries ) )
+  {
+    const QString path = QgsProviderRegistry::instance()->decodeUri( entry.raster->providerType(), entry.raster->source() ).value( QStringLiteral( "path" ) ).toString();
+    const QFileInfo fileInfo( path );
+    cacheSource += '\n' + entry.raster->source() + '\n' + QString::number( fileInfo.exists() ? fileInfo.lastModified().toMSecsSinceEpoch() : 0 );
+  }
+
+  const qgssize dataSize = static_cast< qgssize >( width ) * height * sizeof( double );
+  // blocks which don't fit in a QByteArray are never cached
+  const bool cacheable = outputData && dataSize <= static_cast< qgssize >( std::numeric_limits< int >::max() );
+  QByteArray cached;
+  if ( cacheable && QgsRasterBlockCache::block( cacheSource, 1, extent, width, height, cached ) && static_cast< qgssize >( cached.size() ) == dataSize )
+  {
+    memcpy( outputData, cached.constData(), dataSize );
+    return tblock.release();
+  }
+  bool complete = true;
+
   QMap< QString, QgsRasterBlock * > inputBlocks;
   QVector<QgsRasterCalculatorEntry>::const_iterator it = mRasterEntries.constBegin();
 
@@ -170,6 +196,7 @@ QgsRasterBlock *QgsVirtualRasterProvider::block( int bandNo, const QgsRectangle
       block.reset( proj.block( it->bandNumber, extent, width, height, rasterBlockFeedback.get() ) );
       if ( rasterBlockFeedback->isCanceled() )
       {
+        complete = false;
         qDeleteAll( inputBlocks );
         QgsDebugMsgLevel( "Canceled = 3, User canceled calculation", 2 );
       }
@@ -193,6 +220,7 @@ QgsRasterBlock *QgsVirtualRasterProvider::block( int bandNo, const QgsRectangle
 
     if ( feedback && feedback->isCanceled() )
     {
+      complete = false;
       break;
     }
 
@@ -207,10 +235,16 @@ QgsRasterBlock *QgsVirtualRasterProvider::block( int bandNo, const QgsRectangle
     {
       qDeleteAll( inputBlocks );
       inputBlocks.clear();
+      complete = false;
       QgsDebugError( "calcNode was not run in a correct way" );
     }
   }
 
+  if ( complete && cacheable )
+  {
+    QgsRasterBlockCache::insertBlock( cacheSource, 1, extent, width, height, QByteArray( reinterpret_cast< const char * >( outputData ), static_cast< int >( dataSize ) ) );
+  }
+
   Q_ASSERT( tblock );
   return tblock.release();
 }
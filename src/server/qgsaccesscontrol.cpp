@@ -197,11 +197,13 @@ bool QgsAccessControl::fillCacheKey( QStringList &cacheKey ) const
   for ( acIterator = mPluginsAccessControls->constBegin(); acIterator != mPluginsAccessControls->constEnd(); ++acIterator )
   {
     const QString newKey = acIterator.value()->cacheKey();
-    if ( ! newKey.isEmpty() )
+    if ( newKey.isEmpty() )
     {
+      // an empty key means the response must not be cached
       cacheKey.clear();
       return false;
     }
+    cacheKey << newKey;
   }
   return true;
 }
@@ -157,6 +157,8 @@ class SERVER_EXPORT QgsAccessControl : public QgsFeatureFilterProvider
     /**
      * Fill the capabilities caching key
      * \param cacheKey the list to fill with a cache variant
+     * \returns FALSE if one of the access control plugins returned an empty key, i.e.
+     * the response must not be cached
      */
     bool fillCacheKey( QStringList &cacheKey ) const;
 
@@ -0,0 +1,150 @@
+/***************************************************************************
+                          qgscompressionresponsedecorator.cpp
+
+  Define response adapter for HTTP content encoding
+  -------------------
+  begin                : 2023-10-16
+  copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgscompressionresponsedecorator.h"
+#include "qgsziputils.h"
+
+//! Bodies smaller than this are not worth the compression overhead
+constexpr int MIN_COMPRESSION_SIZE = 1024;
+
+QgsCompressionResponseDecorator::QgsCompressionResponseDecorator( const QgsServerRequest &request, QgsServerResponse &response, bool enabled )
+  : mResponse( response )
+{
+  if ( enabled )
+  {
+    mEncoding = negotiateEncoding( request.header( QStringLiteral( "Accept-Encoding" ) ) );
+  }
+}
+
+QString QgsCompressionResponseDecorator::negotiateEncoding( const QString &acceptEncoding )
+{
+  double gzipQuality = 0;
+  double deflateQuality = 0;
+  double wildcardQuality = -1;
+
+  const QStringList codings = acceptEncoding.split( ',', Qt::SkipEmptyParts );
+  for ( const QString &coding : codings )
+  {
+    const QStringList parts = coding.split( ';' );
+    const QString name = parts.first().trimmed().toLower();
+
+    double quality = 1;
+    for ( int i = 1; i < parts.size(); ++i )
+    {
+      const QString param = parts.at( i ).trimmed();
+      if ( param.startsWith( QLatin1String( "q=" ), Qt::CaseInsensitive ) )
+      {
+        bool ok = false;
+        quality = param.mid( 2 ).toDouble( &ok );
+        if ( !ok )
+          quality = 0;
+      }
+    }
+
+    if ( name == QLatin1String( "gzip" ) || name == QLatin1String( "x-gzip" ) )
+      gzipQuality = quality;
+    else if ( name == QLatin1String( "deflate" ) )
+      deflateQuality = quality;
+    else if ( name == QLatin1String( "*" ) )
+      wildcardQuality = quality;
+  }
+
+  // codings not explicitly listed inherit the wildcard quality
+  if ( wildcardQuality >= 0 )
+  {
+    if ( !acceptEncoding.contains( QLatin1String( "gzip" ), Qt::CaseInsensitive ) )
+      gzipQuality = wildcardQuality;
+    if ( !acceptEncoding.contains( QLatin1String( "deflate" ), Qt::CaseInsensitive ) )
+      deflateQuality = wildcardQuality;
+  }
+
+  if ( gzipQuality > 0 && gzipQuality >= deflateQuality )
+    return QStringLiteral( "gzip" );
+  if ( deflateQuality > 0 )
+    return QStringLiteral( "deflate" );
+  return QString();
+}
+
+bool QgsCompressionResponseDecorator::isCompressible( const QString &contentType )
+{
+  const QString type = contentType.section( ';', 0, 0 ).trimmed().toLower();
+  if ( type.isEmpty() )
+    return false;
+
+  return type.startsWith( QLatin1String( "text/" ) )
+         || type.contains( QLatin1String( "json" ) )
+         || type.contains( QLatin1String( "xml" ) )
+         || type.contains( QLatin1String( "javascript" ) )
+         || type == QLatin1String( "application/dxf" );
+}
+
+bool QgsCompressionResponseDecorator::compress( const QByteArray &data, const QString &encoding, QByteArray &compressed )
+{
+  compressed.clear();
+  if ( encoding == QLatin1String( "gzip" ) )
+  {
+    return QgsZipUtils::encodeGzip( data, compressed );
+  }
+  else if ( encoding == QLatin1String( "deflate" ) )
+  {
+    // HTTP "deflate" is the zlib format, which is what qCompress() produces
+    // after its 4 bytes uncompressed size prefix
+    compressed = qCompress( data ).mid( 4 );
+    return !compressed.isEmpty();
+  }
+  return false;
+}
+
+void QgsCompressionResponseDecorator::finish()
+{
+  if ( !mEncoding.isEmpty() && !mStreamed && !mResponse.headersSent() )
+  {
+    const int code = mResponse.statusCode();
+    const QString contentType = mResponse.header( QStringLiteral( "Content-Type" ) );
+    if ( ( code == 0 || code == 200 ) && isCompressible( contentType )
+         && mResponse.header( QStringLiteral( "Content-Encoding" ) ).isEmpty() )
+    {
+      // the representation depends on the request encoding for every compressible response
+      mResponse.setHeader( QStringLiteral( "Vary" ), QStringLiteral( "Accept-Encoding" ) );
+
+      const QByteArray body = mResponse.data();
+      QByteArray compressed;
+      if ( body.size() >= MIN_COMPRESSION_SIZE
+           && compress( body, mEncoding, compressed )
+           && compressed.size() < body.size() )
+      {
+        mResponse.truncate();
+        mResponse.write( compressed );
+        mResponse.setHeader( QStringLiteral( "Content-Encoding" ), mEncoding );
+        if ( !mResponse.header( QStringLiteral( "Content-Length" ) ).isEmpty() )
+        {
+          mResponse.setHeader( QStringLiteral( "Content-Length" ), QString::number( compressed.size() ) );
+        }
+      }
+    }
+  }
+
+  mResponse.finish();
+}
+
+void QgsCompressionResponseDecorator::flush()
+{
+  // data sent before the response is finished cannot be compressed as a whole
+  mStreamed = true;
+  mResponse.flush();
+}
@@ -0,0 +1,105 @@
+/***************************************************************************
+                          qgscompressionresponsedecorator.h
+
+  Define response adapter for HTTP content encoding
+  -------------------
+  begin                : 2023-10-16
+  copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSCOMPRESSIONRESPONSEDECORATOR_H
+#define QGSCOMPRESSIONRESPONSEDECORATOR_H
+
+#define SIP_NO_FILE
+
+
+#include "qgsserverresponse.h"
+#include "qgsserverrequest.h"
+
+/**
+ * \ingroup server
+ * \class QgsCompressionResponseDecorator
+ * \brief Class defining decorator for compressing the response body
+ *
+ * The encoding is negotiated from the Accept-Encoding header of the request
+ * and the body is compressed when the response is finished. Responses which
+ * are streamed (i.e. flushed before being finished), already encoded or
+ * whose content type is already compressed (e.g. PNG or JPEG images) are
+ * sent unchanged.
+ *
+ * \since QGIS 3.34
+ */
+class SERVER_EXPORT QgsCompressionResponseDecorator: public QgsServerResponse
+{
+  public:
+
+    /**
+     * Constructor for QgsCompressionResponseDecorator.
+     * \param request Server request, used to negotiate the encoding
+     * \param response Server response
+     * \param enabled FALSE to disable compression
+     */
+    QgsCompressionResponseDecorator( const QgsServerRequest &request, QgsServerResponse &response, bool enabled = true );
+
+    /**
+     * Returns the preferred encoding supported by the server for an \a acceptEncoding
+     * header value, either "gzip", "deflate" or an empty string if none is acceptable.
+     */
+    static QString negotiateEncoding( const QString &acceptEncoding );
+
+    /**
+     * Returns TRUE if a body with the \a contentType benefits from compression.
+     */
+    static bool isCompressible( const QString &contentType );
+
+    /**
+     * Compresses \a data with the \a encoding ("gzip" or "deflate").
+     * \returns TRUE on success
+     */
+    static bool compress( const QByteArray &data, const QString &encoding, QByteArray &compressed );
+
+    // QgsServerResponse overrides
+
+    void setHeader( const QString &key, const QString &value ) override {  mResponse.setHeader( key, value ); }
+
+    void removeHeader( const QString &key ) override { mResponse.removeHeader( key ); }
+
+    QString header( const QString &key ) const override { return mResponse.header( key ); }
+
+    QMap<QString, QString> headers() const override { return mResponse.headers(); }
+
+    bool headersSent() const override { return mResponse.headersSent(); }
+
+    void setStatusCode( int code ) override { mResponse.setStatusCode( code ); }
+
+    int statusCode() const override { return mResponse.statusCode(); }
+
+    void sendError( int code,  const QString &message ) override { mResponse.sendError( code, message ); }
+
+    QIODevice *io() override { return mResponse.io(); }
+
+    void finish() override;
+
+    void flush() override;
+
+    void clear() override { mResponse.clear(); }
+
+    QByteArray data() const override { return mResponse.data(); }
+
+    void truncate() override { mResponse.truncate(); }
+
+  private:
+    QgsServerResponse &mResponse;
+    QString mEncoding;
+    bool mStreamed = false;
+};
+
+#endif
@@ -34,6 +34,9 @@
 #include "qgsserverlogger.h"
 #include "qgsserverrequest.h"
 #include "qgsfilterresponsedecorator.h"
+#include "qgscompressionresponsedecorator.h"
+#include "qgsserveretag.h"
+#include "qgsserverrequesttrace.h"
 #include "qgsservice.h"
 #include "qgsserverapi.h"
 #include "qgsserverapicontext.h"
@@ -130,6 +133,25 @@ void QgsServer::printRequestParameters( const QMap< QString, QString> &parameter
   }
 }
 
+bool QgsServer::etagAllowed( const QgsServerRequest &request, QStringList &cacheKey )
+{
+  cacheKey.clear();
+  if ( request.method() != QgsServerRequest::GetMethod && request.method() != QgsServerRequest::HeadMethod )
+  {
+    return false;
+  }
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+  const QgsAccessControl *accessControls = sServerInterface->accessControls();
+  if ( accessControls )
+  {
+    return accessControls->fillCacheKey( cacheKey );
+  }
+#endif
+
+  return true;
+}
+
 QString QgsServer::configPath( const QString &defaultConfigPath, const QString &configPath )
 {
   QString cfPath( defaultConfigPath );
@@ -391,6 +413,8 @@ void QgsServer::putenv( const QString &var, const QString &val )
 void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &response, const QgsProject *project )
 {
   const Qgis::MessageLevel logLevel = QgsServerLogger::instance()->logLevel();
+  QElapsedTimer requestTimer;
+  requestTimer.start();
   {
 
     const QgsScopedRuntimeProfile profiler { QStringLiteral( "handleRequest" ), QStringLiteral( "server" ) };
@@ -409,9 +433,12 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
     }
 #endif
 
+    // Compress the final response body, after the plugin filters had a chance to modify it
+    QgsCompressionResponseDecorator compressionDecorator( request, response, sSettings->responseCompression() );
+
     // Pass the filters to the requestHandler, this is needed for the following reasons:
     // Allow server request to call sendResponse plugin hook if enabled
-    QgsFilterResponseDecorator responseDecorator( sServerInterface->filters(), response );
+    QgsFilterResponseDecorator responseDecorator( sServerInterface->filters(), compressionDecorator );
 
     //Request handler
     QgsRequestHandler requestHandler( request, response );
@@ -473,6 +500,7 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
           // load the project if needed and not empty
           if ( ! configFilePath.isEmpty() )
           {
+            const QgsScopedRuntimeProfile projectProfile { QStringLiteral( "Project load" ), QStringLiteral( "server" ) };
             // Note that  QgsConfigCache::project( ... ) call QgsProject::setInstance(...)
             project = mConfigCache->project( configFilePath, sServerInterface->serverSettings() );
           }
@@ -494,11 +522,24 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
         // There are APIs that work without a project (e.g. the landing page catalog API that
         // lists the available projects metadata).
 
+        // Conditional requests: answer 304 without processing when the client copy is still valid
+        QString etag;
+        QStringList cacheKey;
+        if ( project && sSettings->etag() && etagAllowed( request, cacheKey ) )
+        {
+          etag = QgsServerETag::computeETag( request, *project, cacheKey );
+        }
+        const bool notModified = QgsServerETag::matches( request.header( QStringLiteral( "If-None-Match" ) ), etag );
+
         // Dispatcher: if SERVICE is set, we assume a OWS service, if not, let's try an API
         // TODO: QGIS 4 fix the OWS services and treat them as APIs
         QgsServerApi *api = nullptr;
 
-        if ( params.service().isEmpty() && ( api = sServiceRegistry->apiForRequest( request ) ) )
+        if ( notModified )
+        {
+          responseDecorator.setStatusCode( 304 );
+        }
+        else if ( params.service().isEmpty() && ( api = sServiceRegistry->apiForRequest( request ) ) )
         {
           const QgsServerApiContext context { api->rootPath(), &request, &responseDecorator, project, sServerInterface };
           api->executeRequest( context );
@@ -529,6 +570,13 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
                                           QStringLiteral( "Service unknown or unsupported. Current supported services (case-sensitive): WMS WFS WCS WMTS SampleService, or use a WFS3 (OGC API Features) endpoint" ) );
           }
         }
+
+        // only successful responses may be validated later, error responses must not be cached
+        if ( !etag.isEmpty() && !responseDecorator.headersSent()
+             && ( responseDecorator.statusCode() == 200 || responseDecorator.statusCode() == 304 ) )
+        {
+          responseDecorator.setHeader( QStringLiteral( "ETag" ), etag );
+        }
       }
       catch ( QgsServerException &ex )
       {
@@ -544,10 +592,17 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
       }
     }
 
+    if ( sSettings->traceHeader() && !responseDecorator.headersSent() )
+    {
+      const QgsServerRequestTrace trace;
+      responseDecorator.setHeader( QStringLiteral( "Server-Timing" ), trace.serverTimingHeader( requestTimer.nsecsElapsed() / 1000000.0 ) );
+    }
+
     // Terminate the response
     // This may also throw exceptions if there are errors in python plugins code
     try
     {
+      const QgsScopedRuntimeProfile outputProfile { QStringLiteral( "Output writing" ), QStringLiteral( "server" ) };
       responseDecorator.finish();
     }
     catch ( QgsException &ex )
@@ -593,6 +648,13 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
   }
 
 
+  if ( sSettings->traceLog() )
+  {
+    // log at the current level so that the trace is written whatever the level is
+    const QgsServerRequestTrace trace;
+    QgsMessageLog::logMessage( QStringLiteral( "Trace: %1" ).arg( trace.toJson( request, requestTimer.nsecsElapsed() / 1000000.0 ) ), QStringLiteral( "Server" ), logLevel );
+  }
+
   // Clear the profiler server section after each request
   QgsApplication::profiler()->clear( QStringLiteral( "server" ) );
 
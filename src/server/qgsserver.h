@@ -113,6 +113,13 @@ class SERVER_EXPORT QgsServer
       const QMap< QString, QString> &parameterMap,
       Qgis::MessageLevel logLevel );
 
+    /**
+     * Returns TRUE if the response to the \a request may be validated with an ETag:
+     * only GET and HEAD requests qualify, and all the access control plugins must
+     * provide a cache key. The keys are stored in \a cacheKey.
+     */
+    static bool etagAllowed( const QgsServerRequest &request, QStringList &cacheKey );
+
     /**
      * Returns the default project file.
      */
@@ -0,0 +1,206 @@
+/***************************************************************************
+                              qgsserveretag.cpp
+                              -----------------
+  begin                : 2023-10-16
+  copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsserveretag.h"
+#include "qgsproject.h"
+#include "qgsmaplayer.h"
+#include "qgsproviderregistry.h"
+#include "qgsserverparameters.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+
+namespace
+{
+  QString normalizedTag( const QString &tag )
+  {
+    QString result = tag.trimmed();
+    if ( result.startsWith( QLatin1String( "W/" ) ) )
+      result = result.mid( 2 );
+    return result;
+  }
+
+  //! Data files of the layers of a project, valid as long as the project is not modified
+  struct LayerFiles
+  {
+    QDateTime projectTimestamp;
+    QStringList files;
+  };
+
+  QMutex sLayerFilesMutex;
+  QHash<QString, LayerFiles> sLayerFiles;
+
+  /**
+   * Looks up the data files of all the \a project layers, returns FALSE if one
+   * of the layers is not backed by a local file.
+   */
+  bool scanLayerFiles( const QgsProject &project, QStringList &files )
+  {
+    const QMap<QString, QgsMapLayer *> layers = project.mapLayers();
+    for ( const QgsMapLayer *layer : layers )
+    {
+      const QVariantMap parts = QgsProviderRegistry::instance()->decodeUri( layer->providerType(), layer->source() );
+      const QString path = parts.value( QStringLiteral( "path" ) ).toString();
+      const QFileInfo info( path );
+      if ( path.isEmpty() || !info.isFile() )
+      {
+        return false;
+      }
+
+      // also consider sidecar files (e.g. shapefile .dbf, GeoPackage -wal) which may be
+      // modified without touching the main file
+      const QDir dir = info.absoluteDir();
+      const QFileInfoList entries = dir.entryInfoList( QStringList() << info.completeBaseName() + QStringLiteral( ".*" ), QDir::Files, QDir::Name );
+      for ( const QFileInfo &entry : entries )
+      {
+        files << entry.absoluteFilePath();
+      }
+    }
+
+    files.sort();
+    files.removeDuplicates();
+    return true;
+  }
+}
+
+QString QgsServerETag::layersFingerprint( const QgsProject &project )
+{
+  QStringList files;
+  bool localFiles = true;
+
+  const QString projectFile = project.fileName();
+  const QDateTime projectTimestamp = project.lastModified();
+  if ( projectFile.isEmpty() || !projectTimestamp.isValid() )
+  {
+    localFiles = scanLayerFiles( project, files );
+  }
+  else
+  {
+    const QMutexLocker locker( &sLayerFilesMutex );
+    const auto it = sLayerFiles.constFind( projectFile );
+    if ( it != sLayerFiles.constEnd() && it->projectTimestamp == projectTimestamp )
+    {
+      files = it->files;
+    }
+    else
+    {
+      localFiles = scanLayerFiles( project, files );
+      if ( !localFiles )
+      {
+        files.clear();
+      }
+      sLayerFiles.insert( projectFile, LayerFiles { projectTimestamp, files } );
+    }
+    // a project with layers but no cached file is not backed by local files
+    localFiles = localFiles && ( !files.isEmpty() || project.count() == 0 );
+  }
+
+  if ( !localFiles )
+  {
+    return QString();
+  }
+
+  QStringList fingerprints;
+  fingerprints.reserve( files.size() );
+  for ( const QString &file : std::as_const( files ) )
+  {
+    const QFileInfo info( file );
+    fingerprints << QStringLiteral( "%1:%2:%3" ).arg( file )
+                 .arg( info.lastModified().toMSecsSinceEpoch() )
+                 .arg( info.size() );
+  }
+  return fingerprints.join( '\n' );
+}
+
+QString QgsServerETag::computeETag( const QgsServerRequest &request, const QgsProject &project, const QStringList &cacheKey )
+{
+  const QDateTime projectTimestamp = project.lastModified();
+  if ( !projectTimestamp.isValid() )
+  {
+    return QString();
+  }
+
+  const QString layers = layersFingerprint( project );
+  if ( layers.isEmpty() && project.count() > 0 )
+  {
+    return QString();
+  }
+
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  hash.addData( Qgis::version().toUtf8() );
+  hash.addData( project.fileName().toUtf8() );
+  hash.addData( QByteArray::number( projectTimestamp.toMSecsSinceEpoch() ) );
+  hash.addData( layers.toUtf8() );
+
+  // parameters are sorted by key, so the tag does not depend on their order in the URL
+  const QMap<QString, QString> parameters = request.serverParameters().toMap();
+  for ( auto it = parameters.constBegin(); it != parameters.constEnd(); ++it )
+  {
+    hash.addData( it.key().toUpper().toUtf8() );
+    hash.addData( "=", 1 );
+    hash.addData( it.value().toUtf8() );
+    hash.addData( "&", 1 );
+  }
+
+  hash.addData( request.url().path().toUtf8() );
+  hash.addData( cacheKey.join( '\n' ).toUtf8() );
+
+  // the representation also depends on the negotiated format and on the URLs advertised
+  // in the response, which are built from the host and proxy headers
+  QMap<QString, QString> representationHeaders;
+  const QMap<QString, QString> headers = request.headers();
+  for ( auto it = headers.constBegin(); it != headers.constEnd(); ++it )
+  {
+    const QString name = it.key().toLower();
+    if ( name == QLatin1String( "accept" ) || name == QLatin1String( "host" ) || name == QLatin1String( "forwarded" )
+         || name.startsWith( QLatin1String( "x-forwarded-" ) ) || name.startsWith( QLatin1String( "x-qgis-" ) ) )
+    {
+      representationHeaders.insert( name, it.value() );
+    }
+  }
+  for ( auto it = representationHeaders.constBegin(); it != representationHeaders.constEnd(); ++it )
+  {
+    hash.addData( it.key().toUtf8() );
+    hash.addData( ":", 1 );
+    hash.addData( it.value().toUtf8() );
+    hash.addData( "\n", 1 );
+  }
+
+  return QStringLiteral( "W/\"%1\"" ).arg( QString::fromLatin1( hash.result().toHex() ) );
+}
+
+bool QgsServerETag::matches( const QString &ifNoneMatch, const QString &etag )
+{
+  if ( ifNoneMatch.isEmpty() || etag.isEmpty() )
+  {
+    return false;
+  }
+
+  const QStringList tags = ifNoneMatch.split( ',', Qt::SkipEmptyParts );
+  const QString expected = normalizedTag( etag );
+  for ( const QString &tag : tags )
+  {
+    const QString candidate = normalizedTag( tag );
+    if ( candidate == QLatin1String( "*" ) || candidate == expected )
+    {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************
+                              qgsserveretag.h
+                              ---------------
+  begin                : 2023-10-16
+  copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERETAG_H
+#define QGSSERVERETAG_H
+
+#define SIP_NO_FILE
+
+#include <QString>
+#include <QStringList>
+
+#include "qgis_server.h"
+#include "qgsserverrequest.h"
+
+class QgsProject;
+
+/**
+ * \ingroup server
+ * \brief The QgsServerETag namespace provides entity tags used to answer
+ * conditional requests (If-None-Match) without processing them.
+ *
+ * The tag is derived from the project timestamp, the fingerprint of the data
+ * files of all the project layers, the normalized request parameters and the
+ * request headers the response depends on (Accept, Host, Forwarded, X-Forwarded-*
+ * and X-Qgis-*). No
+ * tag is computed when one of the layers is not backed by a local file (e.g.
+ * database or remote layers), as their content may change without notice.
+ *
+ * \since QGIS 3.34
+ */
+namespace QgsServerETag
+{
+
+  /**
+   * Returns a weak entity tag for the \a request on the \a project, or an
+   * empty string if the response cannot be validated.
+   *
+   * The optional \a cacheKey returned by the access control plugins is part
+   * of the tag, so that the responses filtered for different users do not share it.
+   */
+  SERVER_EXPORT QString computeETag( const QgsServerRequest &request, const QgsProject &project, const QStringList &cacheKey = QStringList() );
+
+  /**
+   * Returns a fingerprint of the data files of all the \a project layers,
+   * or an empty string if one of the layers is not backed by a local file.
+   *
+   * The data files of the layers are looked up once per project file and
+   * timestamp, only their modification time and size are read on each call.
+   */
+  SERVER_EXPORT QString layersFingerprint( const QgsProject &project );
+
+  /**
+   * Returns TRUE if the \a ifNoneMatch header value matches the \a etag,
+   * using the weak comparison function.
+   */
+  SERVER_EXPORT bool matches( const QString &ifNoneMatch, const QString &etag );
+
+};
+
+#endif
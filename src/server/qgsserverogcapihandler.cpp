@@ -179,22 +179,54 @@ std::string QgsServerOgcApiHandler::href( const QgsServerApiContext &context, co
 
 }
 
-void QgsServerOgcApiHandler::jsonDump( json &data, const QgsServerApiContext &context, const QString &contentType ) const
+///@cond PRIVATE
+namespace
 {
-  // Do not append timestamp to openapi
-  if ( ! QgsServerOgcApi::contentTypeMimes().value( QgsServerOgcApi::ContentType::OPENAPI3 ).contains( contentType, Qt::CaseSensitivity::CaseInsensitive ) )
+
+  void addTimeStamp( json &data )
   {
     QDateTime time { QDateTime::currentDateTime() };
     time.setTimeSpec( Qt::TimeSpec::UTC );
     data["timeStamp"] = time.toString( Qt::DateFormat::ISODate ).toStdString() ;
   }
-  context.response()->setStatusCode( 200 );
-  context.response()->setHeader( QStringLiteral( "Content-Type" ), contentType );
+
+  std::string dumpJson( const json &data )
+  {
 #ifdef QGISDEBUG
-  context.response()->write( data.dump( 2 ) );
+    return data.dump( 2 );
 #else
-  context.response()->write( data.dump( ) );
+    return data.dump( );
 #endif
+  }
+
+}
+///@endcond
+
+void QgsServerOgcApiHandler::jsonDump( json &data, const QgsServerApiContext &context, const QString &contentType ) const
+{
+  // Do not append timestamp to openapi
+  if ( ! QgsServerOgcApi::contentTypeMimes().value( QgsServerOgcApi::ContentType::OPENAPI3 ).contains( contentType, Qt::CaseSensitivity::CaseInsensitive ) )
+  {
+    addTimeStamp( data );
+  }
+  context.response()->setStatusCode( 200 );
+  context.response()->setHeader( QStringLiteral( "Content-Type" ), contentType );
+  context.response()->write( dumpJson( data ) );
+}
+
+void QgsServerOgcApiHandler::jsonStreamBegin( const std::string &head, const QgsServerApiContext &context, const QString &contentType ) const
+{
+  context.response()->setStatusCode( 200 );
+  context.response()->setHeader( QStringLiteral( "Content-Type" ), contentType );
+  context.response()->write( head );
+}
+
+void QgsServerOgcApiHandler::jsonStreamEnd( json &data, const QgsServerApiContext &context ) const
+{
+  addTimeStamp( data );
+  // The members of data follow the streamed member: drop the opening brace
+  const std::string members { dumpJson( data ) };
+  context.response()->write( ',' + members.substr( 1 ) );
 }
 
 json QgsServerOgcApiHandler::schema( const QgsServerApiContext &context ) const
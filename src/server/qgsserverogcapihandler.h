@@ -233,6 +233,25 @@ class SERVER_EXPORT QgsServerOgcApiHandler
      */
     void jsonDump( json &data, const QgsServerApiContext &context, const QString &contentType = QStringLiteral( "application/json" ) ) const;
 
+    /**
+     * Starts a JSON object whose first member is streamed to the \a context response:
+     * sets the status and \a contentType of the response and writes \a head, the
+     * beginning of the object. The object must be completed with jsonStreamEnd().
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.34
+     */
+    void jsonStreamBegin( const std::string &head, const QgsServerApiContext &context, const QString &contentType = QStringLiteral( "application/json" ) ) const;
+
+    /**
+     * Completes a JSON object started with jsonStreamBegin() by writing the members
+     * of \a data to the \a context response, the timestamp is added as in jsonDump().
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.34
+     */
+    void jsonStreamEnd( json &data, const QgsServerApiContext &context ) const;
+
     /**
      * Writes \a data as HTML to the response stream in \a context using a template.
      *
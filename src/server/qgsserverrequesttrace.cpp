@@ -0,0 +1,106 @@
+/***************************************************************************
+                          qgsserverrequesttrace.cpp
+
+  Per request performance trace
+  -------------------
+  begin                : 2023-10-16
+  copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsserverrequesttrace.h"
+#include "qgsapplication.h"
+#include "qgsruntimeprofiler.h"
+#include "qgsserverrequest.h"
+#include "qgsserverparameters.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+
+#include <functional>
+
+QgsServerRequestTrace::QgsServerRequestTrace( const QString &group )
+{
+  QgsRuntimeProfiler *profiler = QgsApplication::profiler();
+
+  std::function< void( const QModelIndex &, const QStringList & ) > collect;
+  collect = [ this, profiler, &collect ]( const QModelIndex & index, const QStringList & parentPath )
+  {
+    Step step;
+    step.path = parentPath;
+    step.path << profiler->data( index, QgsRuntimeProfilerNode::Roles::Name ).toString();
+    step.elapsed = profiler->data( index, QgsRuntimeProfilerNode::Roles::Elapsed ).toDouble() * 1000.0;
+    mSteps << step;
+
+    for ( int row = 0; row < profiler->rowCount( index ); ++row )
+    {
+      collect( profiler->index( row, 0, index ), step.path );
+    }
+  };
+
+  for ( int row = 0; row < profiler->rowCount(); ++row )
+  {
+    const QModelIndex index = profiler->index( row, 0 );
+    if ( profiler->data( index, QgsRuntimeProfilerNode::Roles::Group ).toString() == group )
+    {
+      collect( index, QStringList() );
+    }
+  }
+}
+
+QString QgsServerRequestTrace::serverTimingHeader( double total ) const
+{
+  const thread_local QRegularExpression nonTokenChars( QStringLiteral( "[^a-z0-9]+" ) );
+
+  QStringList metrics;
+  int stepIndex = 0;
+  for ( const Step &step : mSteps )
+  {
+    // the top level step is still running when the header is sent, it is reported as the total
+    if ( step.path.size() < 2 )
+      continue;
+
+    const QString name = QStringLiteral( "s%1-%2" ).arg( ++stepIndex ).arg( step.path.last().toLower().replace( nonTokenChars, QStringLiteral( "-" ) ) );
+    QString description = step.path.mid( 1 ).join( QLatin1String( " / " ) );
+    description.replace( '\\', QLatin1String( "\\\\" ) ).replace( '"', QLatin1String( "\\\"" ) );
+    metrics << QStringLiteral( "%1;dur=%2;desc=\"%3\"" ).arg( name, QString::number( step.elapsed, 'f', 1 ), description );
+  }
+
+  metrics << QStringLiteral( "total;dur=%1" ).arg( QString::number( total, 'f', 1 ) );
+  return metrics.join( QLatin1String( ", " ) );
+}
+
+QString QgsServerRequestTrace::toJson( const QgsServerRequest &request, double total ) const
+{
+  QJsonArray steps;
+  for ( const Step &step : mSteps )
+  {
+    steps.append( QJsonObject
+    {
+      { QStringLiteral( "path" ), QJsonArray::fromStringList( step.path ) },
+      { QStringLiteral( "ms" ), step.elapsed },
+    } );
+  }
+
+  const QgsServerParameters parameters = request.serverParameters();
+  const QJsonObject trace
+  {
+    { QStringLiteral( "url" ), request.url().toString() },
+    { QStringLiteral( "service" ), parameters.service() },
+    { QStringLiteral( "request" ), parameters.request() },
+    { QStringLiteral( "total_ms" ), total },
+    { QStringLiteral( "steps" ), steps },
+  };
+
+  return QString::fromUtf8( QJsonDocument( trace ).toJson( QJsonDocument::Compact ) );
+}
@@ -0,0 +1,85 @@
+/***************************************************************************
+                          qgsserverrequesttrace.h
+
+  Per request performance trace
+  -------------------
+  begin                : 2023-10-16
+  copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSSERVERREQUESTTRACE_H
+#define QGSSERVERREQUESTTRACE_H
+
+#define SIP_NO_FILE
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "qgis_server.h"
+
+class QgsServerRequest;
+
+/**
+ * \ingroup server
+ * \class QgsServerRequestTrace
+ * \brief Snapshot of the timings recorded by the runtime profiler while
+ * handling a request.
+ *
+ * The server records its processing steps (project load, access control
+ * filters, per layer rendering, labeling, encoding, output writing...) in the
+ * "server" group of QgsApplication::profiler(). This class flattens that tree
+ * and formats it as a W3C Server-Timing response header or as a single JSON
+ * log line.
+ *
+ * \since QGIS 3.34
+ */
+class SERVER_EXPORT QgsServerRequestTrace
+{
+  public:
+
+    //! A profiled step of the request
+    struct Step
+    {
+      //! Step names, from the outermost step to this one
+      QStringList path;
+      //! Elapsed time in milliseconds
+      double elapsed = 0;
+    };
+
+    /**
+     * Constructor for QgsServerRequestTrace, takes a snapshot of the
+     * profiler \a group.
+     */
+    explicit QgsServerRequestTrace( const QString &group = QStringLiteral( "server" ) );
+
+    /**
+     * Returns the profiled steps, in depth first order.
+     */
+    QList<QgsServerRequestTrace::Step> steps() const { return mSteps; }
+
+    /**
+     * Returns the value of a Server-Timing header for the steps nested in the
+     * top level step, followed by the \a total time (in milliseconds) of the request.
+     */
+    QString serverTimingHeader( double total ) const;
+
+    /**
+     * Returns the trace as a compact JSON document for the \a request,
+     * with the \a total time (in milliseconds) of the request.
+     */
+    QString toJson( const QgsServerRequest &request, double total ) const;
+
+  private:
+    QList<QgsServerRequestTrace::Step> mSteps;
+};
+
+#endif
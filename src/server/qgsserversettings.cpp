@@ -398,6 +398,86 @@ void QgsServerSettings::initSettings()
                                            QVariant()
                                          };
   mSettings[ sCapabilitiesCacheSize.envVar ] = sCapabilitiesCacheSize;
+
+  const Setting sWmsPng8Quantizer = { QgsServerSettingsEnv::QGIS_SERVER_WMS_PNG8_QUANTIZER,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      QStringLiteral( "Color quantization method for 8 bit PNG output. Possible values are 'mediancut' or 'octree'" ),
+                                      QStringLiteral( "/qgis/server_wms_png8_quantizer" ),
+                                      QVariant::String,
+                                      QVariant( "mediancut" ),
+                                      QVariant()
+                                    };
+  mSettings[ sWmsPng8Quantizer.envVar ] = sWmsPng8Quantizer;
+
+  const Setting sWmsPng8Dithering = { QgsServerSettingsEnv::QGIS_SERVER_WMS_PNG8_DITHERING,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      QStringLiteral( "Use error diffusion dithering for 8 bit PNG output" ),
+                                      QStringLiteral( "/qgis/server_wms_png8_dithering" ),
+                                      QVariant::Bool,
+                                      QVariant( false ),
+                                      QVariant()
+                                    };
+  mSettings[ sWmsPng8Dithering.envVar ] = sWmsPng8Dithering;
+
+  const Setting sResponseCompression = { QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_COMPRESSION,
+                                         QgsServerSettingsEnv::DEFAULT_VALUE,
+                                         QStringLiteral( "Compress text based responses according to the Accept-Encoding request header" ),
+                                         QStringLiteral( "/qgis/server_response_compression" ),
+                                         QVariant::Bool,
+                                         QVariant( false ),
+                                         QVariant()
+                                       };
+  mSettings[ sResponseCompression.envVar ] = sResponseCompression;
+
+  const Setting sEtag = { QgsServerSettingsEnv::QGIS_SERVER_ETAG,
+                          QgsServerSettingsEnv::DEFAULT_VALUE,
+                          QStringLiteral( "Send ETag headers and answer If-None-Match conditional requests" ),
+                          QStringLiteral( "/qgis/server_etag" ),
+                          QVariant::Bool,
+                          QVariant( false ),
+                          QVariant()
+                        };
+  mSettings[ sEtag.envVar ] = sEtag;
+
+  const Setting sTraceHeader = { QgsServerSettingsEnv::QGIS_SERVER_TRACE_HEADER,
+                                 QgsServerSettingsEnv::DEFAULT_VALUE,
+                                 QStringLiteral( "Add a Server-Timing header with the time taken by the processing steps of each request" ),
+                                 QStringLiteral( "/qgis/server_trace_header" ),
+                                 QVariant::Bool,
+                                 QVariant( false ),
+                                 QVariant()
+                               };
+  mSettings[ sTraceHeader.envVar ] = sTraceHeader;
+
+  const Setting sTraceLog = { QgsServerSettingsEnv::QGIS_SERVER_TRACE_LOG,
+                              QgsServerSettingsEnv::DEFAULT_VALUE,
+                              QStringLiteral( "Log a JSON line with the time taken by the processing steps of each request" ),
+                              QStringLiteral( "/qgis/server_trace_log" ),
+                              QVariant::Bool,
+                              QVariant( false ),
+                              QVariant()
+                            };
+  mSettings[ sTraceLog.envVar ] = sTraceLog;
+
+  const Setting sWmsFootprintCacheSize = { QgsServerSettingsEnv::QGIS_SERVER_WMS_FOOTPRINT_CACHE_SIZE,
+                                           QgsServerSettingsEnv::DEFAULT_VALUE,
+                                           QStringLiteral( "Number of rendered feature footprint indexes kept in memory" ),
+                                           QStringLiteral( "/qgis/server_wms_footprint_cache_size" ),
+                                           QVariant::Int,
+                                           QVariant( 0 ),
+                                           QVariant()
+                                         };
+  mSettings[ sWmsFootprintCacheSize.envVar ] = sWmsFootprintCacheSize;
+
+  const Setting sWmsFootprintCacheMaxFeatures = { QgsServerSettingsEnv::QGIS_SERVER_WMS_FOOTPRINT_CACHE_MAX_FEATURES,
+                                                  QgsServerSettingsEnv::DEFAULT_VALUE,
+                                                  QStringLiteral( "Maximum number of features of a layer for its rendered feature footprints to be indexed" ),
+                                                  QStringLiteral( "/qgis/server_wms_footprint_cache_max_features" ),
+                                                  QVariant::LongLong,
+                                                  QVariant( 1000000 ),
+                                                  QVariant()
+                                                };
+  mSettings[ sWmsFootprintCacheMaxFeatures.envVar ] = sWmsFootprintCacheMaxFeatures;
 }
 
 void QgsServerSettings::load()
@@ -729,3 +809,50 @@ int QgsServerSettings::capabilitiesCacheSize() const
   QgsMessageLog::logMessage( QStringLiteral( "Invalid capabilities cache size, expecting integer - defaulting to 40" ), "Server", Qgis::MessageLevel::Warning );
   return 40;
 }
+
+QString QgsServerSettings::wmsPng8Quantizer() const
+{
+  QString result = value( QgsServerSettingsEnv::QGIS_SERVER_WMS_PNG8_QUANTIZER ).toString().trimmed().toLower();
+  if ( result.compare( QLatin1String( "mediancut" ) ) &&
+       result.compare( QLatin1String( "octree" ) ) )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Invalid 8 bit PNG quantizer, expecting 'mediancut' or 'octree'. Using 'mediancut' as default." ), "Server", Qgis::MessageLevel::Warning );
+    result = QStringLiteral( "mediancut" );
+  }
+  return result;
+}
+
+bool QgsServerSettings::wmsPng8Dithering() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMS_PNG8_DITHERING ).toBool();
+}
+
+bool QgsServerSettings::responseCompression() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_COMPRESSION ).toBool();
+}
+
+bool QgsServerSettings::etag() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_ETAG ).toBool();
+}
+
+bool QgsServerSettings::traceHeader() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_TRACE_HEADER ).toBool();
+}
+
+bool QgsServerSettings::traceLog() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_TRACE_LOG ).toBool();
+}
+
+int QgsServerSettings::wmsFootprintCacheSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMS_FOOTPRINT_CACHE_SIZE ).toInt();
+}
+
+long long QgsServerSettings::wmsFootprintCacheMaxFeatures() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMS_FOOTPRINT_CACHE_MAX_FEATURES ).toLongLong();
+}
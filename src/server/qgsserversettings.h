@@ -83,6 +83,14 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_SERVER_ALLOWED_EXTRA_SQL_TOKENS, //! Adds these tokens to the list of allowed tokens that the services accept when filtering features (since QGIS 3.28).
       QGIS_SERVER_APPLICATION_NAME, //! Define the QGIS Server application name (since QGIS 3.30).
       QGIS_SERVER_CAPABILITIES_CACHE_SIZE, //! Define the QGIS Server capabilities cache size (since QGIS 3.31)
+      QGIS_SERVER_WMS_PNG8_QUANTIZER, //! Color quantization method used for 8 bit PNG output. Possible values are 'mediancut' or 'octree', default to 'mediancut' (since QGIS 3.34).
+      QGIS_SERVER_WMS_PNG8_DITHERING, //! Use error diffusion dithering when converting images to 8 bit PNG, default to FALSE (since QGIS 3.34).
+      QGIS_SERVER_RESPONSE_COMPRESSION, //! Compress text based responses according to the Accept-Encoding request header, default to FALSE (since QGIS 3.34).
+      QGIS_SERVER_ETAG, //! Send ETag headers and answer If-None-Match conditional requests with 304 Not Modified, default to FALSE (since QGIS 3.34).
+      QGIS_SERVER_TRACE_HEADER, //! Add a Server-Timing header with the time taken by the processing steps of each request, default to FALSE (since QGIS 3.34).
+      QGIS_SERVER_TRACE_LOG, //! Log a JSON line with the time taken by the processing steps of each request, default to FALSE (since QGIS 3.34).
+      QGIS_SERVER_WMS_FOOTPRINT_CACHE_SIZE, //! Number of rendered feature footprint indexes kept in memory to answer GetFeatureInfo requests, default to 0 (disabled) (since QGIS 3.34).
+      QGIS_SERVER_WMS_FOOTPRINT_CACHE_MAX_FEATURES, //! Maximum number of features of a layer for its rendered feature footprints to be indexed, default to 1000000 (since QGIS 3.34).
     };
     Q_ENUM( EnvVar )
 };
@@ -366,6 +374,91 @@ class SERVER_EXPORT QgsServerSettings
      */
     int capabilitiesCacheSize() const;
 
+    /**
+     * Returns the color quantization method used to build the palette of 8 bit PNG images.
+     * The default value is 'mediancut', the value can be changed by setting the environment
+     * variable QGIS_SERVER_WMS_PNG8_QUANTIZER.
+     * Possible values are:
+     *
+     * - 'mediancut': Median cut on the exact image histogram, best quality but slow on large images.
+     * - 'octree': Octree quantization with multithreaded pixel mapping, much faster on large images.
+     *
+     * \since QGIS 3.34
+     */
+    QString wmsPng8Quantizer() const;
+
+    /**
+     * Returns TRUE if error diffusion dithering is used when converting images to 8 bit PNG.
+     * The default value is FALSE, the value can be changed by setting the environment
+     * variable QGIS_SERVER_WMS_PNG8_DITHERING.
+     *
+     * \since QGIS 3.34
+     */
+    bool wmsPng8Dithering() const;
+
+    /**
+     * Returns TRUE if text based responses are compressed with gzip or deflate
+     * when the client advertises it in the Accept-Encoding header.
+     * The default value is FALSE, the value can be changed by setting the environment
+     * variable QGIS_SERVER_RESPONSE_COMPRESSION.
+     *
+     * \since QGIS 3.34
+     */
+    bool responseCompression() const;
+
+    /**
+     * Returns TRUE if ETag headers are sent and conditional requests are answered
+     * with 304 Not Modified when the project and the layer data files did not change.
+     * The default value is FALSE, the value can be changed by setting the environment
+     * variable QGIS_SERVER_ETAG.
+     *
+     * \since QGIS 3.34
+     */
+    bool etag() const;
+
+    /**
+     * Returns TRUE if a Server-Timing header detailing the time taken by the
+     * processing steps (project load, access control, per layer rendering,
+     * labeling, encoding...) is added to each response.
+     * The default value is FALSE, the value can be changed by setting the environment
+     * variable QGIS_SERVER_TRACE_HEADER.
+     *
+     * \since QGIS 3.34
+     */
+    bool traceHeader() const;
+
+    /**
+     * Returns TRUE if a JSON line detailing the time taken by the processing
+     * steps of each request is written to the logs, whatever the log level.
+     * The default value is FALSE, the value can be changed by setting the environment
+     * variable QGIS_SERVER_TRACE_LOG.
+     *
+     * \since QGIS 3.34
+     */
+    bool traceLog() const;
+
+    /**
+     * Returns the maximum number of rendered feature footprint indexes kept in
+     * memory. Each index is built for a vector layer, a style and a scale and
+     * is used to answer GetFeatureInfo requests without evaluating the renderer
+     * of every feature in the search area.
+     * The default value is 0, which disables the cache, the value can be changed
+     * by setting the environment variable QGIS_SERVER_WMS_FOOTPRINT_CACHE_SIZE.
+     *
+     * \since QGIS 3.34
+     */
+    int wmsFootprintCacheSize() const;
+
+    /**
+     * Returns the maximum number of features of a layer for its rendered feature
+     * footprints to be indexed. Larger layers are always queried from their data provider.
+     * The default value is 1000000, the value can be changed by setting the environment
+     * variable QGIS_SERVER_WMS_FOOTPRINT_CACHE_MAX_FEATURES.
+     *
+     * \since QGIS 3.34
+     */
+    long long wmsFootprintCacheMaxFeatures() const;
+
   private:
     void initSettings();
     QVariant value( QgsServerSettingsEnv::EnvVar envVar, bool actual = false ) const;
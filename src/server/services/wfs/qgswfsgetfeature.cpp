@@ -36,6 +36,7 @@
 #include "qgsjsonutils.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgswkbtypes.h"
+#include "qgsruntimeprofiler.h"
 
 #include "qgswfsgetfeature.h"
 
@@ -231,6 +232,8 @@ namespace QgsWfs
         throw QgsRequestNotWellFormedException( QStringLiteral( "TypeName '%1' layer error" ).arg( typeName ) );
       }
 
+      const QgsScopedRuntimeProfile layerProfile { QStringLiteral( "Fetch features: %1" ).arg( typeName ), QStringLiteral( "server" ) };
+
       //test provider
       QgsVectorDataProvider *provider = vlayer->dataProvider();
       if ( !provider )
@@ -42,6 +42,38 @@
 #include "qgsaccesscontrol.h"
 #endif
 
+///@cond PRIVATE
+namespace
+{
+
+  // Size of the streamed GeoJSON buffered before it is flushed to the client
+  constexpr int STREAM_FLUSH_SIZE = 1024 * 1024;
+
+  // Keyset pagination cursors are the base64url encoded primary key of the last feature of the previous page
+  QString encodeCursor( const QVariant &key )
+  {
+    return QString::fromLatin1( key.toString().toUtf8().toBase64( QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals ) );
+  }
+
+  QVariant decodeCursor( const QString &cursor, const QgsField &pkField )
+  {
+    const QByteArray::FromBase64Result decoded { QByteArray::fromBase64Encoding( cursor.toLatin1(), QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals | QByteArray::AbortOnBase64DecodingErrors ) };
+    if ( ! decoded )
+    {
+      return QVariant();
+    }
+
+    QVariant key { QString::fromUtf8( decoded.decoded ) };
+    if ( ! pkField.convertCompatible( key ) || key.isNull() )
+    {
+      return QVariant();
+    }
+    return key;
+  }
+
+}
+///@endcond
+
 
 QgsWfs3APIHandler::QgsWfs3APIHandler( const QgsServerOgcApi *api ):
   mApi( api )
@@ -905,6 +937,12 @@ QList<QgsServerQueryStringParameter> QgsWfs3CollectionsItemsHandler::parameters(
 
   params.push_back( offset );
 
+  // Cursor
+  const QgsServerQueryStringParameter cursor { QStringLiteral( "cursor" ), false,
+      QgsServerQueryStringParameter::Type::String,
+      QStringLiteral( "Position of the page of features to retrieve, as provided by the 'next' link" ) };
+  params.push_back( cursor );
+
   // BBOX
   const QgsServerQueryStringParameter bbox { QStringLiteral( "bbox" ), false,
       QgsServerQueryStringParameter::Type::String,
@@ -1251,6 +1289,29 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
         }
       }
 
+      // Features which are not explicitly sorted are ordered by the primary key when the layer has a
+      // single attribute one, so that the pages of the offset and keyset paginations are the same.
+      // Keyset pagination is then used unless an offset is requested.
+      const QgsAttributeList pkAttributes { mapLayer->dataProvider()->pkAttributeIndexes() };
+      const bool orderByPk { sortBy.isEmpty() && pkAttributes.size() == 1 };
+      const bool keysetPagination { orderByPk && offset == 0 };
+
+      // Cursor
+      const QString cursor { params.value( QStringLiteral( "cursor" ) ).toString() };
+      QVariant cursorValue;
+      if ( ! cursor.isEmpty() )
+      {
+        if ( ! keysetPagination )
+        {
+          throw QgsServerApiBadRequestException( QStringLiteral( "cursor cannot be combined with offset or sortby" ) );
+        }
+        cursorValue = decodeCursor( cursor, mapLayer->fields().at( pkAttributes.first() ) );
+        if ( ! cursorValue.isValid() )
+        {
+          throw QgsServerApiBadRequestException( QStringLiteral( "cursor is not valid" ) );
+        }
+      }
+
       // ////////////////////////////////////////////////////////////////////////////////////////////////////
       // End of input control: inputs are valid, process the request
 
@@ -1307,46 +1368,122 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
 
       // WFS3 core specs only serves 4326
       featureRequest.setDestinationCrs( crs, context.project()->transformContext() );
-      // Add offset to limit because paging is not supported by QgsFeatureRequest
-      featureRequest.setLimit( limit + offset );
+
+      // Matching features are counted without paging
+      QgsFeatureRequest countRequest { featureRequest };
+
       QgsJsonExporter exporter { mapLayer };
       exporter.setAttributes( featureRequest.subsetOfAttributes() );
       exporter.setAttributeDisplayName( true );
       exporter.setSourceCrs( mapLayer->crs() );
       exporter.setTransformGeometries( false );
-      QgsFeatureList featureList;
+
+      if ( orderByPk )
+      {
+        const QString pkColumn { QgsExpression::quotedColumnRef( mapLayer->fields().at( pkAttributes.first() ).name() ) };
+        featureRequest.setOrderBy( { { { pkColumn, true } } } );
+      }
+
+      if ( keysetPagination )
+      {
+        // A page starts after the key of the last feature of the previous page: providers
+        // translate this into an indexed WHERE clause instead of skipping all the previous rows
+        const int pkIndex { pkAttributes.first() };
+        const QString pkColumn { QgsExpression::quotedColumnRef( mapLayer->fields().at( pkIndex ).name() ) };
+        if ( cursorValue.isValid() )
+        {
+          featureRequest.combineFilterExpression( QStringLiteral( "%1 > %2" ).arg( pkColumn, QgsExpression::quotedValue( cursorValue ) ) );
+        }
+        // The primary key is needed to build the next cursor
+        if ( featureRequest.flags().testFlag( QgsFeatureRequest::SubsetOfAttributes ) && ! featureRequest.subsetOfAttributes().contains( pkIndex ) )
+        {
+          featureRequest.setSubsetOfAttributes( featureRequest.subsetOfAttributes() << pkIndex );
+        }
+        // One more feature tells if there is a next page
+        featureRequest.setLimit( limit + 1 );
+      }
+      else
+      {
+        // Add offset to limit because paging is not supported by QgsFeatureRequest
+        featureRequest.setLimit( limit + offset );
+      }
+
+      // GeoJSON features are written to the response as they are fetched
+      const QgsServerOgcApi::ContentType contentType { contentTypeFromRequest( context.request() ) };
+      const bool streamFeatures { contentType == QgsServerOgcApi::ContentType::GEOJSON };
+      if ( streamFeatures )
+      {
+        jsonStreamBegin( R"({"type":"FeatureCollection","features":[)", context, QgsServerOgcApi::contentTypeMimes().value( contentType ).first() );
+      }
+
+      json featuresData = json::array();
       QgsFeatureIterator features { mapLayer->getFeatures( featureRequest ) };
       QgsFeature feat;
       long i { 0 };
-      QMap<QgsFeatureId, QString> fidMap;
+      long returnedFeaturesCount { 0 };
+      bool hasNextPage { false };
+      QVariant lastKey;
 
       while ( features.nextFeature( feat ) )
       {
         // Ignore records before offset
-        if ( i >= offset )
+        if ( i++ < offset )
+        {
+          continue;
+        }
+
+        if ( returnedFeaturesCount == limit )
+        {
+          hasNextPage = true;
+          break;
+        }
+
+        // Patch feature IDs with server feature IDs
+        json featureData = exporter.exportFeatureToJsonObject( feat );
+        featureData["id"] = QgsServerFeatureId::getServerFid( feat, pkAttributes ).toStdString();
+
+        if ( keysetPagination )
+        {
+          lastKey = feat.attribute( pkAttributes.first() );
+        }
+
+        if ( streamFeatures )
         {
-          fidMap.insert( feat.id(), QgsServerFeatureId::getServerFid( feat, mapLayer->dataProvider()->pkAttributeIndexes() ) );
-          featureList << feat;
+          context.response()->write( ( returnedFeaturesCount > 0 ? "," : "" ) + featureData.dump() );
+          // Send large pages in chunks, smaller ones are left to the response compression
+          if ( context.response()->data().size() >= STREAM_FLUSH_SIZE )
+          {
+            context.response()->flush();
+          }
+        }
+        else
+        {
+          featuresData.push_back( std::move( featureData ) );
         }
-        i++;
+        returnedFeaturesCount++;
       }
 
-      // Count features
+      // Count features, counting the filtered features of each page of a harvest
+      // would make it quadratic so they are only counted on the first page
       long matchedFeaturesCount = 0;
       if ( attrFilters.isEmpty() && filterRect.isNull() )
       {
         matchedFeaturesCount = mapLayer->featureCount();
       }
+      else if ( cursorValue.isValid() )
+      {
+        matchedFeaturesCount = -1;
+      }
       else
       {
         if ( filterExpression.isEmpty() )
         {
-          featureRequest.setNoAttributes();
+          countRequest.setNoAttributes();
         }
 
-        featureRequest.setFlags( QgsFeatureRequest::Flag::NoGeometry );
-        featureRequest.setLimit( -1 );
-        features = mapLayer->getFeatures( featureRequest );
+        countRequest.setFlags( QgsFeatureRequest::Flag::NoGeometry );
+        countRequest.setLimit( -1 );
+        features = mapLayer->getFeatures( countRequest );
 
         while ( features.nextFeature( feat ) )
         {
@@ -1354,27 +1491,30 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
         }
       }
 
-      json data = exporter.exportFeaturesToJsonObject( featureList );
-
-      // Patch feature IDs with server feature IDs
-      for ( int i = 0; i < featureList.length(); i++ )
+      json data;
+      if ( ! streamFeatures )
       {
-        data[ "features" ][ i ]["id"] = fidMap.value( data[ "features" ][ i ]["id"] ).toStdString();
+        data["type"] = "FeatureCollection";
+        data["features"] = std::move( featuresData );
       }
 
       // Add some metadata
-      data["numberMatched"] = matchedFeaturesCount;
-      data["numberReturned"] = featureList.count();
+      if ( matchedFeaturesCount >= 0 )
+      {
+        data["numberMatched"] = matchedFeaturesCount;
+      }
+      data["numberReturned"] = returnedFeaturesCount;
       data["links"] = links( context );
 
       // Current url
       const QUrl url { context.request()->url() };
 
-      // Url without offset and limit
+      // Url without offset, limit and cursor
       QUrl cleanedUrl { url };
       QUrlQuery query( cleanedUrl );
       query.removeQueryItem( QStringLiteral( "limit" ) );
       query.removeQueryItem( QStringLiteral( "offset" ) );
+      query.removeQueryItem( QStringLiteral( "cursor" ) );
       cleanedUrl.setQuery( query );
 
       QString cleanedUrlAsString { cleanedUrl.toString() };
@@ -1445,7 +1585,7 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
 
       if ( limit != 0 )
       {
-        // Add prev - next links
+        // Add prev - next links, keyset pagination only goes forward
         json prevLink;
         if ( offset != 0 )
         {
@@ -1457,17 +1597,24 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
         }
 
         json nextLink;
-        if ( limit + offset < matchedFeaturesCount )
+        if ( keysetPagination ? hasNextPage : limit + offset < matchedFeaturesCount )
         {
           nextLink = selfLink;
-          nextLink["href"] = cleanedUrlAsString.toStdString() + QStringLiteral( "offset=%1&limit=%2" ).arg( std::min<long>( matchedFeaturesCount, limit + offset ) ).arg( limit ).toStdString();
+          if ( keysetPagination )
+          {
+            nextLink["href"] = cleanedUrlAsString.toStdString() + QStringLiteral( "cursor=%1&limit=%2" ).arg( encodeCursor( lastKey ) ).arg( limit ).toStdString();
+          }
+          else
+          {
+            nextLink["href"] = cleanedUrlAsString.toStdString() + QStringLiteral( "offset=%1&limit=%2" ).arg( std::min<long>( matchedFeaturesCount, limit + offset ) ).arg( limit ).toStdString();
+          }
           nextLink["rel"] = "next";
           nextLink["title"] = "Next page";
           data["links"].push_back( nextLink );
         }
 
-        // Pagination
-        if ( matchedFeaturesCount - limit > 0 )
+        // Pagination, the page number of a cursor is unknown
+        if ( ! cursorValue.isValid() && matchedFeaturesCount - limit > 0 )
         {
           const int totalPages { static_cast<int>( std::ceil( static_cast<float>( matchedFeaturesCount ) / static_cast<float>( limit ) ) ) };
           const int currentPage { static_cast<int>( offset / limit + 1 ) };
@@ -1530,6 +1677,14 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
         }
       }
 
+      if ( streamFeatures )
+      {
+        // Close the features array and append the other members of the collection
+        context.response()->write( std::string( "]" ) );
+        jsonStreamEnd( data, context );
+        break;
+      }
+
       json navigation = json::array();
       navigation.push_back( {{ "title",  "Landing page" }, { "href", parentLink( url, 3 ).toStdString() }} ) ;
       navigation.push_back( {{ "title",  "Collections" }, { "href", parentLink( url, 2 ).toStdString() }} ) ;
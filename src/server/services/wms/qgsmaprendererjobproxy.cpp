@@ -21,6 +21,7 @@
 #include "qgsmaprendererparalleljob.h"
 #include "qgsmaprenderercustompainterjob.h"
 #include "qgsapplication.h"
+#include "qgsruntimeprofiler.h"
 
 namespace QgsWms
 {
@@ -72,6 +73,7 @@ namespace QgsWms
       }
 
       mErrors = renderJob.errors();
+      recordRenderingTimes( renderJob );
     }
     else
     {
@@ -82,6 +84,23 @@ namespace QgsWms
 #endif
       renderJob.renderSynchronously();
       mErrors = renderJob.errors();
+      recordRenderingTimes( renderJob );
+    }
+  }
+
+  void QgsMapRendererJobProxy::recordRenderingTimes( const QgsMapRendererJob &job ) const
+  {
+    // layers are rendered in worker threads, report their timings to the server profile
+    QgsRuntimeProfiler *profiler = QgsApplication::profiler();
+    const QHash< QgsMapLayer *, int > layerTimes = job.perLayerRenderingTime();
+    for ( auto it = layerTimes.constBegin(); it != layerTimes.constEnd(); ++it )
+    {
+      profiler->record( QStringLiteral( "Render layer: %1" ).arg( it.key()->name() ), it.value() / 1000.0, QStringLiteral( "server" ) );
+    }
+
+    if ( job.labelingRenderingTime() >= 0 )
+    {
+      profiler->record( QStringLiteral( "Labeling" ), job.labelingRenderingTime() / 1000.0, QStringLiteral( "server" ) );
     }
   }
 
@@ -75,6 +75,9 @@ namespace QgsWms
 
       void getRenderErrors( const QgsMapRendererJob *job );
 
+      //! Records per layer and labeling rendering times in the server profile
+      void recordRenderingTimes( const QgsMapRendererJob &job ) const;
+
       //! Layer id / error message
       QgsMapRendererJob::Errors mErrors;
   };
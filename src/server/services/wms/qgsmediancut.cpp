@@ -41,16 +41,23 @@ namespace QgsWms
       const int height = image.height();
 
       const QRgb *currentScanLine = nullptr;
-      QHash<QRgb, int>::iterator colorIt;
+      QHash<QRgb, int>::iterator colorIt = colors.end();
       for ( int i = 0; i < height; ++i )
       {
-        currentScanLine = ( const QRgb * )( image.scanLine( i ) );
+        currentScanLine = ( const QRgb * )( image.constScanLine( i ) );
         for ( int j = 0; j < width; ++j )
         {
+          // rendered maps contain long runs of identical pixels, avoid hashing them again
+          if ( colorIt != colors.end() && colorIt.key() == currentScanLine[j] )
+          {
+            colorIt.value()++;
+            continue;
+          }
+
           colorIt = colors.find( currentScanLine[j] );
           if ( colorIt == colors.end() )
           {
-            colors.insert( currentScanLine[j], 1 );
+            colorIt = colors.insert( currentScanLine[j], 1 );
           }
           else
           {
@@ -0,0 +1,387 @@
+/***************************************************************************
+                              qgsoctreequantizer.cpp
+                              -------------------------
+  begin                : October 2023
+  copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsoctreequantizer.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <limits>
+
+namespace QgsWms
+{
+
+  namespace
+  {
+    // below this number of pixels the thread pool overhead is not worth it
+    constexpr int PARALLEL_PIXELS_THRESHOLD = 256 * 256;
+    constexpr int ROWS_PER_TASK = 32;
+
+    inline QRgb normalizedColor( QRgb color )
+    {
+      // fully transparent pixels all share the same palette entry
+      return qAlpha( color ) == 0 ? 0 : color;
+    }
+
+    inline int childIndex( int red, int green, int blue, int alpha, int level )
+    {
+      const int shift = 7 - level;
+      return ( ( ( red >> shift ) & 1 ) << 3 )
+             | ( ( ( green >> shift ) & 1 ) << 2 )
+             | ( ( ( blue >> shift ) & 1 ) << 1 )
+             | ( ( alpha >> shift ) & 1 );
+    }
+  } // namespace
+
+  QgsOctreeQuantizer::QgsOctreeQuantizer( const QImage &image, int maxColors )
+  {
+    const QImage argbImage = image.format() == QImage::Format_ARGB32 ? image : image.convertToFormat( QImage::Format_ARGB32 );
+
+    createNode( 0 );
+
+    const int width = argbImage.width();
+    const int height = argbImage.height();
+    for ( int i = 0; i < height; ++i )
+    {
+      const QRgb *scanLine = reinterpret_cast< const QRgb * >( argbImage.constScanLine( i ) );
+
+      // rendered maps contain long runs of identical pixels, only walk the tree once per run
+      QRgb runColor = 0;
+      quint64 runLength = 0;
+      for ( int j = 0; j < width; ++j )
+      {
+        const QRgb color = normalizedColor( scanLine[j] );
+        if ( runLength > 0 && color == runColor )
+        {
+          ++runLength;
+          continue;
+        }
+
+        if ( runLength > 0 )
+          addColor( runColor, runLength );
+
+        runColor = color;
+        runLength = 1;
+      }
+
+      if ( runLength > 0 )
+        addColor( runColor, runLength );
+    }
+
+    reduce( std::max( 1, maxColors ) );
+    buildPalette();
+  }
+
+  int QgsOctreeQuantizer::createNode( int level )
+  {
+    const int index = static_cast< int >( mNodes.size() );
+    Node node;
+    node.children.fill( -1 );
+    node.isLeaf = level == MAX_DEPTH;
+    mNodes.push_back( node );
+
+    if ( node.isLeaf )
+      ++mLeafCount;
+    else
+      mReducibleNodes[level].push_back( index );
+
+    return index;
+  }
+
+  void QgsOctreeQuantizer::addColor( QRgb color, quint64 count )
+  {
+    const int red = qRed( color );
+    const int green = qGreen( color );
+    const int blue = qBlue( color );
+    const int alpha = qAlpha( color );
+
+    int node = 0;
+    for ( int level = 0; level < MAX_DEPTH; ++level )
+    {
+      mNodes[node].pixelCount += count;
+
+      const int index = childIndex( red, green, blue, alpha, level );
+      int child = mNodes[node].children[index];
+      if ( child < 0 )
+      {
+        // createNode() may reallocate mNodes, do not keep references across it
+        child = createNode( level + 1 );
+        mNodes[node].children[index] = child;
+      }
+      node = child;
+    }
+
+    Node &leaf = mNodes[node];
+    leaf.red += red * count;
+    leaf.green += green * count;
+    leaf.blue += blue * count;
+    leaf.alpha += alpha * count;
+    leaf.pixelCount += count;
+  }
+
+  void QgsOctreeQuantizer::reduce( int maxColors )
+  {
+    // least populated nodes are merged first: sort in descending order and pop from the back
+    for ( std::vector<int> &nodes : mReducibleNodes )
+    {
+      std::sort( nodes.begin(), nodes.end(), [this]( int a, int b )
+      {
+        return mNodes[a].pixelCount > mNodes[b].pixelCount;
+      } );
+    }
+
+    int level = MAX_DEPTH - 1;
+    while ( mLeafCount > maxColors && level >= 0 )
+    {
+      std::vector<int> &nodes = mReducibleNodes[level];
+      if ( nodes.empty() )
+      {
+        // deeper levels are always reduced first, so children of the next
+        // reduced nodes are guaranteed to be leaves
+        --level;
+        continue;
+      }
+
+      Node &node = mNodes[nodes.back()];
+      nodes.pop_back();
+
+      int mergedLeaves = 0;
+      for ( int &child : node.children )
+      {
+        if ( child < 0 )
+          continue;
+
+        const Node &leaf = mNodes[child];
+        node.red += leaf.red;
+        node.green += leaf.green;
+        node.blue += leaf.blue;
+        node.alpha += leaf.alpha;
+        ++mergedLeaves;
+        child = -1;
+      }
+
+      node.isLeaf = true;
+      mLeafCount -= mergedLeaves - 1;
+    }
+  }
+
+  void QgsOctreeQuantizer::buildPalette()
+  {
+    mColorTable.clear();
+    mColorTable.reserve( mLeafCount );
+
+    std::vector<int> stack { 0 };
+    while ( !stack.empty() )
+    {
+      const int index = stack.back();
+      stack.pop_back();
+
+      Node &node = mNodes[index];
+      if ( node.isLeaf )
+      {
+        if ( node.pixelCount == 0 )
+          continue;
+
+        const quint64 halfCount = node.pixelCount / 2;
+        node.paletteIndex = mColorTable.size();
+        mColorTable.append( qRgba( static_cast< int >( ( node.red + halfCount ) / node.pixelCount ),
+                                   static_cast< int >( ( node.green + halfCount ) / node.pixelCount ),
+                                   static_cast< int >( ( node.blue + halfCount ) / node.pixelCount ),
+                                   static_cast< int >( ( node.alpha + halfCount ) / node.pixelCount ) ) );
+        continue;
+      }
+
+      for ( const int child : node.children )
+      {
+        if ( child >= 0 )
+          stack.push_back( child );
+      }
+    }
+
+    mPaletteRed.resize( mColorTable.size() );
+    mPaletteGreen.resize( mColorTable.size() );
+    mPaletteBlue.resize( mColorTable.size() );
+    mPaletteAlpha.resize( mColorTable.size() );
+    for ( int i = 0; i < mColorTable.size(); ++i )
+    {
+      mPaletteRed[i] = qRed( mColorTable[i] );
+      mPaletteGreen[i] = qGreen( mColorTable[i] );
+      mPaletteBlue[i] = qBlue( mColorTable[i] );
+      mPaletteAlpha[i] = qAlpha( mColorTable[i] );
+    }
+  }
+
+  int QgsOctreeQuantizer::paletteIndex( QRgb color ) const
+  {
+    const int red = qRed( color );
+    const int green = qGreen( color );
+    const int blue = qBlue( color );
+    const int alpha = qAlpha( color );
+
+    int node = 0;
+    for ( int level = 0; level <= MAX_DEPTH; ++level )
+    {
+      const Node &current = mNodes[node];
+      if ( current.isLeaf )
+        return current.paletteIndex;
+
+      node = current.children[ childIndex( red, green, blue, alpha, level ) ];
+      if ( node < 0 )
+        break;
+    }
+
+    // only reached for colors which were not part of the input image (i.e. dithered colors)
+    return nearestIndex( red, green, blue, alpha );
+  }
+
+  int QgsOctreeQuantizer::nearestIndex( int red, int green, int blue, int alpha ) const
+  {
+    const int count = static_cast< int >( mPaletteRed.size() );
+    const int *paletteRed = mPaletteRed.data();
+    const int *paletteGreen = mPaletteGreen.data();
+    const int *paletteBlue = mPaletteBlue.data();
+    const int *paletteAlpha = mPaletteAlpha.data();
+
+    int bestIndex = 0;
+    int bestDistance = std::numeric_limits<int>::max();
+    for ( int i = 0; i < count; ++i )
+    {
+      const int dr = paletteRed[i] - red;
+      const int dg = paletteGreen[i] - green;
+      const int db = paletteBlue[i] - blue;
+      const int da = paletteAlpha[i] - alpha;
+      const int distance = dr * dr + dg * dg + db * db + da * da;
+      if ( distance < bestDistance )
+      {
+        bestDistance = distance;
+        bestIndex = i;
+      }
+    }
+    return bestIndex;
+  }
+
+  void QgsOctreeQuantizer::mapRows( const uchar *source, qsizetype sourceStride, uchar *destination, qsizetype destinationStride, int width, int firstRow, int lastRow ) const
+  {
+    for ( int i = firstRow; i < lastRow; ++i )
+    {
+      const QRgb *sourceLine = reinterpret_cast< const QRgb * >( source + i * sourceStride );
+      uchar *destinationLine = destination + i * destinationStride;
+
+      QRgb previousColor = 0;
+      int previousIndex = -1;
+      for ( int j = 0; j < width; ++j )
+      {
+        const QRgb color = normalizedColor( sourceLine[j] );
+        if ( previousIndex < 0 || color != previousColor )
+        {
+          previousColor = color;
+          previousIndex = paletteIndex( color );
+        }
+        destinationLine[j] = static_cast< uchar >( previousIndex );
+      }
+    }
+  }
+
+  void QgsOctreeQuantizer::mapDithered( const QImage &image, QImage &result ) const
+  {
+    const int width = image.width();
+    const int height = image.height();
+
+    // Floyd-Steinberg error buffers for the current and next rows, with one
+    // extra pixel on each side to avoid bound checks
+    std::vector<int> currentErrors( ( width + 2 ) * 3, 0 );
+    std::vector<int> nextErrors( ( width + 2 ) * 3, 0 );
+
+    for ( int i = 0; i < height; ++i )
+    {
+      const QRgb *sourceLine = reinterpret_cast< const QRgb * >( image.constScanLine( i ) );
+      uchar *destinationLine = result.scanLine( i );
+      std::fill( nextErrors.begin(), nextErrors.end(), 0 );
+
+      for ( int j = 0; j < width; ++j )
+      {
+        const QRgb color = normalizedColor( sourceLine[j] );
+        const int alpha = qAlpha( color );
+        if ( alpha == 0 )
+        {
+          // do not spread errors from or to fully transparent areas
+          destinationLine[j] = static_cast< uchar >( paletteIndex( color ) );
+          continue;
+        }
+
+        int *error = &currentErrors[( j + 1 ) * 3];
+        const int red = std::clamp( qRed( color ) + error[0] / 16, 0, 255 );
+        const int green = std::clamp( qGreen( color ) + error[1] / 16, 0, 255 );
+        const int blue = std::clamp( qBlue( color ) + error[2] / 16, 0, 255 );
+
+        const int index = paletteIndex( qRgba( red, green, blue, alpha ) );
+        destinationLine[j] = static_cast< uchar >( index );
+
+        const int quantizationError[3] = { red - mPaletteRed[index], green - mPaletteGreen[index], blue - mPaletteBlue[index] };
+        for ( int c = 0; c < 3; ++c )
+        {
+          currentErrors[( j + 2 ) * 3 + c] += quantizationError[c] * 7;
+          nextErrors[j * 3 + c] += quantizationError[c] * 3;
+          nextErrors[( j + 1 ) * 3 + c] += quantizationError[c] * 5;
+          nextErrors[( j + 2 ) * 3 + c] += quantizationError[c];
+        }
+      }
+
+      std::swap( currentErrors, nextErrors );
+    }
+  }
+
+  QImage QgsOctreeQuantizer::convertToIndexed8( const QImage &image, bool dither ) const
+  {
+    const QImage argbImage = image.format() == QImage::Format_ARGB32 ? image : image.convertToFormat( QImage::Format_ARGB32 );
+
+    QImage result( argbImage.size(), QImage::Format_Indexed8 );
+    result.setColorTable( mColorTable );
+
+    const int width = argbImage.width();
+    const int height = argbImage.height();
+
+    if ( dither )
+    {
+      mapDithered( argbImage, result );
+      return result;
+    }
+
+    // get raw pointers before dispatching to avoid concurrent calls to QImage::detach()
+    const uchar *source = argbImage.constBits();
+    const qsizetype sourceStride = argbImage.bytesPerLine();
+    uchar *destination = result.bits();
+    const qsizetype destinationStride = result.bytesPerLine();
+
+    if ( static_cast< qint64 >( width ) * height < PARALLEL_PIXELS_THRESHOLD )
+    {
+      mapRows( source, sourceStride, destination, destinationStride, width, 0, height );
+      return result;
+    }
+
+    QVector<int> firstRows;
+    for ( int row = 0; row < height; row += ROWS_PER_TASK )
+      firstRows.append( row );
+
+    QtConcurrent::blockingMap( firstRows, [ & ]( const int firstRow )
+    {
+      mapRows( source, sourceStride, destination, destinationStride, width, firstRow, std::min( firstRow + ROWS_PER_TASK, height ) );
+    } );
+
+    return result;
+  }
+
+} // namespace QgsWms
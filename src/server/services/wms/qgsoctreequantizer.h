@@ -0,0 +1,111 @@
+/***************************************************************************
+                              qgsoctreequantizer.h
+
+  Octree color reduction implementation
+  -------------------------------------
+  begin                : October 2023
+  copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSOCTREEQUANTIZER_H
+#define QGSOCTREEQUANTIZER_H
+
+#include <QVector>
+#include <QImage>
+
+#include <array>
+#include <vector>
+
+/**
+ * \ingroup server
+ * \brief Octree color quantization implementation
+ */
+
+namespace QgsWms
+{
+
+  /**
+   * \ingroup server
+   * \brief Octree quantizer used when reducing ARGB colors to palettized colors.
+   *
+   * Colors are inserted in a 16-ary tree (one bit of red, green, blue and alpha
+   * per level) which is then reduced bottom-up, least populated nodes first,
+   * until the number of leaves fits in the palette. Unlike the median cut
+   * implementation, pixels are mapped to their palette index by walking the
+   * tree, so the conversion does not need any nearest color search and rows
+   * can be converted concurrently.
+   *
+   * \since QGIS 3.34
+   */
+  class QgsOctreeQuantizer
+  {
+    public:
+
+      /**
+       * Builds the palette of at most \a maxColors colors for \a image.
+       */
+      QgsOctreeQuantizer( const QImage &image, int maxColors = 256 );
+
+      /**
+       * Returns the color table computed from the input image.
+       */
+      QVector<QRgb> colorTable() const { return mColorTable; }
+
+      /**
+       * Converts \a image to an indexed image using the color table.
+       *
+       * When \a dither is TRUE, a Floyd-Steinberg error diffusion is applied
+       * on the color channels. Dithering is inherently sequential so rows are
+       * only processed in parallel when \a dither is FALSE.
+       */
+      QImage convertToIndexed8( const QImage &image, bool dither = false ) const;
+
+    private:
+
+      static constexpr int MAX_DEPTH = 5;
+
+      struct Node
+      {
+        quint64 red = 0;
+        quint64 green = 0;
+        quint64 blue = 0;
+        quint64 alpha = 0;
+        quint64 pixelCount = 0;
+        std::array<int, 16> children;
+        bool isLeaf = false;
+        int paletteIndex = -1;
+      };
+
+      int createNode( int level );
+      void addColor( QRgb color, quint64 count );
+      void reduce( int maxColors );
+      void buildPalette();
+      int paletteIndex( QRgb color ) const;
+      int nearestIndex( int red, int green, int blue, int alpha ) const;
+      void mapRows( const uchar *source, qsizetype sourceStride, uchar *destination, qsizetype destinationStride, int width, int firstRow, int lastRow ) const;
+      void mapDithered( const QImage &image, QImage &result ) const;
+
+      std::vector<Node> mNodes;
+      std::array<std::vector<int>, MAX_DEPTH> mReducibleNodes;
+      int mLeafCount = 0;
+
+      QVector<QRgb> mColorTable;
+
+      // palette channels stored separately so that the nearest color search vectorizes
+      std::vector<int> mPaletteRed;
+      std::vector<int> mPaletteGreen;
+      std::vector<int> mPaletteBlue;
+      std::vector<int> mPaletteAlpha;
+  };
+
+} // namespace QgsWms
+
+#endif
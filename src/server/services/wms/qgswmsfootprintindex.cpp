@@ -0,0 +1,293 @@
+/***************************************************************************
+                              qgswmsfootprintindex.cpp
+
+  Cached spatial index of rendered feature footprints
+  ---------------------------------------------------
+  begin                : October 2023
+  copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswmsfootprintindex.h"
+#include "qgsexpressioncontextutils.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeaturerequest.h"
+#include "qgsmapsettings.h"
+#include "qgsreadwritecontext.h"
+#include "qgsrenderer.h"
+#include "qgsruntimeprofiler.h"
+#include "qgsserversettings.h"
+#include "qgssymbol.h"
+#include "qgssymbollayerutils.h"
+#include "qgsvectorlayer.h"
+
+#include <QCryptographicHash>
+#include <QDomDocument>
+#include <QImage>
+#include <QPainter>
+
+namespace QgsWms
+{
+
+  QgsWmsFootprintIndex::QgsWmsFootprintIndex( QgsVectorLayer *layer, const QgsMapSettings &mapSettings )
+  {
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+    context.expressionContext() << QgsExpressionContextUtils::layerScope( layer );
+    context.setCoordinateTransform( mapSettings.layerTransform( layer ) );
+    context.setExtent( layer->extent() );
+
+    // we are not going to draw anything, but symbols still need a working painter
+    QImage image( 1, 1, QImage::Format_ARGB32_Premultiplied );
+    QPainter painter( &image );
+    context.setPainter( &painter );
+
+    // symbol bleeds are computed in pixels, footprints are stored in layer units
+    const QgsRectangle mapExtent = mapSettings.extent();
+    const QgsRectangle layerExtent = mapSettings.mapToLayerCoordinates( layer, mapExtent );
+    double layerUnitsPerPixel = mapSettings.mapUnitsPerPixel();
+    if ( mapExtent.width() > 0 && layerExtent.width() > 0 )
+    {
+      layerUnitsPerPixel *= layerExtent.width() / mapExtent.width();
+    }
+
+    std::unique_ptr< QgsFeatureRenderer > renderer( layer->renderer()->clone() );
+    const bool moreSymbolsPerFeature = renderer->capabilities() & QgsFeatureRenderer::MoreSymbolsPerFeature;
+    renderer->startRender( context, layer->fields() );
+
+    if ( !renderer->canSkipRender() )
+    {
+      QgsFeatureRequest request;
+      const QString rendererFilterExpression = renderer->filter( layer->fields() );
+      if ( !rendererFilterExpression.isEmpty() )
+      {
+        request.setFilterExpression( rendererFilterExpression );
+      }
+      request.setExpressionContext( context.expressionContext() );
+      request.setSubsetOfAttributes( renderer->usedAttributes( context ), layer->fields() );
+
+      // symbols are shared by many features, their properties and bleed are computed once
+      QHash<QgsSymbol *, int> symbolIndexes;
+      QVector<double> symbolBleeds;
+
+      QgsFeatureIterator fit = layer->getFeatures( request );
+      QgsFeature feature;
+      while ( fit.nextFeature( feature ) )
+      {
+        if ( !feature.hasGeometry() )
+          continue;
+
+        context.expressionContext().setFeature( feature );
+        if ( !renderer->willRenderFeature( feature, context ) )
+          continue;
+
+        QgsSymbolList symbols;
+        if ( moreSymbolsPerFeature )
+          symbols = renderer->originalSymbolsForFeature( feature, context );
+        else
+          symbols << renderer->originalSymbolForFeature( feature, context );
+
+        Footprint footprint;
+        footprint.id = feature.id();
+        footprint.boundingBox = feature.geometry().boundingBox();
+        footprint.firstSymbol = static_cast<int>( mFootprintSymbols.size() );
+
+        double bleed = 0;
+        for ( QgsSymbol *symbol : std::as_const( symbols ) )
+        {
+          if ( !symbol )
+            continue;
+
+          auto it = symbolIndexes.constFind( symbol );
+          if ( it == symbolIndexes.constEnd() )
+          {
+            it = symbolIndexes.insert( symbol, mSymbols.size() );
+            mSymbols << QgsSymbolLayerUtils::symbolProperties( symbol );
+            symbolBleeds << QgsSymbolLayerUtils::estimateMaxSymbolBleed( symbol, context );
+          }
+          mFootprintSymbols.push_back( *it );
+          bleed = std::max( bleed, symbolBleeds.at( *it ) );
+        }
+        footprint.symbolCount = static_cast<int>( mFootprintSymbols.size() ) - footprint.firstSymbol;
+
+        mIndex.addFeature( static_cast<QgsFeatureId>( mFootprints.size() ), footprint.boundingBox.buffered( bleed * layerUnitsPerPixel ) );
+        mFootprints.push_back( footprint );
+      }
+    }
+
+    renderer->stopRender( context );
+    painter.end();
+  }
+
+  QgsFeatureIds QgsWmsFootprintIndex::renderedFeatures( const QgsRectangle &rect ) const
+  {
+    QgsFeatureIds ids;
+    const QList<QgsFeatureId> positions = mIndex.intersects( rect );
+    for ( const QgsFeatureId position : positions )
+    {
+      ids.insert( mFootprints[ static_cast<std::size_t>( position ) ].id );
+    }
+    return ids;
+  }
+
+  QSet<QString> QgsWmsFootprintIndex::usedSymbols( QgsVectorLayer *layer, const QgsRectangle &extent ) const
+  {
+    QSet<QString> symbols;
+    const auto addSymbols = [this, &symbols]( const Footprint & footprint )
+    {
+      for ( int i = footprint.firstSymbol; i < footprint.firstSymbol + footprint.symbolCount; ++i )
+      {
+        symbols.insert( mSymbols.at( mFootprintSymbols[ static_cast<std::size_t>( i ) ] ) );
+      }
+    };
+
+    // features fully inside the extent are answered from the index, the other
+    // ones need an exact intersection test against their geometry
+    QHash<QgsFeatureId, std::size_t> boundaryFootprints;
+    const QList<QgsFeatureId> positions = mIndex.intersects( extent );
+    for ( const QgsFeatureId position : positions )
+    {
+      const Footprint &footprint = mFootprints[ static_cast<std::size_t>( position ) ];
+      if ( extent.contains( footprint.boundingBox ) )
+      {
+        addSymbols( footprint );
+        if ( symbols.size() == mSymbols.size() )
+          return symbols;
+      }
+      else if ( extent.intersects( footprint.boundingBox ) )
+      {
+        boundaryFootprints.insert( footprint.id, static_cast<std::size_t>( position ) );
+      }
+    }
+
+    if ( boundaryFootprints.isEmpty() )
+      return symbols;
+
+    QgsFeatureRequest request;
+    request.setFilterFids( qgis::listToSet( boundaryFootprints.keys() ) );
+    request.setFilterRect( extent );
+    request.setFlags( QgsFeatureRequest::ExactIntersect );
+    request.setNoAttributes();
+
+    QgsFeatureIterator fit = layer->getFeatures( request );
+    QgsFeature feature;
+    while ( symbols.size() < mSymbols.size() && fit.nextFeature( feature ) )
+    {
+      addSymbols( mFootprints[ boundaryFootprints.value( feature.id() ) ] );
+    }
+
+    return symbols;
+  }
+
+  QgsWmsFootprintCache *QgsWmsFootprintCache::instance()
+  {
+    static QgsWmsFootprintCache sInstance;
+    return &sInstance;
+  }
+
+  std::shared_ptr<const QgsWmsFootprintIndex> QgsWmsFootprintCache::index( QgsVectorLayer *layer, const QgsMapSettings &mapSettings, const QgsServerSettings &settings )
+  {
+    const int maxEntries = settings.wmsFootprintCacheSize();
+    if ( maxEntries <= 0 || !layer || !layer->isSpatial() || !layer->renderer() )
+      return nullptr;
+
+    // embedded symbols belong to the features, they cannot be shared between footprints
+    if ( layer->renderer()->usesEmbeddedSymbols() )
+      return nullptr;
+
+    const QString key = cacheKey( layer, mapSettings );
+    {
+      QMutexLocker locker( &mMutex );
+      for ( int i = 0; i < mEntries.size(); ++i )
+      {
+        if ( mEntries.at( i ).layer == layer && mEntries.at( i ).key == key )
+        {
+          mEntries.move( i, 0 );
+          return mEntries.at( 0 ).index;
+        }
+      }
+    }
+
+    const long long featureCount = layer->featureCount();
+    if ( featureCount < 0 || featureCount > settings.wmsFootprintCacheMaxFeatures() )
+      return nullptr;
+
+    std::shared_ptr<const QgsWmsFootprintIndex> index;
+    {
+      QgsScopedRuntimeProfile profile( QStringLiteral( "Footprint index: %1" ).arg( layer->name() ), QStringLiteral( "server" ) );
+      index = std::make_shared<const QgsWmsFootprintIndex>( layer, mapSettings );
+    }
+
+    QMutexLocker locker( &mMutex );
+
+    mWatchedLayers.removeAll( nullptr );
+    if ( !mWatchedLayers.contains( layer ) )
+    {
+      mWatchedLayers << layer;
+      // the indexes are stale once the features, or the data source they are read from, change
+      const auto invalidateLayer = [this, layer]
+      {
+        invalidate( layer );
+      };
+      QObject::connect( layer, &QgsVectorLayer::afterCommitChanges, layer, invalidateLayer );
+      QObject::connect( layer, &QgsMapLayer::dataChanged, layer, invalidateLayer );
+      QObject::connect( layer, &QgsMapLayer::dataSourceChanged, layer, invalidateLayer );
+      QObject::connect( layer, &QgsMapLayer::willBeDeleted, layer, invalidateLayer );
+    }
+
+    mEntries.erase( std::remove_if( mEntries.begin(), mEntries.end(), []( const Entry & entry ) { return entry.layer.isNull(); } ), mEntries.end() );
+    mEntries.prepend( { key, layer, index } );
+    while ( mEntries.size() > maxEntries )
+    {
+      mEntries.removeLast();
+    }
+
+    return index;
+  }
+
+  int QgsWmsFootprintCache::size() const
+  {
+    QMutexLocker locker( &mMutex );
+    return mEntries.size();
+  }
+
+  void QgsWmsFootprintCache::clear()
+  {
+    QMutexLocker locker( &mMutex );
+    mEntries.clear();
+  }
+
+  QString QgsWmsFootprintCache::cacheKey( QgsVectorLayer *layer, const QgsMapSettings &mapSettings )
+  {
+    // the style is identified by the renderer definition, which also covers
+    // styles changed by the STYLES and SLD parameters
+    QDomDocument doc;
+    doc.appendChild( layer->renderer()->save( doc, QgsReadWriteContext() ) );
+    const QByteArray rendererHash = QCryptographicHash::hash( doc.toByteArray(), QCryptographicHash::Sha1 ).toHex();
+
+    const QStringList parts
+    {
+      layer->id(),
+      QString::fromLatin1( rendererHash ),
+      layer->subsetString(),
+      QString::number( mapSettings.scale(), 'f', 0 ),
+      QString::number( mapSettings.outputDpi() ),
+      mapSettings.destinationCrs().toWkt()
+    };
+    return parts.join( '\n' );
+  }
+
+  void QgsWmsFootprintCache::invalidate( const QgsVectorLayer *layer )
+  {
+    QMutexLocker locker( &mMutex );
+    mEntries.erase( std::remove_if( mEntries.begin(), mEntries.end(), [layer]( const Entry & entry ) { return entry.layer == layer; } ), mEntries.end() );
+  }
+
+} // namespace QgsWms
@@ -0,0 +1,165 @@
+/***************************************************************************
+                              qgswmsfootprintindex.h
+
+  Cached spatial index of rendered feature footprints
+  ---------------------------------------------------
+  begin                : October 2023
+  copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSWMSFOOTPRINTINDEX_H
+#define QGSWMSFOOTPRINTINDEX_H
+
+#include "qgsfeatureid.h"
+#include "qgsrectangle.h"
+#include "qgsspatialindex.h"
+
+#include <QList>
+#include <QMutex>
+#include <QPointer>
+#include <QSet>
+#include <QStringList>
+
+#include <memory>
+#include <vector>
+
+class QgsMapSettings;
+class QgsServerSettings;
+class QgsVectorLayer;
+
+namespace QgsWms
+{
+
+  /**
+   * \ingroup server
+   * \brief Spatial index of the rendered footprints of the features of a vector layer.
+   *
+   * The index is built once for a layer, a style and a scale by evaluating the
+   * layer renderer on every feature. It stores, for each rendered feature, its
+   * bounding box, its footprint (the bounding box grown by the symbol bleed) and
+   * the symbols used to render it, so that identify and hit test requests do not
+   * have to evaluate the renderer again.
+   *
+   * Extents are expressed in the layer CRS.
+   *
+   * \since QGIS 3.34
+   */
+  class QgsWmsFootprintIndex
+  {
+    public:
+
+      /**
+       * Builds the index of the features of \a layer rendered with the
+       * current layer renderer and the scale of \a mapSettings.
+       */
+      QgsWmsFootprintIndex( QgsVectorLayer *layer, const QgsMapSettings &mapSettings );
+
+      /**
+       * Returns the number of rendered features in the index.
+       */
+      int size() const { return static_cast<int>( mFootprints.size() ); }
+
+      /**
+       * Returns the ids of the rendered features whose footprint intersects \a rect.
+       */
+      QgsFeatureIds renderedFeatures( const QgsRectangle &rect ) const;
+
+      /**
+       * Returns the properties of the symbols used by the rendered features of
+       * \a layer whose geometry intersects \a extent, in the same form as
+       * QgsSymbolLayerUtils::symbolProperties().
+       *
+       * Features whose bounding box is not fully contained in \a extent are
+       * fetched from \a layer to test the exact intersection.
+       */
+      QSet<QString> usedSymbols( QgsVectorLayer *layer, const QgsRectangle &extent ) const;
+
+    private:
+
+      struct Footprint
+      {
+        QgsFeatureId id;
+        QgsRectangle boundingBox;
+        int firstSymbol;
+        int symbolCount;
+      };
+
+      std::vector<Footprint> mFootprints;
+      std::vector<int> mFootprintSymbols;
+      QStringList mSymbols;
+
+      // spatial index of the footprints, indexed by position in mFootprints
+      QgsSpatialIndex mIndex;
+  };
+
+  /**
+   * \ingroup server
+   * \brief Cache of rendered feature footprint indexes.
+   *
+   * Indexes are keyed by layer, renderer definition, subset string, scale, DPI
+   * and output CRS. The least recently used indexes are dropped when the cache
+   * size configured with QGIS_SERVER_WMS_FOOTPRINT_CACHE_SIZE is exceeded, and
+   * the indexes of a layer are dropped when its changes are committed, when its
+ * data or data source change (e.g. when it is reloaded) and when it is deleted.
+   *
+   * \since QGIS 3.34
+   */
+  class QgsWmsFootprintCache
+  {
+    public:
+
+      /**
+       * Returns the cache instance.
+       */
+      static QgsWmsFootprintCache *instance();
+
+      /**
+       * Returns the footprint index of \a layer for \a mapSettings, building it
+       * when it is not cached yet.
+       *
+       * Returns NULLPTR when the cache is disabled by \a settings, when the
+       * layer has too many features or when its renderer does not allow to
+       * index the rendered features.
+       */
+      std::shared_ptr<const QgsWmsFootprintIndex> index( QgsVectorLayer *layer, const QgsMapSettings &mapSettings, const QgsServerSettings &settings );
+
+      /**
+       * Returns the number of cached indexes.
+       */
+      int size() const;
+
+      /**
+       * Removes all the cached indexes.
+       */
+      void clear();
+
+    private:
+
+      struct Entry
+      {
+        QString key;
+        QPointer<QgsVectorLayer> layer;
+        std::shared_ptr<const QgsWmsFootprintIndex> index;
+      };
+
+      static QString cacheKey( QgsVectorLayer *layer, const QgsMapSettings &mapSettings );
+      void invalidate( const QgsVectorLayer *layer );
+
+      mutable QMutex mMutex;
+
+      // most recently used first
+      QList<Entry> mEntries;
+      QList<QPointer<QgsVectorLayer>> mWatchedLayers;
+  };
+
+} // namespace QgsWms
+
+#endif
@@ -22,6 +22,7 @@
 #include "qgsfilterrestorer.h"
 #include "qgsexception.h"
 #include "qgsfields.h"
+#include "qgsruntimeprofiler.h"
 #include "qgsfieldformatter.h"
 #include "qgsfieldformatterregistry.h"
 #include "qgsfeatureiterator.h"
@@ -49,6 +50,7 @@
 #include "qgsaccesscontrol.h"
 #include "qgsfeaturerequest.h"
 #include "qgsmaprendererjobproxy.h"
+#include "qgswmsfootprintindex.h"
 #include "qgswmsserviceexception.h"
 #include "qgsserverprojectutils.h"
 #include "qgsserverfeatureid.h"
@@ -254,6 +256,11 @@ namespace QgsWms
       context.setExtent( tr.transformBoundingBox( mapSettings.extent(), Qgis::TransformDirection::Reverse ) );
 
       SymbolSet &usedSymbols = hitTest[vl];
+      if ( const std::shared_ptr<const QgsWmsFootprintIndex> index = QgsWmsFootprintCache::instance()->index( vl, mapSettings, mContext.settings() ) )
+      {
+        usedSymbols = index->usedSymbols( vl, context.extent() );
+        continue;
+      }
       runHitTestLayer( vl, usedSymbols, context );
     }
   }
@@ -994,7 +1001,10 @@ namespace QgsWms
 
     QgsMapSettings mapSettings;
     mapSettings.setFlag( Qgis::MapSettingsFlag::RenderBlocking );
-    configureLayers( layers, &mapSettings );
+    {
+      const QgsScopedRuntimeProfile profile { QStringLiteral( "Configure layers" ), QStringLiteral( "server" ) };
+      configureLayers( layers, &mapSettings );
+    }
 
     // create the output image and the painter
     std::unique_ptr<QPainter> painter;
@@ -1778,8 +1788,25 @@ namespace QgsWms
     fReq.setSubsetOfAttributes( attributes, layer->fields() );
 #endif
 
+    // rendered features can be looked up in the cached footprint index instead
+    // of evaluating the renderer on every feature in the search rectangle
+    std::shared_ptr<const QgsWmsFootprintIndex> footprintIndex;
+    QgsFeatureIds renderedFeatures;
+    if ( layer->wkbType() != Qgis::WkbType::NoGeometry && ! searchRect.isEmpty() )
+    {
+      footprintIndex = QgsWmsFootprintCache::instance()->index( layer, mapSettings, mContext.settings() );
+      if ( footprintIndex )
+      {
+        renderedFeatures = footprintIndex->renderedFeatures( searchRect );
+        if ( renderedFeatures.isEmpty() )
+        {
+          return true;
+        }
+      }
+    }
+
     QgsFeatureIterator fit = layer->getFeatures( fReq );
-    std::unique_ptr< QgsFeatureRenderer > r2( layer->renderer() ? layer->renderer()->clone() : nullptr );
+    std::unique_ptr< QgsFeatureRenderer > r2( layer->renderer() && !footprintIndex ? layer->renderer()->clone() : nullptr );
     if ( r2 )
     {
       r2->startRender( renderContext, layer->fields() );
@@ -1803,16 +1830,26 @@ namespace QgsWms
 
       if ( layer->wkbType() != Qgis::WkbType::NoGeometry && ! searchRect.isEmpty() )
       {
-        if ( !r2 )
+        if ( footprintIndex )
         {
-          continue;
+          if ( !renderedFeatures.contains( feature.id() ) )
+          {
+            continue;
+          }
         }
-
-        //check if feature is rendered at all
-        bool render = r2->willRenderFeature( feature, renderContext );
-        if ( !render )
+        else
         {
-          continue;
+          if ( !r2 )
+          {
+            continue;
+          }
+
+          //check if feature is rendered at all
+          bool render = r2->willRenderFeature( feature, renderContext );
+          if ( !render )
+          {
+            continue;
+          }
         }
       }
 
@@ -3154,11 +3191,17 @@ namespace QgsWms
     QgsFeatureFilterProviderGroup filters;
     filters.addProvider( &mFeatureFilter );
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
-    mContext.accessControl()->resolveFilterFeatures( mapSettings.layers() );
+    {
+      const QgsScopedRuntimeProfile profile { QStringLiteral( "Access control filters" ), QStringLiteral( "server" ) };
+      mContext.accessControl()->resolveFilterFeatures( mapSettings.layers() );
+    }
     filters.addProvider( mContext.accessControl() );
 #endif
     QgsMapRendererJobProxy renderJob( mContext.settings().parallelRendering(), mContext.settings().maxThreads(), &filters );
-    renderJob.render( mapSettings, &image );
+    {
+      const QgsScopedRuntimeProfile profile { QStringLiteral( "Rendering" ), QStringLiteral( "server" ) };
+      renderJob.render( mapSettings, &image );
+    }
     painter = renderJob.takePainter();
 
     if ( !renderJob.errors().isEmpty() )
@@ -24,9 +24,11 @@
 #include "qgsmodule.h"
 #include "qgswmsutils.h"
 #include "qgsmediancut.h"
+#include "qgsoctreequantizer.h"
 #include "qgsserverprojectutils.h"
 #include "qgswmsserviceexception.h"
 #include "qgsproject.h"
+#include "qgsruntimeprofiler.h"
 
 namespace QgsWms
 {
@@ -109,8 +111,10 @@ namespace QgsWms
 
   // Write image response
   void writeImage( QgsServerResponse &response, QImage &img, const QString &formatStr,
-                   int imageQuality )
+                   int imageQuality, const QgsServerSettings *settings )
   {
+    const QgsScopedRuntimeProfile profile { QStringLiteral( "Image encoding" ), QStringLiteral( "server" ) };
+
     const ImageOutputFormat outputFormat = parseImageFormat( formatStr );
     QImage  result;
     QString saveFormat;
@@ -124,16 +128,26 @@ namespace QgsWms
         break;
       case ImageOutputFormat::PNG8:
       {
-        QVector<QRgb> colorTable;
+        const bool useOctree = settings && settings->wmsPng8Quantizer() == QLatin1String( "octree" );
+        const bool dither = settings && settings->wmsPng8Dithering();
 
         // Rendering is made with the format QImage::Format_ARGB32_Premultiplied
         // So we need to convert it in QImage::Format_ARGB32 in order to properly build
         // the color table.
         const QImage img256 = img.convertToFormat( QImage::Format_ARGB32 );
-        medianCut( colorTable, 256, img256 );
-        result = img256.convertToFormat( QImage::Format_Indexed8, colorTable,
-                                         Qt::ColorOnly | Qt::ThresholdDither |
-                                         Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
+        if ( useOctree )
+        {
+          const QgsOctreeQuantizer quantizer( img256, 256 );
+          result = quantizer.convertToIndexed8( img256, dither );
+        }
+        else
+        {
+          QVector<QRgb> colorTable;
+          medianCut( colorTable, 256, img256 );
+          result = img256.convertToFormat( QImage::Format_Indexed8, colorTable,
+                                           Qt::ColorOnly | ( dither ? Qt::DiffuseDither : Qt::ThresholdDither ) |
+                                           Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
+        }
       }
       contentType = QStringLiteral( "image/png" );
       saveFormat = QStringLiteral( "PNG" );
@@ -67,9 +67,12 @@ namespace QgsWms
 
   /**
    * Write image response
+   *
+   * The optional server \a settings select the color quantization method and
+   * dithering used for 8 bit PNG output (since QGIS 3.34).
    */
   void writeImage( QgsServerResponse &response, QImage &img, const QString &formatStr,
-                   int imageQuality = -1 );
+                   int imageQuality = -1, const QgsServerSettings *settings = nullptr );
 } // namespace QgsWms
 
 #endif
@@ -22,12 +22,15 @@
 #include "qgstotalcurvaturefilter.h"
 #include "qgsapplication.h"
 #include "qgssettings.h"
+#include "qgsogrutils.h"
 
 #ifdef HAVE_OPENCL
 #include "qgsopenclutils.h"
 #endif
 
 #include <QDir>
+#include <algorithm>
+#include <random>
 
 // If true regenerate raster reference images
 const bool REGENERATE_REFERENCES = false;
@@ -48,6 +51,8 @@ class TestNineCellFilters : public QObject
     void testAspect();
     void testRuggedness();
     void testTotalCurvature();
+    void testRowKernels();
+    void testStripBoundaries();
 #ifdef HAVE_OPENCL
     void testHillshadeCl();
     void testSlopeCl();
@@ -60,6 +65,7 @@ class TestNineCellFilters : public QObject
     void _rasterCompare( QgsAlignRaster::RasterInfo &out, QgsAlignRaster::RasterInfo &ref );
 
     template <class T> void _testAlg( const QString &name, bool useOpenCl = false );
+    template <class T> void _testRowKernel();
 
     static QString referenceFile( const QString &name )
     {
@@ -221,6 +227,110 @@ void TestNineCellFilters::testTotalCurvature()
   _testAlg<QgsTotalCurvatureFilter>( QStringLiteral( "totalcurvature" ) );
 }
 
+///@cond PRIVATE
+// exposes the per cell and per row methods of a filter
+template <class T>
+class RowKernelFilter : public T
+{
+  public:
+    RowKernelFilter()
+      : T( QString(), QString(), QString() )
+    {}
+    using T::processNineCellWindow;
+    using T::processNineCellRow;
+};
+
+// returns the value of the cell above the central cell
+class CellAboveFilter : public QgsNineCellFilter
+{
+  public:
+    using QgsNineCellFilter::QgsNineCellFilter;
+    float processNineCellWindow( float *, float *x21, float *, float *, float *, float *, float *, float *, float * ) override
+    {
+      return *x21 == mInputNodataValue ? mOutputNodataValue : *x21;
+    }
+};
+///@endcond
+
+template <class T>
+void TestNineCellFilters::_testRowKernel()
+{
+  RowKernelFilter<T> filter;
+  filter.setCellSizeX( 10 );
+  filter.setCellSizeY( 12.5 );
+  filter.setZFactor( 2 );
+  filter.setInputNodataValue( -1 );
+  filter.setOutputNodataValue( -9999 );
+
+  const int count = 1000;
+  std::mt19937 generator( 42 );
+  std::uniform_real_distribution<float> heights( 100, 200 );
+  std::bernoulli_distribution nodata( 0.2 );
+  std::vector<float> rows[3];
+  for ( std::vector<float> &row : rows )
+  {
+    for ( int i = 0; i < count + 2; ++i )
+      row.push_back( nodata( generator ) ? -1 : heights( generator ) );
+  }
+
+  std::vector<float> rowResult( count );
+  filter.processNineCellRow( rows[0].data(), rows[1].data(), rows[2].data(), rowResult.data(), count );
+  for ( int i = 0; i < count; ++i )
+  {
+    const float cellResult = filter.processNineCellWindow( &rows[0][i], &rows[0][i + 1], &rows[0][i + 2],
+                             &rows[1][i], &rows[1][i + 1], &rows[1][i + 2],
+                             &rows[2][i], &rows[2][i + 1], &rows[2][i + 2] );
+    QVERIFY2( qgsFloatNear( rowResult[i], cellResult, 1e-4f * std::max( 1.0f, std::fabs( cellResult ) ) ),
+              QStringLiteral( "cell %1: %2 != %3" ).arg( i ).arg( rowResult[i] ).arg( cellResult ).toLocal8Bit().constData() );
+  }
+}
+
+void TestNineCellFilters::testRowKernels()
+{
+  _testRowKernel<QgsSlopeFilter>();
+  _testRowKernel<QgsAspectFilter>();
+  _testRowKernel<QgsHillshadeFilter>();
+  _testRowKernel<QgsRuggednessFilter>();
+  _testRowKernel<QgsTotalCurvatureFilter>();
+}
+
+void TestNineCellFilters::testStripBoundaries()
+{
+  // large enough to be processed in several strips of rows
+  const int width = 2000;
+  const int height = 1500;
+  const QString inputFile = tempFile( QStringLiteral( "strips_input" ) );
+  const QString outputFile = tempFile( QStringLiteral( "strips_output" ) );
+  {
+    GDALDriverH driver = GDALGetDriverByName( "GTiff" );
+    gdal::dataset_unique_ptr dataset( GDALCreate( driver, inputFile.toUtf8().constData(), width, height, 1, GDT_Float32, nullptr ) );
+    QVERIFY( dataset );
+    double geoTransform[6] = { 0, 1, 0, height, 0, -1 };
+    GDALSetGeoTransform( dataset.get(), geoTransform );
+    GDALRasterBandH band = GDALGetRasterBand( dataset.get(), 1 );
+    GDALSetRasterNoDataValue( band, -1 );
+    std::vector<float> line( width );
+    for ( int row = 0; row < height; ++row )
+    {
+      std::fill( line.begin(), line.end(), static_cast< float >( row ) );
+      QCOMPARE( GDALRasterIO( band, GF_Write, 0, row, width, 1, line.data(), width, 1, GDT_Float32, 0, 0 ), CE_None );
+    }
+  }
+
+  CellAboveFilter filter( inputFile, outputFile, QStringLiteral( "GTiff" ) );
+  QCOMPARE( filter.processRaster(), 0 );
+
+  const gdal::dataset_unique_ptr output( GDALOpen( outputFile.toUtf8().constData(), GA_ReadOnly ) );
+  QVERIFY( output );
+  GDALRasterBandH band = GDALGetRasterBand( output.get(), 1 );
+  std::vector<float> line( width );
+  for ( int row = 0; row < height; ++row )
+  {
+    QCOMPARE( GDALRasterIO( band, GF_Read, 0, row, width, 1, line.data(), width, 1, GDT_Float32, 0, 0 ), CE_None );
+    const float expected = row == 0 ? -9999 : row - 1;
+    QVERIFY( std::all_of( line.begin(), line.end(), [expected]( float value ) { return value == expected; } ) );
+  }
+}
 
 QGSTEST_MAIN( TestNineCellFilters )
 
@@ -95,6 +95,7 @@ class TestQgsProcessingAlgsPt1: public QObject
     void featureFilterAlg();
     void transformAlg();
     void kmeansCluster();
+    void kmeansClusterScalable();
     void categorizeByStyle();
     void extractBinary();
     void exportLayersInformationAlg();
@@ -1075,6 +1076,55 @@ void TestQgsProcessingAlgsPt1::kmeansCluster()
   QCOMPARE( features[ 2 ].cluster, -1 );
 }
 
+void TestQgsProcessingAlgsPt1::kmeansClusterScalable()
+{
+  // four blobs of points, with more points than a chunk so that several threads are used
+  std::vector< QgsKMeansClusteringAlgorithm::Feature > features;
+  const QList< QgsPointXY > blobCenters { QgsPointXY( 0, 0 ), QgsPointXY( 100, 0 ), QgsPointXY( 0, 100 ), QgsPointXY( 100, 100 ) };
+  for ( int i = 0; i < 200000; ++i )
+  {
+    const QgsPointXY &blobCenter = blobCenters.at( i % 4 );
+    features.emplace_back( QgsKMeansClusteringAlgorithm::Feature( QgsPointXY( blobCenter.x() + ( i * 37 ) % 101 / 10.0, blobCenter.y() + ( i * 53 ) % 97 / 10.0 ) ) );
+  }
+  const int k = 4;
+
+  // k-means++ is reproducible with a seed, whatever the number of threads
+  std::vector< QgsPointXY > centers( k );
+  std::mt19937 generator( 42 );
+  QgsKMeansClusteringAlgorithm::initClustersPlusPlus( features, centers, k, generator, 1 );
+  std::vector< QgsPointXY > parallelCenters( k );
+  std::mt19937 parallelGenerator( 42 );
+  QgsKMeansClusteringAlgorithm::initClustersPlusPlus( features, parallelCenters, k, parallelGenerator, 4 );
+  QCOMPARE( parallelCenters, centers );
+
+  // the parallel Lloyd iteration gives the same clusters as the serial one
+  std::vector< QgsKMeansClusteringAlgorithm::Feature > parallelFeatures = features;
+  QgsKMeansClusteringAlgorithm::calculateKMeans( features, centers, k, nullptr, 1 );
+  QgsKMeansClusteringAlgorithm::calculateKMeans( parallelFeatures, parallelCenters, k, nullptr, 4 );
+  QCOMPARE( parallelCenters, centers );
+  for ( std::size_t i = 0; i < features.size(); ++i )
+    QCOMPARE( parallelFeatures[ i ].cluster, features[ i ].cluster );
+
+  // each blob is a cluster
+  for ( std::size_t i = 4; i < features.size(); ++i )
+    QCOMPARE( features[ i ].cluster, features[ i % 4 ].cluster );
+
+  // mini-batches find the same blobs
+  std::vector< QgsPointXY > miniBatchCenters( k );
+  std::mt19937 miniBatchGenerator( 42 );
+  QgsKMeansClusteringAlgorithm::initClustersPlusPlus( parallelFeatures, miniBatchCenters, k, miniBatchGenerator, 4 );
+  QgsKMeansClusteringAlgorithm::calculateMiniBatchKMeans( parallelFeatures, miniBatchCenters, k, 1000, miniBatchGenerator, nullptr, 4 );
+  for ( std::size_t i = 4; i < parallelFeatures.size(); ++i )
+    QCOMPARE( parallelFeatures[ i ].cluster, parallelFeatures[ i % 4 ].cluster );
+  for ( int blob = 0; blob < 4; ++blob )
+  {
+    // the points of a blob are spread over 10 by 10 units
+    const QgsPointXY &center = miniBatchCenters[ parallelFeatures[ blob ].cluster ];
+    QGSCOMPARENEAR( center.x(), blobCenters.at( blob ).x() + 5, 1 );
+    QGSCOMPARENEAR( center.y(), blobCenters.at( blob ).y() + 5, 1 );
+  }
+}
+
 void TestQgsProcessingAlgsPt1::categorizeByStyle()
 {
   std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:categorizeusingstyle" ) ) );
@@ -37,6 +37,7 @@
 #include "qgsrasteranalysisutils.cpp"
 #include "qgsrasterfilewriter.h"
 #include "qgsreclassifyutils.h"
+#include "qgsoutofcoreoperators.h"
 #include "qgsalgorithmrasterlogicalop.h"
 #include "qgsprintlayout.h"
 #include "qgslayertree.h"
@@ -118,11 +119,26 @@ class TestQgsProcessingAlgsPt2: public QObject
     void splitVectorLayer();
     void buffer();
     void splitWithLines();
+    void threadSafeFeatureProcessing();
+    void overlayPartitioned();
+    void dissolveCascadedUnion();
+    void spatialJoinEngine();
+    void dbscanParallel();
+    void outOfCoreOperators();
+    void checkpointedExecution();
 
   private:
 
     bool imageCheck( const QString &testName, const QString &renderedImage );
 
+    /**
+     * Runs an algorithm with a maximum number of \a threads and a memory budget, and returns the features of its
+     * \a output layer as their attributes followed by their normalized geometry. Returns an empty list if the algorithm
+     * failed. If set, \a results is filled with the results of the algorithm.
+     */
+    QStringList runAlgorithmFeatures( const QString &algorithmId, const QVariantMap &parameters, int threads, qint64 memoryBudget = 0,
+                                      const QString &output = QStringLiteral( "OUTPUT" ), QVariantMap *results = nullptr );
+
     QString mPointLayerPath;
     QgsVectorLayer *mPointsLayer = nullptr;
     QgsVectorLayer *mPolygonLayer = nullptr;
@@ -1896,5 +1912,675 @@ bool TestQgsProcessingAlgsPt2::imageCheck( const QString &testName, const QStrin
   return equal;
 }
 
+QStringList TestQgsProcessingAlgsPt2::runAlgorithmFeatures( const QString &algorithmId, const QVariantMap &parameters, int threads, qint64 memoryBudget, const QString &output, QVariantMap *results )
+{
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( algorithmId ) );
+  if ( !alg )
+    return QStringList();
+
+  QgsProcessingContext context;
+  context.setMaximumThreads( threads );
+  context.setMemoryBudget( memoryBudget );
+  QgsProcessingFeedback feedback;
+  bool ok = false;
+  const QVariantMap algorithmResults = alg->run( parameters, context, &feedback, &ok );
+  if ( !ok )
+    return QStringList();
+  if ( results )
+    *results = algorithmResults;
+
+  QStringList features;
+  QgsVectorLayer *outputLayer = qobject_cast< QgsVectorLayer * >( context.getMapLayer( algorithmResults.value( output ).toString() ) );
+  if ( !outputLayer )
+    return features;
+  QgsFeatureIterator it = outputLayer->getFeatures();
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    QStringList attributes;
+    for ( const QVariant &attribute : f.attributes() )
+      attributes << attribute.toString();
+    // overlapping geometries may be unioned in another order
+    QgsGeometry geometry = f.geometry();
+    geometry.normalize();
+    features << QStringLiteral( "%1 %2" ).arg( attributes.join( ',' ), geometry.asWkt( 6 ) );
+  }
+  return features;
+}
+
+void TestQgsProcessingAlgsPt2::threadSafeFeatureProcessing()
+{
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=epsg:4326&field=pk:int" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 1050; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, -i ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:swapxy" ) ) );
+  QVERIFY( alg != nullptr );
+  QVERIFY( alg->flags() & QgsProcessingAlgorithm::FlagThreadSafeFeatureProcessing );
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( layer.get() ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+  for ( const int threads : { 1, 4 } )
+  {
+    bool ok = false;
+    std::unique_ptr< QgsProcessingContext > context = std::make_unique< QgsProcessingContext >();
+    context->setMaximumThreads( threads );
+    QgsProcessingFeedback feedback;
+    const QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+    QVERIFY( ok );
+
+    QgsVectorLayer *outputLayer = qobject_cast< QgsVectorLayer * >( context->getMapLayer( results.value( QStringLiteral( "OUTPUT" ) ).toString() ) );
+    QVERIFY( outputLayer );
+    QCOMPARE( outputLayer->featureCount(), 1050l );
+
+    // features are written in the order of the input features
+    QgsFeatureIterator it = outputLayer->getFeatures();
+    QgsFeature f;
+    int i = 0;
+    while ( it.nextFeature( f ) )
+    {
+      QCOMPARE( f.attribute( 0 ).toInt(), i );
+      QCOMPARE( f.geometry().asWkt(), QStringLiteral( "Point (%1 %2)" ).arg( -i ).arg( i ) );
+      ++i;
+    }
+    QCOMPARE( i, 1050 );
+  }
+}
+
+void TestQgsProcessingAlgsPt2::overlayPartitioned()
+{
+  // squares of a grid overlaid with bigger squares of a shifted grid, so that many features cross partitions
+  std::unique_ptr< QgsVectorLayer > layerA = std::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=epsg:3857&field=a:int" ), QStringLiteral( "a" ), QStringLiteral( "memory" ) );
+  std::unique_ptr< QgsVectorLayer > layerB = std::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=epsg:3857&field=b:int" ), QStringLiteral( "b" ), QStringLiteral( "memory" ) );
+  QVERIFY( layerA->isValid() );
+  QVERIFY( layerB->isValid() );
+  QgsFeatureList featuresA;
+  for ( int i = 0; i < 900; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( i % 30, i / 30, i % 30 + 1, i / 30 + 1 ) ) );
+    featuresA << f;
+  }
+  QVERIFY( layerA->dataProvider()->addFeatures( featuresA ) );
+  QgsFeatureList featuresB;
+  for ( int i = 0; i < 400; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( 0.25 + 1.5 * ( i % 20 ), 0.25 + 1.5 * ( i / 20 ), 1.5 + 1.5 * ( i % 20 ), 1.5 + 1.5 * ( i / 20 ) ) ) );
+    featuresB << f;
+  }
+  QVERIFY( layerB->dataProvider()->addFeatures( featuresB ) );
+
+  // the partitioned overlay must give the same features, in the same order, as the serial one
+  for ( const QString &algorithmId : { QStringLiteral( "native:intersection" ), QStringLiteral( "native:difference" ), QStringLiteral( "native:union" ) } )
+  {
+    QVariantMap parameters;
+    parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( layerA.get() ) );
+    parameters.insert( QStringLiteral( "OVERLAY" ), QVariant::fromValue( layerB.get() ) );
+    parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+    const QStringList expected = runAlgorithmFeatures( algorithmId, parameters, 1 );
+    QVERIFY( !expected.isEmpty() );
+    QCOMPARE( runAlgorithmFeatures( algorithmId, parameters, 4 ), expected );
+  }
+
+  // a point at the origin has the same bounding box as a null rectangle, it must still be overlaid
+  std::unique_ptr< QgsVectorLayer > origin = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=epsg:3857&field=a:int" ), QStringLiteral( "origin" ), QStringLiteral( "memory" ) );
+  QVERIFY( origin->isValid() );
+  QgsFeature originFeature;
+  originFeature.setAttributes( QgsAttributes() << 0 );
+  originFeature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 0, 0 ) ) );
+  QVERIFY( origin->dataProvider()->addFeature( originFeature ) );
+  std::unique_ptr< QgsVectorLayer > square = std::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=epsg:3857&field=b:int" ), QStringLiteral( "square" ), QStringLiteral( "memory" ) );
+  QVERIFY( square->isValid() );
+  QgsFeature squareFeature;
+  squareFeature.setAttributes( QgsAttributes() << 1 );
+  squareFeature.setGeometry( QgsGeometry::fromRect( QgsRectangle( -1, -1, 1, 1 ) ) );
+  QVERIFY( square->dataProvider()->addFeature( squareFeature ) );
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( origin.get() ) );
+  parameters.insert( QStringLiteral( "OVERLAY" ), QVariant::fromValue( square.get() ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+  for ( const int threads : { 1, 4 } )
+  {
+    const QStringList intersection = runAlgorithmFeatures( QStringLiteral( "native:intersection" ), parameters, threads );
+    QCOMPARE( intersection.size(), 1 );
+    QVERIFY( intersection.at( 0 ).startsWith( QLatin1String( "0,1 " ) ) );
+
+    QVariantMap results;
+    QCOMPARE( runAlgorithmFeatures( QStringLiteral( "native:difference" ), parameters, threads, 0, QStringLiteral( "OUTPUT" ), &results ), QStringList() );
+    QVERIFY( !results.isEmpty() );
+  }
+}
+
+void TestQgsProcessingAlgsPt2::dissolveCascadedUnion()
+{
+  // a grid of squares, in vertical strips of 10 columns by 40 rows
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=epsg:3857&field=strip:int" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 1600; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << ( i % 40 ) / 10 );
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( i % 40, i / 40, i % 40 + 1, i / 40 + 1 ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  for ( const bool byStrip : { false, true } )
+  {
+    QVariantMap parameters;
+    parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( layer.get() ) );
+    if ( byStrip )
+      parameters.insert( QStringLiteral( "FIELD" ), QStringLiteral( "strip" ) );
+    parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+    const QStringList expected = runAlgorithmFeatures( QStringLiteral( "native:dissolve" ), parameters, 1 );
+    QCOMPARE( expected.size(), byStrip ? 4 : 1 );
+    for ( const QString &feature : expected )
+    {
+      // each strip is dissolved to a single rectangle
+      const int separator = feature.indexOf( ' ' );
+      const QgsGeometry geometry = QgsGeometry::fromWkt( feature.mid( separator + 1 ) );
+      QCOMPARE( geometry.constGet()->partCount(), 1 );
+      QGSCOMPARENEAR( geometry.area(), byStrip ? 400 : 1600, 0.000001 );
+      if ( byStrip )
+      {
+        const int strip = feature.left( separator ).toInt();
+        QCOMPARE( geometry.boundingBox(), QgsRectangle( strip * 10, 0, strip * 10 + 10, 40 ) );
+      }
+    }
+
+    // parts may be unioned in another order, giving other vertices along the same boundary
+    const QStringList cascaded = runAlgorithmFeatures( QStringLiteral( "native:dissolve" ), parameters, 4 );
+    QCOMPARE( cascaded.size(), expected.size() );
+    for ( int i = 0; i < expected.size(); ++i )
+    {
+      const int separator = expected.at( i ).indexOf( ' ' );
+      QCOMPARE( cascaded.at( i ).left( cascaded.at( i ).indexOf( ' ' ) ), expected.at( i ).left( separator ) );
+      QVERIFY( QgsGeometry::fromWkt( cascaded.at( i ).mid( cascaded.at( i ).indexOf( ' ' ) + 1 ) ).isGeosEqual( QgsGeometry::fromWkt( expected.at( i ).mid( separator + 1 ) ) ) );
+    }
+  }
+}
+
+void TestQgsProcessingAlgsPt2::spatialJoinEngine()
+{
+  // points every half unit, some of them on the boundaries of the squares, and squares overlapping their neighbors
+  std::unique_ptr< QgsVectorLayer > points = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=epsg:3857&field=p:int" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  std::unique_ptr< QgsVectorLayer > squares = std::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=epsg:3857&field=s:int" ), QStringLiteral( "squares" ), QStringLiteral( "memory" ) );
+  QVERIFY( points->isValid() );
+  QVERIFY( squares->isValid() );
+  QgsFeatureList pointFeatures;
+  for ( int i = 0; i < 2500; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 0.5 * ( i % 50 ), 0.5 * ( i / 50 ) ) ) );
+    pointFeatures << f;
+  }
+  // a point without geometry is never joined, but is disjoint
+  QgsFeature noGeometry;
+  noGeometry.setAttributes( QgsAttributes() << 2500 );
+  pointFeatures << noGeometry;
+  QVERIFY( points->dataProvider()->addFeatures( pointFeatures ) );
+  QgsFeatureList squareFeatures;
+  for ( int i = 0; i < 64; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( 3 * ( i % 8 ), 3 * ( i / 8 ), 3 * ( i % 8 ) + 4, 3 * ( i / 8 ) + 4 ) ) );
+    squareFeatures << f;
+  }
+  QVERIFY( squares->dataProvider()->addFeatures( squareFeatures ) );
+
+  // the parallel join must give the same features as the serial one, in any order
+  const auto sortedFeatures = [this]( const QString & algorithmId, const QVariantMap & parameters, int threads, const QString & output ) -> QStringList
+  {
+    QStringList features = runAlgorithmFeatures( algorithmId, parameters, threads, 0, output );
+    features.sort();
+    return features;
+  };
+
+  // one to many, join to first and largest overlap, with each layer as base layer
+  for ( const bool pointsAsBase : { true, false } )
+  {
+    for ( const QVariantList &predicates : { QVariantList() << 0, QVariantList() << 3 << 1 << 5 } )
+    {
+      QVariantMap parameters;
+      parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( pointsAsBase ? points.get() : squares.get() ) );
+      parameters.insert( QStringLiteral( "JOIN" ), QVariant::fromValue( pointsAsBase ? squares.get() : points.get() ) );
+      parameters.insert( QStringLiteral( "PREDICATE" ), predicates );
+      parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+      parameters.insert( QStringLiteral( "NON_MATCHING" ), QStringLiteral( "memory:" ) );
+
+      parameters.insert( QStringLiteral( "METHOD" ), 0 );
+      const QStringList allMatches = sortedFeatures( QStringLiteral( "native:joinattributesbylocation" ), parameters, 1, QStringLiteral( "OUTPUT" ) );
+      QVERIFY( !allMatches.isEmpty() );
+
+      for ( const int method : { 0, 1, 2 } )
+      {
+        parameters.insert( QStringLiteral( "METHOD" ), method );
+
+        const QStringList expectedNonMatching = sortedFeatures( QStringLiteral( "native:joinattributesbylocation" ), parameters, 1, QStringLiteral( "NON_MATCHING" ) );
+        QCOMPARE( sortedFeatures( QStringLiteral( "native:joinattributesbylocation" ), parameters, 4, QStringLiteral( "NON_MATCHING" ) ), expectedNonMatching );
+
+        const QStringList expected = sortedFeatures( QStringLiteral( "native:joinattributesbylocation" ), parameters, 1, QStringLiteral( "OUTPUT" ) );
+        const QStringList joined = sortedFeatures( QStringLiteral( "native:joinattributesbylocation" ), parameters, 4, QStringLiteral( "OUTPUT" ) );
+        if ( method == 0 )
+        {
+          QCOMPARE( joined, expected );
+          continue;
+        }
+
+        // the first match, or the match with the largest overlap when overlaps are points, isn't always the same one:
+        // the same base features must be joined, each of them to one of its matches
+        QCOMPARE( joined.size(), expected.size() );
+        for ( int i = 0; i < joined.size(); ++i )
+        {
+          QCOMPARE( joined.at( i ).section( ',', 0, 0 ), expected.at( i ).section( ',', 0, 0 ) );
+          QVERIFY2( allMatches.contains( joined.at( i ) ), joined.at( i ).toLocal8Bit().constData() );
+        }
+      }
+    }
+  }
+
+  // intersect, disjoint and within/touch, extracting from each layer
+  for ( const bool extractPoints : { true, false } )
+  {
+    for ( const QVariantList &predicates : { QVariantList() << 0, QVariantList() << 2, QVariantList() << 6 << 4 } )
+    {
+      QVariantMap parameters;
+      parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( extractPoints ? points.get() : squares.get() ) );
+      parameters.insert( QStringLiteral( "INTERSECT" ), QVariant::fromValue( extractPoints ? squares.get() : points.get() ) );
+      parameters.insert( QStringLiteral( "PREDICATE" ), predicates );
+      parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+      const QStringList expected = sortedFeatures( QStringLiteral( "native:extractbylocation" ), parameters, 1, QStringLiteral( "OUTPUT" ) );
+      QCOMPARE( sortedFeatures( QStringLiteral( "native:extractbylocation" ), parameters, 4, QStringLiteral( "OUTPUT" ) ), expected );
+    }
+  }
+}
+
+void TestQgsProcessingAlgsPt2::dbscanParallel()
+{
+  // scattered points, dense enough for clusters with core, border and noise points
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=epsg:3857&field=datetime:datetime" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 2000; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << QDateTime( QDate( 2023, 1, 1 ), QTime( 0, 0, 0 ) ).addSecs( 3600 * ( i % 24 ) ) );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 0.3 * ( ( i * 37 ) % 101 ), 0.3 * ( ( i * 53 ) % 97 ) ) ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  for ( const QString &algorithmId : { QStringLiteral( "native:dbscanclustering" ), QStringLiteral( "native:stdbscanclustering" ) } )
+  {
+    for ( const bool borderPointsAreNoise : { false, true } )
+    {
+      QVariantMap parameters;
+      parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( layer.get() ) );
+      parameters.insert( QStringLiteral( "MIN_SIZE" ), 3 );
+      parameters.insert( QStringLiteral( "EPS" ), 0.5 );
+      if ( algorithmId == QLatin1String( "native:stdbscanclustering" ) )
+      {
+        parameters.insert( QStringLiteral( "DATETIME_FIELD" ), QStringLiteral( "datetime" ) );
+        // milliseconds
+        parameters.insert( QStringLiteral( "EPS2" ), 2 * 3600 * 1000 );
+      }
+      parameters.insert( QStringLiteral( "DBSCAN*" ), borderPointsAreNoise );
+      parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+      // the parallel clustering must give the same clusters, with the same ids
+      QVariantMap expectedResults;
+      const QStringList expected = runAlgorithmFeatures( algorithmId, parameters, 1, 0, QStringLiteral( "OUTPUT" ), &expectedResults );
+      QCOMPARE( expected.size(), 2000 );
+      QVERIFY( expectedResults.value( QStringLiteral( "NUM_CLUSTERS" ) ).toInt() > 1 );
+
+      QVariantMap results;
+      QCOMPARE( runAlgorithmFeatures( algorithmId, parameters, 4, 0, QStringLiteral( "OUTPUT" ), &results ), expected );
+      QCOMPARE( results.value( QStringLiteral( "NUM_CLUSTERS" ) ).toInt(), expectedResults.value( QStringLiteral( "NUM_CLUSTERS" ) ).toInt() );
+    }
+  }
+}
+
+void TestQgsProcessingAlgsPt2::outOfCoreOperators()
+{
+  // a memory budget of a few features, so that everything is spilled to disk
+  QgsProcessingContext spillingContext;
+  spillingContext.setMemoryBudget( 4096 );
+
+  QgsExternalFeatureSorter sorter( spillingContext );
+  for ( int i = 0; i < 1000; ++i )
+  {
+    QgsFeature f( i );
+    f.setAttributes( QgsAttributes() << i );
+    sorter.add( ( i * 7 ) % 100, f );
+  }
+  QVERIFY( sorter.hasSpilled() );
+  QgsFeature f;
+  int previousKey = -1;
+  int previousId = -1;
+  int sortedCount = 0;
+  while ( sorter.next( f ) )
+  {
+    const int key = ( static_cast< int >( f.id() ) * 7 ) % 100;
+    QVERIFY( key >= previousKey );
+    // equal keys keep their order
+    if ( key == previousKey )
+      QVERIFY( f.id() > previousId );
+    QCOMPARE( f.attribute( 0 ).toInt(), static_cast< int >( f.id() ) );
+    previousKey = key;
+    previousId = static_cast< int >( f.id() );
+    sortedCount++;
+  }
+  QCOMPARE( sortedCount, 1000 );
+
+  // the budget is split between the operators an algorithm holds at once
+  QgsExternalFeatureSorter wholeBudgetSorter( spillingContext );
+  QgsExternalFeatureSorter budgetShareSorter( spillingContext, QgsFields(), 4 );
+  for ( int i = 0; i < 20; ++i )
+  {
+    QgsFeature feature( i );
+    feature.setAttributes( QgsAttributes() << i );
+    wholeBudgetSorter.add( i, feature );
+    budgetShareSorter.add( i, feature );
+  }
+  QVERIFY( !wholeBudgetSorter.hasSpilled() );
+  QVERIFY( budgetShareSorter.hasSpilled() );
+
+  // a run per feature, more runs than are merged at once
+  QgsExternalFeatureSorter multiPassSorter( spillingContext, QgsFields(), 4096 );
+  for ( int i = 0; i < 1000; ++i )
+  {
+    QgsFeature feature( i );
+    multiPassSorter.add( ( i * 7 ) % 100, feature );
+  }
+  previousKey = -1;
+  previousId = -1;
+  sortedCount = 0;
+  while ( multiPassSorter.next( f ) )
+  {
+    const int key = ( static_cast< int >( f.id() ) * 7 ) % 100;
+    QVERIFY( key >= previousKey );
+    if ( key == previousKey )
+      QVERIFY( f.id() > previousId );
+    previousKey = key;
+    previousId = static_cast< int >( f.id() );
+    sortedCount++;
+  }
+  QCOMPARE( sortedCount, 1000 );
+
+  // keys which can't be streamed as variants, such as geometries, are written in their own format
+  QgsSpillingFeatureGrouper grouper( spillingContext );
+  for ( int i = 0; i < 200; ++i )
+  {
+    QgsFeature feature( i );
+    feature.setAttributes( QgsAttributes() << i );
+    grouper.add( QVariantList() << QVariant::fromValue( QgsGeometry::fromPointXY( QgsPointXY( i % 10, 0 ) ) ) << ( i % 10 ), feature );
+  }
+  QVERIFY( grouper.hasSpilled() );
+  std::vector< QgsSpillingFeatureGrouper::Group > groups;
+  int groupedCount = 0;
+  while ( grouper.nextGroups( groups ) )
+  {
+    for ( const QgsSpillingFeatureGrouper::Group &group : groups )
+    {
+      QCOMPARE( group.key.size(), 2 );
+      QVERIFY( group.key.at( 0 ).userType() == qMetaTypeId< QgsGeometry >() );
+      for ( const QgsFeature &feature : group.features )
+      {
+        QCOMPARE( group.key.at( 0 ).value< QgsGeometry >().asWkt(), QStringLiteral( "Point (%1 0)" ).arg( feature.attribute( 0 ).toInt() % 10 ) );
+        QCOMPARE( group.key.at( 1 ).toInt(), feature.attribute( 0 ).toInt() % 10 );
+        groupedCount++;
+      }
+    }
+  }
+  QCOMPARE( groupedCount, 200 );
+
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=epsg:3857&field=id:int&field=g:int&field=name:string" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  std::unique_ptr< QgsVectorLayer > table = std::make_unique< QgsVectorLayer >( QStringLiteral( "None?field=g:int&field=value:string" ), QStringLiteral( "table" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QVERIFY( table->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 2000; ++i )
+  {
+    QgsFeature feature;
+    feature.setAttributes( QgsAttributes() << i << ( i * 13 ) % 97 << QStringLiteral( "feature %1" ).arg( i ) );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i % 50, i / 50 ) ) );
+    features << feature;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+  features.clear();
+  // values 0 to 79 are joined, several times for some of them
+  for ( int i = 0; i < 200; ++i )
+  {
+    QgsFeature feature;
+    feature.setAttributes( QgsAttributes() << i % 80 << QStringLiteral( "value %1" ).arg( i ) );
+    features << feature;
+  }
+  QVERIFY( table->dataProvider()->addFeatures( features ) );
+
+  // the algorithms must give the same features with and without memory budget, in the same order
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( layer.get() ) );
+  parameters.insert( QStringLiteral( "FIELDS" ), QStringList() << QStringLiteral( "g" ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+  parameters.insert( QStringLiteral( "DUPLICATES" ), QStringLiteral( "memory:" ) );
+  for ( const QString &output : { QStringLiteral( "OUTPUT" ), QStringLiteral( "DUPLICATES" ) } )
+  {
+    const QStringList expected = runAlgorithmFeatures( QStringLiteral( "native:removeduplicatesbyattribute" ), parameters, 1, 0, output );
+    QCOMPARE( expected.size(), output == QLatin1String( "OUTPUT" ) ? 97 : 1903 );
+    QCOMPARE( runAlgorithmFeatures( QStringLiteral( "native:removeduplicatesbyattribute" ), parameters, 1, 4096, output ), expected );
+  }
+
+  for ( const int method : { 0, 1 } )
+  {
+    parameters.clear();
+    parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( layer.get() ) );
+    parameters.insert( QStringLiteral( "FIELD" ), QStringLiteral( "g" ) );
+    parameters.insert( QStringLiteral( "INPUT_2" ), QVariant::fromValue( table.get() ) );
+    parameters.insert( QStringLiteral( "FIELD_2" ), QStringLiteral( "g" ) );
+    parameters.insert( QStringLiteral( "METHOD" ), method );
+    parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+    parameters.insert( QStringLiteral( "NON_MATCHING" ), QStringLiteral( "memory:" ) );
+    for ( const QString &output : { QStringLiteral( "OUTPUT" ), QStringLiteral( "NON_MATCHING" ) } )
+    {
+      const QStringList expected = runAlgorithmFeatures( QStringLiteral( "native:joinattributestable" ), parameters, 1, 0, output );
+      QVERIFY( !expected.isEmpty() );
+      QCOMPARE( runAlgorithmFeatures( QStringLiteral( "native:joinattributestable" ), parameters, 1, 4096, output ), expected );
+    }
+  }
+
+  parameters.clear();
+  parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( layer.get() ) );
+  parameters.insert( QStringLiteral( "GROUP_BY" ), QStringLiteral( "\"g\"" ) );
+  QVariantMap sum;
+  sum.insert( QStringLiteral( "aggregate" ), QStringLiteral( "sum" ) );
+  sum.insert( QStringLiteral( "input" ), QStringLiteral( "\"id\"" ) );
+  sum.insert( QStringLiteral( "name" ), QStringLiteral( "sum" ) );
+  sum.insert( QStringLiteral( "type" ), static_cast< int >( QVariant::LongLong ) );
+  QVariantMap first;
+  first.insert( QStringLiteral( "aggregate" ), QStringLiteral( "first_value" ) );
+  first.insert( QStringLiteral( "input" ), QStringLiteral( "\"name\"" ) );
+  first.insert( QStringLiteral( "name" ), QStringLiteral( "first" ) );
+  first.insert( QStringLiteral( "type" ), static_cast< int >( QVariant::String ) );
+  parameters.insert( QStringLiteral( "AGGREGATES" ), QVariantList() << sum << first );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+  QStringList expected = runAlgorithmFeatures( QStringLiteral( "native:aggregate" ), parameters, 1 );
+  QCOMPARE( expected.size(), 97 );
+  QCOMPARE( runAlgorithmFeatures( QStringLiteral( "native:aggregate" ), parameters, 1, 4096 ), expected );
+
+  // groups are collected in any order
+  parameters.clear();
+  parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( layer.get() ) );
+  parameters.insert( QStringLiteral( "FIELD" ), QStringList() << QStringLiteral( "g" ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+  expected = runAlgorithmFeatures( QStringLiteral( "native:collect" ), parameters, 1 );
+  expected.sort();
+  QCOMPARE( expected.size(), 97 );
+  QStringList collected = runAlgorithmFeatures( QStringLiteral( "native:collect" ), parameters, 1, 4096 );
+  collected.sort();
+  QCOMPARE( collected, expected );
+}
+
+void TestQgsProcessingAlgsPt2::checkpointedExecution()
+{
+  std::unique_ptr< QgsVectorLayer > layer = std::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=epsg:3857&field=id:int" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 1000; ++i )
+  {
+    QgsFeature feature;
+    feature.setAttributes( QgsAttributes() << i );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i % 50, i / 50 ) ) );
+    features << feature;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  QTemporaryDir dir;
+  const QString checkpointFile = dir.filePath( QStringLiteral( "checkpoint.json" ) );
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "INPUT" ), QVariant::fromValue( layer.get() ) );
+
+  // threads 0 keeps the default number of threads of the context
+  const auto runAlgorithm = [&]( const QString & algorithmId, int threads, double cancelAtProgress, bool & ok ) -> QVariantMap
+  {
+    std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( algorithmId ) );
+    QgsProcessingContext context;
+    if ( threads > 0 )
+      context.setMaximumThreads( threads );
+    context.setCheckpointFile( checkpointFile );
+    context.setCheckpointInterval( 0 );
+    QgsProcessingFeedback feedback;
+    connect( &feedback, &QgsFeedback::progressChanged, &feedback, [&feedback, cancelAtProgress]( double progress )
+    {
+      if ( progress >= cancelAtProgress )
+        feedback.cancel();
+    } );
+    return alg->run( parameters, context, &feedback, &ok );
+  };
+
+  const auto outputFeatureCount = []( const QString & output ) -> long long
+  {
+    QgsVectorLayer outputLayer( output, QStringLiteral( "output" ), QStringLiteral( "ogr" ) );
+    return outputLayer.isValid() ? outputLayer.featureCount() : -1;
+  };
+
+  // the output has the features of the input in their order, with the points of swapped coordinates if swapped
+  const auto checkOutput = []( const QString & output, bool swapped )
+  {
+    QgsVectorLayer outputLayer( output, QStringLiteral( "output" ), QStringLiteral( "ogr" ) );
+    QVERIFY( outputLayer.isValid() );
+    QCOMPARE( outputLayer.featureCount(), 1000LL );
+    QgsFeatureIterator it = outputLayer.getFeatures( QgsFeatureRequest().addOrderBy( QStringLiteral( "fid" ) ) );
+    QgsFeature f;
+    int expectedId = 0;
+    while ( it.nextFeature( f ) )
+    {
+      QCOMPARE( f.attribute( QStringLiteral( "id" ) ).toInt(), expectedId );
+      const QgsPointXY point( expectedId % 50, expectedId / 50 );
+      QCOMPARE( f.geometry().asPoint(), swapped ? QgsPointXY( point.y(), point.x() ) : point );
+      expectedId++;
+    }
+    QCOMPARE( expectedId, 1000 );
+  };
+
+  // the interrupted run keeps its progress, the next run appends the remaining features and removes the checkpoint once done
+  const QString output = dir.filePath( QStringLiteral( "centroids.gpkg" ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), output );
+  bool ok = false;
+  runAlgorithm( QStringLiteral( "native:centroids" ), 1, 30, ok );
+  QVERIFY( ok );
+  QVERIFY( QFile::exists( checkpointFile ) );
+  long long partialCount = outputFeatureCount( output );
+  QVERIFY( partialCount > 0 );
+  QVERIFY( partialCount < 1000 );
+
+  QVariantMap results = runAlgorithm( QStringLiteral( "native:centroids" ), 1, 101, ok );
+  QVERIFY( ok );
+  QCOMPARE( results.value( QStringLiteral( "OUTPUT" ) ).toString(), output );
+  QVERIFY( !QFile::exists( checkpointFile ) );
+  checkOutput( output, false );
+
+  // features processed concurrently with the default number of threads, the features written to the output
+  // after the checkpoint was saved are removed when resuming
+  const QString swappedOutput = dir.filePath( QStringLiteral( "swapped.gpkg" ) );
+  parameters.insert( QStringLiteral( "OUTPUT" ), swappedOutput );
+  runAlgorithm( QStringLiteral( "native:swapxy" ), 0, 30, ok );
+  QVERIFY( ok );
+  QVERIFY( QFile::exists( checkpointFile ) );
+  partialCount = outputFeatureCount( swappedOutput );
+  QVERIFY( partialCount > 0 );
+  QVERIFY( partialCount < 1000 );
+  {
+    QgsVectorLayer partial( swappedOutput, QStringLiteral( "partial" ), QStringLiteral( "ogr" ) );
+    QVERIFY( partial.isValid() );
+    QgsFeatureList extraFeatures;
+    for ( int i = 0; i < 5; ++i )
+    {
+      QgsFeature feature( partial.fields() );
+      feature.setAttribute( QStringLiteral( "id" ), -1 );
+      feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( -1, -1 ) ) );
+      extraFeatures << feature;
+    }
+    QVERIFY( partial.dataProvider()->addFeatures( extraFeatures ) );
+  }
+  QCOMPARE( outputFeatureCount( swappedOutput ), partialCount + 5 );
+
+  results = runAlgorithm( QStringLiteral( "native:swapxy" ), 0, 101, ok );
+  QVERIFY( ok );
+  QCOMPARE( results.value( QStringLiteral( "OUTPUT" ) ).toString(), swappedOutput );
+  QVERIFY( !QFile::exists( checkpointFile ) );
+  checkOutput( swappedOutput, true );
+
+  // the algorithm is run from the start when the output saved to the checkpoint is missing
+  runAlgorithm( QStringLiteral( "native:swapxy" ), 4, 30, ok );
+  QVERIFY( ok );
+  QVERIFY( QFile::exists( checkpointFile ) );
+  QVERIFY( QFile::remove( swappedOutput ) );
+  results = runAlgorithm( QStringLiteral( "native:swapxy" ), 4, 101, ok );
+  QVERIFY( ok );
+  QVERIFY( !QFile::exists( checkpointFile ) );
+  checkOutput( swappedOutput, true );
+
+  // no progress is saved for temporary outputs, which are gone once the run is over
+  parameters.insert( QStringLiteral( "OUTPUT" ), QgsProcessing::TEMPORARY_OUTPUT );
+  runAlgorithm( QStringLiteral( "native:centroids" ), 1, 30, ok );
+  QVERIFY( ok );
+  QVERIFY( !QFile::exists( checkpointFile ) );
+
+  // nor for layers written through a provider
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+  runAlgorithm( QStringLiteral( "native:centroids" ), 1, 30, ok );
+  QVERIFY( ok );
+  QVERIFY( !QFile::exists( checkpointFile ) );
+
+  // nor by algorithms whose features depend on the ones processed before
+  parameters.insert( QStringLiteral( "OUTPUT" ), dir.filePath( QStringLiteral( "incremental.gpkg" ) ) );
+  std::unique_ptr< QgsProcessingAlgorithm > incremental( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:addautoincrementalfield" ) ) );
+  QVERIFY( !( incremental->flags() & QgsProcessingAlgorithm::FlagSupportsCheckpoints ) );
+  runAlgorithm( QStringLiteral( "native:addautoincrementalfield" ), 1, 30, ok );
+  QVERIFY( ok );
+  QVERIFY( !QFile::exists( checkpointFile ) );
+}
+
 QGSTEST_MAIN( TestQgsProcessingAlgsPt2 )
 #include "testqgsprocessingalgspt2.moc"
@@ -24,6 +24,11 @@
 #include "qgsexpressioncontextutils.h"
 #include "qgsxmlutils.h"
 #include "qgsprocessingprovider.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsprocessingfeaturepipe.h"
+
+#include <QTemporaryDir>
 
 
 class DummyAlgorithm2 : public QgsProcessingAlgorithm
@@ -96,6 +101,9 @@ class TestQgsProcessingModelAlgorithm: public QObject
     void modelExecution();
     void modelBranchPruning();
     void modelBranchPruningConditional();
+    void modelConcurrentExecution();
+    void modelPipedExecution();
+    void modelCheckpointedExecution();
     void modelWithProviderWithLimitedTypes();
     void modelVectorOutputIsCompatibleType();
     void modelAcceptableValues();
@@ -1675,6 +1683,294 @@ void TestQgsProcessingModelAlgorithm::modelBranchPruningConditional()
   QVERIFY( ok ); // the branch with the exception should NOT be hit
 }
 
+void TestQgsProcessingModelAlgorithm::modelConcurrentExecution()
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( "Point?crs=epsg:3111", "v1", "memory" );
+  QgsFeature f;
+  f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 1, 2 ) ) );
+  layer->dataProvider()->addFeature( f );
+  QgsProject p;
+  p.addMapLayer( layer );
+
+  // two independent branches, merged by a last child algorithm
+  QgsProcessingModelAlgorithm model1;
+  QgsProcessingModelParameter param;
+  param.setParameterName( QStringLiteral( "LAYER" ) );
+  model1.addModelParameter( new QgsProcessingParameterVectorLayer( QStringLiteral( "LAYER" ) ), param );
+
+  for ( const QString &childId : { QStringLiteral( "buffer1" ), QStringLiteral( "buffer2" ) } )
+  {
+    QgsProcessingModelChildAlgorithm buffer;
+    buffer.setChildId( childId );
+    buffer.setAlgorithmId( "native:buffer" );
+    buffer.addParameterSources( QStringLiteral( "INPUT" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromModelParameter( QStringLiteral( "LAYER" ) ) );
+    buffer.addParameterSources( QStringLiteral( "DISTANCE" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromStaticValue( 10 ) );
+    model1.addChildAlgorithm( buffer );
+  }
+
+  QgsProcessingModelChildAlgorithm merge;
+  merge.setChildId( QStringLiteral( "merge" ) );
+  merge.setAlgorithmId( "native:mergevectorlayers" );
+  merge.addParameterSources( QStringLiteral( "LAYERS" ), QList< QgsProcessingModelChildParameterSource >()
+                             << QgsProcessingModelChildParameterSource::fromChildOutput( QStringLiteral( "buffer1" ), QStringLiteral( "OUTPUT" ) )
+                             << QgsProcessingModelChildParameterSource::fromChildOutput( QStringLiteral( "buffer2" ), QStringLiteral( "OUTPUT" ) ) );
+  QMap<QString, QgsProcessingModelOutput> outputs;
+  QgsProcessingModelOutput out( "MERGED" );
+  out.setChildOutputName( "OUTPUT" );
+  outputs.insert( QStringLiteral( "MERGED" ), out );
+  merge.setModelOutputs( outputs );
+  model1.addChildAlgorithm( merge );
+
+  // the buffers are run concurrently when more than one thread is allowed
+  for ( const int threads : { 1, 4 } )
+  {
+    QgsProcessingContext context;
+    context.setProject( &p );
+    context.setMaximumThreads( threads );
+
+    QgsProcessingFeedback feedback;
+    QVariantMap params;
+    params.insert( QStringLiteral( "LAYER" ), QStringLiteral( "v1" ) );
+    params.insert( QStringLiteral( "merge:MERGED" ), QgsProcessing::TEMPORARY_OUTPUT );
+    bool ok = false;
+    const QVariantMap results = model1.run( params, context, &feedback, &ok );
+    QVERIFY( ok );
+
+    const QVariantMap childResults = results.value( QStringLiteral( "CHILD_RESULTS" ) ).toMap();
+    QCOMPARE( childResults.count(), 3 );
+    QVERIFY( !childResults.value( QStringLiteral( "buffer1" ) ).toMap().value( QStringLiteral( "OUTPUT" ) ).toString().isEmpty() );
+    QVERIFY( !childResults.value( QStringLiteral( "buffer2" ) ).toMap().value( QStringLiteral( "OUTPUT" ) ).toString().isEmpty() );
+
+    QgsVectorLayer *merged = qobject_cast< QgsVectorLayer * >( context.getMapLayer( results.value( QStringLiteral( "merge:MERGED" ) ).toString() ) );
+    QVERIFY( merged );
+    QCOMPARE( merged->featureCount(), 2L );
+    QVERIFY( context.willLoadLayerOnCompletion( merged->id() ) );
+    QCOMPARE( feedback.progress(), 100.0 );
+  }
+
+  // a child failing while the others run makes the model fail
+  QgsProcessingModelChildAlgorithm fail;
+  fail.setChildId( QStringLiteral( "fail" ) );
+  fail.setAlgorithmId( "native:raiseexception" );
+  fail.addParameterSources( QStringLiteral( "MESSAGE" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromStaticValue( QStringLiteral( "failed" ) ) );
+  model1.addChildAlgorithm( fail );
+  for ( const int threads : { 1, 4 } )
+  {
+    QgsProcessingContext context;
+    context.setProject( &p );
+    context.setMaximumThreads( threads );
+
+    QgsProcessingFeedback feedback;
+    QVariantMap params;
+    params.insert( QStringLiteral( "LAYER" ), QStringLiteral( "v1" ) );
+    params.insert( QStringLiteral( "merge:MERGED" ), QgsProcessing::TEMPORARY_OUTPUT );
+    bool ok = false;
+    model1.run( params, context, &feedback, &ok );
+    QVERIFY( !ok );
+  }
+}
+
+void TestQgsProcessingModelAlgorithm::modelPipedExecution()
+{
+  // more features than a pipe holds
+  QgsVectorLayer *layer = new QgsVectorLayer( "Point?crs=epsg:3111", "v1", "memory" );
+  QgsFeatureList features;
+  for ( int i = 0; i < 2500; ++i )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, 2 * i ) ) );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+  QgsProject p;
+  p.addMapLayer( layer );
+
+  // the output of the translation is only read by the swap, and the output of the swap by the
+  // second translation, so they can be streamed
+  QgsProcessingModelAlgorithm model1;
+  QgsProcessingModelParameter param;
+  param.setParameterName( QStringLiteral( "LAYER" ) );
+  model1.addModelParameter( new QgsProcessingParameterVectorLayer( QStringLiteral( "LAYER" ) ), param );
+
+  QgsProcessingModelChildAlgorithm translate;
+  translate.setChildId( QStringLiteral( "translate" ) );
+  translate.setAlgorithmId( "native:translategeometry" );
+  translate.addParameterSources( QStringLiteral( "INPUT" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromModelParameter( QStringLiteral( "LAYER" ) ) );
+  translate.addParameterSources( QStringLiteral( "DELTA_X" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromStaticValue( 1 ) );
+  model1.addChildAlgorithm( translate );
+
+  QgsProcessingModelChildAlgorithm swap;
+  swap.setChildId( QStringLiteral( "swap" ) );
+  swap.setAlgorithmId( "native:swapxy" );
+  swap.addParameterSources( QStringLiteral( "INPUT" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromChildOutput( QStringLiteral( "translate" ), QStringLiteral( "OUTPUT" ) ) );
+  model1.addChildAlgorithm( swap );
+
+  QgsProcessingModelChildAlgorithm translate2;
+  translate2.setChildId( QStringLiteral( "translate2" ) );
+  translate2.setAlgorithmId( "native:translategeometry" );
+  translate2.addParameterSources( QStringLiteral( "INPUT" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromChildOutput( QStringLiteral( "swap" ), QStringLiteral( "OUTPUT" ) ) );
+  translate2.addParameterSources( QStringLiteral( "DELTA_X" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromStaticValue( 1 ) );
+  QMap<QString, QgsProcessingModelOutput> outputs;
+  QgsProcessingModelOutput out( "TRANSLATED" );
+  out.setChildOutputName( "OUTPUT" );
+  outputs.insert( QStringLiteral( "TRANSLATED" ), out );
+  translate2.setModelOutputs( outputs );
+  model1.addChildAlgorithm( translate2 );
+
+  for ( const int threads : { 1, 2, 4 } )
+  {
+    QgsProcessingContext context;
+    context.setProject( &p );
+    context.setMaximumThreads( threads );
+
+    QgsProcessingFeedback feedback;
+    double maximumProgress = 0;
+    connect( &feedback, &QgsFeedback::progressChanged, this, [&maximumProgress]( double progress ) { maximumProgress = std::max( maximumProgress, progress ); } );
+    QVariantMap params;
+    params.insert( QStringLiteral( "LAYER" ), QStringLiteral( "v1" ) );
+    params.insert( QStringLiteral( "translate2:TRANSLATED" ), QgsProcessing::TEMPORARY_OUTPUT );
+    bool ok = false;
+    const QVariantMap results = model1.run( params, context, &feedback, &ok );
+    QVERIFY( ok );
+    QCOMPARE( maximumProgress, 100.0 );
+
+    // features are only streamed when the children can run at the same time, each reader of a pipe uses one
+    // of the threads left by the first child. The streamed outputs are not reported.
+    const QVariantMap childResults = results.value( QStringLiteral( "CHILD_RESULTS" ) ).toMap();
+    QCOMPARE( childResults.value( QStringLiteral( "translate" ) ).toMap().contains( QStringLiteral( "OUTPUT" ) ), threads == 1 );
+    QCOMPARE( childResults.value( QStringLiteral( "swap" ) ).toMap().contains( QStringLiteral( "OUTPUT" ) ), threads < 4 );
+    const QString swapped = childResults.value( QStringLiteral( "swap" ) ).toMap().value( QStringLiteral( "OUTPUT" ) ).toString();
+    QVERIFY( !QgsProcessingFeaturePipe::isPipeUri( swapped ) );
+
+    QgsVectorLayer *translated = qobject_cast< QgsVectorLayer * >( context.getMapLayer( results.value( QStringLiteral( "translate2:TRANSLATED" ) ).toString() ) );
+    QVERIFY( translated );
+    QCOMPARE( translated->featureCount(), 2500L );
+    QgsFeatureIterator it = translated->getFeatures();
+    QgsFeature f;
+    int i = 0;
+    while ( it.nextFeature( f ) )
+    {
+      QCOMPARE( f.geometry().asPoint(), QgsPointXY( 2 * i + 1, i + 1 ) );
+      i++;
+    }
+  }
+}
+
+void TestQgsProcessingModelAlgorithm::modelCheckpointedExecution()
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( "Point?crs=epsg:3111", "v1", "memory" );
+  QgsFeatureList features;
+  for ( int i = 0; i < 10; ++i )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, 2 * i ) ) );
+    features << f;
+  }
+  layer->dataProvider()->addFeatures( features );
+  QgsProject p;
+  p.addMapLayer( layer );
+
+  // the model fails after the translation and the swap while the fail_model variable is set
+  QgsProcessingModelAlgorithm model1;
+  QgsProcessingModelParameter param;
+  param.setParameterName( QStringLiteral( "LAYER" ) );
+  model1.addModelParameter( new QgsProcessingParameterVectorLayer( QStringLiteral( "LAYER" ) ), param );
+
+  QgsProcessingModelChildAlgorithm translate;
+  translate.setChildId( QStringLiteral( "translate" ) );
+  translate.setAlgorithmId( "native:translategeometry" );
+  translate.addParameterSources( QStringLiteral( "INPUT" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromModelParameter( QStringLiteral( "LAYER" ) ) );
+  translate.addParameterSources( QStringLiteral( "DELTA_X" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromStaticValue( 1 ) );
+  QMap<QString, QgsProcessingModelOutput> outputs;
+  QgsProcessingModelOutput out( "TRANSLATED" );
+  out.setChildOutputName( "OUTPUT" );
+  outputs.insert( QStringLiteral( "TRANSLATED" ), out );
+  translate.setModelOutputs( outputs );
+  model1.addChildAlgorithm( translate );
+
+  QgsProcessingModelChildAlgorithm swap;
+  swap.setChildId( QStringLiteral( "swap" ) );
+  swap.setAlgorithmId( "native:swapxy" );
+  swap.addParameterSources( QStringLiteral( "INPUT" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromChildOutput( QStringLiteral( "translate" ), QStringLiteral( "OUTPUT" ) ) );
+  outputs.clear();
+  QgsProcessingModelOutput out2( "SWAPPED" );
+  out2.setChildOutputName( "OUTPUT" );
+  outputs.insert( QStringLiteral( "SWAPPED" ), out2 );
+  swap.setModelOutputs( outputs );
+  model1.addChildAlgorithm( swap );
+
+  QgsProcessingModelChildAlgorithm fail;
+  fail.setChildId( QStringLiteral( "fail" ) );
+  fail.setAlgorithmId( "native:raiseexception" );
+  fail.addParameterSources( QStringLiteral( "MESSAGE" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromStaticValue( QStringLiteral( "failed" ) ) );
+  fail.addParameterSources( QStringLiteral( "CONDITION" ), QList< QgsProcessingModelChildParameterSource >() << QgsProcessingModelChildParameterSource::fromStaticValue( QStringLiteral( "@fail_model = 1" ) ) );
+  fail.setDependencies( QList< QgsProcessingModelChildDependency >() << QgsProcessingModelChildDependency( QStringLiteral( "swap" ) ) );
+  model1.addChildAlgorithm( fail );
+
+  QTemporaryDir dir;
+  const QString checkpointFile = dir.filePath( QStringLiteral( "checkpoint.json" ) );
+  const QString translatedOutput = dir.filePath( QStringLiteral( "translated.gpkg" ) );
+  const QString swappedOutput = dir.filePath( QStringLiteral( "swapped.gpkg" ) );
+
+  const auto runModel = [&]( bool failModel ) -> bool
+  {
+    QgsExpressionContextUtils::setProjectVariable( &p, QStringLiteral( "fail_model" ), failModel ? 1 : 0 );
+    QgsProcessingContext context;
+    context.setProject( &p );
+    context.setMaximumThreads( 1 );
+    context.setCheckpointFile( checkpointFile );
+    QgsProcessingFeedback feedback;
+    QVariantMap params;
+    params.insert( QStringLiteral( "LAYER" ), QStringLiteral( "v1" ) );
+    params.insert( QStringLiteral( "translate:TRANSLATED" ), translatedOutput );
+    params.insert( QStringLiteral( "swap:SWAPPED" ), swappedOutput );
+    bool ok = false;
+    model1.run( params, context, &feedback, &ok );
+    return ok;
+  };
+
+  const auto featureCount = []( const QString & output ) -> long long
+  {
+    QgsVectorLayer outputLayer( output, QStringLiteral( "output" ), QStringLiteral( "ogr" ) );
+    return outputLayer.isValid() ? outputLayer.featureCount() : -1;
+  };
+
+  // a feature added to an output shows whether the child writing it was run again
+  const auto addFeature = []( const QString & output ) -> bool
+  {
+    QgsVectorLayer outputLayer( output, QStringLiteral( "output" ), QStringLiteral( "ogr" ) );
+    QgsFeature f( outputLayer.fields() );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( -1, -1 ) ) );
+    return outputLayer.isValid() && outputLayer.dataProvider()->addFeature( f );
+  };
+
+  // the children executed before the failure are saved
+  QVERIFY( !runModel( true ) );
+  QVERIFY( QFile::exists( checkpointFile ) );
+  QCOMPARE( featureCount( translatedOutput ), 10LL );
+  QCOMPARE( featureCount( swappedOutput ), 10LL );
+
+  // the translation whose output exists is skipped, the swap whose output is missing is run again
+  QVERIFY( addFeature( translatedOutput ) );
+  QVERIFY( QFile::remove( swappedOutput ) );
+  QVERIFY( runModel( false ) );
+  QVERIFY( !QFile::exists( checkpointFile ) );
+  QCOMPARE( featureCount( translatedOutput ), 11LL );
+  QCOMPARE( featureCount( swappedOutput ), 11LL );
+
+  // the swap depending on the translation which is run again is run again too, even though its output exists
+  QVERIFY( !runModel( true ) );
+  QVERIFY( QFile::exists( checkpointFile ) );
+  QCOMPARE( featureCount( translatedOutput ), 10LL );
+  QVERIFY( addFeature( swappedOutput ) );
+  QCOMPARE( featureCount( swappedOutput ), 11LL );
+  QVERIFY( QFile::remove( translatedOutput ) );
+  QVERIFY( runModel( false ) );
+  QVERIFY( !QFile::exists( checkpointFile ) );
+  QCOMPARE( featureCount( translatedOutput ), 10LL );
+  QCOMPARE( featureCount( swappedOutput ), 10LL );
+}
+
 void TestQgsProcessingModelAlgorithm::modelWithProviderWithLimitedTypes()
 {
   QgsApplication::processingRegistry()->addProvider( new DummyProvider4() );
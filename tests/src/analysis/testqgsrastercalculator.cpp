@@ -20,6 +20,8 @@ Email                : nyall dot dawson at gmail dot com
 
 #include "qgsrastercalculator.h"
 #include "qgsrastercalcnode.h"
+#include "qgsrastercalckernel.h"
+#include "qgsrasterblock.h"
 #include "qgsrasterdataprovider.h"
 #include "qgsrasterlayer.h"
 #include "qgsrastermatrix.h"
@@ -56,6 +58,8 @@ class TestQgsRasterCalculator : public QObject
 
     void rasterRefOp();
     void dualOpRasterRaster(); //test dual op on raster ref and raster ref
+    void compiledKernel_data();
+    void compiledKernel(); //test compiled kernels give the same results as the node tree
 
     void calcWithLayers();
     void calcWithReprojectedLayers();
@@ -439,6 +443,70 @@ void TestQgsRasterCalculator::dualOpRasterRaster()
   QCOMPARE( result.data()[5], -9999.0 );
 }
 
+void TestQgsRasterCalculator::compiledKernel_data()
+{
+  QTest::addColumn<QString>( "formula" );
+
+  QTest::newRow( "plus" ) << QStringLiteral( "\"raster1\" + \"raster2\"" );
+  QTest::newRow( "ndvi" ) << QStringLiteral( "( \"raster2\" - \"raster1\" ) / ( \"raster2\" + \"raster1\" )" );
+  QTest::newRow( "constants" ) << QStringLiteral( "2 * \"raster1\" ^ 2 - 3.5" );
+  QTest::newRow( "functions" ) << QStringLiteral( "sqrt( abs( \"raster1\" ) ) + log10( \"raster2\" ) - ln( \"raster1\" )" );
+  QTest::newRow( "comparisons" ) << QStringLiteral( "( \"raster1\" > 2 ) AND ( \"raster2\" <= 15 ) OR \"raster1\" = \"raster2\"" );
+  QTest::newRow( "min max" ) << QStringLiteral( "max( \"raster1\", min( \"raster2\", 3 ) )" );
+  QTest::newRow( "if" ) << QStringLiteral( "if( \"raster1\" > 1, \"raster2\", -\"raster1\" )" );
+  QTest::newRow( "same reference" ) << QStringLiteral( "\"raster1\" * \"raster1\" / \"raster1\"" );
+}
+
+void TestQgsRasterCalculator::compiledKernel()
+{
+  QFETCH( QString, formula );
+
+  QgsRasterBlock m1( Qgis::DataType::Float32, 3, 4 );
+  m1.setNoDataValue( -1.0 );
+  QgsRasterBlock m2( Qgis::DataType::Int16, 3, 4 );
+  m2.setNoDataValue( -2.0 );
+  const double values1[] = { 1, 2, -2, -1, 5, 0, 3.5, 4, 13, 0.5, 2, 7 };
+  const double values2[] = { -1, -2, 13, -2, 15, -1, 0, 4, 13, 2, 0, 9 };
+  for ( int i = 0; i < 12; ++i )
+  {
+    m1.setValue( i / 3, i % 3, values1[i] );
+    m2.setValue( i / 3, i % 3, values2[i] );
+  }
+  QMap<QString, QgsRasterBlock *> rasterData;
+  rasterData.insert( QStringLiteral( "raster1" ), &m1 );
+  rasterData.insert( QStringLiteral( "raster2" ), &m2 );
+
+  QString error;
+  std::unique_ptr< QgsRasterCalcNode > node( QgsRasterCalcNode::parseRasterCalcString( formula, error ) );
+  QVERIFY2( node, error.toLocal8Bit().constData() );
+
+  const double nodataValue = -FLT_MAX;
+  std::unique_ptr< QgsRasterCalcKernel > kernel = QgsRasterCalcKernel::compile( *node, nodataValue );
+  QVERIFY( kernel );
+
+  std::vector< const QgsRasterBlock * > inputs;
+  for ( const QString &reference : kernel->rasterReferences() )
+    inputs.push_back( rasterData.value( reference ) );
+  std::vector< float > kernelResult( 12 );
+  kernel->evaluate( inputs, kernelResult.size(), kernelResult.data() );
+
+  QgsRasterMatrix result( 3, 4, nullptr, nodataValue );
+  QVERIFY( node->calculate( rasterData, result ) );
+  for ( int i = 0; i < 12; ++i )
+  {
+    const float expected = static_cast< float >( result.data()[i] );
+    if ( std::isnan( expected ) )
+      QVERIFY( std::isnan( kernelResult[i] ) );
+    else
+      QCOMPARE( kernelResult[i], expected );
+  }
+
+  // matrices cannot be compiled
+  QgsRasterMatrix *matrix = new QgsRasterMatrix( 2, 2, new double[4] { 1, 2, 3, 4 }, -1 );
+  const QgsRasterCalcNode matrixNode( QgsRasterCalcNode::opPLUS, new QgsRasterCalcNode( matrix ), new QgsRasterCalcNode( 1.0 ) );
+  QVERIFY( !QgsRasterCalcKernel::compile( matrixNode, nodataValue ) );
+}
+
 void TestQgsRasterCalculator::calcWithLayers()
 {
   QgsRasterCalculatorEntry entry1;
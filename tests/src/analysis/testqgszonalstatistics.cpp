@@ -21,6 +21,7 @@
 #include "qgsvectorlayer.h"
 #include "qgsrasterlayer.h"
 #include "qgszonalstatistics.h"
+#include "qgszonalspans.h"
 #include "qgsproject.h"
 #include "qgsvectorlayerutils.h"
 
@@ -43,6 +44,7 @@ class TestQgsZonalStatistics : public QObject
     void testNoData();
     void testSmallPolygons();
     void testShortName();
+    void testSpans();
 
   private:
     QgsVectorLayer *mVectorLayer = nullptr;
@@ -360,5 +362,43 @@ void TestQgsZonalStatistics::testShortName()
   QCOMPARE( QgsZonalStatistics::shortName( QgsZonalStatistics::Variance ), QStringLiteral( "variance" ) );
 }
 
+void TestQgsZonalStatistics::testSpans()
+{
+  QgsZonalSpans spans( QgsRectangle( 0, 0, 10, 10 ), 10, 10, 1, 1 );
+
+  // cell centers on the boundary are not part of a zone
+  QCOMPARE( spans.addZone( 0, QgsGeometry::fromWkt( QStringLiteral( "Polygon((2 2, 5 2, 5 5, 2 5, 2 2))" ) ) ), 9ULL );
+  QCOMPARE( spans.addZone( 1, QgsGeometry::fromWkt( QStringLiteral( "Polygon((2.5 2.5, 5.5 2.5, 5.5 5.5, 2.5 5.5, 2.5 2.5))" ) ) ), 4ULL );
+  QCOMPARE( spans.addZone( 2, QgsGeometry::fromWkt( QStringLiteral( "Polygon((0 0, 10 0, 10 10, 0 10, 0 0),(3 3, 7 3, 7 7, 3 7, 3 3))" ) ) ), 84ULL );
+  QCOMPARE( spans.addZone( 3, QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon(((-5 -5, 1 -5, 1 1, -5 1, -5 -5)),((8 8, 8 20, 20 20, 20 8, 8 8)))" ) ) ), 5ULL );
+  QCOMPARE( spans.addZone( 4, QgsGeometry::fromWkt( QStringLiteral( "Polygon((1 1, 9 1, 5 9, 1 1))" ) ) ), 32ULL );
+  QCOMPARE( spans.addZone( 5, QgsGeometry::fromWkt( QStringLiteral( "Polygon((20 20, 30 20, 30 30, 20 20))" ) ) ), 0ULL );
+  spans.finalize();
+
+  // row with a center at y = 3.5
+  QList< QList< int > > row;
+  for ( const QgsZonalSpans::Span *span = spans.rowBegin( 6 ); span != spans.rowEnd( 6 ); ++span )
+  {
+    row << QList< int >( { span->zone, span->firstColumn, span->endColumn } );
+  }
+  QCOMPARE( row, QList< QList< int > >( {
+    { 0, 2, 5 },
+    { 1, 3, 5 },
+    { 2, 0, 3 },
+    { 2, 7, 10 },
+    { 4, 2, 8 }
+  } ) );
+
+  row.clear();
+  for ( const QgsZonalSpans::Span *span = spans.rowBegin( 9 ); span != spans.rowEnd( 9 ); ++span )
+  {
+    row << QList< int >( { span->zone, span->firstColumn, span->endColumn } );
+  }
+  QCOMPARE( row, QList< QList< int > >( {
+    { 2, 0, 10 },
+    { 3, 0, 1 }
+  } ) );
+}
+
 QGSTEST_MAIN( TestQgsZonalStatistics )
 #include "testqgszonalstatistics.moc"
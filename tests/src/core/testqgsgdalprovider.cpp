@@ -13,6 +13,7 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <algorithm>
 #include <limits>
 
 // GDAL includes
@@ -26,6 +27,7 @@
 #include <QApplication>
 #include <QFileInfo>
 #include <QDir>
+#include <QTemporaryDir>
 
 //qgis includes...
 #include <qgis.h>
@@ -37,6 +39,9 @@
 #include "qgsprovidermetadata.h"
 #include "qgsprovidersublayerdetails.h"
 #include "qgsrasterlayer.h"
+#include "qgsgdaloverviewcache.h"
+#include "qgsogrutils.h"
+#include "qgssettingsentryimpl.h"
 
 /**
  * \ingroup UnitTests
@@ -76,6 +81,7 @@ class TestQgsGdalProvider : public QgsTest
     void testGdalProviderQuerySublayersFastScan();
     void testGdalProviderQuerySublayersFastScan_NetCDF();
     void testGdalProviderAbsoluteRelativeUri();
+    void overviewCache();
 
   private:
     QString mTestDataDir;
@@ -866,5 +872,99 @@ void TestQgsGdalProvider::testGdalProviderAbsoluteRelativeUri()
   QCOMPARE( mGdalMetadata->relativeToAbsoluteUri( relativeUri, context ), absoluteUri );
 }
 
+void TestQgsGdalProvider::overviewCache()
+{
+  // a 2048 x 2048 raster with a per dataset mask, whose values are constant over blocks of 4 x 4 pixels
+  const QTemporaryDir dir;
+  const QString fileName = dir.filePath( QStringLiteral( "no_overviews.tif" ) );
+  const int size = 2048;
+  {
+    const gdal::dataset_unique_ptr dataset( GDALCreate( GDALGetDriverByName( "GTiff" ), fileName.toUtf8().constData(), size, size, 1, GDT_Byte, nullptr ) );
+    QVERIFY( dataset );
+    GDALRasterBandH band = GDALGetRasterBand( dataset.get(), 1 );
+    QCOMPARE( GDALCreateMaskBand( band, GMF_PER_DATASET ), CE_None );
+    std::vector< unsigned char > values( size );
+    std::vector< unsigned char > mask( size );
+    for ( int row = 0; row < size; ++row )
+    {
+      for ( int col = 0; col < size; ++col )
+      {
+        values[col] = static_cast< unsigned char >( ( ( row / 4 ) * 7 + ( col / 4 ) * 3 ) % 251 );
+        mask[col] = ( row / 4 + col / 4 ) % 5 == 0 ? 0 : 255;
+      }
+      QCOMPARE( GDALRasterIO( band, GF_Write, 0, row, size, 1, values.data(), size, 1, GDT_Byte, 0, 0 ), CE_None );
+      QCOMPARE( GDALRasterIO( GDALGetMaskBand( band ), GF_Write, 0, row, size, 1, mask.data(), size, 1, GDT_Byte, 0, 0 ), CE_None );
+    }
+  }
+  const QList< GDALDataType > dataTypes { GDT_Byte, GDT_Byte };
+
+  // disabled by default
+  QVERIFY( !QgsGdalOverviewCache::settingsEnabled->value() );
+  QVERIFY( !QgsGdalOverviewCache::create( fileName, size, size, dataTypes, true ) );
+
+  QgsGdalOverviewCache::settingsEnabled->setValue( true );
+  QgsGdalOverviewCache::settingsMaximumMemory->setValue( 1 );
+
+  // remote, vsi and small rasters are not cached
+  QVERIFY( !QgsGdalOverviewCache::create( QStringLiteral( "/vsicurl/https://www.qgis.org/dataset.tif" ), size, size, dataTypes, true ) );
+  QVERIFY( !QgsGdalOverviewCache::create( QStringLiteral( "/vsizip/%1/raster.zip/raster.tif" ).arg( dir.path() ), size, size, dataTypes, true ) );
+  QVERIFY( !QgsGdalOverviewCache::create( fileName, 512, 512, dataTypes, true ) );
+
+  // the finest power of two decimation fitting 1 MB, the bands and the mask exposed as alpha use 512 KB
+  std::shared_ptr< QgsGdalOverviewCache > cache = QgsGdalOverviewCache::create( fileName, size, size, dataTypes, true );
+  QVERIFY( cache );
+  QCOMPARE( cache->factor(), 4 );
+
+  const int bufferSize = 256;
+  std::vector< unsigned char > data( bufferSize * bufferSize );
+  // finer than the overview
+  QVERIFY( !cache->read( 1, 0, 0, size, size, data.data(), size / 2, size / 2, GDT_Byte ) );
+  QCOMPARE( QgsGdalOverviewCache::totalMemoryUsage(), 0LL );
+  // starts the build
+  QVERIFY( !cache->read( 1, 0, 0, size, size, data.data(), bufferSize, bufferSize, GDT_Byte ) );
+  QCOMPARE( QgsGdalOverviewCache::totalMemoryUsage(), 512LL * 1024 );
+  QTRY_VERIFY_WITH_TIMEOUT( cache->read( 1, 0, 0, size, size, data.data(), bufferSize, bufferSize, GDT_Byte ), 20000 );
+
+  // the values are constant over the pixels sampled for the overview, so they match a direct read
+  const gdal::dataset_unique_ptr dataset( GDALOpen( fileName.toUtf8().constData(), GA_ReadOnly ) );
+  GDALRasterBandH band = GDALGetRasterBand( dataset.get(), 1 );
+  std::vector< unsigned char > expected( bufferSize * bufferSize );
+  QCOMPARE( GDALRasterIO( band, GF_Read, 0, 0, size, size, expected.data(), bufferSize, bufferSize, GDT_Byte, 0, 0 ), CE_None );
+  QVERIFY( data == expected );
+
+  // the alpha band is read from the mask
+  QVERIFY( cache->read( 2, 0, 0, size, size, data.data(), bufferSize, bufferSize, GDT_Byte ) );
+  QCOMPARE( GDALRasterIO( GDALGetMaskBand( band ), GF_Read, 0, 0, size, size, expected.data(), bufferSize, bufferSize, GDT_Byte, 0, 0 ), CE_None );
+  QVERIFY( data == expected );
+  QVERIFY( std::count( data.begin(), data.end(), 0 ) > 0 );
+
+  // a window of the raster
+  QVERIFY( cache->read( 1, 512, 1024, 1024, 512, data.data(), 128, 64, GDT_Byte ) );
+  QCOMPARE( GDALRasterIO( band, GF_Read, 512, 1024, 1024, 512, expected.data(), 128, 64, GDT_Byte, 0, 0 ), CE_None );
+  QVERIFY( std::equal( expected.begin(), expected.begin() + 128 * 64, data.begin() ) );
+
+  // the memory of all the overviews is limited
+  std::shared_ptr< QgsGdalOverviewCache > cache2 = QgsGdalOverviewCache::create( fileName, size, size, dataTypes, true );
+  std::shared_ptr< QgsGdalOverviewCache > cache3 = QgsGdalOverviewCache::create( fileName, size, size, dataTypes, true );
+  QVERIFY( !cache2->read( 1, 0, 0, size, size, data.data(), bufferSize, bufferSize, GDT_Byte ) );
+  QCOMPARE( QgsGdalOverviewCache::totalMemoryUsage(), 1024LL * 1024 );
+  QVERIFY( !cache3->read( 1, 0, 0, size, size, data.data(), bufferSize, bufferSize, GDT_Byte ) );
+  QCOMPARE( QgsGdalOverviewCache::totalMemoryUsage(), 1024LL * 1024 );
+
+  // until another overview is dropped
+  cache.reset();
+  QCOMPARE( QgsGdalOverviewCache::totalMemoryUsage(), 512LL * 1024 );
+  QVERIFY( !cache3->read( 1, 0, 0, size, size, data.data(), bufferSize, bufferSize, GDT_Byte ) );
+  QCOMPARE( QgsGdalOverviewCache::totalMemoryUsage(), 1024LL * 1024 );
+  QTRY_VERIFY_WITH_TIMEOUT( cache3->read( 1, 0, 0, size, size, data.data(), bufferSize, bufferSize, GDT_Byte ), 20000 );
+
+  cache2.reset();
+  cache3.reset();
+  QCOMPARE( QgsGdalOverviewCache::totalMemoryUsage(), 0LL );
+
+  QgsGdalOverviewCache::settingsEnabled->remove();
+  QgsGdalOverviewCache::settingsMaximumMemory->remove();
+}
+
 QGSTEST_MAIN( TestQgsGdalProvider )
 #include "testqgsgdalprovider.moc"
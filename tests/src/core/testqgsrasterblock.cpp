@@ -20,6 +20,7 @@
 
 #include "qgsrasterlayer.h"
 #include "qgsrasterdataprovider.h"
+#include "qgsrasterblockkernels.h"
 
 /**
  * \ingroup UnitTests
@@ -39,6 +40,8 @@ class TestQgsRasterBlock : public QObject
 
     void testBasic();
     void testWrite();
+    void testReadValues();
+    void testKernels();
 
   private:
 
@@ -242,6 +245,114 @@ void TestQgsRasterBlock::testWrite()
   delete block;
 }
 
+void TestQgsRasterBlock::testReadValues()
+{
+  // no data value
+  QgsRasterBlock block( Qgis::DataType::Int16, 10, 3 );
+  block.setNoDataValue( -1 );
+  for ( int i = 0; i < 30; ++i )
+    block.setValue( static_cast< qgssize >( i ), i % 7 == 0 ? -1 : i * 10 );
+
+  double values[30];
+  quint8 noData[30];
+  QVERIFY( block.readValues( 0, 30, values, noData ) );
+  for ( int i = 0; i < 30; ++i )
+  {
+    bool isNoData = false;
+    QCOMPARE( values[i], block.valueAndNoData( static_cast< qgssize >( i ), isNoData ) );
+    QCOMPARE( static_cast< bool >( noData[i] ), isNoData );
+  }
+
+  // range in the middle of a row
+  QVERIFY( block.readValues( 13, 5, values ) );
+  QCOMPARE( values[0], 130.0 );
+  QCOMPARE( values[4], 170.0 );
+
+  // out of block range
+  QVERIFY( !block.readValues( 25, 10, values, noData ) );
+
+  // no data bitmap, spanning several rows
+  QgsRasterBlock bitmapBlock( Qgis::DataType::Float32, 10, 3 );
+  for ( int i = 0; i < 30; ++i )
+    bitmapBlock.setValue( static_cast< qgssize >( i ), i / 2.0 );
+  bitmapBlock.setIsNoData( 0, 9 );
+  bitmapBlock.setIsNoData( 1, 0 );
+  bitmapBlock.setIsNoData( 2, 8 );
+
+  QVERIFY( bitmapBlock.readValues( 5, 25, values, noData ) );
+  for ( int i = 0; i < 25; ++i )
+  {
+    QCOMPARE( values[i], ( i + 5 ) / 2.0 );
+    QCOMPARE( static_cast< bool >( noData[i] ), bitmapBlock.isNoData( static_cast< qgssize >( i + 5 ) ) );
+  }
+  QCOMPARE( noData[4], static_cast< quint8 >( 1 ) );
+  QCOMPARE( noData[5], static_cast< quint8 >( 1 ) );
+  QCOMPARE( noData[23], static_cast< quint8 >( 1 ) );
+
+  // color blocks cannot be read as values
+  QgsRasterBlock colorBlock( Qgis::DataType::ARGB32, 2, 2 );
+  QVERIFY( !colorBlock.readValues( 0, 4, values ) );
+}
+
+void TestQgsRasterBlock::testKernels()
+{
+  QgsRasterBlock block( Qgis::DataType::Float64, 5, 2 );
+  block.setNoDataValue( -9999 );
+  const double blockValues[] = { 3, -9999, 12.5, std::numeric_limits<double>::infinity(), -4, 8, std::numeric_limits<double>::quiet_NaN(), 0, 1, -9999 };
+  for ( int i = 0; i < 10; ++i )
+    block.setValue( static_cast< qgssize >( i ), blockValues[i] );
+
+  // nodata, infinite and NaN values are ignored
+  double minimum = 0;
+  double maximum = 0;
+  QVERIFY( QgsRasterBlockKernels::minimumMaximum( block, minimum, maximum ) );
+  QCOMPARE( minimum, -4.0 );
+  QCOMPARE( maximum, 12.5 );
+
+  QgsRasterBlock emptyBlock( Qgis::DataType::Float64, 2, 1 );
+  emptyBlock.setNoDataValue( -9999 );
+  emptyBlock.setValue( 0, 0, -9999 );
+  emptyBlock.setValue( 0, 1, -9999 );
+  QVERIFY( !QgsRasterBlockKernels::minimumMaximum( emptyBlock, minimum, maximum ) );
+
+  // stretch matches the linear min max enhancement
+  const double values[] = { -10, 0, 1, 50, 99.9, 100, 150 };
+  quint8 levels[7];
+  QgsRasterBlockKernels::linearStretch( values, 7, 0, 100, levels );
+  QCOMPARE( levels[0], static_cast< quint8 >( 0 ) );
+  QCOMPARE( levels[1], static_cast< quint8 >( 0 ) );
+  QCOMPARE( levels[2], static_cast< quint8 >( 2 ) );
+  QCOMPARE( levels[3], static_cast< quint8 >( 127 ) );
+  QCOMPARE( levels[4], static_cast< quint8 >( 254 ) );
+  QCOMPARE( levels[5], static_cast< quint8 >( 255 ) );
+  QCOMPARE( levels[6], static_cast< quint8 >( 255 ) );
+
+  quint8 noData[7] = { 0, 1, 0, 0, 0, 0, 0 };
+  QgsRasterBlockKernels::maskOutsideRange( values, 7, 0, 100, noData );
+  const quint8 expectedMask[7] = { 1, 1, 0, 0, 0, 0, 1 };
+  for ( int i = 0; i < 7; ++i )
+    QCOMPARE( noData[i], expectedMask[i] );
+
+  // colors
+  const std::array<QRgb, 256> opaque = QgsRasterBlockKernels::grayTable( 1.0, false );
+  QCOMPARE( opaque[100], qRgba( 100, 100, 100, 255 ) );
+  const std::array<QRgb, 256> inverted = QgsRasterBlockKernels::grayTable( 0.5, true );
+  QCOMPARE( inverted[55], qRgba( 100, 100, 100, 127 ) );
+
+  QRgb colors[7];
+  QgsRasterBlockKernels::lookupColors( levels, noData, 7, opaque, qRgba( 0, 0, 0, 0 ), colors );
+  QCOMPARE( colors[0], qRgba( 0, 0, 0, 0 ) );
+  QCOMPARE( colors[3], qRgba( 127, 127, 127, 255 ) );
+
+  const quint8 red[] = { 10, 20 };
+  const quint8 green[] = { 30, 40 };
+  const quint8 blue[] = { 50, 60 };
+  const quint8 rgbNoData[] = { 0, 1 };
+  QgsRasterBlockKernels::packRgb( red, green, blue, rgbNoData, 2, qRgba( 1, 2, 3, 4 ), colors );
+  QCOMPARE( colors[0], qRgb( 10, 30, 50 ) );
+  QCOMPARE( colors[1], qRgba( 1, 2, 3, 4 ) );
+}
+
 QGSTEST_MAIN( TestQgsRasterBlock )
 
 #include "testqgsrasterblock.moc"
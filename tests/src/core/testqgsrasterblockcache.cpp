@@ -0,0 +1,157 @@
+/***************************************************************************
+     testqgsrasterblockcache.cpp
+     --------------------------------------
+    Date                 : October 2023
+    Copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+
+#include "qgsrasterblockcache.h"
+#include "qgsrasterlayer.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterblock.h"
+#include "qgsrectangle.h"
+
+#include <memory>
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the QgsRasterBlockCache class.
+ */
+class TestQgsRasterBlockCache : public QObject
+{
+    Q_OBJECT
+  public:
+    TestQgsRasterBlockCache() = default;
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void insertAndRetrieve();
+    void invalidate();
+    void eviction();
+    void gdalProviderBlocks();
+
+  private:
+    int mMaxCost = 0;
+};
+
+void TestQgsRasterBlockCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  mMaxCost = QgsRasterBlockCache::maxCost();
+}
+
+void TestQgsRasterBlockCache::cleanupTestCase()
+{
+  QgsRasterBlockCache::setMaxCost( mMaxCost );
+  QgsApplication::exitQgis();
+}
+
+void TestQgsRasterBlockCache::insertAndRetrieve()
+{
+  const QgsRectangle extent( 0, 0, 10, 20 );
+  const QByteArray data( "0123456789" );
+  QgsRasterBlockCache::insertBlock( QStringLiteral( "source" ), 1, extent, 2, 5, data );
+
+  QByteArray cached;
+  QVERIFY( QgsRasterBlockCache::block( QStringLiteral( "source" ), 1, extent, 2, 5, cached ) );
+  QCOMPARE( cached, data );
+
+  // any difference in the request is another block
+  QVERIFY( !QgsRasterBlockCache::block( QStringLiteral( "source" ), 2, extent, 2, 5, cached ) );
+  QVERIFY( !QgsRasterBlockCache::block( QStringLiteral( "other source" ), 1, extent, 2, 5, cached ) );
+  QVERIFY( !QgsRasterBlockCache::block( QStringLiteral( "source" ), 1, QgsRectangle( 0, 0, 10, 20.0000001 ), 2, 5, cached ) );
+  QVERIFY( !QgsRasterBlockCache::block( QStringLiteral( "source" ), 1, extent, 5, 2, cached ) );
+}
+
+void TestQgsRasterBlockCache::invalidate()
+{
+  const QgsRectangle extent( 0, 0, 10, 10 );
+  QgsRasterBlockCache::insertBlock( QStringLiteral( "dataset\nsettings 1" ), 1, extent, 1, 1, QByteArray( "a" ) );
+  QgsRasterBlockCache::insertBlock( QStringLiteral( "dataset\nsettings 2" ), 1, extent, 1, 1, QByteArray( "b" ) );
+  QgsRasterBlockCache::insertBlock( QStringLiteral( "dataset 2\nsettings 1" ), 1, extent, 1, 1, QByteArray( "c" ) );
+
+  QgsRasterBlockCache::invalidate( QStringLiteral( "dataset\n" ) );
+
+  QByteArray cached;
+  QVERIFY( !QgsRasterBlockCache::block( QStringLiteral( "dataset\nsettings 1" ), 1, extent, 1, 1, cached ) );
+  QVERIFY( !QgsRasterBlockCache::block( QStringLiteral( "dataset\nsettings 2" ), 1, extent, 1, 1, cached ) );
+  QVERIFY( QgsRasterBlockCache::block( QStringLiteral( "dataset 2\nsettings 1" ), 1, extent, 1, 1, cached ) );
+  QCOMPARE( cached, QByteArray( "c" ) );
+}
+
+void TestQgsRasterBlockCache::eviction()
+{
+  QgsRasterBlockCache::setMaxCost( 4000 );
+  const QgsRectangle extent( 0, 0, 10, 10 );
+  for ( int i = 0; i < 10; ++i )
+  {
+    QgsRasterBlockCache::insertBlock( QStringLiteral( "eviction" ), i, extent, 10, 100, QByteArray( 1000, static_cast< char >( i ) ) );
+  }
+  QVERIFY( QgsRasterBlockCache::totalCost() <= 4000 );
+
+  // the least recently used blocks were evicted
+  QByteArray cached;
+  QVERIFY( !QgsRasterBlockCache::block( QStringLiteral( "eviction" ), 0, extent, 10, 100, cached ) );
+  QVERIFY( QgsRasterBlockCache::block( QStringLiteral( "eviction" ), 9, extent, 10, 100, cached ) );
+  QCOMPARE( cached, QByteArray( 1000, static_cast< char >( 9 ) ) );
+
+  // blocks using a large part of the cache are not cached
+  QgsRasterBlockCache::insertBlock( QStringLiteral( "eviction" ), 10, extent, 10, 300, QByteArray( 3000, 'x' ) );
+  QVERIFY( !QgsRasterBlockCache::block( QStringLiteral( "eviction" ), 10, extent, 10, 300, cached ) );
+
+  QgsRasterBlockCache::setMaxCost( mMaxCost );
+}
+
+void TestQgsRasterBlockCache::gdalProviderBlocks()
+{
+  const QString raster = QStringLiteral( TEST_DATA_DIR ) + "/raster/band1_byte_ct_epsg4326.tif";
+  const std::unique_ptr< QgsRasterLayer > layer = std::make_unique< QgsRasterLayer >( raster, QStringLiteral( "raster" ) );
+  QVERIFY( layer->isValid() );
+
+  // the request extends outside of the raster, the part outside must stay no data
+  QgsRectangle extent = layer->extent();
+  extent.setXMaximum( extent.xMaximum() + extent.width() / 2 );
+  const int width = 150;
+  const int height = 100;
+
+  const std::unique_ptr< QgsRasterBlock > read( layer->dataProvider()->block( 1, extent, width, height ) );
+  const std::unique_ptr< QgsRasterBlock > cached( layer->dataProvider()->block( 1, extent, width, height ) );
+  QVERIFY( read && read->isValid() );
+  QVERIFY( cached && cached->isValid() );
+  for ( int row = 0; row < height; ++row )
+  {
+    for ( int col = 0; col < width; ++col )
+    {
+      QCOMPARE( cached->isNoData( row, col ), read->isNoData( row, col ) );
+      if ( !read->isNoData( row, col ) )
+        QCOMPARE( cached->value( row, col ), read->value( row, col ) );
+    }
+  }
+
+  // another layer over the same dataset shares the cached blocks
+  const std::unique_ptr< QgsRasterLayer > otherLayer = std::make_unique< QgsRasterLayer >( raster, QStringLiteral( "raster" ) );
+  const std::unique_ptr< QgsRasterBlock > inside( layer->dataProvider()->block( 1, layer->extent(), width, height ) );
+  const std::unique_ptr< QgsRasterBlock > shared( otherLayer->dataProvider()->block( 1, layer->extent(), width, height ) );
+  QVERIFY( inside && inside->isValid() );
+  QVERIFY( shared && shared->isValid() );
+  QCOMPARE( shared->data(), inside->data() );
+}
+
+QGSTEST_MAIN( TestQgsRasterBlockCache )
+#include "testqgsrasterblockcache.moc"
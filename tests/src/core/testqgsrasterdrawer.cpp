@@ -0,0 +1,138 @@
+/***************************************************************************
+     testqgsrasterdrawer.cpp
+     --------------------------------------
+    Date                 : October 2023
+    Copyright            : (C) 2023 by QGIS.org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QPainter>
+#include <QThreadPool>
+
+#include "qgsrasterlayer.h"
+#include "qgsrasterdrawer.h"
+#include "qgsrasteriterator.h"
+#include "qgsrasterpipe.h"
+#include "qgsrasterviewport.h"
+#include "qgsmaptopixel.h"
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the QgsRasterDrawer class.
+ */
+class TestQgsRasterDrawer : public QObject
+{
+    Q_OBJECT
+  public:
+    TestQgsRasterDrawer() = default;
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void testConcurrentDraw();
+    void testConcurrentDrawCanceled();
+
+  private:
+
+    QImage draw( int maximumThreads, QgsRasterBlockFeedback *feedback = nullptr );
+
+    QgsRasterLayer *mpRasterLayer = nullptr;
+    int mMaxThreadCount = 0;
+};
+
+//runs before all tests
+void TestQgsRasterDrawer::initTestCase()
+{
+  // init QGIS's paths - true means that all path will be inited from prefix
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  const QString testDataDir = QStringLiteral( TEST_DATA_DIR ); //defined in CmakeLists.txt
+  mpRasterLayer = new QgsRasterLayer( testDataDir + "/big_raster.tif", QStringLiteral( "big_raster" ) );
+  QVERIFY( mpRasterLayer && mpRasterLayer->isValid() );
+
+  // workers are only started on idle threads of the global pool
+  mMaxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 4 );
+}
+
+//runs after all tests
+void TestQgsRasterDrawer::cleanupTestCase()
+{
+  QThreadPool::globalInstance()->setMaxThreadCount( mMaxThreadCount );
+  delete mpRasterLayer;
+
+  QgsApplication::exitQgis();
+}
+
+QImage TestQgsRasterDrawer::draw( int maximumThreads, QgsRasterBlockFeedback *feedback )
+{
+  // 1200 x 1000 pixels at the native resolution of the raster, from its top left corner
+  const int width = 1200;
+  const int height = 1000;
+  const QgsRectangle layerExtent = mpRasterLayer->extent();
+  const QgsRectangle extent( layerExtent.xMinimum(), layerExtent.yMaximum() - height * mpRasterLayer->rasterUnitsPerPixelY(),
+                             layerExtent.xMinimum() + width * mpRasterLayer->rasterUnitsPerPixelX(), layerExtent.yMaximum() );
+
+  QgsRasterViewPort viewPort;
+  viewPort.mTopLeftPoint = QgsPointXY( 0, 0 );
+  viewPort.mBottomRightPoint = QgsPointXY( width, height );
+  viewPort.mWidth = width;
+  viewPort.mHeight = height;
+  viewPort.mDrawnExtent = extent;
+  const QgsMapToPixel mapToPixel( mpRasterLayer->rasterUnitsPerPixelX(), extent.center().x(), extent.center().y(), width, height, 0 );
+
+  QImage image( width, height, QImage::Format_ARGB32_Premultiplied );
+  image.fill( Qt::transparent );
+  QPainter painter( &image );
+
+  QgsRasterPipe *pipe = mpRasterLayer->pipe();
+  QgsRasterIterator iterator( pipe->last(), maximumThreads > 1 ? 1 : 0 );
+  iterator.setMaximumTileWidth( 512 );
+  iterator.setMaximumTileHeight( 512 );
+  QgsRasterDrawer drawer( &iterator );
+  if ( maximumThreads > 1 )
+    drawer.setConcurrentPipe( pipe, maximumThreads );
+  drawer.draw( &painter, &viewPort, &mapToPixel, feedback );
+  painter.end();
+
+  return image;
+}
+
+void TestQgsRasterDrawer::testConcurrentDraw()
+{
+  const QImage expected = draw( 1 );
+  QVERIFY( expected.pixelColor( 0, 0 ).alpha() > 0 );
+  QVERIFY( expected.pixelColor( expected.width() - 1, expected.height() - 1 ).alpha() > 0 );
+
+  // overlapping tiles rendered by several threads with copies of the pipe give the same image
+  const QImage concurrent = draw( 4 );
+  QCOMPARE( concurrent, expected );
+
+  // the original pipe is left usable
+  QCOMPARE( draw( 1 ), expected );
+}
+
+void TestQgsRasterDrawer::testConcurrentDrawCanceled()
+{
+  QgsRasterBlockFeedback feedback;
+  feedback.cancel();
+
+  // workers stop without waiting for their tiles to be painted
+  const QImage image = draw( 4, &feedback );
+  QCOMPARE( image.pixelColor( 0, 0 ).alpha(), 0 );
+}
+
+QGSTEST_MAIN( TestQgsRasterDrawer )
+#include "testqgsrasterdrawer.moc"
@@ -42,6 +42,7 @@ class TestQgsRasterIterator : public QObject
     void testNoBlock();
     void testSubRegion();
     void testPixelOverlap();
+    void testNextWithOverlap();
 
   private:
 
@@ -629,6 +630,51 @@ void TestQgsRasterIterator::testPixelOverlap()
 }
 
 
+void TestQgsRasterIterator::testNextWithOverlap()
+{
+  QgsRasterDataProvider *provider = mpRasterLayer->dataProvider();
+  QVERIFY( provider );
+  QgsRasterIterator it( provider, 20 );
+  it.setMaximumTileHeight( 2500 );
+  it.setMaximumTileWidth( 3000 );
+  it.startRasterRead( 1, mpRasterLayer->width(), mpRasterLayer->height(), mpRasterLayer->extent() );
+
+  int nCols;
+  int nRows;
+  int topLeftCol;
+  int topLeftRow;
+  int tileCols;
+  int tileRows;
+  int tileTopLeftCol;
+  int tileTopLeftRow;
+  QgsRectangle blockExtent;
+
+  // same parts as readNextRasterPart(), without fetching the blocks
+  QVERIFY( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent, tileCols, tileRows, tileTopLeftCol, tileTopLeftRow ) );
+  QCOMPARE( nCols, 3020 );
+  QCOMPARE( nRows, 2520 );
+  QCOMPARE( topLeftCol, 0 );
+  QCOMPARE( topLeftRow, 0 );
+  QCOMPARE( tileCols, 3000 );
+  QCOMPARE( tileRows, 2500 );
+  QCOMPARE( tileTopLeftCol, 0 );
+  QCOMPARE( tileTopLeftRow, 0 );
+  QCOMPARE( blockExtent.xMinimum(), 497470.0 );
+  QCOMPARE( blockExtent.xMaximum(), 497772.0 );
+
+  QVERIFY( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent, tileCols, tileRows, tileTopLeftCol, tileTopLeftRow ) );
+  QCOMPARE( nCols, 3040 );
+  QCOMPARE( nRows, 2520 );
+  QCOMPARE( topLeftCol, 2980 );
+  QCOMPARE( topLeftRow, 0 );
+  QCOMPARE( tileCols, 3000 );
+  QCOMPARE( tileRows, 2500 );
+  QCOMPARE( tileTopLeftCol, 3000 );
+  QCOMPARE( tileTopLeftRow, 0 );
+  QCOMPARE( blockExtent.xMinimum(), mpRasterLayer->extent().xMinimum() + topLeftCol * mpRasterLayer->rasterUnitsPerPixelX() );
+  QCOMPARE( blockExtent.width(), nCols * mpRasterLayer->rasterUnitsPerPixelX() );
+}
+
 QGSTEST_MAIN( TestQgsRasterIterator )
 
 #include "testqgsrasteriterator.moc"
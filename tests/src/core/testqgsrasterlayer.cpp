@@ -79,6 +79,7 @@ class TestQgsRasterLayer : public QgsTest
     void colorRamp2();
     void colorRamp3();
     void colorRamp4();
+    void colorRampLookupTable();
     void landsatBasic();
     void landsatBasic875Qml();
     void checkDimensions();
@@ -91,6 +92,7 @@ class TestQgsRasterLayer : public QgsTest
     void multiBandColorRendererNoData();
     void multiBandColorRendererNoDataColor();
     void palettedRendererNoData();
+    void palettedRendererClassesChange();
     void palettedRendererRasterAttributeTable();
     void palettedRendererNoDataColor();
     void palettedRendererConstantInt();
@@ -343,6 +345,63 @@ void TestQgsRasterLayer::colorRamp4()
                           QgsColorRampShader::Discrete, 10 ) );
 }
 
+void TestQgsRasterLayer::colorRampLookupTable()
+{
+  QgsColorRampShader shader;
+  shader.setColorRampType( QgsColorRampShader::Interpolated );
+  shader.setColorRampItemList( { QgsColorRampShader::ColorRampItem( 10, QColor( 0, 0, 0 ) ),
+                                 QgsColorRampShader::ColorRampItem( 100, QColor( 255, 0, 0, 128 ) ),
+                                 QgsColorRampShader::ColorRampItem( 1000, QColor( 0, 255, 255 ) )
+                               } );
+  shader.setClip( true );
+
+  // integer types get exact tables
+  for ( const Qgis::DataType type : { Qgis::DataType::Byte, Qgis::DataType::Int16 } )
+  {
+    const std::shared_ptr< const QgsColorRampLookupTable > table = shader.lookupTable( type );
+    QVERIFY( table );
+    for ( const double value : { -5.0, 0.0, 10.0, 55.0, 100.0, 255.0, 999.0, 1000.0, 1001.0 } )
+    {
+      if ( !table->covers( value ) )
+        continue;
+      int red, green, blue, alpha;
+      const bool rendered = shader.shade( value, &red, &green, &blue, &alpha );
+      QRgb color;
+      QCOMPARE( table->color( value, color ), rendered );
+      if ( rendered )
+        QCOMPARE( color, qRgba( red, green, blue, alpha ) );
+    }
+  }
+  QVERIFY( !shader.lookupTable( Qgis::DataType::Int32 ) );
+
+  // float tables are opt-in
+  QVERIFY( !shader.lookupTable( Qgis::DataType::Float32 ) );
+  shader.setQuantizedLookupTableSize( 991 );
+  std::shared_ptr< const QgsColorRampLookupTable > floatTable = shader.lookupTable( Qgis::DataType::Float32 );
+  QVERIFY( floatTable );
+  QCOMPARE( floatTable->size(), 991 );
+  QVERIFY( floatTable->covers( 10 ) );
+  QVERIFY( floatTable->covers( 1000 ) );
+  QVERIFY( !floatTable->covers( 1000.5 ) );
+  QRgb color;
+  QVERIFY( floatTable->color( 550.2, color ) );
+  int red, green, blue, alpha;
+  QVERIFY( shader.shade( 550, &red, &green, &blue, &alpha ) );
+  QCOMPARE( color, qRgba( red, green, blue, alpha ) );
+
+  // tables are shared by copies and rebuilt when the shader changes
+  const QgsColorRampShader copy( shader );
+  QCOMPARE( copy.lookupTable( Qgis::DataType::Float32 ).get(), floatTable.get() );
+  shader.setClip( false );
+  QVERIFY( shader.lookupTable( Qgis::DataType::Float32 ).get() != floatTable.get() );
+  QCOMPARE( copy.lookupTable( Qgis::DataType::Float32 ).get(), floatTable.get() );
+
+  // exact ramps are never quantized
+  shader.setColorRampType( QgsColorRampShader::Exact );
+  QVERIFY( !shader.lookupTable( Qgis::DataType::Float64 ) );
+  QVERIFY( shader.lookupTable( Qgis::DataType::UInt16 ) );
+}
+
 void TestQgsRasterLayer::landsatBasic()
 {
   QVERIFY2( mpLandsatRasterLayer->isValid(), "landsat.tif layer is not valid!" );
@@ -736,6 +795,56 @@ void TestQgsRasterLayer::palettedRendererNoData()
   QVERIFY( render( QStringLiteral( "raster_palettedrenderer_nodata" ) ) );
 }
 
+void TestQgsRasterLayer::palettedRendererClassesChange()
+{
+  const QString rasterFileName = mTestDataDir + "raster/with_color_table.tif";
+  std::unique_ptr< QgsRasterLayer> rl = std::make_unique< QgsRasterLayer >( rasterFileName,
+                                        QStringLiteral( "rl" ) );
+  QVERIFY( rl->isValid() );
+  QCOMPARE( rl->dataProvider()->dataType( 1 ), Qgis::DataType::Byte );
+
+  // every byte value gets the same color
+  const auto classesWithColor = []( const QColor & color )
+  {
+    QVector< QVariant > values;
+    for ( int value = 0; value < 256; ++value )
+      values << value;
+    return QgsPalettedRasterRenderer::MultiValueClassData() << QgsPalettedRasterRenderer::MultiValueClass( values, color );
+  };
+  const auto colorCount = []( QgsRasterRenderer * renderer, const QgsRasterLayer * layer, QColor color )
+  {
+    std::unique_ptr< QgsRasterBlock > block( renderer->block( 1, layer->extent(), layer->width(), layer->height() ) );
+    const QImage image = block->image();
+    int count = 0;
+    for ( int y = 0; y < image.height(); ++y )
+    {
+      for ( int x = 0; x < image.width(); ++x )
+      {
+        if ( image.pixelColor( x, y ) == color )
+          count++;
+      }
+    }
+    return count;
+  };
+
+  QgsPalettedRasterRenderer renderer( rl->dataProvider(), 1, classesWithColor( QColor( 0, 255, 0 ) ) );
+  const int green = colorCount( &renderer, rl.get(), QColor( 0, 255, 0 ) );
+  QVERIFY( green > 0 );
+
+  // the dense color table is rebuilt when the classes change
+  renderer.setMultiValueClasses( classesWithColor( QColor( 255, 0, 0 ) ) );
+  QCOMPARE( colorCount( &renderer, rl.get(), QColor( 0, 255, 0 ) ), 0 );
+  QCOMPARE( colorCount( &renderer, rl.get(), QColor( 255, 0, 0 ) ), green );
+
+  // clones render with the same table
+  std::unique_ptr< QgsPalettedRasterRenderer > clone( renderer.clone() );
+  clone->setInput( rl->dataProvider() );
+  QCOMPARE( colorCount( clone.get(), rl.get(), QColor( 255, 0, 0 ) ), green );
+  clone->setMultiValueClasses( classesWithColor( QColor( 0, 0, 255 ) ) );
+  QCOMPARE( colorCount( clone.get(), rl.get(), QColor( 0, 0, 255 ) ), green );
+  QCOMPARE( colorCount( &renderer, rl.get(), QColor( 255, 0, 0 ) ), green );
+}
+
 void TestQgsRasterLayer::palettedRendererRasterAttributeTable()
 {
   const QString rasterFileName = mTestDataDir + "raster/band1_byte_attribute_table_epsg4326.tif";
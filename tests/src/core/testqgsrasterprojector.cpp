@@ -0,0 +1,155 @@
+/***************************************************************************
+     testqgsrasterprojector.cpp
+     --------------------------------------
+    Date                 : October 2023
+    Copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+#include <QDomDocument>
+
+#include "qgsrasterlayer.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterprojector.h"
+#include "qgsrasterblock.h"
+#include "qgscoordinatetransform.h"
+#include "qgsproject.h"
+#include "qgsrasterpipe.h"
+#include "qgssettingsentryenumflag.h"
+
+#include <memory>
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the QgsRasterProjector class.
+ */
+class TestQgsRasterProjector : public QObject
+{
+    Q_OBJECT
+  public:
+    TestQgsRasterProjector() = default;
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void adaptiveMatchesExact_data();
+    void adaptiveMatchesExact();
+    void layerPrecision();
+
+  private:
+
+    QgsRasterLayer *mpRasterLayer = nullptr;
+};
+
+void TestQgsRasterProjector::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  const QString raster = QStringLiteral( TEST_DATA_DIR ) + "/raster/band1_byte_ct_epsg4326.tif";
+  mpRasterLayer = new QgsRasterLayer( raster, QStringLiteral( "raster" ) );
+  QVERIFY( mpRasterLayer && mpRasterLayer->isValid() );
+}
+
+void TestQgsRasterProjector::cleanupTestCase()
+{
+  delete mpRasterLayer;
+
+  QgsApplication::exitQgis();
+}
+
+void TestQgsRasterProjector::adaptiveMatchesExact_data()
+{
+  QTest::addColumn<QString>( "destinationCrs" );
+
+  QTest::newRow( "web mercator" ) << QStringLiteral( "EPSG:3857" );
+  QTest::newRow( "polar stereographic" ) << QStringLiteral( "EPSG:3413" );
+}
+
+void TestQgsRasterProjector::adaptiveMatchesExact()
+{
+  QFETCH( QString, destinationCrs );
+
+  QgsRasterDataProvider *provider = mpRasterLayer->dataProvider();
+  const QgsCoordinateReferenceSystem destCrs( destinationCrs );
+  const QgsCoordinateTransform ct( provider->crs(), destCrs, QgsProject::instance()->transformContext() );
+  const QgsRectangle extent = ct.transformBoundingBox( provider->extent() );
+  const int width = 200;
+  const int height = 150;
+
+  const auto projectedBlock = [ = ]( QgsRasterProjector::Precision precision )
+  {
+    QgsRasterProjector projector;
+    projector.setInput( provider );
+    projector.setCrs( provider->crs(), destCrs, QgsProject::instance()->transformContext() );
+    projector.setPrecision( precision );
+    return std::unique_ptr< QgsRasterBlock >( projector.block( 1, extent, width, height ) );
+  };
+
+  const std::unique_ptr< QgsRasterBlock > exact = projectedBlock( QgsRasterProjector::Exact );
+  const std::unique_ptr< QgsRasterBlock > adaptive = projectedBlock( QgsRasterProjector::Adaptive );
+  QVERIFY( exact && exact->isValid() );
+  QVERIFY( adaptive && adaptive->isValid() );
+
+  // interpolation errors are below a pixel, only a few pixels on the boundaries of source pixels may differ
+  int differences = 0;
+  for ( int row = 0; row < height; ++row )
+  {
+    for ( int col = 0; col < width; ++col )
+    {
+      if ( exact->isNoData( row, col ) != adaptive->isNoData( row, col ) || exact->value( row, col ) != adaptive->value( row, col ) )
+        ++differences;
+    }
+  }
+  QVERIFY2( differences < width * height / 50, QStringLiteral( "%1 pixels differ" ).arg( differences ).toLocal8Bit().constData() );
+
+  // the second block is built from the cached grid
+  const std::unique_ptr< QgsRasterBlock > cached = projectedBlock( QgsRasterProjector::Adaptive );
+  QVERIFY( cached && cached->isValid() );
+  QCOMPARE( cached->data(), adaptive->data() );
+}
+
+void TestQgsRasterProjector::layerPrecision()
+{
+  const QString raster = QStringLiteral( TEST_DATA_DIR ) + "/raster/band1_byte_ct_epsg4326.tif";
+
+  // new layers use the default precision from the settings
+  QgsRasterProjector::settingsDefaultPrecision->setValue( QgsRasterProjector::Adaptive );
+  QgsRasterLayer layer( raster, QStringLiteral( "raster" ) );
+  QgsRasterProjector::settingsDefaultPrecision->remove();
+  QVERIFY( layer.isValid() );
+  QCOMPARE( layer.pipe()->projector()->precision(), QgsRasterProjector::Adaptive );
+
+  // the precision is saved with the layer style
+  QDomDocument doc;
+  QString errorMessage;
+  layer.exportNamedStyle( doc, errorMessage );
+  QVERIFY( errorMessage.isEmpty() );
+
+  QgsRasterLayer otherLayer( raster, QStringLiteral( "raster" ) );
+  QCOMPARE( otherLayer.pipe()->projector()->precision(), QgsRasterProjector::Approximate );
+  QVERIFY( otherLayer.importNamedStyle( doc, errorMessage ) );
+  QCOMPARE( otherLayer.pipe()->projector()->precision(), QgsRasterProjector::Adaptive );
+
+  // styles without a precision use the approximate precision
+  layer.pipe()->projector()->setPrecision( QgsRasterProjector::Approximate );
+  doc.clear();
+  layer.exportNamedStyle( doc, errorMessage );
+  QVERIFY( otherLayer.importNamedStyle( doc, errorMessage ) );
+  QCOMPARE( otherLayer.pipe()->projector()->precision(), QgsRasterProjector::Approximate );
+}
+
+QGSTEST_MAIN( TestQgsRasterProjector )
+#include "testqgsrasterprojector.moc"
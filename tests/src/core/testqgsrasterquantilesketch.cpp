@@ -0,0 +1,186 @@
+/***************************************************************************
+     testqgsrasterquantilesketch.cpp
+     --------------------------------------
+    Date                 : October 2023
+    Copyright            : (C) 2023 by QGIS developers
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+
+#include "qgsrasterquantilesketch.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterlayer.h"
+
+#include <QTemporaryDir>
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the QgsRasterQuantileSketch class.
+ */
+class TestQgsRasterQuantileSketch : public QObject
+{
+    Q_OBJECT
+  public:
+    TestQgsRasterQuantileSketch() = default;
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void empty();
+    void uniformQuantiles();
+    void merge();
+    void serialization();
+    void floatCumulativeCut();
+};
+
+void TestQgsRasterQuantileSketch::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsRasterQuantileSketch::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+// values 0 .. count - 1 in a scrambled order
+static double scrambledValue( int index, int count )
+{
+  return static_cast< double >( ( static_cast< qint64 >( index ) * 7919 ) % count );
+}
+
+void TestQgsRasterQuantileSketch::empty()
+{
+  const QgsRasterQuantileSketch sketch;
+  QCOMPARE( sketch.count(), static_cast< qgssize >( 0 ) );
+  QVERIFY( std::isnan( sketch.quantile( 0.5 ) ) );
+  QVERIFY( std::isnan( sketch.minimum() ) );
+  QVERIFY( std::isnan( sketch.maximum() ) );
+}
+
+void TestQgsRasterQuantileSketch::uniformQuantiles()
+{
+  const int count = 100000;
+  QgsRasterQuantileSketch sketch;
+  for ( int i = 0; i < count; ++i )
+    sketch.add( scrambledValue( i, count ) );
+
+  QCOMPARE( sketch.count(), static_cast< qgssize >( count ) );
+  QCOMPARE( sketch.minimum(), 0.0 );
+  QCOMPARE( sketch.maximum(), static_cast< double >( count - 1 ) );
+  QCOMPARE( sketch.quantile( 0 ), 0.0 );
+  QCOMPARE( sketch.quantile( 1 ), static_cast< double >( count - 1 ) );
+
+  // the tails are more accurate than the median
+  QGSCOMPARENEAR( sketch.quantile( 0.02 ), 0.02 * count, 0.001 * count );
+  QGSCOMPARENEAR( sketch.quantile( 0.98 ), 0.98 * count, 0.001 * count );
+  QGSCOMPARENEAR( sketch.quantile( 0.5 ), 0.5 * count, 0.01 * count );
+}
+
+void TestQgsRasterQuantileSketch::merge()
+{
+  const int count = 50000;
+  QgsRasterQuantileSketch whole;
+  QgsRasterQuantileSketch first;
+  QgsRasterQuantileSketch second;
+  for ( int i = 0; i < count; ++i )
+  {
+    const double value = scrambledValue( i, count );
+    whole.add( value );
+    if ( i < count / 3 )
+      first.add( value );
+    else
+      second.add( value );
+  }
+
+  first.merge( second );
+  QCOMPARE( first.count(), whole.count() );
+  QCOMPARE( first.minimum(), whole.minimum() );
+  QCOMPARE( first.maximum(), whole.maximum() );
+  for ( const double q : { 0.01, 0.02, 0.25, 0.5, 0.75, 0.98, 0.99 } )
+  {
+    QGSCOMPARENEAR( first.quantile( q ), whole.quantile( q ), 0.01 * count );
+  }
+
+  // merging an empty sketch does not change the sketch
+  const double median = first.quantile( 0.5 );
+  first.merge( QgsRasterQuantileSketch() );
+  QCOMPARE( first.count(), whole.count() );
+  QCOMPARE( first.quantile( 0.5 ), median );
+}
+
+void TestQgsRasterQuantileSketch::serialization()
+{
+  QgsRasterQuantileSketch sketch;
+  for ( int i = 0; i < 10000; ++i )
+    sketch.add( std::sin( i ) * 100 );
+
+  bool ok = false;
+  const QgsRasterQuantileSketch restored = QgsRasterQuantileSketch::fromString( sketch.toString(), &ok );
+  QVERIFY( ok );
+  QCOMPARE( restored.count(), sketch.count() );
+  QCOMPARE( restored.minimum(), sketch.minimum() );
+  QCOMPARE( restored.maximum(), sketch.maximum() );
+  for ( const double q : { 0.02, 0.5, 0.98 } )
+  {
+    QCOMPARE( restored.quantile( q ), sketch.quantile( q ) );
+  }
+  QCOMPARE( restored.toString(), sketch.toString() );
+
+  QgsRasterQuantileSketch::fromString( QStringLiteral( "not a sketch" ), &ok );
+  QVERIFY( !ok );
+  QgsRasterQuantileSketch::fromString( QStringLiteral( "tdigest;100;3;0;1;0.5,2" ), &ok );
+  QVERIFY( !ok );
+}
+
+void TestQgsRasterQuantileSketch::floatCumulativeCut()
+{
+  // a float raster with the values 0 .. count - 1
+  const int width = 200;
+  const int height = 200;
+  const int count = width * height;
+  QTemporaryDir dir;
+  const QString fileName = dir.filePath( QStringLiteral( "float.tif" ) );
+  double geoTransform[6] = { 0, 1, 0, height, 0, -1 };
+  std::unique_ptr< QgsRasterDataProvider > writer( QgsRasterDataProvider::create( QStringLiteral( "gdal" ), fileName, QStringLiteral( "GTiff" ), 1, Qgis::DataType::Float32, width, height, geoTransform, QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) ) );
+  QVERIFY( writer );
+  QgsRasterBlock block( Qgis::DataType::Float32, width, height );
+  for ( int i = 0; i < count; ++i )
+    block.setValue( static_cast< qgssize >( i ), scrambledValue( i, count ) );
+  QVERIFY( writer->writeBlock( &block, 1 ) );
+  writer.reset();
+
+  QgsRasterLayer layer( fileName, QStringLiteral( "float" ) );
+  QVERIFY( layer.isValid() );
+  QgsRasterDataProvider *provider = layer.dataProvider();
+
+  // float cuts are estimated from the t-digest of the band
+  const double tolerance = count * 0.005;
+  double lower = 0;
+  double upper = 0;
+  provider->cumulativeCut( 1, 0.02, 0.98, lower, upper );
+  QGSCOMPARENEAR( lower, 0.02 * count, tolerance );
+  QGSCOMPARENEAR( upper, 0.98 * count, tolerance );
+
+  // changing the no data values drops the cached sketch
+  provider->setUserNoDataValue( 1, QgsRasterRangeList() << QgsRasterRange( count / 2, count ) );
+  provider->cumulativeCut( 1, 0.02, 0.98, lower, upper );
+  QGSCOMPARENEAR( lower, 0.02 * count / 2, tolerance );
+  QGSCOMPARENEAR( upper, 0.98 * count / 2, tolerance );
+}
+
+QGSTEST_MAIN( TestQgsRasterQuantileSketch )
+#include "testqgsrasterquantilesketch.moc"
@@ -26,6 +26,7 @@ class TestQgsRuntimeProfiler: public QObject
     void initTestCase();
     void cleanupTestCase();
     void testGroups();
+    void record();
     void threading();
 
 };
@@ -90,6 +91,22 @@ void TestQgsRuntimeProfiler::testGroups()
 }
 
 
+void TestQgsRuntimeProfiler::record()
+{
+  QgsRuntimeProfiler profiler;
+  profiler.start( QStringLiteral( "task 1" ), QStringLiteral( "group 1" ) );
+  QSignalSpy endedSpy( &profiler, &QgsRuntimeProfiler::ended );
+  profiler.record( QStringLiteral( "measured elsewhere" ), 1.5, QStringLiteral( "group 1" ) );
+  QVERIFY( profiler.groupIsActive( QStringLiteral( "group 1" ) ) );
+  // the recorded time is reported, e.g. to the main thread profiler
+  QCOMPARE( endedSpy.count(), 1 );
+  QCOMPARE( endedSpy.at( 0 ).at( 2 ).toString(), QStringLiteral( "measured elsewhere" ) );
+  QCOMPARE( endedSpy.at( 0 ).at( 3 ).toDouble(), 1.5 );
+  profiler.end( QStringLiteral( "group 1" ) );
+
+  QCOMPARE( profiler.childGroups( QStringLiteral( "task 1" ), QStringLiteral( "group 1" ) ), QStringList() << QStringLiteral( "measured elsewhere" ) );
+  QCOMPARE( profiler.profileTime( QStringLiteral( "task 1/measured elsewhere" ), QStringLiteral( "group 1" ) ), 1.5 );
+}
 
 class ProfileInThread : public QThread
 {
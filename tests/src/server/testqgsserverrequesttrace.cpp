@@ -0,0 +1,94 @@
+/***************************************************************************
+
+   testqgsserverrequesttrace.cpp
+     --------------------------------------
+    Date                 : Oct 16 2023
+    Copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+//qgis includes...
+#include "qgsserverrequesttrace.h"
+#include "qgsbufferserverrequest.h"
+#include "qgsruntimeprofiler.h"
+
+/**
+ * \ingroup UnitTests
+ * Unit tests for the server per request trace
+ */
+class TestQgsServerRequestTrace : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void steps();
+};
+
+void TestQgsServerRequestTrace::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsServerRequestTrace::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsServerRequestTrace::steps()
+{
+  QgsRuntimeProfiler *profiler = QgsApplication::profiler();
+  profiler->clear( QStringLiteral( "server" ) );
+
+  profiler->start( QStringLiteral( "handleRequest" ), QStringLiteral( "server" ) );
+  profiler->record( QStringLiteral( "Project load" ), 0.012, QStringLiteral( "server" ) );
+  profiler->start( QStringLiteral( "Rendering" ), QStringLiteral( "server" ) );
+  profiler->record( QStringLiteral( "Render layer: \"roads\"" ), 0.1, QStringLiteral( "server" ) );
+  profiler->end( QStringLiteral( "server" ) );
+
+  // unrelated groups are ignored
+  profiler->start( QStringLiteral( "other" ), QStringLiteral( "projectload" ) );
+  profiler->end( QStringLiteral( "projectload" ) );
+
+  const QgsServerRequestTrace trace;
+  const QList<QgsServerRequestTrace::Step> steps = trace.steps();
+  QCOMPARE( steps.size(), 4 );
+  QCOMPARE( steps.at( 0 ).path, QStringList() << QStringLiteral( "handleRequest" ) );
+  QCOMPARE( steps.at( 1 ).path, QStringList() << QStringLiteral( "handleRequest" ) << QStringLiteral( "Project load" ) );
+  QGSCOMPARENEAR( steps.at( 1 ).elapsed, 12, 0.001 );
+  QCOMPARE( steps.at( 3 ).path.last(), QStringLiteral( "Render layer: \"roads\"" ) );
+  QGSCOMPARENEAR( steps.at( 3 ).elapsed, 100, 0.001 );
+
+  const QString header = trace.serverTimingHeader( 150 );
+  QVERIFY( header.startsWith( QStringLiteral( "s1-project-load;dur=12.0;desc=\"Project load\", " ) ) );
+  QVERIFY( header.contains( QStringLiteral( "s3-render-layer-roads-;dur=100.0;desc=\"Rendering / Render layer: \\\"roads\\\"\"" ) ) );
+  QVERIFY( header.endsWith( QStringLiteral( "total;dur=150.0" ) ) );
+
+  const QgsBufferServerRequest request( QStringLiteral( "http://server.qgis.org/ows?SERVICE=WMS&REQUEST=GetMap" ) );
+  const QJsonObject json = QJsonDocument::fromJson( trace.toJson( request, 150 ).toUtf8() ).object();
+  QCOMPARE( json.value( QStringLiteral( "service" ) ).toString(), QStringLiteral( "WMS" ) );
+  QCOMPARE( json.value( QStringLiteral( "request" ) ).toString(), QStringLiteral( "GetMap" ) );
+  QCOMPARE( json.value( QStringLiteral( "total_ms" ) ).toDouble(), 150.0 );
+  QCOMPARE( json.value( QStringLiteral( "steps" ) ).toArray().size(), 4 );
+
+  profiler->end( QStringLiteral( "server" ) );
+  profiler->clear( QStringLiteral( "server" ) );
+  profiler->clear( QStringLiteral( "projectload" ) );
+}
+
+QGSTEST_MAIN( TestQgsServerRequestTrace )
+#include "testqgsserverrequesttrace.moc"
@@ -0,0 +1,225 @@
+/***************************************************************************
+
+   testqgsserverresponsecompression.cpp
+     --------------------------------------
+    Date                 : Oct 16 2023
+    Copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+#include <QtEndian>
+
+//qgis includes...
+#include "qgscompressionresponsedecorator.h"
+#include "qgsserveretag.h"
+#include "qgsbufferserverrequest.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsziputils.h"
+#include "qgsproject.h"
+
+/**
+ * \ingroup UnitTests
+ * Unit tests for the server response compression and conditional requests
+ */
+class TestQgsServerResponseCompression : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void negotiateEncoding_data();
+    void negotiateEncoding();
+    void compressGzip();
+    void compressDeflate();
+    void notCompressible();
+    void streamed();
+    void etagMatches();
+    void etagHeaders();
+};
+
+void TestQgsServerResponseCompression::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsServerResponseCompression::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsServerResponseCompression::negotiateEncoding_data()
+{
+  QTest::addColumn<QString>( "acceptEncoding" );
+  QTest::addColumn<QString>( "expected" );
+
+  QTest::newRow( "empty" ) << QString() << QString();
+  QTest::newRow( "identity" ) << QStringLiteral( "identity" ) << QString();
+  QTest::newRow( "gzip" ) << QStringLiteral( "gzip" ) << QStringLiteral( "gzip" );
+  QTest::newRow( "deflate" ) << QStringLiteral( "deflate, br" ) << QStringLiteral( "deflate" );
+  QTest::newRow( "both" ) << QStringLiteral( "deflate, gzip" ) << QStringLiteral( "gzip" );
+  QTest::newRow( "quality" ) << QStringLiteral( "gzip;q=0.5, deflate;q=0.8" ) << QStringLiteral( "deflate" );
+  QTest::newRow( "refused" ) << QStringLiteral( "gzip;q=0" ) << QString();
+  QTest::newRow( "wildcard" ) << QStringLiteral( "*" ) << QStringLiteral( "gzip" );
+  QTest::newRow( "wildcard gzip refused" ) << QStringLiteral( "gzip;q=0, *" ) << QStringLiteral( "deflate" );
+}
+
+void TestQgsServerResponseCompression::negotiateEncoding()
+{
+  QFETCH( QString, acceptEncoding );
+  QFETCH( QString, expected );
+
+  QCOMPARE( QgsCompressionResponseDecorator::negotiateEncoding( acceptEncoding ), expected );
+}
+
+void TestQgsServerResponseCompression::compressGzip()
+{
+  QgsBufferServerRequest request( QStringLiteral( "http://server.qgis.org/wfs3" ) );
+  request.setHeader( QStringLiteral( "Accept-Encoding" ), QStringLiteral( "gzip, deflate" ) );
+  QgsBufferServerResponse response;
+  QgsCompressionResponseDecorator decorator( request, response );
+
+  const QByteArray content = QByteArray( "{\"type\": \"FeatureCollection\"}" ).repeated( 100 );
+  decorator.setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "application/geo+json" ) );
+  decorator.write( content );
+  decorator.finish();
+
+  QCOMPARE( response.header( QStringLiteral( "Content-Encoding" ) ), QStringLiteral( "gzip" ) );
+  QCOMPARE( response.header( QStringLiteral( "Vary" ) ), QStringLiteral( "Accept-Encoding" ) );
+  QVERIFY( response.body().size() < content.size() );
+  QCOMPARE( response.header( QStringLiteral( "Content-Length" ) ), QString::number( response.body().size() ) );
+
+  QByteArray decoded;
+  QVERIFY( QgsZipUtils::decodeGzip( response.body(), decoded ) );
+  QCOMPARE( decoded, content );
+}
+
+void TestQgsServerResponseCompression::compressDeflate()
+{
+  QgsBufferServerRequest request( QStringLiteral( "http://server.qgis.org/ows" ) );
+  request.setHeader( QStringLiteral( "Accept-Encoding" ), QStringLiteral( "deflate" ) );
+  QgsBufferServerResponse response;
+  QgsCompressionResponseDecorator decorator( request, response );
+
+  const QByteArray content = QByteArray( "<WMS_Capabilities></WMS_Capabilities>" ).repeated( 100 );
+  decorator.setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "text/xml; charset=utf-8" ) );
+  decorator.write( content );
+  decorator.finish();
+
+  QCOMPARE( response.header( QStringLiteral( "Content-Encoding" ) ), QStringLiteral( "deflate" ) );
+
+  // add back the uncompressed size prefix expected by qUncompress
+  QByteArray prefixed( 4, '\0' );
+  qToBigEndian<quint32>( content.size(), reinterpret_cast< uchar * >( prefixed.data() ) );
+  QCOMPARE( qUncompress( prefixed + response.body() ), content );
+}
+
+void TestQgsServerResponseCompression::notCompressible()
+{
+  QgsBufferServerRequest request( QStringLiteral( "http://server.qgis.org/ows" ) );
+  request.setHeader( QStringLiteral( "Accept-Encoding" ), QStringLiteral( "gzip" ) );
+
+  // images are already compressed
+  QgsBufferServerResponse response;
+  QgsCompressionResponseDecorator decorator( request, response );
+  const QByteArray content( 4096, 'a' );
+  decorator.setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "image/png" ) );
+  decorator.write( content );
+  decorator.finish();
+  QVERIFY( response.header( QStringLiteral( "Content-Encoding" ) ).isEmpty() );
+  QCOMPARE( response.body(), content );
+
+  // disabled
+  QgsBufferServerResponse response2;
+  QgsCompressionResponseDecorator decorator2( request, response2, false );
+  decorator2.setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "text/plain" ) );
+  decorator2.write( content );
+  decorator2.finish();
+  QVERIFY( response2.header( QStringLiteral( "Content-Encoding" ) ).isEmpty() );
+  QCOMPARE( response2.body(), content );
+
+  // too small
+  QgsBufferServerResponse response3;
+  QgsCompressionResponseDecorator decorator3( request, response3 );
+  decorator3.setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "text/plain" ) );
+  decorator3.write( QByteArray( "small" ) );
+  decorator3.finish();
+  QVERIFY( response3.header( QStringLiteral( "Content-Encoding" ) ).isEmpty() );
+  QCOMPARE( response3.body(), QByteArray( "small" ) );
+}
+
+void TestQgsServerResponseCompression::streamed()
+{
+  QgsBufferServerRequest request( QStringLiteral( "http://server.qgis.org/ows" ) );
+  request.setHeader( QStringLiteral( "Accept-Encoding" ), QStringLiteral( "gzip" ) );
+  QgsBufferServerResponse response;
+  QgsCompressionResponseDecorator decorator( request, response );
+
+  const QByteArray content( 4096, 'a' );
+  decorator.setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "text/plain" ) );
+  decorator.write( content );
+  decorator.flush();
+  decorator.write( content );
+  decorator.finish();
+
+  QVERIFY( response.header( QStringLiteral( "Content-Encoding" ) ).isEmpty() );
+  QCOMPARE( response.body(), content + content );
+}
+
+void TestQgsServerResponseCompression::etagMatches()
+{
+  const QString etag = QStringLiteral( "W/\"abc\"" );
+  QVERIFY( !QgsServerETag::matches( QString(), etag ) );
+  QVERIFY( !QgsServerETag::matches( QStringLiteral( "\"def\"" ), etag ) );
+  QVERIFY( QgsServerETag::matches( QStringLiteral( "\"abc\"" ), etag ) );
+  QVERIFY( QgsServerETag::matches( QStringLiteral( "W/\"abc\"" ), etag ) );
+  QVERIFY( QgsServerETag::matches( QStringLiteral( "\"def\", W/\"abc\"" ), etag ) );
+  QVERIFY( QgsServerETag::matches( QStringLiteral( "*" ), etag ) );
+}
+
+void TestQgsServerResponseCompression::etagHeaders()
+{
+  QTemporaryDir dir;
+  QgsProject project;
+  QVERIFY( project.write( dir.filePath( QStringLiteral( "project.qgs" ) ) ) );
+
+  const auto etagFor = [&project]( const QMap<QString, QString> &headers )
+  {
+    QgsBufferServerRequest request( QStringLiteral( "http://server.qgis.org/ows?SERVICE=WMS&REQUEST=GetCapabilities" ) );
+    for ( auto it = headers.constBegin(); it != headers.constEnd(); ++it )
+      request.setHeader( it.key(), it.value() );
+    return QgsServerETag::computeETag( request, project );
+  };
+
+  const QString etag = etagFor( { { QStringLiteral( "Host" ), QStringLiteral( "server.qgis.org" ) } } );
+  QVERIFY( !etag.isEmpty() );
+  QCOMPARE( etagFor( { { QStringLiteral( "Host" ), QStringLiteral( "server.qgis.org" ) } } ), etag );
+  // headers which don't change the response are ignored
+  QCOMPARE( etagFor( { { QStringLiteral( "Host" ), QStringLiteral( "server.qgis.org" ) }, { QStringLiteral( "User-Agent" ), QStringLiteral( "test" ) } } ), etag );
+
+  // the format and the advertised URLs depend on these headers
+  QVERIFY( etagFor( { { QStringLiteral( "Host" ), QStringLiteral( "other.qgis.org" ) } } ) != etag );
+  QVERIFY( etagFor( { { QStringLiteral( "Host" ), QStringLiteral( "server.qgis.org" ) }, { QStringLiteral( "Accept" ), QStringLiteral( "application/json" ) } } ) != etag );
+  QVERIFY( etagFor( { { QStringLiteral( "Host" ), QStringLiteral( "server.qgis.org" ) }, { QStringLiteral( "X-Forwarded-Proto" ), QStringLiteral( "https" ) } } ) != etag );
+  QVERIFY( etagFor( { { QStringLiteral( "Host" ), QStringLiteral( "server.qgis.org" ) }, { QStringLiteral( "X-Qgis-Service-Url" ), QStringLiteral( "https://proxy/ows" ) } } ) != etag );
+
+  // responses filtered by access control plugins depend on their cache key
+  QgsBufferServerRequest request( QStringLiteral( "http://server.qgis.org/ows?SERVICE=WMS&REQUEST=GetCapabilities" ) );
+  request.setHeader( QStringLiteral( "Host" ), QStringLiteral( "server.qgis.org" ) );
+  const QString userEtag = QgsServerETag::computeETag( request, project, QStringList() << QStringLiteral( "user" ) );
+  QVERIFY( userEtag != etag );
+  QVERIFY( QgsServerETag::computeETag( request, project, QStringList() << QStringLiteral( "admin" ) ) != userEtag );
+}
+
+QGSTEST_MAIN( TestQgsServerResponseCompression )
+#include "testqgsserverresponsecompression.moc"
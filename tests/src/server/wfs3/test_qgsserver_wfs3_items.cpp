@@ -0,0 +1,182 @@
+/***************************************************************************
+     test_qgsserver_wfs3_items.cpp
+     -----------------------------
+    Date                 : October 2023
+    Copyright            : (C) 2023 by QGIS.org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgsproject.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectorfilewriter.h"
+
+#include "qgsbufferserverrequest.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsserverapicontext.h"
+#include "qgsserverinterfaceimpl.h"
+#include "qgsserverogcapi.h"
+#include "qgsserverexception.h"
+#include "qgswfs3handlers.h"
+
+#include <nlohmann/json.hpp>
+
+#include <QTemporaryDir>
+
+using namespace nlohmann;
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the OGC API Features items handler
+ */
+class TestQgsServerWfs3Items : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void streamedItems();
+    void keysetPagination();
+
+  private:
+    json getItems( const QString &url, QgsBufferServerResponse &response );
+
+    std::unique_ptr<QgsServiceRegistry> mRegistry;
+    std::unique_ptr<QgsServerSettings> mSettings;
+    std::unique_ptr<QgsCapabilitiesCache> mCache;
+    std::unique_ptr<QgsServerInterfaceImpl> mInterface;
+    std::unique_ptr<QgsServerOgcApi> mApi;
+    std::unique_ptr<QgsProject> mProject;
+    QTemporaryDir mTempDir;
+};
+
+void TestQgsServerWfs3Items::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mRegistry = std::make_unique<QgsServiceRegistry>();
+  mSettings = std::make_unique<QgsServerSettings>();
+  mCache = std::make_unique<QgsCapabilitiesCache>( mSettings->capabilitiesCacheSize() );
+  mInterface = std::make_unique<QgsServerInterfaceImpl>( mCache.get(), mRegistry.get(), mSettings.get() );
+
+  mApi = std::make_unique<QgsServerOgcApi>( mInterface.get(), QStringLiteral( "/wfs3" ), QStringLiteral( "OGC WFS3 (Draft)" ), QStringLiteral( "1.0.0" ) );
+  mApi->registerHandler<QgsWfs3CollectionsItemsHandler>();
+
+  // A GeoPackage layer, its fid is a single attribute primary key
+  QgsVectorLayer memoryLayer( QStringLiteral( "Point?crs=epsg:4326&field=name:string" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < 5; ++i )
+  {
+    QgsFeature f( memoryLayer.fields() );
+    f.setAttribute( 0, QStringLiteral( "point %1" ).arg( i ) );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+    features << f;
+  }
+  QVERIFY( memoryLayer.dataProvider()->addFeatures( features ) );
+
+  const QString fileName = mTempDir.filePath( QStringLiteral( "points.gpkg" ) );
+  QgsVectorFileWriter::SaveVectorOptions options;
+  options.driverName = QStringLiteral( "GPKG" );
+  options.layerName = QStringLiteral( "points" );
+  QCOMPARE( QgsVectorFileWriter::writeAsVectorFormatV3( &memoryLayer, fileName, memoryLayer.transformContext(), options ), QgsVectorFileWriter::NoError );
+
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "%1|layername=points" ).arg( fileName ), QStringLiteral( "points" ), QStringLiteral( "ogr" ) );
+  QVERIFY( layer->isValid() );
+  QCOMPARE( layer->dataProvider()->pkAttributeIndexes().size(), 1 );
+
+  mProject = std::make_unique<QgsProject>();
+  mProject->addMapLayer( layer );
+  mProject->writeEntry( QStringLiteral( "WFSLayers" ), QStringLiteral( "/" ), QStringList() << layer->id() );
+}
+
+void TestQgsServerWfs3Items::cleanupTestCase()
+{
+  mApi.reset();
+  mProject.reset();
+  QgsApplication::exitQgis();
+}
+
+json TestQgsServerWfs3Items::getItems( const QString &url, QgsBufferServerResponse &response )
+{
+  const QgsBufferServerRequest request( url );
+  const QgsServerApiContext context { QStringLiteral( "/wfs3" ), &request, &response, mProject.get(), mInterface.get() };
+  mApi->executeRequest( context );
+  response.finish();
+  return json::parse( response.body().toStdString() );
+}
+
+void TestQgsServerWfs3Items::streamedItems()
+{
+  QgsBufferServerResponse response;
+  const json data = getItems( QStringLiteral( "http://server.qgis.org/wfs3/collections/points/items.geojson" ), response );
+
+  QCOMPARE( response.statusCode(), 200 );
+  QCOMPARE( response.headers().value( QStringLiteral( "Content-Type" ) ), QStringLiteral( "application/geo+json" ) );
+  QVERIFY( data["type"] == "FeatureCollection" );
+  QCOMPARE( data["features"].size(), static_cast<size_t>( 5 ) );
+  QVERIFY( data["features"][0]["properties"]["name"] == "point 0" );
+  QCOMPARE( data["numberReturned"].get<int>(), 5 );
+  QCOMPARE( data["numberMatched"].get<int>(), 5 );
+  QVERIFY( data.contains( "timeStamp" ) );
+  QVERIFY( data["links"].is_array() );
+}
+
+void TestQgsServerWfs3Items::keysetPagination()
+{
+  QString url { QStringLiteral( "http://server.qgis.org/wfs3/collections/points/items.geojson?limit=2" ) };
+  QStringList names;
+  int pages = 0;
+  while ( ! url.isEmpty() )
+  {
+    QgsBufferServerResponse response;
+    const json data = getItems( url, response );
+    QCOMPARE( response.statusCode(), 200 );
+    QVERIFY( data["numberReturned"].get<int>() <= 2 );
+    for ( const auto &feature : data["features"] )
+    {
+      names << QString::fromStdString( feature["properties"]["name"].get<std::string>() );
+    }
+
+    url.clear();
+    for ( const auto &link : data["links"] )
+    {
+      if ( link["rel"] == "next" )
+      {
+        url = QString::fromStdString( link["href"].get<std::string>() );
+        QVERIFY( url.contains( QStringLiteral( "cursor=" ) ) );
+      }
+    }
+    QVERIFY( ++pages <= 3 );
+  }
+
+  QCOMPARE( pages, 3 );
+  QCOMPARE( names, QStringList() << QStringLiteral( "point 0" ) << QStringLiteral( "point 1" ) << QStringLiteral( "point 2" ) << QStringLiteral( "point 3" ) << QStringLiteral( "point 4" ) );
+
+  // The pages of the offset pagination follow the same primary key order
+  {
+    QgsBufferServerResponse response;
+    const json data = getItems( QStringLiteral( "http://server.qgis.org/wfs3/collections/points/items.geojson?limit=2&offset=2" ), response );
+    QCOMPARE( response.statusCode(), 200 );
+    QCOMPARE( data["features"].size(), static_cast<size_t>( 2 ) );
+    QVERIFY( data["features"][0]["properties"]["name"] == "point 2" );
+    QVERIFY( data["features"][1]["properties"]["name"] == "point 3" );
+  }
+
+  // A cursor cannot be combined with an offset
+  QgsBufferServerResponse response;
+  const QgsBufferServerRequest request( QStringLiteral( "http://server.qgis.org/wfs3/collections/points/items.geojson?limit=2&offset=2&cursor=MQ" ) );
+  const QgsServerApiContext context { QStringLiteral( "/wfs3" ), &request, &response, mProject.get(), mInterface.get() };
+  QVERIFY_EXCEPTION_THROWN( mApi->executeRequest( context ), QgsServerApiBadRequestException );
+}
+
+QGSTEST_MAIN( TestQgsServerWfs3Items )
+#include "test_qgsserver_wfs3_items.moc"
@@ -0,0 +1,184 @@
+/***************************************************************************
+     test_qgsserver_wms_footprintindex.cpp
+     --------------------------------------
+    Date                 : October 2023
+    Copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgswmsfootprintindex.h"
+#include "qgsserversettings.h"
+#include "qgsvectorlayer.h"
+#include "qgsmapsettings.h"
+#include "qgscategorizedsymbolrenderer.h"
+#include "qgsmarkersymbol.h"
+#include "qgssymbollayerutils.h"
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the cached index of rendered feature footprints
+ */
+class TestQgsServerWmsFootprintIndex : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void renderedFeatures();
+    void usedSymbols();
+    void cache();
+
+  private:
+    std::unique_ptr<QgsVectorLayer> createLayer() const;
+    QgsMapSettings mapSettings( QgsVectorLayer *layer ) const;
+};
+
+void TestQgsServerWmsFootprintIndex::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsServerWmsFootprintIndex::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+std::unique_ptr<QgsVectorLayer> TestQgsServerWmsFootprintIndex::createLayer() const
+{
+  std::unique_ptr<QgsVectorLayer> layer = std::make_unique<QgsVectorLayer>( QStringLiteral( "Point?crs=EPSG:3857&field=class:string" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+
+  QgsFeatureList features;
+  const QStringList classes { QStringLiteral( "a" ), QStringLiteral( "b" ), QStringLiteral( "hidden" ) };
+  for ( int i = 0; i < 30; ++i )
+  {
+    QgsFeature feature( layer->fields() );
+    feature.setAttribute( 0, classes.at( i % 3 ) );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i * 10, i * 10 ) ) );
+    features << feature;
+  }
+  layer->dataProvider()->addFeatures( features );
+
+  QgsCategoryList categories;
+  categories << QgsRendererCategory( QStringLiteral( "a" ), QgsMarkerSymbol::createSimple( { { QStringLiteral( "color" ), QStringLiteral( "255,0,0" ) } } ), QStringLiteral( "a" ) );
+  categories << QgsRendererCategory( QStringLiteral( "b" ), QgsMarkerSymbol::createSimple( { { QStringLiteral( "color" ), QStringLiteral( "0,0,255" ) } } ), QStringLiteral( "b" ) );
+  categories << QgsRendererCategory( QStringLiteral( "hidden" ), QgsMarkerSymbol::createSimple( QVariantMap() ), QStringLiteral( "hidden" ), false );
+  layer->setRenderer( new QgsCategorizedSymbolRenderer( QStringLiteral( "class" ), categories ) );
+
+  return layer;
+}
+
+QgsMapSettings TestQgsServerWmsFootprintIndex::mapSettings( QgsVectorLayer *layer ) const
+{
+  QgsMapSettings settings;
+  settings.setDestinationCrs( layer->crs() );
+  settings.setOutputSize( QSize( 300, 300 ) );
+  settings.setExtent( QgsRectangle( 0, 0, 300, 300 ) );
+  settings.setLayers( QList<QgsMapLayer *>() << layer );
+  return settings;
+}
+
+void TestQgsServerWmsFootprintIndex::renderedFeatures()
+{
+  std::unique_ptr<QgsVectorLayer> layer = createLayer();
+  const QgsWms::QgsWmsFootprintIndex index( layer.get(), mapSettings( layer.get() ) );
+
+  // features of the unchecked category are not rendered
+  QCOMPARE( index.size(), 20 );
+
+  // fids are 1 based in memory layers
+  QgsFeatureIds ids = index.renderedFeatures( QgsRectangle( 95, 95, 105, 105 ) );
+  QCOMPARE( ids, QgsFeatureIds() << 11 );
+
+  // only a feature of the unchecked category
+  ids = index.renderedFeatures( QgsRectangle( 136, 136, 144, 144 ) );
+  QVERIFY( ids.isEmpty() );
+
+  // symbol footprints are larger than the point geometries
+  ids = index.renderedFeatures( QgsRectangle( 101, 101, 102, 102 ) );
+  QCOMPARE( ids, QgsFeatureIds() << 11 );
+}
+
+void TestQgsServerWmsFootprintIndex::usedSymbols()
+{
+  std::unique_ptr<QgsVectorLayer> layer = createLayer();
+  const QgsWms::QgsWmsFootprintIndex index( layer.get(), mapSettings( layer.get() ) );
+
+  QgsCategorizedSymbolRenderer *renderer = static_cast<QgsCategorizedSymbolRenderer *>( layer->renderer() );
+  const QString symbolA = QgsSymbolLayerUtils::symbolProperties( renderer->categories().at( 0 ).symbol() );
+  const QString symbolB = QgsSymbolLayerUtils::symbolProperties( renderer->categories().at( 1 ).symbol() );
+
+  QCOMPARE( index.usedSymbols( layer.get(), QgsRectangle( -5, -5, 5, 5 ) ), QSet<QString>() << symbolA );
+  QCOMPARE( index.usedSymbols( layer.get(), QgsRectangle( -5, -5, 15, 15 ) ), QSet<QString>() << symbolA << symbolB );
+
+  // the point is within the symbol footprint but outside of the extent
+  QVERIFY( index.usedSymbols( layer.get(), QgsRectangle( 11, 11, 15, 15 ) ).isEmpty() );
+
+  // only a hidden feature
+  QVERIFY( index.usedSymbols( layer.get(), QgsRectangle( 15, 15, 25, 25 ) ).isEmpty() );
+}
+
+void TestQgsServerWmsFootprintIndex::cache()
+{
+  std::unique_ptr<QgsVectorLayer> layer = createLayer();
+  QgsWms::QgsWmsFootprintCache *cache = QgsWms::QgsWmsFootprintCache::instance();
+  cache->clear();
+
+  // disabled by default
+  QgsServerSettings settings;
+  QVERIFY( !cache->index( layer.get(), mapSettings( layer.get() ), settings ) );
+
+  qputenv( "QGIS_SERVER_WMS_FOOTPRINT_CACHE_SIZE", "2" );
+  settings.load();
+  qunsetenv( "QGIS_SERVER_WMS_FOOTPRINT_CACHE_SIZE" );
+
+  const std::shared_ptr<const QgsWms::QgsWmsFootprintIndex> index = cache->index( layer.get(), mapSettings( layer.get() ), settings );
+  QVERIFY( index );
+  QCOMPARE( index->size(), 20 );
+  QCOMPARE( cache->index( layer.get(), mapSettings( layer.get() ), settings ), index );
+
+  // another scale means another index
+  QgsMapSettings zoomed = mapSettings( layer.get() );
+  zoomed.setExtent( QgsRectangle( 0, 0, 150, 150 ) );
+  QVERIFY( cache->index( layer.get(), zoomed, settings ) != index );
+  QCOMPARE( cache->size(), 2 );
+
+  // so does another style
+  QgsCategorizedSymbolRenderer *renderer = static_cast<QgsCategorizedSymbolRenderer *>( layer->renderer() );
+  renderer->updateCategoryRenderState( 2, true );
+  const std::shared_ptr<const QgsWms::QgsWmsFootprintIndex> allIndex = cache->index( layer.get(), mapSettings( layer.get() ), settings );
+  QCOMPARE( allIndex->size(), 30 );
+  QCOMPARE( cache->size(), 2 );
+
+  // committed changes invalidate the layer indexes
+  layer->startEditing();
+  layer->deleteFeature( 1 );
+  layer->commitChanges();
+  QCOMPARE( cache->size(), 0 );
+  QCOMPARE( cache->index( layer.get(), mapSettings( layer.get() ), settings )->size(), 29 );
+
+  // so does a reload of the data
+  QCOMPARE( cache->size(), 1 );
+  layer->dataProvider()->reloadData();
+  QCOMPARE( cache->size(), 0 );
+
+  // and the removal of the layer
+  QVERIFY( cache->index( layer.get(), mapSettings( layer.get() ), settings ) );
+  QCOMPARE( cache->size(), 1 );
+  layer.reset();
+  QCOMPARE( cache->size(), 0 );
+
+  cache->clear();
+}
+
+QGSTEST_MAIN( TestQgsServerWmsFootprintIndex )
+#include "test_qgsserver_wms_footprintindex.moc"
@@ -0,0 +1,147 @@
+/***************************************************************************
+     test_qgsserver_wms_octreequantizer.cpp
+     --------------------------------------
+    Date                 : October 2023
+    Copyright            : (C) 2023 by QGIS Server developers
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgsoctreequantizer.h"
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the octree color quantizer used for 8 bit PNG output
+ */
+class TestQgsServerWmsOctreeQuantizer : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void fewColors();
+    void transparent();
+    void manyColors();
+    void dithering();
+};
+
+void TestQgsServerWmsOctreeQuantizer::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsServerWmsOctreeQuantizer::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsServerWmsOctreeQuantizer::fewColors()
+{
+  // colors which fit in the palette are kept exactly
+  QImage image( 600, 600, QImage::Format_ARGB32 );
+  image.fill( qRgba( 255, 0, 0, 255 ) );
+  for ( int i = 0; i < 600; ++i )
+    image.setPixel( i, i, qRgba( 0, 0, 255, 128 ) );
+
+  const QgsWms::QgsOctreeQuantizer quantizer( image, 256 );
+  QCOMPARE( quantizer.colorTable().size(), 2 );
+  QVERIFY( quantizer.colorTable().contains( qRgba( 255, 0, 0, 255 ) ) );
+  QVERIFY( quantizer.colorTable().contains( qRgba( 0, 0, 255, 128 ) ) );
+
+  const QImage result = quantizer.convertToIndexed8( image );
+  QCOMPARE( result.format(), QImage::Format_Indexed8 );
+  QCOMPARE( result.size(), image.size() );
+  for ( int i = 0; i < 600; i += 7 )
+  {
+    for ( int j = 0; j < 600; j += 3 )
+    {
+      QCOMPARE( result.pixel( i, j ), image.pixel( i, j ) );
+    }
+  }
+}
+
+void TestQgsServerWmsOctreeQuantizer::transparent()
+{
+  // fully transparent pixels share a single palette entry whatever their RGB values
+  QImage image( 10, 10, QImage::Format_ARGB32 );
+  for ( int i = 0; i < 10; ++i )
+  {
+    for ( int j = 0; j < 10; ++j )
+      image.setPixel( i, j, qRgba( i * 20, j * 20, 0, 0 ) );
+  }
+
+  const QgsWms::QgsOctreeQuantizer quantizer( image, 256 );
+  QCOMPARE( quantizer.colorTable().size(), 1 );
+  QCOMPARE( qAlpha( quantizer.colorTable().at( 0 ) ), 0 );
+}
+
+void TestQgsServerWmsOctreeQuantizer::manyColors()
+{
+  QImage image( 512, 512, QImage::Format_ARGB32 );
+  for ( int i = 0; i < 512; ++i )
+  {
+    for ( int j = 0; j < 512; ++j )
+      image.setPixel( i, j, qRgba( i / 2, j / 2, ( i + j ) / 4, 255 ) );
+  }
+
+  const QgsWms::QgsOctreeQuantizer quantizer( image, 256 );
+  QVERIFY( quantizer.colorTable().size() <= 256 );
+  QVERIFY( quantizer.colorTable().size() > 128 );
+
+  const QImage result = quantizer.convertToIndexed8( image );
+  QCOMPARE( result.colorCount(), quantizer.colorTable().size() );
+
+  // every pixel is mapped to a close palette color
+  for ( int i = 0; i < 512; i += 5 )
+  {
+    for ( int j = 0; j < 512; j += 5 )
+    {
+      const QRgb expected = image.pixel( i, j );
+      const QRgb actual = result.pixel( i, j );
+      QVERIFY( std::abs( qRed( expected ) - qRed( actual ) ) <= 48 );
+      QVERIFY( std::abs( qGreen( expected ) - qGreen( actual ) ) <= 48 );
+      QVERIFY( std::abs( qBlue( expected ) - qBlue( actual ) ) <= 48 );
+      QCOMPARE( qAlpha( actual ), 255 );
+    }
+  }
+}
+
+void TestQgsServerWmsOctreeQuantizer::dithering()
+{
+  QImage image( 64, 64, QImage::Format_ARGB32 );
+  for ( int i = 0; i < 64; ++i )
+  {
+    for ( int j = 0; j < 64; ++j )
+      image.setPixel( i, j, qRgba( i * 4, j * 4, 128, 255 ) );
+  }
+
+  const QgsWms::QgsOctreeQuantizer quantizer( image, 16 );
+  QVERIFY( quantizer.colorTable().size() <= 16 );
+
+  const QImage result = quantizer.convertToIndexed8( image, true );
+  QCOMPARE( result.format(), QImage::Format_Indexed8 );
+
+  // dithering preserves the mean color of flat areas
+  double red = 0;
+  for ( int i = 0; i < 64; ++i )
+  {
+    for ( int j = 0; j < 64; ++j )
+    {
+      QVERIFY( result.pixelIndex( i, j ) < quantizer.colorTable().size() );
+      red += qRed( result.pixel( i, j ) );
+    }
+  }
+  QGSCOMPARENEAR( red / ( 64 * 64 ), 126, 8 );
+}
+
+QGSTEST_MAIN( TestQgsServerWmsOctreeQuantizer )
+#include "test_qgsserver_wms_octreequantizer.moc"